@@ -0,0 +1,74 @@
+#ifndef DRY_RUN_GUARD_H
+#define DRY_RUN_GUARD_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "utils/EventBus.h"
+#include "utils/SensorCalibration.h"
+
+struct DryRunConfig {
+    int tripLevel;               // Tank level (% of the sensor height) at or below which the pump is cut
+    int resetLevel;              // The trip clears once the tank is back at or above this level
+    uint8_t tripSamples;         // Consecutive low reads needed, so a slosh doesn't trip
+};
+
+// Keeps the pump from running the tank dry, manual override included. While
+// a valve is open, a timer on the esp_timer task reads the water level every
+// DryRun::SAMPLE_PERIOD; tripSamples low reads in a row cut every valve at
+// the pin from that task, so a trip lands within tripSamples periods whatever
+// the loop task is doing. The trip is posted to the event bus, and the
+// control handler then closes the zones, ends manual overrides and publishes
+// it. The guard stays tripped, holding every valve closed, until the tank is
+// back at resetLevel.
+class DryRunGuard {
+public:
+    typedef void (*CutHandler)(void* context);
+
+private:
+    int pin;
+    DryRunConfig config;
+    EventBus* bus;
+    CutHandler cut;
+    void* cutContext;
+    esp_timer_handle_t timer;
+    portMUX_TYPE lock;
+
+    volatile bool armed;             // A valve is open: low reads count and the timer runs
+    volatile bool tripped;           // Latched until the tank refills
+    volatile bool acknowledged;      // The loop task has closed the zones
+    uint8_t lowCount;
+    unsigned long firstLowAt;        // millis() of the first low read of the current run
+    int level;                       // Latest read, %
+    int tripLevelSeen;               // Read that tripped, %
+    unsigned long tripLatency;       // ms from the first low read to the cut
+    uint32_t trips;
+    uint32_t fastSamples;            // Timer reads since the previous payload
+
+    static void onSample(void* arg);
+    bool check(int levelPercent, unsigned long now);
+    void raise(int levelPercent);
+
+public:
+    DryRunGuard(int waterLevelPin = Pins::WATER_LEVEL_PIN);
+
+    // The handler runs on the esp_timer task when the guard trips: it must only drive pins
+    void begin(EventBus& eventBus, CutHandler handler, void* context);
+    void setConfig(const DryRunConfig& newConfig);
+    const DryRunConfig& getConfig() const { return config; }
+
+    // Called every loop pass: starts the fast reads when a valve opens, stops them when all are closed
+    void update(bool pumping);
+    // A water level read taken by the sensor pipeline; also the only way a trip clears
+    void sample(int levelPercent, unsigned long now);
+
+    bool isTripped() const { return tripped; }
+    // The zones were closed for the trip; the timer stops re-cutting the pins
+    void acknowledge() { acknowledged = true; }
+    String describeTrip() const;
+
+    void serialize(JsonDocument& doc);
+};
+
+#endif
@@ -3,23 +3,55 @@
 
 #include <Arduino.h>
 
+struct PumpControlConfig {
+    int onThreshold;             // Pump starts at or below this soil moisture (%)
+    int offThreshold;            // Pump stops at or above this soil moisture (%)
+    unsigned long minOnTime;     // Minimum dwell time once switched ON (ms)
+    unsigned long minOffTime;    // Minimum dwell time once switched OFF (ms)
+    bool inhibitOnRain;          // Force pump OFF while rain is detected
+    bool inhibitOnLowWater;      // Force pump OFF while the tank level is "Low"
+};
+
 class RelayController {
 private:
     int pin;
     bool isActive;
     bool lastState;
-    const int SOIL_THRESHOLD = 10;       // 0-10% soil moisture triggers pump
+    PumpControlConfig config;
+    unsigned long lastChangeTime;        // millis() of the last relay toggle
+    bool heldForCapacity;                // Last control() wanted ON but wasn't allowed to open
+
+    // Decision/toggle accounting, rolled over every hour
+    static const unsigned long STATS_WINDOW = 3600000;
+    unsigned long statsWindowStart;
+    unsigned long decisionCount;
+    unsigned long toggleCount;
+    unsigned long lastHourDecisions;
+    unsigned long lastHourToggles;
+
+    void applyState(bool state);
+    void updateStatsWindow(unsigned long now);
 
 public:
     RelayController(int relayPin);
-    void begin();
+    // initialState/stateAge come from persisted control state; the defaults start OFF
+    void begin(bool initialState = false, unsigned long stateAge = 0);
+    void setConfig(const PumpControlConfig& newConfig);
+    const PumpControlConfig& getConfig() const;
     bool shouldActivate(int soilMoisture);  
-    void control(int soilMoisture, String& reason);  
+    // mayOpen = false keeps a closed relay closed (shared pump capacity); it never closes one.
+    // demanded treats the soil as dry regardless of the thresholds (a rule asked for water).
+    void control(int soilMoisture, bool rainDetected, bool waterLow, String& reason, bool mayOpen = true,
+                 bool demanded = false);
     void setRelayState(bool state);  
+    void failSafe() const;               // Output OFF, state untouched; safe from another task
     bool isRelayActive() const;
+    bool isHeldForCapacity() const { return heldForCapacity; }
     bool hasStateChanged();
     void updateLastState();
+    unsigned long getDecisionsPerHour() const;
+    unsigned long getTogglesPerHour() const;
     void printDebugInfo(const String& reason) const;
 };
 
-#endif
\ No newline at end of file
+#endif
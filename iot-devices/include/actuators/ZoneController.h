@@ -0,0 +1,97 @@
+#ifndef ZONE_CONTROLLER_H
+#define ZONE_CONTROLLER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <array>
+#include <utility>
+#include "actuators/RelayController.h"
+#include "sensors/SoilMoistureSensor.h"
+#include "rules/RuleEngine.h"
+#include "utils/MoistureTrend.h"
+#include "utils/SignalMonitor.h"
+#include "utils/SensorCalibration.h"
+
+// Drives one valve relay per irrigation zone (Zones::TABLE) from that zone's
+// soil probe. Each zone runs its own hysteresis and dwell times; the shared
+// pump feeds at most Zones::MAX_OPEN_VALVES valves, so a zone that comes due
+// while the pump is at capacity waits. Closed zones are offered capacity
+// round-robin, so one zone that keeps drying out can't starve the others.
+// Rule decisions come on top: an inhibited zone stays closed, a demanded one
+// counts as dry. A control pass is one decision per zone. Each zone keeps a
+// moisture trend: an open valve closes once the soil is expected to reach
+// its OFF threshold within Trend::STOP_LEAD, so it doesn't overshoot while
+// the water soaks down to the probe.
+class ZoneController {
+public:
+    struct Zone {
+        RelayController relay;
+        SoilMoistureSensor probe;        // Not read for zone 1: the sensor pipeline owns that probe
+        int moisture;
+        bool probeValid;
+        bool manualOverride;             // Opened by a remote command, the probe is ignored
+        String reason;                   // Of the last automatic decision
+        SignalMonitor monitor;           // Zones 2+; the app's AnomalyDetector checks zone 1
+        MoistureTrend trend;             // Wetting while the valve is open, drying otherwise
+    };
+
+private:
+    static_assert(Zones::COUNT >= 1 && Zones::COUNT <= Zones::MAX_ZONES, "Zones::TABLE needs 1 to MAX_ZONES rows");
+
+    std::array<Zone, Zones::COUNT> zones;
+    uint8_t nextToOpen;                  // Closed zones are offered capacity starting here
+    uint32_t capacityWaits;              // Decisions that held a due zone closed
+
+    template <size_t... I>
+    static std::array<Zone, Zones::COUNT> makeZones(std::index_sequence<I...>) {
+        return {{Zone{RelayController(Zones::TABLE[I].relayPin), SoilMoistureSensor(Zones::TABLE[I].soilPin),
+                      0, false, false, String(), SignalMonitor(&SoilMoistureSensor::Reading::LIMITS[0]),
+                      MoistureTrend()}...}};
+    }
+
+    uint8_t countOpen() const;
+    void updateTrend(Zone& zone, unsigned long now);
+    int findPreemptable() const;
+
+public:
+    ZoneController();
+
+    // Drives every relay to its persisted state; bit n of the masks is zone n+1
+    void begin(uint16_t openMask, uint16_t overrideMask, unsigned long stateAge);
+
+    // Reads the other zones' probes; zone 1 takes the pipeline's reading
+    void sample(int primaryMoisture, bool primaryValid);
+    void control(bool rainDetected, bool waterLow, const RuleEngine::Decision& rules);
+
+    // Rule engine inputs of every zone
+    void getRuleInputs(RuleEngine::ZoneInputs* inputs) const;
+
+    // Seconds until the first automatic zone is expected to need water; 0 while a valve
+    // is open or a zone's trend is unknown
+    float getQuietSeconds() const;
+
+    // Remote command for one zone (0-based). ON opens it in manual override,
+    // taking capacity from an automatic zone if needed; OFF closes it and
+    // returns it to automatic control. False if the command can't be applied.
+    bool command(uint8_t index, bool on, const String& reason);
+
+    // Every valve off at the pin, e.g. from the loop watchdog before a restart
+    void failSafe() const;
+    // Closes every zone and ends manual overrides, e.g. when the tank runs dry
+    void cutOff(const String& reason);
+    // Thresholds and dwell times of every zone, e.g. from the runtime configuration
+    void setPumpConfig(const PumpControlConfig& config);
+
+    static constexpr uint8_t count() { return Zones::COUNT; }
+    Zone& zone(uint8_t index) { return zones[index]; }
+    const Zone& zone(uint8_t index) const { return zones[index]; }
+
+    bool anyOpen() const { return getOpenMask() != 0; }
+    uint16_t getOpenMask() const;
+    uint16_t getOverrideMask() const;
+
+    void serialize(JsonDocument& doc) const;
+    void printStatus() const;
+};
+
+#endif
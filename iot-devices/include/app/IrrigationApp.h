@@ -0,0 +1,136 @@
+#ifndef IRRIGATION_APP_H
+#define IRRIGATION_APP_H
+
+#include <Arduino.h>
+#include "utils/SensorCalibration.h"
+#include "sensors/DHT11Sensor.h"
+#include "sensors/SoilMoistureSensor.h"
+#include "sensors/SoilTemperatureSensor.h"
+#include "sensors/RainSensor.h"
+#include "sensors/WaterLevelSensor.h"
+#include "sensors/SensorPipeline.h"
+#include "sensors/SamplingScheduler.h"
+#include "sensors/SensorRollup.h"
+#include "sensors/AnomalyDetector.h"
+#include "actuators/ZoneController.h"
+#include "actuators/DryRunGuard.h"
+#include "rules/RuleEngine.h"
+#include "actuators/ModemRelay.h"
+#include "display/OLEDDisplay.h"
+#include "network/MQTTClient.h"
+#include "network/RadioManager.h"
+#include "network/WiFiLink.h"
+#include "network/LeafLink.h"
+#include "network/LeafGateway.h"
+#include "ota/FirmwareUpdater.h"
+#include "app/RuntimeConfig.h"
+#include "storage/TimeSeriesStore.h"
+#include "storage/SnapshotBatch.h"
+#include "storage/ControlStateStore.h"
+#include "utils/MemoryDiagnostics.h"
+#include "utils/LoopWatchdog.h"
+#include "utils/SampleClock.h"
+#include "utils/EventBus.h"
+
+// Sensors fitted to this board; the read loop, snapshot and MQTT payload are generated from this list
+typedef SensorPipeline<DHT11Sensor, SoilMoistureSensor, SoilTemperatureSensor, RainSensor, WaterLevelSensor> BoardSensors;
+
+// Connection settings of one device (config.h on the board)
+struct DeviceConfig {
+    const char* wifiSsid;
+    const char* wifiPassword;
+    const char* mqttServer;
+    int mqttPort;
+    const char* mqttUser;
+    const char* mqttPassword;
+    const char* deviceId;
+    const char* sensorTopic;
+    const char* relayTopic;
+    const char* statusTopic;
+    const char* relayCommandTopic;
+};
+
+// Everything one irrigation controller owns: sensors, pump and modem relays,
+// display, local history and the MQTT link. The firmware runs a single
+// instance from main.cpp; the fleet simulator runs many in one process.
+// Sampling, the rain interrupt and the MQTT client post to the event bus;
+// control and display react to those events. Given a LeafLink, the
+// controller also acts as gateway for nearby leaf nodes (see LeafGateway).
+class IrrigationApp {
+private:
+    static const int64_t RAIN_EDGE_DEBOUNCE = 500000;   // µs; a wet sensor chatters while drops land
+
+    DeviceConfig config;
+    EventBus bus;
+    BoardSensors sensors;
+    SamplingScheduler<BoardSensors> scheduler;
+    SensorRollup<BoardSensors> rollup;
+    AnomalyDetector<BoardSensors> anomalies;
+    ZoneController zones;
+    DryRunGuard dryRun;
+    RuleEngine rules;
+    ControlStateStore controlStore;
+    ModemRelay modemRelay;
+    OLEDDisplay oled;
+    TimeSeriesStore history;
+    SnapshotBatch<BoardSensors> offlineBatch;
+    WiFiLink wifi;
+    MQTTClient mqttClient;
+    RadioManager radio;
+    FirmwareUpdater ota;
+    RuntimeConfig settings;          // Backend-tuned thresholds and intervals (sf/<id>/config)
+    MemoryDiagnostics memory;
+    LoopWatchdog watchdog;
+    SampleClock clock;
+    LeafLink* leafLink;
+    LeafGateway* gateway;            // Created in setup() when a leaf link is set
+    uint16_t leafCapacity;
+
+    uint32_t lastCommandId;          // Last remote relay command applied
+    RelayCommand pendingCommand;     // Waits for valid readings before it is applied
+    bool commandPending;
+    volatile int64_t lastRainEdge;   // Set by the rain interrupt
+    bool sensorDataValid;
+    unsigned long lastSummaryPrint;
+    unsigned long lastDataSent;
+    unsigned long sendInterval;      // From settings
+    unsigned long summaryInterval;
+    uint32_t oversizedPayloads;      // Sensor publishes over the MQTT packet size
+
+    static void onControlEvent(void* context, const Event& event);
+    static void onDisplayEvent(void* context, const Event& event);
+    static void onGatewayEvent(void* context, const Event& event);
+    static void onRainEdge(void* arg);
+    static void onLoopStall(void* context);
+    static void onDryRunCut(void* context);
+    
+    void restoreControlState();
+    void saveControlState();
+    void initializeComponents();
+    void printSensorSummary();
+    void controlPump();
+    void sampleZones();
+    void beginRules();
+    void beginSettings();
+    void applySettings(unsigned long now);
+    void updateSettings(const String& json);
+    void evaluateRules(RuleEngine::Decision& decision);
+    void updateDisplay();
+    void sendDataToMQTT();
+    void sendMetricsToMQTT();
+    void testSensors();
+
+public:
+    explicit IrrigationApp(const DeviceConfig& config);
+    ~IrrigationApp();
+    void setLeafLink(LeafLink* link, uint16_t capacity = Gateway::MAX_LEAVES);  // Before setup(); keeps the radio on
+    void setup();
+    void loop();
+    void idle();        // Sleeps until the next sample is due, at most Timing::LOOP_PERIOD (Gateway::POLL_PERIOD as gateway)
+
+    MQTTClient& getMqttClient();
+    RadioManager& getRadio();
+    const ZoneController& getZones() const;
+};
+
+#endif
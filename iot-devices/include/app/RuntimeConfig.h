@@ -0,0 +1,82 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "actuators/RelayController.h"
+#include "actuators/DryRunGuard.h"
+#include "utils/SensorCalibration.h"
+
+// Settings the backend tunes without a reflash, from a versioned JSON document
+// on the retained topic sf/<id>/config, e.g.
+//   {"version":7,"sendInterval":900000,"commandPoll":600000,
+//    "pump":{"on":12,"off":25,"minOff":300000},
+//    "dryRun":{"trip":25,"reset":40,"samples":3},
+//    "waterLevel":{"low":350,"medium":400},
+//    "sampling":{"SoilMoisture":{"base":5000,"min":1000,"max":120000,"perHour":1800}}}
+// Times are in ms, sensors go by their NAME. Every field is optional and falls
+// back to its compile-time default, so the settings in force are always the
+// defaults plus the latest document. A document is parsed and checked as a whole; an unknown key, a
+// value out of range or inconsistent limits reject all of it and the active
+// settings stay. An accepted document is kept in NVS and parsed again on boot.
+// Versions only go up: the retained copy the broker sends on every connect is
+// acknowledged once per boot, not applied again.
+class RuntimeConfig {
+public:
+    static const uint8_t MAX_SENSORS = 8;
+
+    struct Settings {
+        uint32_t version;                        // 0 = compile-time defaults
+        unsigned long sendInterval;              // Upload period
+        unsigned long commandPollInterval;       // Radio wake-up for held commands between uploads
+        unsigned long summaryInterval;           // Serial sensor summary
+        PumpControlConfig pump;                  // Every zone
+        DryRunConfig dryRun;
+        int waterLow;                            // Raw water level thresholds of the Low/Medium/High status
+        int waterMedium;
+        SamplingPolicy sampling[MAX_SENSORS];    // In sampling order
+    };
+
+    enum Outcome : uint8_t {
+        APPLIED,                     // New settings in force
+        CURRENT,                     // Same version as the active one
+        IGNORED,                     // Redelivered, already acknowledged
+        REJECTED
+    };
+
+private:
+    static constexpr const char* NVS_NAMESPACE = "config";
+    static constexpr const char* NVS_KEY = "document";
+
+    const char* sensorNames[MAX_SENSORS];
+    const SamplingPolicy* sensorDefaults[MAX_SENSORS];
+    uint8_t sensorCount;
+
+    Settings active;
+    bool acknowledged;               // The active version was reported since boot
+    uint32_t rejectedUpdates;
+    uint32_t rejectedHash;           // Of the last document rejected, so its redeliveries are not reported again
+    String lastError;
+
+    void setDefaults(Settings& settings) const;
+    bool parse(const String& json, Settings& candidate, String& error) const;
+    bool saveDocument(const String& json) const;
+
+public:
+    RuntimeConfig();
+
+    // Sensor names and default policies in sampling order; then applies the stored document
+    void begin(const char* const* names, const SamplingPolicy* const* defaults, uint8_t count);
+
+    // Checks a received document and, if it is newer and valid, makes it the active settings.
+    // report gets the acknowledgement for sf/<id>/config/status (left empty for IGNORED).
+    Outcome update(const String& json, JsonDocument& report);
+
+    const Settings& get() const { return active; }
+    uint32_t getVersion() const { return active.version; }
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
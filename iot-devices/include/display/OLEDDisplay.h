@@ -21,7 +21,7 @@ public:
     bool begin();
     void showStartupMessage();
     void updateSensorData(float temp, float humidity, int soilMoisture, float soilTemp,
-                         String waterLevel, bool rain, bool pumpActive, bool wifiConnected);
+                         String waterLevel, String rain, bool pumpActive, bool wifiConnected);
     void clearDisplay();
     void displayError(const String& errorMessage);
 };
@@ -0,0 +1,53 @@
+#ifndef ESP_NOW_LINK_H
+#define ESP_NOW_LINK_H
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <freertos/FreeRTOS.h>
+#include "network/LeafLink.h"
+
+// LeafLink over ESP-NOW on the station interface, so frames go out on the
+// channel of the access point the gateway is joined to. Received frames are
+// queued by the WiFi task's callback and taken by receive() in the loop task.
+// ESP-NOW keeps at most 20 unencrypted peers, so senders are registered on
+// demand and the least recently added peer makes room for a new one.
+class EspNowLink : public LeafLink {
+private:
+    static const uint8_t RECEIVE_QUEUE = 16;
+    static const uint8_t MAX_PEERS = 16;
+
+    static EspNowLink* instance;                 // The receive callback has no argument
+    static portMUX_TYPE receiveLock;
+
+    Frame queue[RECEIVE_QUEUE];
+    uint8_t queueHead;
+    uint8_t queueCount;
+    volatile uint32_t dropped;
+
+    uint8_t peers[MAX_PEERS][ADDRESS_LENGTH];
+    uint8_t peerCount;
+    uint8_t nextEviction;
+    uint8_t ownAddress[ADDRESS_LENGTH];
+    uint32_t sendFailures;
+
+#if defined(ESP_IDF_VERSION_MAJOR) && ESP_IDF_VERSION_MAJOR >= 5
+    static void onReceive(const esp_now_recv_info_t* info, const uint8_t* data, int length);
+#else
+    static void onReceive(const uint8_t* mac, const uint8_t* data, int length);
+#endif
+    void enqueue(const uint8_t* mac, const uint8_t* data, int length);
+    bool ensurePeer(const uint8_t* peer);
+
+public:
+    EspNowLink();
+
+    // WiFi must be started in station mode first
+    bool begin() override;
+    bool send(const uint8_t* peer, const uint8_t* data, size_t length) override;
+    bool receive(Frame& frame) override;
+    const uint8_t* address() const override { return ownAddress; }
+    uint32_t getDropped() const override { return dropped; }
+    uint32_t getSendFailures() const { return sendFailures; }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef LEAF_GATEWAY_H
+#define LEAF_GATEWAY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "network/LeafLink.h"
+#include "network/LeafProtocol.h"
+#include "network/MQTTClient.h"
+#include "utils/SensorCalibration.h"
+
+// Gateway role: leaf nodes without WiFi report over a LeafLink, and this
+// device uplinks their reports through its own MQTT session, many per
+// message on sf/<id>/leaves (format in LeafProtocol.h). Relay commands
+// for a leaf arrive on sf/<id>/leaves/command and are handed to the leaf
+// in the ACK to its next report, until it confirms them.
+class LeafGateway {
+private:
+    struct Leaf {
+        uint8_t address[LeafLink::ADDRESS_LENGTH];
+        uint16_t lastSequence;
+        unsigned long lastSeen;      // millis() of the last report
+        uint32_t reports;
+        RelayCommand command;        // Pending while command.id != 0
+        bool reported;               // Sent at least one report; a command can name a leaf that hasn't yet
+    };
+
+    LeafLink& link;
+    MQTTClient& mqtt;
+
+    Leaf* leaves;
+    uint16_t capacity;
+    uint16_t leafCount;
+
+    uint8_t batch[Gateway::BATCH_BYTES];
+    size_t batchLength;
+    uint16_t batchRecords;
+    unsigned long batchStartedAt;
+    uint32_t batchBaseTime;
+    unsigned long lastFlushAttempt;  // Offline retries are spaced a quarter interval apart
+
+    uint32_t nextCommandId;
+
+    // Since the last serialize()
+    uint32_t framesReceived;
+    uint32_t framesRejected;         // Malformed, or from a leaf that didn't fit the table
+    uint32_t duplicates;             // Retransmitted reports, acknowledged again but not uplinked
+    uint32_t recordsDeferred;        // Reports left unacknowledged (to be resent) while the batch was full
+    uint32_t batchesSent;
+    uint32_t bytesUplinked;
+    uint32_t commandsRelayed;
+    uint32_t commandsConfirmed;
+    uint32_t maxLoopMicros;
+
+    Leaf* find(const uint8_t* address, bool create);
+    void handleReport(const LeafLink::Frame& frame, unsigned long now);
+    void acknowledge(const Leaf& leaf, uint16_t sequence);
+    bool append(const LeafLink::Frame& frame, unsigned long now);
+    bool flush(unsigned long now);
+
+public:
+    LeafGateway(LeafLink& link, MQTTClient& mqtt, uint16_t capacity);
+    ~LeafGateway();
+    LeafGateway(const LeafGateway&) = delete;
+    LeafGateway& operator=(const LeafGateway&) = delete;
+
+    bool begin();
+    void loop(unsigned long now);    // Handles received frames and uplinks the batch when it is due
+
+    bool queueCommand(const uint8_t* leaf, const RelayCommand& command);
+
+    uint16_t getLeafCount() const { return leafCount; }
+
+    void serialize(JsonDocument& doc);
+    void printDebugInfo() const;
+};
+
+#endif
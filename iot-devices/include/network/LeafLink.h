@@ -0,0 +1,30 @@
+#ifndef LEAF_LINK_H
+#define LEAF_LINK_H
+
+#include <Arduino.h>
+
+// Datagram link between a gateway and its leaf nodes: ESP-NOW on the board
+// (EspNowLink), UDP on the host (tools/gateway_bench). Frames are small and
+// unreliable; LeafProtocol adds acknowledgements on top.
+class LeafLink {
+public:
+    static const size_t ADDRESS_LENGTH = 6;
+    static const size_t MAX_FRAME = 250;         // ESP-NOW payload limit
+
+    struct Frame {
+        uint8_t peer[ADDRESS_LENGTH];
+        uint8_t length;
+        uint8_t data[MAX_FRAME];
+    };
+
+    virtual ~LeafLink() {}
+
+    virtual bool begin() = 0;
+    virtual bool send(const uint8_t* peer, const uint8_t* data, size_t length) = 0;
+    virtual bool receive(Frame& frame) = 0;      // Next received frame; false when none is waiting
+    virtual const uint8_t* address() const = 0;
+
+    virtual uint32_t getDropped() const = 0;     // Received frames lost to a full receive queue
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LEAF_NODE_H
+#define LEAF_NODE_H
+
+#include <Arduino.h>
+#include "network/LeafLink.h"
+#include "network/LeafProtocol.h"
+#include "utils/EventBus.h"
+
+// Leaf side of the gateway protocol: sends a report to the gateway, waits
+// briefly for its ACK and resends the same report (same sequence) if none
+// comes. A relay command carried by the ACK is returned by poll() once; the
+// caller reports it back through commandApplied(), and the next report tells
+// the gateway to stop resending it. Between reports the leaf can sleep with
+// its radio off.
+class LeafNode {
+private:
+    static const unsigned long ACK_TIMEOUT = 100;    // ms; the gateway answers from its loop task
+    static const uint8_t MAX_ATTEMPTS = 3;
+
+    LeafLink& link;
+    uint8_t gateway[LeafLink::ADDRESS_LENGTH];
+
+    LeafProtocol::Report pending;
+    size_t pendingLength;
+    bool awaitingAck;
+    uint8_t attempts;
+    unsigned long sentAt;
+    uint16_t sequence;
+
+    uint32_t appliedCommand;         // Echoed in every report
+    uint32_t deliveredCommand;       // Last command returned by poll(), so resends aren't applied twice
+
+    uint32_t reportsSent;
+    uint32_t retries;
+    uint32_t reportsAcked;
+    uint32_t reportsLost;            // No ACK after MAX_ATTEMPTS, or replaced by a newer report
+
+    void transmit(unsigned long now);
+
+public:
+    LeafNode(LeafLink& link, const uint8_t* gatewayAddress);
+
+    bool begin() { return link.begin(); }
+
+    // Fields are in the units of the snapshot; NaN marks a missing reading
+    bool report(const float* fields, uint8_t count, uint16_t layout, uint16_t relayMask, unsigned long now);
+
+    // Handles the ACK and retries; true when a new command arrived
+    bool poll(unsigned long now, RelayCommand& command);
+    void commandApplied(uint32_t id) { appliedCommand = id; }
+
+    bool isIdle() const { return !awaitingAck; }     // Nothing in flight, the radio may sleep
+    uint16_t getSequence() const { return sequence; }  // Of the last report
+
+    uint32_t getReportsSent() const { return reportsSent; }
+    uint32_t getRetries() const { return retries; }
+    uint32_t getReportsAcked() const { return reportsAcked; }
+    uint32_t getReportsLost() const { return reportsLost; }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LEAF_PROTOCOL_H
+#define LEAF_PROTOCOL_H
+
+#include <Arduino.h>
+#include "utils/Fnv1a.h"
+
+// Frames between leaf nodes and their gateway (see LeafGateway, LeafNode).
+//
+// A leaf sends a REPORT with its snapshot fields in tenths (int16, so 23.4 °C
+// is 234). The gateway answers every REPORT with an ACK carrying the
+// sequence number, and a pending relay command if there is one. Leaves only
+// listen right after a report, so commands ride on the ACK. The leaf echoes
+// the last command it applied in its next REPORT; until then the gateway
+// keeps resending it.
+//
+// The gateway forwards REPORT frames verbatim to MQTT, many per message:
+//   batch:  magic 0x4C, version, record count (u16), base time (u32, Unix s, 0 if unknown)
+//   record: leaf address (6), seconds after the base time (u16), frame length (u8), frame
+// All integers are little-endian.
+namespace LeafProtocol {
+    const uint8_t MAGIC = 0xF1;
+    const uint8_t BATCH_MAGIC = 0x4C;
+    const uint8_t BATCH_VERSION = 1;
+    const uint8_t MAX_FIELDS = 16;
+    const int16_t FIELD_MISSING = INT16_MIN;     // NaN or an invalid reading
+
+    enum FrameType : uint8_t {
+        FRAME_REPORT = 1,
+        FRAME_ACK = 2
+    };
+
+    enum AckFlags : uint8_t {
+        ACK_HAS_COMMAND = 0x01
+    };
+
+    struct __attribute__((packed)) Header {
+        uint8_t magic;
+        uint8_t type;
+        uint16_t sequence;
+    };
+
+    struct __attribute__((packed)) Report {
+        Header header;
+        uint32_t appliedCommand;     // Last relay command the leaf applied, 0 = none
+        uint16_t relayMask;          // Zones with the valve open
+        uint16_t layout;             // Hash of the field names, so the backend can tell boards apart
+        uint8_t fieldCount;
+        int16_t fields[MAX_FIELDS];  // Only fieldCount are sent
+    };
+
+    struct __attribute__((packed)) Ack {
+        Header header;               // Sequence of the REPORT acknowledged
+        uint8_t flags;
+        uint32_t commandId;
+        uint8_t zone;                // 0-based
+        uint8_t status;
+    };
+
+    struct __attribute__((packed)) BatchHeader {
+        uint8_t magic;
+        uint8_t version;
+        uint16_t recordCount;
+        uint32_t baseTime;
+    };
+
+    struct __attribute__((packed)) RecordHeader {
+        uint8_t address[6];
+        uint16_t offset;
+        uint8_t length;
+    };
+
+    inline size_t reportLength(uint8_t fieldCount) {
+        return offsetof(Report, fields) + fieldCount * sizeof(int16_t);
+    }
+
+    inline int16_t encodeField(float value) {
+        if (isnan(value) || value > 3276.7f || value < -3276.7f) return FIELD_MISSING;
+        return static_cast<int16_t>(lroundf(value * 10.0f));
+    }
+
+    inline float decodeField(int16_t value) {
+        return value == FIELD_MISSING ? NAN : value / 10.0f;
+    }
+
+    // FNV-1a over the field names, folded to 16 bits
+    inline uint16_t layoutOf(const char* const* names, uint8_t count) {
+        uint32_t hash = Fnv1a::hashNames(names, count);
+        return static_cast<uint16_t>(hash ^ (hash >> 16));
+    }
+}
+
+#endif
@@ -4,10 +4,18 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
-#include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include "network/OutboundQueue.h"
+#include "network/MQTTTransport.h"
+#include "network/WiFiLink.h"
+#include "utils/EventBus.h"
+
+class FirmwareUpdater;
 
 class MQTTClient {
+public:
+    typedef OutboundQueue::MessageId MessageId;     // 0 = not queued
+
 private:
     const char* mqttServer;
     int mqttPort;
@@ -19,33 +27,90 @@ private:
     const char* relayLogTopic;
     const char* statusTopic;
     const char* relayCommandTopic;
+    String calibrationTopic;
+    String rulesTopic;
+    String batchTopic;
+    String leafBatchTopic;
+    String leafCommandTopic;
+    String otaTopic;
+    String otaDataTopic;
+    String otaRequestTopic;
+    String otaStatusTopic;
+    String configTopic;
+    String configStatusTopic;
+    String metricsTopic;
+    bool gatewayEnabled;
+    
+    String clientId;
     
     WiFiClientSecure wifiClientSecure;
-    PubSubClient mqttClient;
+    OutboundQueue outbox;
+    MQTTTransport transport;
+    
+    // Commands, rule sets, configuration and connectivity changes are posted here
+    EventBus* bus;
+    
+    // Last rule set received; RULES_UPDATE events point at it
+    String rulesUpdate;
+    // Last configuration document received; CONFIG_UPDATE events point at it
+    String configUpdate;
+    
+    // Firmware offers and data chunks go straight to the updater
+    FirmwareUpdater* updater;
     
     unsigned long lastReconnectAttempt;
     bool isConnectedFlag;
+    bool autoReconnect;
     static const unsigned long RECONNECT_INTERVAL = 5000;
-    static const int MAX_WIFI_ATTEMPTS = 20;
+    static const unsigned long CONNECT_WAIT = 10000;   // Setup blocks this long for the CONNACK
+    static const uint8_t INFLIGHT_WINDOW = 4;          // QoS 1 publishes awaiting PUBACK at once
+    static const bool CLEAN_SESSION = false;           // Broker keeps subscriptions and queued commands while offline
+    static const uint16_t KEEP_ALIVE = 60;
+    static constexpr const char* OUTBOX_PATH = "/mqtt_outbox.bin";
     
     bool loadCertificates();
+    bool startConnect();
+    void handleConnected(bool sessionPresent);
+    void setConnected(bool connected);
     void handleMessage(char* topic, byte* payload, unsigned int length);
+    void handleCalibrationCommand(const String& message);
+    void handleLeafCommand(const String& message);
 
 public:
     MQTTClient(const char* server, int port, const char* user, const char* password, 
                const char* deviceId, const char* sensorTopic, const char* relayTopic, 
                const char* statusTopic, const char* relayCommandTopic);
     
-    bool connectWiFi(const char* ssid, const char* password);
+    bool begin();       // Mounts SPIFFS and restores unacknowledged messages
+    void setEventBus(EventBus& eventBus) { bus = &eventBus; }
+    void setFirmwareUpdater(FirmwareUpdater& firmwareUpdater) { updater = &firmwareUpdater; }
+    void enableGateway();     // Subscribes to commands for leaf nodes, which are posted as LEAF_COMMAND
+    bool connectWiFi(WiFiLink& wifi);     // Waits for a join started with wifi.connect()
     bool connectMQTT();
     void loop();
     void disconnect();
+    void suspend();     // Closes the session without an "offline" status, for radio power-down
+    void setAutoReconnect(bool enabled);
     bool isConnected();
     void printConnectionInfo();
     
-    bool publishSensorData(float temp, float humidity, int soilMoisture, float soilTemp, bool rain, String waterLevel);
-    bool publishRelayLog(bool relayStatus, String reason);
-    bool publishStatus(String status);
+    // Publishes are queued and sent from loop(); a returned id stays pending until the
+    // broker acknowledges it. Sensor data, batches and status are only queued while
+    // connected, so the caller keeps buffering offline; relay logs are always queued.
+    MessageId publishSensorData(const JsonDocument& doc);
+    size_t getSensorDataLimit() const { return MQTTTransport::maxPayload(sensorDataTopic, 1); }
+    // Device diagnostics (memory, radio, ...) on sf/<id>/metrics, apart from the sensor data
+    MessageId publishMetrics(const JsonDocument& doc);
+    MessageId publishSensorBatch(const uint8_t* data, size_t length);
+    MessageId publishLeafBatch(const uint8_t* data, size_t length);
+    MessageId publishRelayLog(uint8_t zone, bool relayStatus, String reason);
+    MessageId publishStatus(String status);
+    MessageId publishOtaRequest(uint32_t offset, uint32_t length);     // Only while connected
+    MessageId publishOtaStatus(const JsonDocument& doc);               // Queued even while offline
+    MessageId publishConfigStatus(const JsonDocument& doc);            // Queued even while offline
+    bool isPending(MessageId id) { return transport.isPending(id); }
+    bool hasPendingMessages() const { return outbox.size() > 0; }
+    void printQueueInfo() const { outbox.printDebugInfo(); }
 };
 
 #endif
\ No newline at end of file
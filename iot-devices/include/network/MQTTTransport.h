@@ -0,0 +1,141 @@
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <functional>
+#include "network/OutboundQueue.h"
+
+// Non-blocking MQTT 3.1.1 client for the cooperative main loop. publish()
+// only queues the message and returns a handle; loop() reads whatever the
+// socket has, writes queued messages while fewer than the inflight window
+// of QoS 1 publishes are waiting for their PUBACK, and keeps the session
+// alive. Unacknowledged QoS 1 messages stay in the OutboundQueue across
+// reconnects (and reboots) and are resent with DUP set, so with a persistent
+// session (cleanSession = false) nothing is lost while the link is down.
+class MQTTTransport {
+public:
+    typedef OutboundQueue::MessageId MessageId;
+    typedef std::function<void(char* topic, uint8_t* payload, unsigned int length)> MessageCallback;
+    typedef std::function<void(bool sessionPresent)> ConnectCallback;
+    typedef std::function<void(MessageId id)> DeliveryCallback;
+
+    // Same codes as PubSubClient::state()
+    enum State : int8_t {
+        CONNECTION_TIMEOUT = -4,
+        CONNECTION_LOST = -3,
+        CONNECT_FAILED = -2,
+        DISCONNECTED = -1,
+        CONNECTED = 0,
+        BAD_PROTOCOL = 1,
+        BAD_CLIENT_ID = 2,
+        UNAVAILABLE = 3,
+        BAD_CREDENTIALS = 4,
+        UNAUTHORIZED = 5
+    };
+
+    static const size_t MAX_PACKET_SIZE = 1536;
+
+private:
+    static const uint8_t MAX_SUBSCRIPTIONS = 7;
+    static const uint8_t MAX_SENDS_PER_LOOP = 8;
+    static const size_t HEADER_RESERVE = 5;                  // Fixed header with the longest remaining length
+    static const unsigned long CONNACK_TIMEOUT = 10000;
+    static const unsigned long ACK_TIMEOUT = 20000;          // PUBACK overdue: assume a half-open connection
+    static const unsigned long PERSIST_DELAY = 1000;         // Journal QoS 1 messages still queued after this
+
+    enum RxState : uint8_t {
+        RX_HEADER,
+        RX_LENGTH,
+        RX_BODY,
+        RX_DISCARD                   // Packet larger than the buffer
+    };
+
+    struct Subscription {
+        const char* topic;
+        uint8_t qos;
+    };
+
+    Client& client;
+    OutboundQueue& queue;
+
+    const char* host;
+    uint16_t port;
+    const char* clientId;
+    const char* user;
+    const char* password;
+    bool cleanSession;
+    uint16_t keepAlive;              // Seconds
+    uint8_t inflightWindow;
+
+    State state;
+    bool awaitingConnack;
+    unsigned long connectStartedAt;
+    unsigned long lastOutbound;
+    unsigned long lastInbound;
+    bool pingOutstanding;
+    uint16_t nextPacketId;
+    uint8_t inflight;
+
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    uint8_t subscriptionCount;
+
+    MessageCallback messageCallback;
+    ConnectCallback connectCallback;
+    DeliveryCallback deliveryCallback;
+
+    RxState rxState;
+    uint8_t rxHeader;
+    uint32_t rxLength;
+    uint32_t rxMultiplier;
+    uint32_t rxReceived;
+    uint8_t rxBuffer[MAX_PACKET_SIZE];
+    uint8_t txBuffer[HEADER_RESERVE + MAX_PACKET_SIZE];
+
+    uint16_t takePacketId();
+    bool sendPacket(uint8_t header, size_t bodyLength);
+    bool sendPublish(OutboundQueue::Entry* entry);
+    bool sendSubscribe(const Subscription& subscription);
+    bool sendPendingMessages(unsigned long now);
+    bool readPackets(unsigned long now);
+    void handlePacket();
+    void handleConnack();
+    void handlePublish();
+    void handlePuback();
+    void connectionLost(State reason);
+
+public:
+    MQTTTransport(Client& client, OutboundQueue& queue);
+
+    void setServer(const char* host, uint16_t port);
+    void setCredentials(const char* clientId, const char* user, const char* password);
+    void setSession(bool cleanSession, uint16_t keepAliveSeconds);
+    void setInflightWindow(uint8_t window);
+    void setMessageCallback(MessageCallback callback) { messageCallback = callback; }
+    void setConnectCallback(ConnectCallback callback) { connectCallback = callback; }
+    void setDeliveryCallback(DeliveryCallback callback) { deliveryCallback = callback; }
+
+    // Opens the socket and sends CONNECT; the CONNACK is handled by loop()
+    bool connect();
+    void disconnect();
+    void loop();
+
+    bool connected();
+    bool connecting() const { return awaitingConnack; }
+    State getState() const { return state; }
+
+    // Queues the message; returns 0 if it is too large or the queue is full.
+    // Subscriptions are kept (the topic must stay valid) and renewed on every connect.
+    MessageId publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain);
+    // Largest payload publish() takes for a topic: what is left of the packet buffer
+    static size_t maxPayload(const char* topic, uint8_t qos) {
+        size_t overhead = 2 + strlen(topic) + (qos > 0 ? 2 : 0);
+        return overhead < MAX_PACKET_SIZE ? MAX_PACKET_SIZE - overhead : 0;
+    }
+    bool subscribe(const char* topic, uint8_t qos);
+
+    bool isPending(MessageId id) { return queue.find(id) != nullptr; }
+    uint8_t getInflight() const { return inflight; }
+};
+
+#endif
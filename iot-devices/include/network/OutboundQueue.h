@@ -0,0 +1,102 @@
+#ifndef OUTBOUND_QUEUE_H
+#define OUTBOUND_QUEUE_H
+
+#include <Arduino.h>
+
+// FIFO of MQTT messages waiting to be written or acknowledged, kept in a
+// fixed RAM arena. QoS 1 messages are also journaled to SPIFFS once they have
+// waited a moment (or the connection drops), so they survive a reboot; the
+// delay keeps the common case of a quick PUBACK off the flash entirely.
+// Compaction writes the live entries to a temporary file that only replaces
+// the journal once complete, so a reset while compacting loses nothing.
+class OutboundQueue {
+public:
+    typedef uint32_t MessageId;      // 0 = not queued
+
+    enum EntryFlags : uint8_t {
+        FLAG_RETAIN = 0x01,
+        FLAG_SENT = 0x02,            // Written to the current connection (QoS 1: waiting for PUBACK)
+        FLAG_DUP = 0x04,             // Sent on an earlier connection, resend with DUP set
+        FLAG_JOURNALED = 0x08
+    };
+
+    // Stored in the arena, followed by the NUL-terminated topic and the payload
+    struct Entry {
+        MessageId id;
+        uint32_t queuedAt;           // millis()
+        uint32_t sentAt;
+        uint16_t packetId;
+        uint16_t topicLength;
+        uint16_t payloadLength;
+        uint8_t qos;
+        uint8_t flags;
+
+        const char* topic() const { return reinterpret_cast<const char*>(this + 1); }
+        const uint8_t* payload() const { return reinterpret_cast<const uint8_t*>(this + 1) + topicLength + 1; }
+    };
+
+    static const size_t CAPACITY = 8192;
+
+private:
+    static const uint32_t JOURNAL_COMPACT_BYTES = 16384;
+
+    // Journal record: an ADD carries the message, a DONE only its id
+    struct JournalHeader {
+        uint8_t type;
+        uint8_t qos;
+        uint8_t flags;
+        uint8_t crc;
+        MessageId id;
+        uint16_t topicLength;
+        uint16_t payloadLength;
+    };
+
+    enum JournalType : uint8_t {
+        JOURNAL_ADD = 0xA1,
+        JOURNAL_DONE = 0xD1
+    };
+
+    alignas(4) uint8_t arena[CAPACITY];
+    size_t used;
+    size_t count;
+    MessageId nextId;
+    uint32_t droppedMessages;
+
+    const char* journalPath;
+    char compactPath[32];            // journalPath + ".tmp"
+    uint32_t journalBytes;
+    uint16_t journalLive;            // Journaled entries still in the queue
+
+    static size_t entrySize(size_t topicLength, size_t payloadLength);
+    static uint8_t computeCrc(const JournalHeader& header, const char* topic, const uint8_t* payload);
+
+    static JournalHeader addRecord(const Entry* entry);
+    static size_t appendRecord(const char* path, const JournalHeader& header, const char* topic,
+                               const uint8_t* payload);
+    bool writeJournal(const JournalHeader& header, const char* topic, const uint8_t* payload);
+    void loadJournal(const char* path);
+    void compactJournal();
+
+public:
+    OutboundQueue();
+    bool begin(const char* journalPath);     // SPIFFS must be mounted; reloads unacknowledged messages
+
+    // Returns 0 when the message doesn't fit
+    MessageId push(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain);
+    Entry* remove(Entry* entry);             // Returns the entry that moved into its place, if any
+
+    Entry* first();
+    Entry* next(Entry* entry);
+    Entry* find(MessageId id);
+    Entry* findPacket(uint16_t packetId);
+
+    void persist(Entry* entry);
+    void persistOlderThan(unsigned long now, unsigned long age);
+
+    size_t size() const { return count; }
+    size_t bytesUsed() const { return used; }
+    uint32_t getDroppedMessages() const { return droppedMessages; }
+    void printDebugInfo() const;
+};
+
+#endif
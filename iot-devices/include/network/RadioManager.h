@@ -0,0 +1,83 @@
+#ifndef RADIO_MANAGER_H
+#define RADIO_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "actuators/ModemRelay.h"
+#include "network/MQTTClient.h"
+#include "network/WiFiLink.h"
+
+// Powers the modem (through ModemRelay) and the WiFi station only around
+// scheduled uploads and periodic command polls. Power-up starts early by the
+// measured modem boot/association and MQTT connect times, so the link is up
+// when the upload is due; the window closes once the outbound queue is empty
+// and held commands had time to arrive. Radio-on time is accounted per day.
+class RadioManager {
+private:
+    enum State : uint8_t {
+        RADIO_OFF,
+        RADIO_ASSOCIATING,           // Modem booting, station joining its access point
+        RADIO_CONNECTING,            // Waiting for the MQTT CONNACK
+        RADIO_ONLINE
+    };
+
+    ModemRelay& modem;
+    WiFiLink& wifi;
+    MQTTClient& mqtt;
+
+    State state;
+    bool dutyCycling;
+    bool holdAwake;
+    bool measuring;                  // Current warm-up started from power-up, so its phases are timed
+    unsigned long poweredAt;
+    unsigned long associatedAt;
+    unsigned long onlineAt;
+    unsigned long phaseStartedAt;    // For the association and connect timeouts
+    unsigned long nextUpload;
+    unsigned long nextPoll;
+    unsigned long pollInterval;
+
+    // Warm-up estimates (ms), smoothed over recent windows
+    uint32_t associateEstimate;
+    uint32_t connectEstimate;
+
+    // Radio-on accounting per local day
+    long accountedDay;
+    unsigned long accountedAt;
+    uint32_t onMsToday;
+    uint32_t onMsYesterday;
+    uint16_t windowsToday;
+    uint16_t failedWindowsToday;
+
+    static long currentDay(unsigned long now);
+    static uint32_t smooth(uint32_t estimate, uint32_t sample);
+
+    bool wantsWindow(unsigned long now) const;
+    bool windowDone(unsigned long now) const;
+    void powerUp(unsigned long now);
+    void powerDown(unsigned long now, bool failed);
+    void account(unsigned long now);
+
+public:
+    RadioManager(ModemRelay& modem, WiFiLink& wifi, MQTTClient& mqtt);
+
+    // The modem is already on and setup() connected (or tried to); duty cycling starts from here
+    void begin(unsigned long now);
+    void loop(unsigned long now);
+
+    void scheduleUpload(unsigned long dueAt) { nextUpload = dueAt; }
+    void setHoldAwake(bool hold) { holdAwake = hold; }
+    void setDutyCycling(bool enabled) { dutyCycling = enabled; }
+    // A shorter interval brings the next poll forward; a longer one applies after it
+    void setCommandPollInterval(unsigned long interval, unsigned long now);
+
+    bool isOnline() const { return state == RADIO_ONLINE; }
+    bool isWarmingUp() const { return state == RADIO_ASSOCIATING || state == RADIO_CONNECTING; }
+    unsigned long getWarmupLead() const;
+    uint32_t getOnMsToday() const { return onMsToday; }
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Station join that skips the scan and DHCP when it can. The BSSID, channel
+// and address of the last successful join are kept in NVS (they survive
+// brownout resets, unlike RTC memory); the next join goes straight to that
+// access point with the cached address, and falls back to a full scan with
+// DHCP if it isn't associated within WiFiPolicy::FAST_JOIN_TIMEOUT.
+class WiFiLink {
+private:
+    struct CachedNetwork {
+        uint8_t version;
+        uint8_t channel;
+        uint8_t bssid[6];
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t leasedAt;           // Unix time the address came from DHCP, 0 if unknown
+    };
+
+    enum JoinState : uint8_t {
+        JOIN_IDLE,
+        JOIN_FAST,                   // Cached access point, no scan
+        JOIN_SCAN,                   // Full scan and DHCP
+        JOIN_DONE
+    };
+
+    static constexpr const char* NVS_NAMESPACE = "wifi";
+    static constexpr const char* NVS_KEY = "cache";
+    static const uint8_t STORAGE_VERSION = 1;
+
+    const char* ssid;
+    const char* password;
+
+    CachedNetwork cache;
+    bool cacheValid;
+    bool addressReused;
+
+    JoinState joinState;
+    unsigned long joinStartedAt;
+    unsigned long fastWindow;        // Time the cached access point gets before falling back to a scan
+
+    // Join timings, from connect() to association
+    uint32_t lastJoinMs;
+    bool lastJoinFast;
+    uint16_t fastJoins;
+    uint16_t scanJoins;
+    uint16_t fastMisses;
+    uint32_t fastJoinTotalMs;
+    uint32_t scanJoinTotalMs;
+
+    bool loadCache();
+    void saveCache();
+    void useDhcp();
+    void startScan();
+    void joined(unsigned long now);
+
+public:
+    WiFiLink();
+
+    // Loads the cached network; call before the first connect()
+    void begin(const char* ssid, const char* password);
+
+    // Starts a join without waiting; poll() drives it and reports association.
+    // apBootTime extends the cached access point's window while the modem hotspot boots.
+    void connect(unsigned long now, unsigned long apBootTime = 0);
+    bool poll(unsigned long now);
+    void disconnect();
+    bool isConnected() const;
+    void forgetAddress();            // Next join renews the lease through DHCP
+
+    uint32_t getLastJoinMs() const { return lastJoinMs; }
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
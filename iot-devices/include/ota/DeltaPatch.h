@@ -0,0 +1,97 @@
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming decoder of the "SFD1" firmware delta, which describes the new
+// image as copies from the running image and inserted bytes:
+//   "SFD1" varint(imageSize) { 0x01 varint(sourceOffset) varint(length)     copy
+//                            | 0x02 varint(length) bytes[length] }          insert
+//   0x00                                                                    end
+// Varints are unsigned LEB128. A full image goes through the same decoder as
+// one insert without framing. Input is fed in chunks of any size. Output goes
+// to the Sink in pieces that never cross Sink::room(), and the State is
+// advanced before each piece is written, so when the sink flushes a sector
+// the State describes exactly the output flushed and can be checkpointed.
+// RAM: the State plus a COPY_BLOCK buffer on the stack. This file is plain
+// C++ and builds both on the ESP32 and on the host (tools/ota_tool).
+class DeltaPatch {
+public:
+    class Sink {
+    public:
+        virtual ~Sink() {}
+        virtual size_t room() = 0;                   // Bytes the sink takes before its next flush
+        virtual bool write(const uint8_t* data, size_t length) = 0;
+        virtual bool readSource(uint32_t offset, uint8_t* buffer, size_t length) = 0;
+    };
+
+    enum Result : uint8_t {
+        OK,                          // Input used up, more expected
+        DONE,                        // Image complete
+        BAD_FORMAT,
+        BAD_SOURCE,                  // Copy outside the running image, or the read failed
+        WRITE_FAILED,
+        TOO_LONG                     // Input past the end marker
+    };
+
+    // Everything needed to carry on after a reset; plain data, so it can be kept in NVS
+    struct State {
+        uint8_t phase;
+        uint8_t shift;               // Of the varint being read
+        uint8_t raw;                 // Full image: one unframed insert
+        uint8_t reserved;
+        uint32_t value;              // Varint being read, or magic bytes matched
+        uint32_t source;             // Next byte of the current copy in the running image
+        uint32_t remaining;          // Of the current copy or insert
+        uint32_t imageSize;
+        uint32_t produced;           // Output bytes
+        uint32_t consumed;           // Input bytes
+    };
+
+    static constexpr uint32_t MAGIC = 0x31444653;        // "SFD1", little-endian
+    static constexpr uint8_t OP_END = 0x00;
+    static constexpr uint8_t OP_COPY = 0x01;
+    static constexpr uint8_t OP_INSERT = 0x02;
+
+private:
+    enum Phase : uint8_t {
+        PHASE_MAGIC,
+        PHASE_IMAGE_SIZE,
+        PHASE_OPCODE,
+        PHASE_COPY_SOURCE,
+        PHASE_COPY_LENGTH,
+        PHASE_COPYING,
+        PHASE_INSERT_LENGTH,
+        PHASE_INSERTING,
+        PHASE_DONE
+    };
+
+    static const size_t COPY_BLOCK = 256;
+
+    State state;
+    Sink* sink;
+    uint32_t sourceSize;
+
+    bool readVarint(uint8_t byte, Result& result);
+    Result copy();
+    Result startOp(uint8_t opcode);
+
+public:
+    DeltaPatch();
+
+    // raw: the input is the image itself, imageSize bytes long; otherwise it is a delta against
+    // a running image of sourceSize bytes
+    void begin(Sink& output, bool raw, uint32_t imageSize, uint32_t sourceSize);
+    // Carries on from a checkpointed State
+    void resume(Sink& output, const State& saved, uint32_t sourceSize);
+
+    Result feed(const uint8_t* data, size_t length);
+
+    const State& getState() const { return state; }
+    bool isDone() const { return state.phase == PHASE_DONE; }
+
+    static const char* resultName(Result result);
+};
+
+#endif
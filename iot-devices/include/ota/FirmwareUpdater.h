@@ -0,0 +1,139 @@
+#ifndef FIRMWARE_UPDATER_H
+#define FIRMWARE_UPDATER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "ota/DeltaPatch.h"
+#include "network/OutboundQueue.h"
+#include "utils/SensorCalibration.h"
+
+class MQTTClient;
+
+// Firmware updates over the MQTT session the device already keeps. The
+// backend offers an image on sf/<id>/ota, in full or as a DeltaPatch against
+// the running image (see tools/ota_tool/README.md). The device pulls it in
+// windows of Ota::WINDOW bytes with requests on sf/<id>/ota/request; the
+// backend answers with chunks on sf/<id>/ota/data, each prefixed with its
+// offset. Chunks go through the decoder straight into the inactive app
+// partition one flash sector at a time, so an update holds one sector
+// buffer of RAM. Every Ota::CHECKPOINT_BYTES of flash the position is saved
+// in NVS: after a lost connection the device asks again from the last byte
+// it took, after a reset it resumes from the checkpoint. The finished image
+// must match the offer's SHA-256 before it becomes the boot partition.
+// Progress, transfer time and peak heap use are reported on sf/<id>/ota/status.
+class FirmwareUpdater : public DeltaPatch::Sink {
+public:
+    enum Phase : uint8_t {
+        PHASE_IDLE,
+        PHASE_DOWNLOADING,
+        PHASE_SUSPENDED,             // No progress for a while; resumes when the offer comes again
+        PHASE_READY                  // Verified and set to boot; restarts once control allows it
+    };
+
+private:
+    struct Offer {
+        uint8_t sha256[32];          // Of the new image
+        uint8_t base[32];            // Of the running image a delta was made against
+        uint32_t size;               // Bytes transferred
+        uint32_t imageSize;
+        uint8_t delta;
+        char version[23];
+    };
+
+    struct Checkpoint {
+        uint32_t magic;
+        uint8_t storageVersion;
+        Offer offer;
+        DeltaPatch::State decoder;
+        uint32_t written;            // Target partition bytes in flash
+        uint32_t elapsed;            // ms spent on the transfer so far
+        uint32_t received;           // Chunk bytes received, repeats included
+        uint16_t resumes;
+        uint16_t retries;
+        uint32_t peakHeap;
+    };
+
+    static const uint32_t MAGIC = 0x4F544131;        // "OTA1"
+    static const uint8_t STORAGE_VERSION = 1;
+    static const size_t SECTOR_SIZE = 4096;
+    static constexpr const char* NVS_NAMESPACE = "ota";
+    static constexpr const char* NVS_KEY = "checkpoint";
+
+    MQTTClient& mqtt;
+    DeltaPatch decoder;
+    Offer offer;
+    Phase phase;
+    const esp_partition_t* running;
+    const esp_partition_t* target;
+    uint8_t runningSha[32];
+    bool runningShaKnown;
+    bool currentReported;            // "current" goes out once per boot, not on every retained offer
+
+    uint8_t* sector;                 // SECTOR_SIZE bytes, allocated only while downloading
+    size_t sectorFill;
+    uint32_t written;
+    uint32_t checkpointedAt;         // written at the last checkpoint
+
+    uint32_t requestedTo;            // Input offset the latest request asked up to
+    unsigned long lastProgress;      // millis() of the last chunk taken or request sent
+    bool requestNow;
+    bool wasConnected;
+    uint8_t idleRequests;            // Timed-out requests in a row
+
+    unsigned long sessionStart;      // millis() this boot's share of the transfer started
+    uint32_t elapsedBefore;
+    uint32_t received;
+    uint16_t resumes;
+    uint16_t retries;
+    uint32_t heapBefore;             // Free heap before the sector buffer was taken
+    uint32_t peakHeap;               // Most heap the update held at once
+    unsigned long readyAt;
+    OutboundQueue::MessageId readyReport;
+    bool restartDue;
+    String lastError;
+
+    // DeltaPatch::Sink: output goes to the sector buffer, copies read the running partition
+    size_t room() override;
+    bool write(const uint8_t* data, size_t length) override;
+    bool readSource(uint32_t offset, uint8_t* buffer, size_t length) override;
+
+    bool flushSector();
+    void start(const Checkpoint* resumeFrom);
+    void finish();
+    void fail(const String& reason);
+    void suspend();
+    void release();
+    void request(uint32_t from, unsigned long now);
+    void saveCheckpoint();
+    bool loadCheckpoint(Checkpoint& checkpoint);
+    void clearCheckpoint();
+    void trackHeap();
+    const uint8_t* getRunningSha();
+    uint32_t getElapsed() const;
+    OutboundQueue::MessageId report(const char* state);
+
+    static bool parseHex(const char* hex, uint8_t* out, size_t length);
+    static String toHex(const uint8_t* data, size_t length);
+
+public:
+    explicit FirmwareUpdater(MQTTClient& mqtt);
+
+    void begin();                    // Resumes an update a reset interrupted
+
+    // From MQTTClient: an offer or {"cancel":true}, and a data chunk
+    void handleOffer(const uint8_t* payload, size_t length);
+    void handleChunk(const uint8_t* payload, size_t length);
+
+    void loop(unsigned long now);
+
+    bool isActive() const { return phase == PHASE_DOWNLOADING; }     // The radio stays on
+    bool isRestartDue() const { return restartDue; }
+    Phase getPhase() const { return phase; }
+
+    void serialize(JsonDocument& doc) const;
+    static const char* phaseName(Phase phase);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef RULE_COMPILER_H
+#define RULE_COMPILER_H
+
+#include <Arduino.h>
+#include "rules/RuleProgram.h"
+
+// Compiles rule conditions into a RuleProgram. Grammar, loosest first:
+//   or:    and ("||" and)*
+//   and:   not ("&&" not)*
+//   not:   "!" not | cmp
+//   cmp:   sum (("<" | "<=" | ">" | ">=" | "==" | "!=") sum)?
+//   sum:   term (("+" | "-") term)*
+//   term:  unary (("*" | "/") unary)*
+//   unary: "-" unary | number | name | "(" or ")"
+// Names are the engine's variables, true/false and the water level names
+// (Low, Medium, High). Anything non-zero is true.
+class RuleCompiler {
+private:
+    static const uint8_t MAX_NESTING = 8;
+    static const size_t MAX_CONDITION_LENGTH = 120;     // Also bounds the parser's recursion
+
+    RuleProgram& program;
+    const char* const* variables;
+    uint8_t variableCount;
+    uint8_t firstZoneVariable;       // Variables from here on differ per zone
+
+    const char* source;
+    const char* pos;
+    uint8_t stackDepth;
+    uint8_t nesting;
+    bool usesZoneVariables;
+    String error;
+
+    void skipSpace();
+    bool accept(const char* token);
+    bool fail(const char* message);
+
+    bool emit(uint8_t op);
+    bool emit(uint8_t op, uint8_t operand);
+    bool emitConstant(float value);
+    bool emitName(const char* name, size_t length);
+
+    bool parseOr();
+    bool parseAnd();
+    bool parseNot();
+    bool parseComparison();
+    bool parseSum();
+    bool parseTerm();
+    bool parseUnary();
+
+public:
+    RuleCompiler(RuleProgram& program, const char* const* variables, uint8_t variableCount,
+                 uint8_t firstZoneVariable);
+
+    // Appends one rule to the program; on failure the program is unchanged
+    bool addRule(const char* name, const char* condition, RuleProgram::Action action, uint8_t zone);
+
+    const String& getError() const { return error; }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "rules/RuleProgram.h"
+#include "utils/SensorCalibration.h"
+
+// Irrigation rules run on the device. A rule set arrives as JSON on
+// sf/<id>/rules, e.g.
+//   {"rules":[{"name":"rain","when":"rainDetected","do":"inhibit"},
+//             {"name":"dawn","when":"hour >= 5 && hour < 6.5 && moisture < 30","do":"water","zone":2}]}
+// Rules see the snapshot fields by their payload names, "hour" (local time,
+// 5.5 = 05:30), "openValves" and the zone's "moisture", "valve", "manual",
+// "trend" (moisture change in %/h) and "eta" (hours until the valve is
+// expected to switch; unknown without a clear trend), e.g.
+//   {"name":"early","when":"eta < 1 && hour >= 5 && hour < 7","do":"water"}
+// The set is compiled once into bytecode that is kept in NVS. Every control pass
+// interprets it over the latest snapshot; a pass costs at most
+// getOpsPerPass() bytecode ops. "inhibit" keeps the zone's valve closed while
+// the condition holds; "water" makes the zone count as dry, so it opens
+// (dwell times and pump capacity permitting) and then runs until the soil
+// reaches the OFF threshold. Without "zone", a rule applies to every zone.
+// {"rules":[]} removes all rules.
+class RuleEngine {
+public:
+    static const uint8_t MAX_VARIABLES = 24;
+
+    // Per-zone inputs, named as in ZONE_VARIABLES
+    struct ZoneInputs {
+        float moisture;
+        float valve;
+        float manual;
+        float trend;
+        float eta;
+    };
+
+    static const uint8_t ZONE_VARIABLE_COUNT = 5;
+
+    // What the rules asked for in one pass; bit n of the masks is zone n+1
+    struct Decision {
+        uint16_t inhibitMask;
+        uint16_t demandMask;
+        const char* rule[Zones::MAX_ZONES];      // Name of the rule behind each zone's bit
+
+        bool inhibits(uint8_t zone) const { return (inhibitMask >> zone) & 1; }
+        bool demands(uint8_t zone) const { return (demandMask >> zone) & 1; }
+    };
+
+private:
+    static const char* const ZONE_VARIABLES[ZONE_VARIABLE_COUNT];
+    static constexpr const char* NVS_NAMESPACE = "rules";
+    static constexpr const char* NVS_KEY = "program";
+
+    RuleProgram program;
+    bool programValid;
+    const char* variables[MAX_VARIABLES];
+    uint8_t variableCount;
+    uint8_t firstZoneVariable;
+    uint32_t layoutHash;             // Programs compiled against other variables are dropped
+
+    uint16_t opsPerPass;             // Worst case for the loaded rules
+    uint8_t activeMask;              // Rules that held in the last pass
+    uint32_t rejectedUpdates;
+
+    bool run(const RuleProgram::Rule& rule, const float* values) const;
+    void computeCost();
+    bool loadProgram();
+    bool saveProgram();
+
+public:
+    RuleEngine();
+
+    // globals: names of the values evaluate() receives first, e.g. the snapshot fields
+    void begin(const char* const* globals, uint8_t count);
+
+    // Compiles a JSON rule set; the loaded rules stay in force if any rule fails
+    bool update(const String& json);
+
+    // values holds the globals on entry, the zone variables go after them
+    void evaluate(float* values, const ZoneInputs* zones, uint8_t zoneCount, Decision& decision);
+
+    uint8_t getRuleCount() const { return programValid ? program.ruleCount : 0; }
+    uint16_t getOpsPerPass() const { return opsPerPass; }
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef RULE_PROGRAM_H
+#define RULE_PROGRAM_H
+
+#include <Arduino.h>
+
+// Bytecode for irrigation rules: a stack machine over float variables.
+// CONST and LOAD take a one-byte operand, every other op works on the stack.
+// There are no jumps, so a rule costs exactly its code length to evaluate.
+namespace RuleOps {
+    enum Op : uint8_t {
+        OP_CONST,                    // push constants[operand]
+        OP_LOAD,                     // push variables[operand]
+        OP_NOT,
+        OP_NEG,
+        OP_AND,
+        OP_OR,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_EQ,
+        OP_NE,
+        OP_COUNT
+    };
+}
+
+// A compiled rule set, stored as is in NVS
+struct RuleProgram {
+    static const uint32_t MAGIC = 0x52554C45;      // "RULE"
+    static const uint8_t STORAGE_VERSION = 1;
+    static const uint8_t MAX_RULES = 8;
+    static const uint8_t MAX_CODE = 160;           // Bytes over all rules
+    static const uint8_t MAX_CONSTANTS = 16;
+    static const uint8_t MAX_STACK = 8;
+    static const uint8_t NAME_LENGTH = 12;
+
+    enum Action : uint8_t {
+        ACTION_INHIBIT,              // Valve forced closed while the condition holds
+        ACTION_WATER                 // Zone counts as dry while the condition holds
+    };
+
+    struct Rule {
+        char name[NAME_LENGTH];
+        uint8_t zone;                // 0 = every zone, else the zone number
+        uint8_t action;
+        uint8_t codeStart;
+        uint8_t codeLength;
+        uint8_t usesZoneVariables;   // Evaluated once per zone instead of once per pass
+        uint8_t reserved[3];
+    };
+
+    uint32_t magic;
+    uint8_t version;
+    uint8_t ruleCount;
+    uint8_t constantCount;
+    uint8_t codeLength;
+    uint32_t layoutHash;             // Of the variable names the code was compiled against
+    Rule rules[MAX_RULES];
+    float constants[MAX_CONSTANTS];
+    uint8_t code[MAX_CODE];
+
+    void clear();
+
+    // Checks every opcode, operand and the stack depth, so the interpreter doesn't have to
+    bool verify(uint8_t variableCount) const;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sensors/SensorPipeline.h"
+#include "utils/SignalMonitor.h"
+
+// One SignalMonitor per snapshot field, fed with every sample the scheduler
+// takes, using the limits each sensor declares in Reading::LIMITS. Control
+// reads fields through controlValue() and substitute(): a rejected spike is
+// replaced by the last credible reading, a stuck input becomes NaN, which
+// the zones treat as an invalid probe and the rules as unknown. Suspect
+// fields are listed in the sensor payload under "anomalies".
+template <typename Pipeline>
+class AnomalyDetector {
+private:
+    static_assert(Pipeline::FIELD_COUNT <= 32, "Suspect mask holds at most 32 fields");
+
+    const Pipeline& pipeline;
+    SignalMonitor monitors[Pipeline::FIELD_COUNT];
+    uint32_t suspectMask;                // Bit per field, in snapshot order
+
+    struct Checker {
+        AnomalyDetector& detector;
+        size_t field;
+        unsigned long now;
+
+        template <typename T>
+        void operator()(const char* key, T value) {
+            SignalMonitor& monitor = detector.monitors[field];
+            SignalMonitor::Verdict before = monitor.getVerdict();
+            SignalMonitor::Verdict after = monitor.add(SensorFields::toScalar(value), now);
+
+            if (after != before) {
+                if (after == SignalMonitor::OK) {
+                    Serial.printf("Anomaly cleared: %s\n", key);
+                } else {
+                    Serial.printf("Anomaly: %s %s (%.2f, last credible %.2f)\n", key,
+                                  SignalMonitor::verdictName(after), SensorFields::toScalar(value),
+                                  monitor.getAccepted());
+                }
+            }
+            if (after != SignalMonitor::OK) detector.suspectMask |= (1u << field);
+            else detector.suspectMask &= ~(1u << field);
+            field++;
+        }
+    };
+
+    struct Writer {
+        JsonObject anomalies;
+        SignalMonitor* monitors;
+        size_t field;
+
+        template <typename T>
+        void operator()(const char* key, T) {
+            SignalMonitor& monitor = monitors[field++];
+            if (!monitor.isSuspect() && !monitor.hasCounts()) return;
+
+            JsonObject entry = anomalies[key].template to<JsonObject>();
+            entry["state"] = SignalMonitor::verdictName(monitor.getVerdict());
+            entry["stuck"] = monitor.getCount(SignalMonitor::STUCK);
+            entry["rate"] = monitor.getCount(SignalMonitor::RATE);
+            entry["outlier"] = monitor.getCount(SignalMonitor::OUTLIER);
+            monitor.resetCounts();
+        }
+    };
+
+    template <size_t I>
+    void limitIndex() {
+        typedef typename std::tuple_element<I, typename Pipeline::Snapshot>::type Reading;
+        for (size_t f = 0; f < Reading::FIELD_COUNT; f++) {
+            monitors[Pipeline::template fieldOffset<I>() + f].setLimits(&Reading::LIMITS[f]);
+        }
+    }
+
+    template <size_t I>
+    void addIndex(uint32_t sampledMask, unsigned long now) {
+        if (!(sampledMask & (1u << I)) || !pipeline.template isValidAt<I>()) return;
+
+        Checker checker{*this, Pipeline::template fieldOffset<I>(), now};
+        pipeline.template readingAt<I>().visit(checker);
+    }
+
+    template <size_t... I>
+    void limitAll(std::index_sequence<I...>) {
+        (limitIndex<I>(), ...);
+    }
+
+    template <size_t... I>
+    void addAll(uint32_t sampledMask, unsigned long now, std::index_sequence<I...>) {
+        (addIndex<I>(sampledMask, now), ...);
+    }
+
+    float controlValueAt(size_t field, float reading) const {
+        const SignalMonitor& monitor = monitors[field];
+        switch (monitor.getVerdict()) {
+            case SignalMonitor::STUCK: return NAN;
+            case SignalMonitor::OK: return reading;
+            default: return monitor.getAccepted();
+        }
+    }
+
+public:
+    explicit AnomalyDetector(const Pipeline& pipeline) : pipeline(pipeline), suspectMask(0) {
+        limitAll(std::make_index_sequence<Pipeline::SENSOR_COUNT>{});
+    }
+
+    // Checks the sensors that were just sampled (bitmask from SamplingScheduler::poll);
+    // returns the suspect fields
+    uint32_t add(uint32_t sampledMask, unsigned long now) {
+        addAll(sampledMask, now, std::make_index_sequence<Pipeline::SENSOR_COUNT>{});
+        return suspectMask;
+    }
+
+    uint32_t getSuspectMask() const { return suspectMask; }
+
+    // Field of sensor S as control should see it
+    template <typename S>
+    float controlValue(size_t field = 0) const {
+        constexpr size_t first = Pipeline::template fieldOffset<__builtin_ctz(Pipeline::template bit<S>())>();
+        float values[S::Reading::FIELD_COUNT];
+        SensorFields::ScalarList list{values, 0};
+        pipeline.template reading<S>().visit(list);
+        return controlValueAt(first + field, values[field]);
+    }
+
+    // Applies controlValue() to every field of a SensorFields::ScalarList
+    void substitute(float* values) const {
+        for (size_t field = 0; field < Pipeline::FIELD_COUNT; field++) {
+            values[field] = controlValueAt(field, values[field]);
+        }
+    }
+
+    // Suspect fields, and fields flagged since the previous call, under doc["anomalies"]
+    void serialize(JsonDocument& doc) {
+        if (!suspectMask) {
+            bool any = false;
+            for (const SignalMonitor& monitor : monitors) any = any || monitor.hasCounts();
+            if (!any) return;
+        }
+        Writer writer{doc["anomalies"].template to<JsonObject>(), monitors, 0};
+        pipeline.visitFields(writer);
+    }
+};
+
+#endif
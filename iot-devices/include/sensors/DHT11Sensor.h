@@ -2,6 +2,7 @@
 #define DHT11_SENSOR_H
 
 #include <DHT.h>
+#include "utils/SensorCalibration.h"
 
 class DHT11Sensor {
 private:
@@ -12,12 +13,36 @@ private:
     bool dataValid;
 
 public:
-    DHT11Sensor(int dhtPin, int dhtType);
+    static constexpr const char* NAME = "DHT11";
+    // DHT11 needs >1 s between reads; air changes slowly
+    static constexpr SamplingPolicy SAMPLING = {10000, 5000, 60000, 0.5f, false, false, 720, 30000000};
+    
+    // Snapshot fields contributed by this sensor (see SensorPipeline)
+    struct Reading {
+        float temperature;
+        float humidity;
+        
+        static constexpr size_t FIELD_COUNT = 2;
+        // Whole degrees and percent; air does not hold one value for a whole day
+        static constexpr SignalLimits LIMITS[FIELD_COUNT] = {
+            {1.0f, 86400000, 0.1f, 1.0f, 0.05f, 0.0f, 0.0f},
+            {1.0f, 86400000, 1.0f, 2.0f, 0.2f, 0.0f, 100.0f}
+        };
+        
+        template <typename Visitor>
+        void visit(Visitor& visitor) const {
+            visitor("temperature", temperature);
+            visitor("humidity", humidity);
+        }
+    };
+    
+    DHT11Sensor(int dhtPin = Pins::DHT11_PIN, int dhtType = DHT11Config::DHT_TYPE);
     void begin();
     bool readData();
     float getTemperature() const;
     float getHumidity() const;
     bool isDataValid() const;
+    Reading getReading() const;
     void printDebugInfo() const;
 };
 
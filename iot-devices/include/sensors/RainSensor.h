@@ -2,6 +2,7 @@
 #define RAIN_SENSOR_H
 
 #include <Arduino.h>
+#include "utils/SensorCalibration.h"
 
 class RainSensor {
 private:
@@ -9,10 +10,29 @@ private:
     bool rainDetected;
 
 public:
-    RainSensor(int digitalPin);
+    static constexpr const char* NAME = "Rain";
+    // Cheap digital read; rain starts abruptly
+    static constexpr SamplingPolicy SAMPLING = {2000, 1000, 10000, 0.5f, false, false, 3600, 1000000};
+    
+    // Snapshot fields contributed by this sensor (see SensorPipeline)
+    struct Reading {
+        bool rainDetected;
+        
+        static constexpr size_t FIELD_COUNT = 1;
+        // Digital, legitimately steady for weeks: no checks
+        static constexpr SignalLimits LIMITS[FIELD_COUNT] = {{}};
+        
+        template <typename Visitor>
+        void visit(Visitor& visitor) const {
+            visitor("rainDetected", rainDetected);
+        }
+    };
+    
+    RainSensor(int digitalPin = Pins::RAIN_SENSOR_PIN);
     void begin();
     bool readData();
     bool isRainDetected() const;
+    Reading getReading() const;
     void printDebugInfo() const;
 };
 
@@ -0,0 +1,245 @@
+#ifndef SAMPLING_SCHEDULER_H
+#define SAMPLING_SCHEDULER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "sensors/SensorPipeline.h"
+#include "utils/RunningStats.h"
+#include "utils/SampleClock.h"
+
+// Adaptive per-sensor sampling on top of a SensorPipeline. Each sensor runs
+// on its own period (Sensor::SAMPLING): the period halves while the signal
+// is changing or the pump is running, and backs off towards maxPeriod while
+// it is steady or at night. Every sensor has an hourly budget of reads and
+// CPU time; once spent, it is not sampled again until the next window.
+// Due times stay on each sensor's own grid rather than following when loop()
+// happened to run, and every read is stamped at acquisition and compared
+// with its due time for the jitter statistics.
+template <typename Pipeline>
+class SamplingScheduler;
+
+template <typename... Sensors>
+class SamplingScheduler<SensorPipeline<Sensors...>> {
+public:
+    typedef SensorPipeline<Sensors...> Pipeline;
+    static constexpr size_t SENSOR_COUNT = sizeof...(Sensors);
+
+private:
+    static const unsigned long BUDGET_WINDOW = 3600000;   // Budgets reset every hour
+    static constexpr float ACTIVITY_ALPHA = 0.3f;         // EWMA weight of the latest change
+
+    struct SensorState {
+        const char* name;
+        const SamplingPolicy* defaults;     // Sensor::SAMPLING
+        SamplingPolicy policy;              // In force; starts as the defaults
+        unsigned long period;
+        unsigned long maxPeriod;    // policy.maxPeriod, or longer while nothing is expected to change
+        unsigned long nextDue;
+        int64_t sampledAt;          // SampleClock monotonic µs of the last read, 0 = never
+        float lastValue;
+        float variance;             // EWMA of squared sample-to-sample change
+        bool primed;
+        uint32_t samples;           // Reads in the current budget window
+        uint32_t cpuMicros;         // Time spent in readData() in the current window
+        uint32_t budgetSkips;       // Reads skipped because the budget was spent
+        uint32_t lastWindowSamples;
+        uint32_t lastWindowCpuMicros;
+    };
+
+    Pipeline& pipeline;
+    SensorState states[SENSOR_COUNT];
+    unsigned long windowStart;
+    RunningStats jitter;            // Read start minus due time (ms), since the last upload
+
+    static bool isNight() {
+        time_t now = time(nullptr);
+        if (!SampleClock::isWallClockSet(now)) return false;
+
+        time_t local = now + Timing::LOCAL_UTC_OFFSET;
+        struct tm timeinfo;
+        gmtime_r(&local, &timeinfo);
+        return timeinfo.tm_hour >= Timing::NIGHT_START_HOUR || timeinfo.tm_hour < Timing::NIGHT_END_HOUR;
+    }
+
+    static unsigned long nextPeriod(const SensorState& state, bool pumpActive, bool night) {
+        const SamplingPolicy& policy = state.policy;
+
+        if (policy.fastWhilePumping && pumpActive) {
+            return policy.minPeriod;
+        }
+        if (policy.slowAtNight && night) {
+            return state.maxPeriod;
+        }
+
+        unsigned long period = state.period;
+        if (state.variance > policy.activityThreshold * policy.activityThreshold) {
+            period /= 2;                      // Signal changing: speed up
+        } else {
+            period += period / 2;             // Signal steady: back off
+        }
+        return constrain(period, policy.minPeriod, state.maxPeriod);
+    }
+
+    void rollWindow(unsigned long now) {
+        if (now - windowStart < BUDGET_WINDOW) return;
+
+        for (SensorState& state : states) {
+            state.lastWindowSamples = state.samples;
+            state.lastWindowCpuMicros = state.cpuMicros;
+            state.samples = 0;
+            state.cpuMicros = 0;
+        }
+        windowStart = now;
+        printStats();
+    }
+
+    template <size_t I>
+    bool pollIndex(unsigned long now, bool pumpActive, bool night) {
+        SensorState& state = states[I];
+        if ((long)(now - state.nextDue) < 0) return false;
+
+        const SamplingPolicy& policy = state.policy;
+        if (state.samples >= policy.maxSamplesPerHour || state.cpuMicros >= policy.maxCpuMicrosPerHour) {
+            state.budgetSkips++;
+            state.nextDue = windowStart + BUDGET_WINDOW;
+            return false;
+        }
+
+        int64_t start = SampleClock::monotonicMicros();
+        long lateMicros = static_cast<long>(static_cast<unsigned long>(start / 1000) - state.nextDue) * 1000 +
+                          static_cast<long>(start % 1000);
+        jitter.add(lateMicros / 1000.0f);
+
+        pipeline.template readIndex<I>(false);
+        state.sampledAt = start;
+        state.cpuMicros += SampleClock::monotonicMicros() - start;
+        state.samples++;
+
+        SensorFields::ScalarSum scalar{0.0f};
+        pipeline.template readingAt<I>().visit(scalar);
+        if (state.primed) {
+            float delta = scalar.sum - state.lastValue;
+            state.variance += ACTIVITY_ALPHA * (delta * delta - state.variance);
+        }
+        state.lastValue = scalar.sum;
+        state.primed = true;
+
+        // Next due time on the schedule; a read more than a period late restarts the grid
+        state.period = nextPeriod(state, pumpActive, night);
+        state.nextDue += state.period;
+        if ((long)(now - state.nextDue) >= 0) state.nextDue = now + state.period;
+        return true;
+    }
+
+    template <size_t... I>
+    uint32_t pollAll(unsigned long now, bool pumpActive, bool night, std::index_sequence<I...>) {
+        uint32_t sampled = 0;
+        ((sampled |= pollIndex<I>(now, pumpActive, night) ? (1u << I) : 0u), ...);
+        return sampled;
+    }
+
+public:
+    explicit SamplingScheduler(Pipeline& pipeline) : pipeline(pipeline), windowStart(0) {
+        const char* names[] = {Sensors::NAME...};
+        const SamplingPolicy* policies[] = {&Sensors::SAMPLING...};
+        for (size_t i = 0; i < SENSOR_COUNT; i++) {
+            states[i] = SensorState();
+            states[i].name = names[i];
+            states[i].defaults = policies[i];
+            states[i].policy = *policies[i];
+            states[i].period = policies[i]->basePeriod;
+            states[i].maxPeriod = policies[i]->maxPeriod;
+        }
+    }
+
+    void begin(unsigned long now) {
+        windowStart = now;
+        for (SensorState& state : states) {
+            state.nextDue = now;
+        }
+    }
+
+    // Reads every sensor that is due; returns a bitmask of the sensors sampled
+    uint32_t poll(unsigned long now, bool pumpActive) {
+        rollWindow(now);
+        return pollAll(now, pumpActive, isNight(), std::index_sequence_for<Sensors...>{});
+    }
+
+    // Makes a sensor due now, e.g. when an interrupt says its input changed; the budget still applies
+    template <typename S>
+    void expedite(unsigned long now) {
+        states[__builtin_ctz(Pipeline::template bit<S>())].nextDue = now;
+    }
+
+    // Lets a sensor back off past its policy's maxPeriod, e.g. while no threshold is
+    // expected to be crossed for hours; 0 restores the policy and pulls a far due time in
+    template <typename S>
+    void setMaxPeriod(unsigned long period, unsigned long now) {
+        SensorState& state = states[__builtin_ctz(Pipeline::template bit<S>())];
+        state.maxPeriod = period > state.policy.maxPeriod ? period : state.policy.maxPeriod;
+        if (state.period > state.maxPeriod) state.period = state.maxPeriod;
+        if ((long)(state.nextDue - (now + state.maxPeriod)) > 0) state.nextDue = now + state.maxPeriod;
+    }
+
+    // Replaces a sensor's policy, e.g. from the runtime configuration; the period and a
+    // far due time are pulled into the new range, a setMaxPeriod() back-off is dropped
+    void setPolicy(size_t index, const SamplingPolicy& policy, unsigned long now) {
+        SensorState& state = states[index];
+        state.policy = policy;
+        state.maxPeriod = policy.maxPeriod;
+        state.period = constrain(state.period, policy.minPeriod, policy.maxPeriod);
+        if ((long)(state.nextDue - (now + state.period)) > 0) state.nextDue = now + state.period;
+    }
+
+    const SamplingPolicy& getPolicy(size_t index) const { return states[index].policy; }
+    const SamplingPolicy& getDefaultPolicy(size_t index) const { return *states[index].defaults; }
+    const char* getName(size_t index) const { return states[index].name; }
+
+    unsigned long getPeriod(size_t index) const {
+        return states[index].period;
+    }
+
+    // Earliest due time over all sensors, for sleeping until then
+    unsigned long getNextDue(unsigned long now) const {
+        unsigned long next = now + BUDGET_WINDOW;
+        for (const SensorState& state : states) {
+            if ((long)(state.nextDue - next) < 0) next = state.nextDue;
+        }
+        return next;
+    }
+
+    // Acquisition time of each sensor's latest reading, Unix ms; left out until the wall time is known
+    void serializeSampledAt(JsonDocument& doc, const SampleClock& clock) const {
+        if (clock.nowUnixMillis() == 0) return;
+        JsonObject sampledAt = doc["sampledAt"].to<JsonObject>();
+        for (const SensorState& state : states) {
+            if (state.sampledAt) sampledAt[state.name] = clock.unixMillis(state.sampledAt);
+        }
+    }
+
+    // Sampling jitter since the previous call, which starts a new jitter window
+    void serializeJitter(JsonDocument& doc) {
+        JsonObject timing = doc["sampling"].to<JsonObject>();
+        timing["reads"] = jitter.getCount();
+        timing["jitterMeanMs"] = roundf(jitter.getMean() * 10) / 10;
+        timing["jitterSdMs"] = roundf(sqrtf(jitter.getVariance()) * 10) / 10;
+        timing["jitterMaxMs"] = roundf(jitter.getMax() * 10) / 10;
+        jitter.reset();
+    }
+
+    void printStats() const {
+        Serial.println("=== SAMPLING SCHEDULER ===");
+        for (const SensorState& state : states) {
+            Serial.printf("  %-12s period %6lu ms | last hour: %lu reads, %lu ms CPU | budget skips: %lu\n",
+                          state.name, state.period,
+                          (unsigned long)state.lastWindowSamples,
+                          (unsigned long)(state.lastWindowCpuMicros / 1000),
+                          (unsigned long)state.budgetSkips);
+        }
+        Serial.printf("  Jitter since last upload: mean %.1f ms, max %.1f ms over %lu reads\n", jitter.getMean(),
+                      jitter.getMax(), (unsigned long)jitter.getCount());
+        Serial.println("==========================");
+    }
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <tuple>
+#include <utility>
+#include "utils/SensorCalibration.h"
+
+// Compile-time sensor registry. Every sensor type provides the same static
+// interface:
+//   static constexpr const char* NAME;  static constexpr SamplingPolicy SAMPLING;
+//   void begin();  bool readData();  void printDebugInfo() const;
+//   struct Reading { ...; FIELD_COUNT; template <typename V> void visit(V& v) const; };
+//   Reading getReading() const;
+// The read loop, snapshot layout and serializer are generated from the type
+// list, so a board only pays for the sensors it lists and there is no
+// virtual dispatch.
+namespace SensorFields {
+    // Writes each snapshot field into the MQTT JSON payload
+    struct JsonWriter {
+        JsonDocument& doc;
+
+        template <typename T>
+        void operator()(const char* key, const T& value) { doc[key] = value; }
+        void operator()(const char* key, WaterLevelCalibration::Level value) {
+            doc[key] = WaterLevelCalibration::levelName(value);
+        }
+    };
+
+    // Prints each snapshot field as "key=value" on the serial console
+    struct SerialPrinter {
+        void operator()(const char* key, float value) { Serial.printf(" %s=%.1f", key, value); }
+        void operator()(const char* key, int value) { Serial.printf(" %s=%d", key, value); }
+        void operator()(const char* key, bool value) { Serial.printf(" %s=%s", key, value ? "true" : "false"); }
+        void operator()(const char* key, WaterLevelCalibration::Level value) {
+            Serial.printf(" %s=%s", key, WaterLevelCalibration::levelName(value));
+        }
+    };
+
+    // Numeric view of any field type, for statistics and activity tracking
+    inline float toScalar(float value) { return value; }
+    inline float toScalar(int value) { return static_cast<float>(value); }
+    inline float toScalar(bool value) { return value ? 1.0f : 0.0f; }
+    inline float toScalar(WaterLevelCalibration::Level value) { return static_cast<float>(value); }
+
+    // Folds all fields of a reading into one scalar, used to measure signal activity
+    struct ScalarSum {
+        float sum;
+
+        template <typename T>
+        void operator()(const char*, T value) { sum += toScalar(value); }
+    };
+
+    // Lists field keys in snapshot order
+    struct KeyList {
+        const char** keys;
+        uint8_t count;
+
+        template <typename T>
+        void operator()(const char* key, const T&) { keys[count++] = key; }
+    };
+
+    // Writes every field as a float, in snapshot order
+    struct ScalarList {
+        float* values;
+        uint8_t count;
+
+        template <typename T>
+        void operator()(const char*, T value) { values[count++] = toScalar(value); }
+    };
+}
+
+template <typename... Sensors>
+class SensorPipeline {
+public:
+    typedef std::tuple<typename Sensors::Reading...> Snapshot;
+    static constexpr size_t SENSOR_COUNT = sizeof...(Sensors);
+    static constexpr size_t FIELD_COUNT = (Sensors::Reading::FIELD_COUNT + ...);
+    static_assert(SENSOR_COUNT <= 32, "Validity mask holds at most 32 sensors");
+
+    // Position of the I-th sensor's first field in the flattened field list
+    template <size_t I>
+    static constexpr size_t fieldOffset() {
+        constexpr size_t counts[] = {Sensors::Reading::FIELD_COUNT...};
+        size_t offset = 0;
+        for (size_t i = 0; i < I; i++) offset += counts[i];
+        return offset;
+    }
+
+private:
+    std::tuple<Sensors...> sensors;      // Constructed in place with each sensor's default pins
+    Snapshot snapshot;
+    uint32_t validMask;
+
+    static constexpr uint32_t ALL_VALID = (SENSOR_COUNT == 32) ? 0xFFFFFFFFu : ((1u << SENSOR_COUNT) - 1);
+
+    template <typename S, size_t I = 0>
+    static constexpr size_t indexOf() {
+        static_assert(I < SENSOR_COUNT, "Sensor type is not part of this pipeline");
+        if constexpr (std::is_same<S, typename std::tuple_element<I, std::tuple<Sensors...>>::type>::value) {
+            return I;
+        } else {
+            return indexOf<S, I + 1>();
+        }
+    }
+
+    template <size_t... I>
+    void readAll(bool verbose, std::index_sequence<I...>) {
+        (readIndex<I>(verbose), ...);
+    }
+
+public:
+    SensorPipeline() : snapshot(), validMask(0) {}
+
+    // Reads the I-th sensor and refreshes its slot in the snapshot
+    template <size_t I>
+    bool readIndex(bool verbose = false) {
+        auto& sensor = std::get<I>(sensors);
+        bool ok = sensor.readData();
+        std::get<I>(snapshot) = sensor.getReading();
+
+        if (ok) {
+            validMask |= (1u << I);
+            if (verbose) sensor.printDebugInfo();
+        } else {
+            validMask &= ~(1u << I);
+        }
+        return ok;
+    }
+
+    void begin() {
+        std::apply([](auto&... sensor) { (sensor.begin(), ...); }, sensors);
+    }
+
+    // Reads every sensor, refreshes the snapshot and returns true if all are valid
+    bool readAll(bool verbose = true) {
+        readAll(verbose, std::index_sequence_for<Sensors...>{});
+        return allValid();
+    }
+
+    // Reads a single sensor and refreshes its slot in the snapshot
+    template <typename S>
+    bool read(bool verbose = false) {
+        return readIndex<indexOf<S>()>(verbose);
+    }
+
+    // Bit of sensor S in validity and sampled masks
+    template <typename S>
+    static constexpr uint32_t bit() {
+        return 1u << indexOf<S>();
+    }
+
+    template <typename S>
+    static constexpr bool has() {
+        return (std::is_same<S, Sensors>::value || ...);
+    }
+
+    template <typename S>
+    S& sensor() {
+        return std::get<S>(sensors);
+    }
+
+    template <typename S>
+    const typename S::Reading& reading() const {
+        return std::get<indexOf<S>()>(snapshot);
+    }
+
+    template <size_t I>
+    const typename std::tuple_element<I, Snapshot>::type& readingAt() const {
+        return std::get<I>(snapshot);
+    }
+
+    template <typename S>
+    bool isValid() const {
+        return (validMask & (1u << indexOf<S>())) != 0;
+    }
+
+    template <size_t I>
+    bool isValidAt() const {
+        return (validMask & (1u << I)) != 0;
+    }
+
+    bool allValid() const {
+        return validMask == ALL_VALID;
+    }
+
+    const Snapshot& getSnapshot() const {
+        return snapshot;
+    }
+
+    // Visits every field of every reading as visitor(key, value)
+    template <typename Visitor>
+    void visitFields(Visitor& visitor) const {
+        std::apply([&visitor](const auto&... reading) { (reading.visit(visitor), ...); }, snapshot);
+    }
+
+    void serialize(JsonDocument& doc) const {
+        SensorFields::JsonWriter writer{doc};
+        visitFields(writer);
+    }
+
+    void printSummary() const {
+        SensorFields::SerialPrinter printer;
+        Serial.print("Summary -");
+        visitFields(printer);
+    }
+};
+
+#endif
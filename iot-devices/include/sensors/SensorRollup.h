@@ -0,0 +1,111 @@
+#ifndef SENSOR_ROLLUP_H
+#define SENSOR_ROLLUP_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sensors/SensorPipeline.h"
+#include "utils/RunningStats.h"
+
+// Streaming per-field aggregates (count/min/max/mean/variance) over every
+// sample the scheduler takes, kept for several window sizes at once
+// (Timing::ROLLUP_WINDOWS, in send intervals). Rollups ride along with the
+// regular sensor publish, so message volume does not change.
+template <typename Pipeline>
+class SensorRollup {
+public:
+    static constexpr size_t WINDOW_COUNT = sizeof(Timing::ROLLUP_WINDOWS) / sizeof(Timing::ROLLUP_WINDOWS[0]);
+
+private:
+    const Pipeline& pipeline;
+    RunningStats stats[WINDOW_COUNT][Pipeline::FIELD_COUNT];
+    uint32_t publishCount;
+
+    struct StatsAdder {
+        RunningStats (*stats)[Pipeline::FIELD_COUNT];
+        size_t field;
+
+        template <typename T>
+        void operator()(const char*, T value) {
+            float scalar = SensorFields::toScalar(value);
+            for (size_t w = 0; w < WINDOW_COUNT; w++) {
+                stats[w][field].add(scalar);
+            }
+            field++;
+        }
+    };
+
+    struct StatsWriter {
+        JsonObject window;
+        RunningStats* stats;
+        size_t field;
+
+        template <typename T>
+        void operator()(const char* key, T) {
+            RunningStats& s = stats[field++];
+            if (s.getCount() == 0) return;
+
+            // Finer than any sensor resolves; full float digits would cost the publish ~200 bytes
+            JsonObject entry = window[key].template to<JsonObject>();
+            entry["n"] = s.getCount();
+            entry["min"] = roundf(s.getMin() * 100.0f) / 100.0f;
+            entry["max"] = roundf(s.getMax() * 100.0f) / 100.0f;
+            entry["mean"] = roundf(s.getMean() * 100.0f) / 100.0f;
+            entry["var"] = roundf(s.getVariance() * 10000.0f) / 10000.0f;
+        }
+    };
+
+    template <size_t I>
+    void addIndex(uint32_t sampledMask) {
+        if (!(sampledMask & (1u << I)) || !pipeline.template isValidAt<I>()) return;
+
+        StatsAdder adder{stats, Pipeline::template fieldOffset<I>()};
+        pipeline.template readingAt<I>().visit(adder);
+    }
+
+    template <size_t... I>
+    void addAll(uint32_t sampledMask, std::index_sequence<I...>) {
+        (addIndex<I>(sampledMask), ...);
+    }
+
+public:
+    explicit SensorRollup(const Pipeline& pipeline) : pipeline(pipeline), publishCount(0) {}
+
+    // Folds the sensors that were just sampled (bitmask from SamplingScheduler::poll) into every window
+    void add(uint32_t sampledMask) {
+        addAll(sampledMask, std::make_index_sequence<Pipeline::SENSOR_COUNT>{});
+    }
+
+    // Writes every window that closes at this publish under doc["stats"]["<seconds>"] and restarts it;
+    // sendInterval (ms) is the current upload period the windows are counted in
+    void serializeDue(JsonDocument& doc, unsigned long sendInterval) {
+        publishCount++;
+
+        for (size_t w = 0; w < WINDOW_COUNT; w++) {
+            if (publishCount % Timing::ROLLUP_WINDOWS[w] != 0) continue;
+
+            unsigned long seconds = Timing::ROLLUP_WINDOWS[w] * (sendInterval / 1000);
+            StatsWriter writer{doc["stats"][String(seconds)].template to<JsonObject>(), stats[w], 0};
+            pipeline.visitFields(writer);
+
+            for (RunningStats& s : stats[w]) {
+                s.reset();
+            }
+        }
+    }
+
+    // A send interval without a publish (no valid snapshot): the windows that close
+    // now restart unpublished, so every window keeps covering the span it is labelled with
+    void skipDue() {
+        publishCount++;
+
+        for (size_t w = 0; w < WINDOW_COUNT; w++) {
+            if (publishCount % Timing::ROLLUP_WINDOWS[w] != 0) continue;
+
+            for (RunningStats& s : stats[w]) {
+                s.reset();
+            }
+        }
+    }
+};
+
+#endif
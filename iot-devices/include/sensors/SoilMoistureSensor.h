@@ -2,6 +2,7 @@
 #define SOIL_MOISTURE_SENSOR_H
 
 #include <Arduino.h>
+#include "utils/SensorCalibration.h"
 
 class SoilMoistureSensor {
 private:
@@ -11,10 +12,33 @@ private:
     
 
 public:
-    SoilMoistureSensor(int analogPin);
+    static constexpr const char* NAME = "SoilMoisture";
+    // Sampled fast while irrigating
+    static constexpr SamplingPolicy SAMPLING = {2000, 500, 30000, 2.0f, true, false, 7200, 2000000};
+    
+    // Snapshot fields contributed by this sensor (see SensorPipeline)
+    struct Reading {
+        int soilMoisture;
+        
+        static constexpr size_t FIELD_COUNT = 1;
+        // Irrigation raises it a few % per minute at most; ADC noise alone
+        // moves a live probe by a step within a few hours
+        static constexpr SignalLimits LIMITS[FIELD_COUNT] = {
+            {1.0f, 21600000, 2.0f, 1.5f, 0.5f, 0.0f, 100.0f}
+        };
+        
+        template <typename Visitor>
+        void visit(Visitor& visitor) const {
+            visitor("soilMoisture", soilMoisture);
+        }
+    };
+    
+    SoilMoistureSensor(int analogPin = Pins::SOIL_MOISTURE_PIN);
+    void begin();
     bool readData();
     int getRawValue() const;
     int getPercentage() const;
+    Reading getReading() const;
     int convertToPercentage(int rawValue);
     void printDebugInfo() const;
     bool isValidReading() const;
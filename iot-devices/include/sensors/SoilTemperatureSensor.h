@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "utils/SensorCalibration.h"
 
 class SoilTemperatureSensor {
 private:
@@ -18,11 +19,32 @@ private:
     bool validateReading(float temp);
     
 public:
-    SoilTemperatureSensor(int sensorPin);
+    static constexpr const char* NAME = "DS18B20";
+    // Blocking 750 ms conversion; soil temperature barely moves
+    static constexpr SamplingPolicy SAMPLING = {30000, 10000, 300000, 0.1f, false, true, 360, 300000000};
+    
+    // Snapshot fields contributed by this sensor (see SensorPipeline)
+    struct Reading {
+        float soilTemperature;
+        
+        static constexpr size_t FIELD_COUNT = 1;
+        // Soil heat capacity: well under a degree per minute
+        static constexpr SignalLimits LIMITS[FIELD_COUNT] = {
+            {0.0625f, 86400000, 0.01f, 0.1f, 0.01f, 0.0f, 0.0f}
+        };
+        
+        template <typename Visitor>
+        void visit(Visitor& visitor) const {
+            visitor("soilTemperature", soilTemperature);
+        }
+    };
+    
+    SoilTemperatureSensor(int sensorPin = Pins::SOIL_TEMP_PIN);
     void begin();
     bool readData();
     float getTemperature() const;
     bool isDataValid() const;
+    Reading getReading() const;
     void printDebugInfo() const;
     
     // Static validation constants
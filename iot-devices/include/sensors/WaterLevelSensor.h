@@ -2,19 +2,43 @@
 #define WATER_LEVEL_SENSOR_H
 
 #include <Arduino.h>
+#include "utils/SensorCalibration.h"
 
 class WaterLevelSensor {
 private:
     int pin;
     int rawValue;
-    String status;
+    int levelPercent;
+    WaterLevelCalibration::Level level;
     // Calibration thresholds moved to SensorCalibration.h/cpp
 
 public:
-    WaterLevelSensor(int analogPin);
+    static constexpr const char* NAME = "WaterLevel";
+    // Tank drains while the pump runs
+    static constexpr SamplingPolicy SAMPLING = {2000, 500, 30000, 0.5f, true, false, 7200, 2000000};
+    
+    // Snapshot fields contributed by this sensor (see SensorPipeline)
+    struct Reading {
+        WaterLevelCalibration::Level waterLevel;
+        
+        static constexpr size_t FIELD_COUNT = 1;
+        // Tank level jumps on refill and sits still when unused: no checks
+        static constexpr SignalLimits LIMITS[FIELD_COUNT] = {{}};
+        
+        template <typename Visitor>
+        void visit(Visitor& visitor) const {
+            visitor("waterLevel", waterLevel);
+        }
+    };
+    
+    WaterLevelSensor(int analogPin = Pins::WATER_LEVEL_PIN);
+    void begin();
     bool readData();
     int getRawValue() const;
+    int getLevelPercent() const;
     String getStatus() const;
+    WaterLevelCalibration::Level getLevel() const;
+    Reading getReading() const;
     String determineStatus(int rawValue);
     void printDebugInfo() const;
     bool isValidReading() const;
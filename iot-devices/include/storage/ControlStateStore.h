@@ -0,0 +1,70 @@
+#ifndef CONTROL_STATE_STORE_H
+#define CONTROL_STATE_STORE_H
+
+#include <Arduino.h>
+
+// Pump control state that must survive a reset; bit n of the masks is zone n+1
+struct ControlState {
+    uint16_t overrideMask;       // Zones in manual override
+    uint16_t relayMask;          // Zones with the valve relay ON
+    uint32_t lastCommandId;      // Last remote command applied, so a redelivery isn't applied twice
+    uint32_t changedAt;          // Unix time of the last relay change, 0 if the clock wasn't set
+};
+
+// Keeps ControlState in two places. RTC memory holds every change; it
+// survives watchdog, panic and brownout resets, and writing it costs
+// nothing. NVS holds the durable part: the override zones with their relay
+// state and the last command id. It is written only when one of those
+// changes, i.e. on remote commands, not on every automatic pump toggle.
+// restore() is cheap enough to run before anything else in setup().
+class ControlStateStore {
+public:
+    enum Source : uint8_t {
+        SOURCE_NONE,
+        SOURCE_RTC,                  // Warm reset: the full state, including automatic pump runs
+        SOURCE_NVS                   // Power loss: override mode only, an automatic run restarts off
+    };
+
+private:
+    struct Record {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t reserved;
+        uint16_t overrideMask;
+        uint16_t relayMask;
+        uint16_t reserved2;
+        uint32_t tag;                // Pairs the RTC copy with this device's NVS record
+        uint32_t lastCommandId;
+        uint32_t changedAt;
+        uint32_t checksum;
+    };
+
+    static const uint32_t MAGIC = 0x43544C31;       // "CTL1"
+    static const uint8_t STORAGE_VERSION = 2;
+    static constexpr const char* NVS_NAMESPACE = "control";
+    static constexpr const char* NVS_KEY = "state";
+
+    static Record rtcRecord;         // RTC_NOINIT memory: kept across resets, garbage after power-on
+
+    Record durable;                  // Last record written to NVS
+    bool durableValid;
+    uint32_t nvsWrites;
+
+    static uint32_t checksum(const Record& record);
+    static bool valid(const Record& record);
+    static void seal(Record& record);
+
+    bool loadDurable();
+    bool writeDurable(const Record& record);
+
+public:
+    ControlStateStore();
+
+    Source restore(ControlState& state);
+    void save(const ControlState& state);
+
+    uint32_t getNvsWrites() const { return nvsWrites; }
+    static const char* sourceName(Source source);
+};
+
+#endif
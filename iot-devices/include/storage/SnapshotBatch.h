@@ -0,0 +1,90 @@
+#ifndef SNAPSHOT_BATCH_H
+#define SNAPSHOT_BATCH_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "sensors/SensorPipeline.h"
+#include "storage/SnapshotCodec.h"
+
+// Compressed RAM buffer of pipeline snapshots (see SnapshotCodec). Snapshots
+// that could not be published are appended here and uploaded later as one
+// binary MQTT batch; the buffer is self-describing so the host can decode it
+// with tools/codec_bench.
+template <typename Pipeline, size_t CAPACITY = 1024>
+class SnapshotBatch {
+    static_assert(Pipeline::FIELD_COUNT <= SnapshotCodec::MAX_FIELDS, "Snapshot has more fields than the codec supports");
+
+private:
+    uint8_t buffer[CAPACITY];
+    SnapshotCodec::Encoder encoder;
+    bool ready;
+    uint32_t droppedSamples;
+
+    // Collects field names and codec types in snapshot order
+    struct SchemaBuilder {
+        SnapshotCodec::Schema& schema;
+
+        void add(const char* key, SnapshotCodec::FieldType type) {
+            strncpy(schema.keys[schema.fieldCount], key, SnapshotCodec::MAX_KEY_LENGTH);
+            schema.keys[schema.fieldCount][SnapshotCodec::MAX_KEY_LENGTH] = '\0';
+            schema.types[schema.fieldCount++] = type;
+        }
+
+        void operator()(const char* key, float) { add(key, SnapshotCodec::FIELD_FLOAT); }
+        void operator()(const char* key, int) { add(key, SnapshotCodec::FIELD_INT); }
+        void operator()(const char* key, bool) { add(key, SnapshotCodec::FIELD_BOOL); }
+        void operator()(const char* key, WaterLevelCalibration::Level) { add(key, SnapshotCodec::FIELD_ENUM); }
+    };
+
+    struct SampleBuilder {
+        SnapshotCodec::Sample& sample;
+        uint8_t field;
+
+        void operator()(const char*, float value) { sample.values[field++] = SnapshotCodec::floatBits(value); }
+        void operator()(const char*, int value) { sample.values[field++] = static_cast<uint32_t>(value); }
+        void operator()(const char*, bool value) { sample.values[field++] = value ? 1 : 0; }
+        void operator()(const char*, WaterLevelCalibration::Level value) { sample.values[field++] = value; }
+    };
+
+public:
+    SnapshotBatch() : encoder(buffer, CAPACITY) {
+        ready = false;
+        droppedSamples = 0;
+    }
+
+    bool begin(const Pipeline& pipeline) {
+        SnapshotCodec::Schema schema = {};
+        SchemaBuilder builder{schema};
+        pipeline.visitFields(builder);
+        ready = encoder.begin(schema);
+        return ready;
+    }
+
+    // Appends the current snapshot; returns false (and counts a drop) when the buffer is full
+    bool append(const Pipeline& pipeline, uint32_t timestamp) {
+        if (!ready) return false;
+
+        SnapshotCodec::Sample sample = {};
+        sample.timestamp = timestamp;
+        SampleBuilder builder{sample, 0};
+        pipeline.visitFields(builder);
+
+        if (!encoder.append(sample)) {
+            droppedSamples++;
+            return false;
+        }
+        return true;
+    }
+
+    void clear() {
+        encoder.reset();
+    }
+
+    bool isEmpty() const { return encoder.count() == 0; }
+    uint16_t count() const { return encoder.count(); }
+    size_t size() const { return encoder.size(); }
+    const uint8_t* data() const { return encoder.data(); }
+    uint32_t getDroppedSamples() const { return droppedSamples; }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming time-series codec for snapshot sequences (Gorilla-style):
+//   timestamps      delta-of-delta, 1 bit when the interval is unchanged
+//   float fields    XOR with the previous value, reusing its leading/trailing zero window
+//   int fields      bucketed delta, 1 bit when unchanged
+//   bool/enum       1 bit when unchanged
+// The stream starts with a self-describing header (field names and types), so
+// a host-side decoder needs no knowledge of the board's sensor list. This file
+// is plain C++ and builds both on the ESP32 and on the host (tools/codec_bench).
+namespace SnapshotCodec {
+    const uint8_t MAX_FIELDS = 8;
+    const uint8_t MAX_KEY_LENGTH = 23;
+    const uint8_t VERSION = 1;
+    const size_t HEADER_FIXED_SIZE = 6;          // Magic (2), version, field count, sample count (2)
+
+    enum FieldType : uint8_t {
+        FIELD_FLOAT = 0,
+        FIELD_INT = 1,
+        FIELD_BOOL = 2,
+        FIELD_ENUM = 3
+    };
+
+    struct Schema {
+        uint8_t fieldCount;
+        FieldType types[MAX_FIELDS];
+        char keys[MAX_FIELDS][MAX_KEY_LENGTH + 1];
+    };
+
+    // One snapshot: floats are stored as their IEEE-754 bit pattern, everything else as int32
+    struct Sample {
+        uint32_t timestamp;
+        uint32_t values[MAX_FIELDS];
+    };
+
+    uint32_t floatBits(float value);
+    float bitsToFloat(uint32_t bits);
+
+    class Encoder {
+    private:
+        uint8_t* buffer;
+        size_t capacity;
+        size_t bitPos;
+        size_t headerSize;
+        uint16_t sampleCount;
+        Schema schema;
+
+        uint32_t prevTimestamp;
+        int32_t prevDelta;
+        uint32_t prevValues[MAX_FIELDS];
+        uint8_t prevLeading[MAX_FIELDS];
+        uint8_t prevTrailing[MAX_FIELDS];
+
+        bool writeBits(uint32_t value, uint8_t bits);
+        bool writeBucketed(int32_t value);
+        bool writeFloat(uint8_t field, uint32_t value);
+        bool encodeSample(const Sample& sample);
+
+    public:
+        Encoder(uint8_t* buffer, size_t capacity);
+        bool begin(const Schema& schema);
+        bool append(const Sample& sample);   // Leaves the stream untouched when the sample doesn't fit
+        void reset();                        // Drops all samples, keeps the header
+        size_t size() const;                 // Encoded bytes including the header
+        uint16_t count() const;
+        const uint8_t* data() const;
+    };
+
+    class Decoder {
+    private:
+        const uint8_t* data;
+        size_t length;
+        size_t bitPos;
+        uint16_t sampleCount;
+        uint16_t decoded;
+        Schema schema;
+
+        uint32_t prevTimestamp;
+        int32_t prevDelta;
+        uint32_t prevValues[MAX_FIELDS];
+        uint8_t prevLeading[MAX_FIELDS];
+        uint8_t prevTrailing[MAX_FIELDS];
+
+        bool readBits(uint8_t bits, uint32_t& value);
+        bool readBucketed(int32_t& value);
+        bool readFloat(uint8_t field, uint32_t& value);
+
+    public:
+        Decoder(const uint8_t* data, size_t length);
+        bool readHeader();
+        bool next(Sample& sample);
+        const Schema& getSchema() const;
+        uint16_t count() const;
+    };
+}
+
+#endif
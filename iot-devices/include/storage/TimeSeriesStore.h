@@ -0,0 +1,107 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <Arduino.h>
+#include <functional>
+#include "sensors/SensorPipeline.h"
+
+// Append-only local history on the SPIFFS partition. Fixed-size records are
+// buffered in RAM and appended to segment files a few at a time; old raw
+// segments are compacted into hourly averages and the oldest averages are
+// finally dropped, so weeks of history fit in a bounded footprint. Records
+// carry a CRC so a write torn by power loss is skipped on read.
+class TimeSeriesStore {
+public:
+    static const uint8_t MAX_FIELDS = 8;
+
+    enum RecordType : uint8_t {
+        RECORD_SNAPSHOT = 1,
+        RECORD_RELAY_EVENT = 2,
+        RECORD_DOWNSAMPLED = 3
+    };
+
+    struct Record {
+        uint32_t timestamp;          // Unix time (s)
+        uint8_t type;                // RecordType
+        uint8_t fieldCount;
+        uint8_t sampleCount;         // Snapshots averaged into this record
+        uint8_t crc;
+        int16_t values[MAX_FIELDS];  // Field values x100 (relay events: state, manual override, zone index)
+    };
+
+    // Return false from the callback to stop the query early
+    typedef std::function<bool(const Record&)> RecordCallback;
+
+private:
+    struct Tier {
+        char prefix;
+        uint32_t firstSeq;           // Oldest segment on flash
+        uint32_t nextSeq;            // One past the newest segment
+        uint16_t tailRecords;        // Records already in the newest segment
+    };
+
+    static const uint16_t SEGMENT_RECORDS = 170;              // ~4 KB per segment file
+    static const uint8_t MAX_RAW_SEGMENTS = 14;               // ~8 days of 5-minute snapshots
+    static const uint8_t MAX_DOWNSAMPLED_SEGMENTS = 13;       // ~3 months of hourly averages
+    static const uint32_t DOWNSAMPLE_SECONDS = 3600;
+    static const uint8_t FLUSH_RECORDS = 6;                   // Append to flash every ~30 minutes
+    static const uint32_t WRITE_BUDGET_BYTES_PER_HOUR = 2048; // Flash endurance budget for new data
+    static const unsigned long BUDGET_WINDOW = 3600000;
+
+    Tier raw;
+    Tier downsampled;
+    Record buffer[FLUSH_RECORDS];
+    uint8_t bufferedCount;
+    bool mounted;
+
+    unsigned long budgetWindowStart;
+    uint32_t bytesThisWindow;
+    uint32_t totalBytesWritten;
+    uint32_t droppedRecords;
+    uint32_t compactions;
+
+    // Stores each snapshot field as a scaled int16
+    struct SnapshotPacker {
+        Record& record;
+
+        template <typename T>
+        void operator()(const char*, T value) {
+            float scaled = SensorFields::toScalar(value) * 100.0f;
+            record.values[record.fieldCount++] = static_cast<int16_t>(constrain(lroundf(scaled), -32768L, 32767L));
+        }
+    };
+
+    static uint8_t computeCrc(const Record& record);
+    static bool isValid(const Record& record);
+    static void segmentPath(char* path, size_t size, char prefix, uint32_t seq);
+
+    bool writeToTier(Tier& tier, const Record* records, size_t count);
+    bool compactOldestRaw();
+    bool readSegment(char prefix, uint32_t seq, uint32_t from, uint32_t to, const RecordCallback& callback);
+
+public:
+    TimeSeriesStore();
+    bool begin();
+    bool append(Record record);
+    bool appendRelayEvent(bool relayStatus, bool manualOverride, uint8_t zone);
+    bool flush();
+    void maintain();
+    size_t query(uint32_t from, uint32_t to, const RecordCallback& callback);
+    void printDebugInfo() const;
+
+    // Converts the current pipeline snapshot into a fixed-size record
+    template <typename Pipeline>
+    static Record fromSnapshot(const Pipeline& pipeline) {
+        static_assert(Pipeline::FIELD_COUNT <= MAX_FIELDS, "Snapshot has more fields than a history record");
+
+        Record record = {};
+        record.timestamp = static_cast<uint32_t>(time(nullptr));
+        record.type = RECORD_SNAPSHOT;
+        record.sampleCount = 1;
+        SnapshotPacker packer{record};
+        pipeline.visitFields(packer);
+        return record;
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CALIBRATION_CURVE_H
+#define CALIBRATION_CURVE_H
+
+#include <Arduino.h>
+#include <array>
+
+// One calibration point: raw ADC reading -> physical value (%, 0-CalibrationTable::VALUE_MAX)
+struct CalibrationPoint {
+    uint16_t raw;
+    uint8_t value;
+};
+
+namespace CalibrationTable {
+    const int ADC_MAX = 4095;              // 12-bit ESP32 ADC
+    const int SIZE = ADC_MAX + 1;          // One entry per possible raw reading
+    const int VALUE_MAX = 100;             // Every curve maps to a percentage
+
+    typedef std::array<uint8_t, SIZE> Table;
+
+    // Piecewise-linear interpolation between points sorted by ascending raw value.
+    // Readings outside the curve are clamped to the first/last point.
+    constexpr uint8_t interpolate(const CalibrationPoint* points, int count, int raw) {
+        if (raw <= points[0].raw) return points[0].value;
+        if (raw >= points[count - 1].raw) return points[count - 1].value;
+
+        int i = 1;
+        while (raw > points[i].raw) i++;
+
+        // Anchored on the upper point so the default two-point soil curve
+        // reproduces the old 100 * (DRY - raw) / (DRY - WET) truncation exactly
+        const CalibrationPoint& lo = points[i - 1];
+        const CalibrationPoint& hi = points[i];
+        return static_cast<uint8_t>(hi.value + (lo.value - hi.value) * (hi.raw - raw) / (hi.raw - lo.raw));
+    }
+
+    constexpr Table build(const CalibrationPoint* points, int count) {
+        Table table{};
+        for (int raw = 0; raw < SIZE; raw++) {
+            table[raw] = interpolate(points, count, raw);
+        }
+        return table;
+    }
+
+    template <size_t N>
+    constexpr Table build(const CalibrationPoint (&points)[N]) {
+        static_assert(N >= 2, "A calibration curve needs at least two points");
+        return build(points, N);
+    }
+}
+
+// Per-sensor calibration curve compiled into a 4096-entry lookup table.
+// The default table is built at compile time and lives in flash; a custom
+// curve loaded from NVS (or received over MQTT) is compiled into RAM once.
+class CalibrationCurve {
+public:
+    static const int MAX_POINTS = 8;
+
+private:
+    const char* name;                      // NVS key, also used in MQTT messages
+    const CalibrationPoint* defaultPoints;
+    int defaultCount;
+    const CalibrationTable::Table& defaultTable;
+
+    CalibrationPoint points[MAX_POINTS];
+    int pointCount;
+    CalibrationTable::Table* customTable;  // Allocated on first custom curve
+    const uint8_t* table;                  // Active table (flash default or RAM custom)
+
+    static const char* NVS_NAMESPACE;
+    static const uint8_t STORAGE_VERSION = 1;
+
+public:
+    CalibrationCurve(const char* name, const CalibrationPoint* defaultPoints, int defaultCount,
+                     const CalibrationTable::Table& defaultTable);
+    ~CalibrationCurve();
+
+    // Raw-to-physical conversion is a single table access
+    uint8_t convert(int raw) const {
+        if (raw < 0) raw = 0;
+        if (raw > CalibrationTable::ADC_MAX) raw = CalibrationTable::ADC_MAX;
+        return table[raw];
+    }
+
+    static bool validatePoints(const CalibrationPoint* points, int count);
+    bool setPoints(const CalibrationPoint* newPoints, int count);
+    void resetToDefault();
+    bool loadFromNVS();
+    bool saveToNVS() const;
+    bool clearNVS() const;
+
+    const char* getName() const;
+    int getPointCount() const;
+    const CalibrationPoint* getPoints() const;
+    bool isCustom() const;
+    void printDebugInfo() const;
+};
+
+#endif
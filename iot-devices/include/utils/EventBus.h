@@ -0,0 +1,150 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Remote relay command: {"relayStatus":true,"zone":2,"commandId":17}
+struct RelayCommand {
+    bool status;
+    uint8_t zone;                    // 0-based; the payload's "zone" is 1-based and defaults to zone 1
+    uint32_t id;                     // Optional "commandId", 0 if the command had none
+};
+
+namespace Events {
+    enum Type : uint8_t {
+        SENSOR_SNAPSHOT,             // The scheduler read one or more sensors
+        RAIN_EDGE,                   // The rain input changed; posted from its interrupt
+        RELAY_COMMAND,               // Remote relay command received
+        RULES_UPDATE,                // Rule set received
+        CONNECTIVITY,                // MQTT session came up or went down
+        LEAF_COMMAND,                // Relay command for a leaf node behind this gateway
+        DRY_RUN_TRIP,                // Tank ran low with a valve open; posted from the esp_timer task
+        CONFIG_UPDATE,               // Runtime configuration document received
+        TYPE_COUNT
+    };
+
+    inline constexpr uint32_t bit(Type type) { return 1u << type; }
+
+    struct Snapshot {
+        uint32_t sampled;            // Pipeline bits of the sensors read; the readings stay in the pipeline
+        bool valid;                  // Every sensor has a valid reading
+        uint32_t suspect;            // Snapshot fields AnomalyDetector flags (bit per field)
+    };
+
+    struct Rain {
+        bool raining;                // Pin level at the edge; the rain sensor's next read confirms it
+    };
+
+    struct Rules {
+        const String* json;          // Borrowed: the publisher keeps it unchanged until dispatched
+    };
+
+    struct Config {
+        const String* json;          // Borrowed, as for Rules
+    };
+
+    struct Link {
+        bool connected;
+    };
+
+    struct DryRun {
+        int16_t level;               // Tank level that tripped, %
+        uint16_t latency;            // ms from the first low read to the cut
+    };
+
+    struct LeafCommand {
+        uint8_t leaf[6];             // Leaf address
+        RelayCommand command;
+    };
+}
+
+// Fixed-size event record
+struct Event {
+    Events::Type type;
+    uint32_t sequence;               // Set by the bus, in posting order
+    int64_t postedAt;                // SampleClock monotonic µs, set by the bus
+    union {
+        Events::Snapshot snapshot;
+        Events::Rain rain;
+        RelayCommand command;
+        Events::Rules rules;
+        Events::Link link;
+        Events::LeafCommand leafCommand;
+        Events::DryRun dryRun;
+        Events::Config config;
+    };
+};
+
+// Statically allocated publish/subscribe bus between the sensors, the
+// control logic and the network client of one controller. A posted event is
+// copied once into a pool slot; each subscriber's bounded queue holds only
+// the slot index, and handlers get a reference to the pooled record, so fan
+// out costs no copies. The slot is freed when the last subscriber has seen it.
+// post() and postFromISR() may run in any task or interrupt; dispatch() runs
+// the handlers in the loop task, each subscriber's events in posting order.
+// A subscriber whose queue is full loses the new event (counted as dropped).
+class EventBus {
+public:
+    typedef void (*Handler)(void* context, const Event& event);
+
+    static const uint8_t MAX_SUBSCRIBERS = 4;
+    static const uint8_t POOL_SIZE = 16;
+    static const uint8_t QUEUE_DEPTH = 8;
+
+private:
+    struct Subscriber {
+        const char* name;
+        uint32_t mask;               // Events::bit() of the types it receives
+        Handler handler;
+        void* context;
+        uint8_t queue[QUEUE_DEPTH];  // Pool slots, oldest at head
+        uint8_t head;
+        uint8_t count;
+        uint8_t highWater;
+        uint32_t delivered;
+        uint32_t dropped;
+        uint32_t handlerMicros;      // Time spent in the handler
+        uint32_t maxHandlerMicros;
+        uint32_t maxWaitMicros;      // Longest time from post to handler
+    };
+
+    portMUX_TYPE lock;
+    Event pool[POOL_SIZE];
+    uint8_t references[POOL_SIZE];   // Queues still holding each slot, 0 = free
+    Subscriber subscribers[MAX_SUBSCRIBERS];
+    uint8_t subscriberCount;
+    uint32_t sequence;
+    uint32_t posted;
+    uint32_t poolFull;               // Events lost because every slot was in use
+    TaskHandle_t wakeTask;
+
+    bool enqueue(const Event& event);
+
+public:
+    EventBus();
+
+    // Call before anything posts; handlers must not subscribe
+    bool subscribe(const char* name, uint32_t mask, Handler handler, void* context);
+
+    // Notified on every post, so a loop task sleeping in ulTaskNotifyTake() wakes up
+    void setWakeTask(TaskHandle_t task) { wakeTask = task; }
+
+    // false if no subscriber took the event
+    bool post(const Event& event);
+    bool postFromISR(const Event& event);
+
+    // Runs the handlers of every queued event, including ones posted by handlers;
+    // returns the number of deliveries
+    uint16_t dispatch();
+    bool hasPending() const;
+
+    // Dispatch cost since the previous call, which starts a new window
+    void serialize(JsonDocument& doc);
+    void printDebugInfo() const;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <Arduino.h>
+
+// 32-bit FNV-1a. Its values are kept in RTC memory, NVS and leaf frames, so
+// the constants must never change. Pass a previous result as hash to chain.
+namespace Fnv1a {
+    const uint32_t OFFSET_BASIS = 2166136261u;
+    const uint32_t PRIME = 16777619u;
+
+    inline uint32_t hash(const void* data, size_t length, uint32_t hash = OFFSET_BASIS) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) hash = (hash ^ bytes[i]) * PRIME;
+        return hash;
+    }
+
+    // Over the names with their terminators, so {"ab","c"} and {"a","bc"} differ
+    inline uint32_t hashNames(const char* const* names, uint8_t count) {
+        uint32_t hash = OFFSET_BASIS;
+        for (uint8_t i = 0; i < count; i++) hash = Fnv1a::hash(names[i], strlen(names[i]) + 1, hash);
+        return hash;
+    }
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+
+// Trace points along the remote relay command path, for tools/latency_bench.
+// They compile to nothing unless LATENCY_TRACE is defined; the host harness
+// installs the hook and timestamps each stage itself.
+namespace LatencyTrace {
+    enum Stage : uint8_t {
+        STAGE_MESSAGE_RECEIVED = 0,   // MQTTClient::handleMessage() entered
+        STAGE_COMMAND_TAKEN,          // controlPump() picked up the queued command
+        STAGE_RELAY_SET,              // RelayController::setRelayState() called
+        STAGE_RELAY_LOG_PUBLISHED,    // Relay log handed to the MQTT client
+        STAGE_COUNT
+    };
+
+    typedef void (*Hook)(Stage stage);
+
+    inline Hook hook = nullptr;
+
+    inline void mark(Stage stage) {
+        if (hook) hook(stage);
+    }
+}
+
+#ifdef LATENCY_TRACE
+#define LATENCY_TRACE_POINT(stage) LatencyTrace::mark(LatencyTrace::stage)
+#else
+#define LATENCY_TRACE_POINT(stage) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include "utils/SensorCalibration.h"
+
+// Deadlines for the stages of setup() and loop(). Code run inside a Scope is
+// one stage. A stage that finishes past its deadline is logged as an overrun.
+// A stage still running past its stall limit is hung (a blocking TLS
+// handshake, OneWire or I2C waiting on a dead bus): a supervisor on the
+// esp_timer task calls the fail-safe handler, which turns the valves off,
+// logs the stall and restarts. The ESP task watchdog watches the loop task
+// as the backstop for when the supervisor can't run either; the stage that
+// was running then is logged on the next boot. The log is kept in RTC
+// memory across resets and published with the next device metrics.
+class LoopWatchdog {
+public:
+    enum Stage : uint8_t {
+        STAGE_NONE = 0,
+        STAGE_SETUP,
+        STAGE_SENSORS,
+        STAGE_CLOCK,
+        STAGE_MQTT,
+        STAGE_RADIO,
+        STAGE_GATEWAY,
+        STAGE_EVENTS,                // Control and display handlers
+        STAGE_UPLOAD,
+        STAGE_STORAGE,
+        STAGE_IDLE,
+        STAGE_COUNT
+    };
+
+    enum Kind : uint8_t {
+        KIND_OVERRUN,                // Finished past its deadline
+        KIND_STALL,                  // Past its stall limit; the supervisor restarted
+        KIND_WATCHDOG                // Running when a watchdog or panic reset the chip
+    };
+
+    // Nests; the enclosing stage's clock stops while a nested stage runs
+    class Scope {
+    private:
+        LoopWatchdog& watchdog;
+        Stage previous;
+        uint32_t previousStart;
+
+    public:
+        Scope(LoopWatchdog& watchdog, Stage stage);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    typedef void (*FailSafeHandler)(void* context);
+
+private:
+    struct Entry {
+        uint8_t stage;
+        uint8_t kind;
+        uint16_t boot;               // Low bits of the boot count
+        uint32_t duration;           // ms; 0 if a watchdog cut it short
+        uint32_t startedAt;          // s after that boot
+    };
+
+    struct Log {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t count;
+        uint8_t stalled;             // The supervisor restarted the chip
+        uint8_t reserved;
+        uint32_t boots;
+        uint32_t dropped;            // Entries lost to a full log since the last publish
+        Entry entries[Watchdog::LOG_SIZE];
+        uint32_t checksum;
+    };
+
+    // Written on every stage change, so a watchdog reset can still tell the stage
+    struct Running {
+        volatile uint8_t stage;
+        volatile uint8_t check;      // ~stage
+        volatile uint32_t startedAt; // millis()
+    };
+
+    static const uint32_t MAGIC = 0x57444C31;       // "WDL1"
+    static const uint8_t STORAGE_VERSION = 1;
+
+    static Log rtcLog;               // RTC_NOINIT memory, like ControlStateStore's record
+    static Running rtcRunning;
+
+    esp_timer_handle_t supervisor;
+    FailSafeHandler failSafe;
+    void* failSafeContext;
+    esp_reset_reason_t resetReason;
+    bool uncleanReset;               // Previous boot ended in a stall, watchdog or panic
+    bool resetReported;
+    bool subscribed;                 // Loop task added to the task watchdog
+    volatile bool tripped;
+    uint8_t publishedCount;
+
+    static uint32_t checksum(const Log& log);
+    static void seal(Log& log);
+    static void append(Stage stage, Kind kind, uint32_t duration, uint32_t startedAt, uint32_t boot);
+    static void enter(Stage stage, uint32_t startedAt);
+    static void onCheck(void* arg);
+
+    void finish(Stage stage, uint32_t startedAt);
+
+public:
+    LoopWatchdog();
+
+    // First thing in setup(): reads the log and the reset reason, then arms the supervisor and the task watchdog
+    void begin(FailSafeHandler handler, void* context);
+
+    // Resets the task watchdog; called at every stage end, call it in long stages too
+    void feed();
+
+    bool wasUncleanReset() const { return uncleanReset; }
+    uint32_t getBoots() const { return rtcLog.boots; }
+
+    // Reset reason on the first payload after boot, and the log while it has entries
+    void serialize(JsonDocument& doc);
+    void markPublished();            // The payload from serialize() was queued: drop what it carried
+
+    static const char* stageName(Stage stage);
+    static const char* kindName(Kind kind);
+    static const char* resetReasonName(esp_reset_reason_t reason);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef MEMORY_DIAGNOSTICS_H
+#define MEMORY_DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Heap, PSRAM and stack figures sampled on a slow timer, plus per-subsystem
+// accounting: code run inside a Scope is charged with the operator new calls
+// and JsonAllocator allocations it makes, and with the heap it leaves
+// allocated when the scope ends. A
+// subsystem whose retained bytes keep growing over days is leaking; a falling
+// largest-block/free ratio shows fragmentation before allocations fail.
+// The figures go out with the device metrics on sf/<id>/metrics.
+class MemoryDiagnostics {
+public:
+    enum Subsystem : uint8_t {
+        SUB_SENSORS,
+        SUB_CONTROL,
+        SUB_DISPLAY,
+        SUB_MQTT,
+        SUB_RADIO,
+        SUB_UPLOAD,                  // Building the sensor and metrics payloads
+        SUB_STORAGE,
+        SUB_COUNT
+    };
+
+    // Charges the enclosed code to one subsystem. Scopes nest; only the loop
+    // task that opened the scope is counted, other tasks' allocations aren't.
+    class Scope {
+    private:
+        MemoryDiagnostics& diagnostics;
+        Subsystem subsystem;
+        Scope* previous;
+        TaskHandle_t task;
+        uint32_t freeAtEntry;
+        uint32_t allocations;
+
+        friend class MemoryDiagnostics;
+
+    public:
+        Scope(MemoryDiagnostics& diagnostics, Subsystem subsystem);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // For JsonDocuments: ArduinoJson allocates with malloc, which operator new doesn't see
+    class JsonAllocator : public ArduinoJson::Allocator {
+    public:
+        void* allocate(size_t size) override;
+        void deallocate(void* pointer) override;
+        void* reallocate(void* pointer, size_t size) override;
+        static JsonAllocator* instance();
+    };
+
+private:
+    struct SubsystemStats {
+        uint32_t calls;
+        uint32_t allocations;        // operator new calls and JsonAllocator (re)allocations
+        int32_t retainedBytes;       // Net heap change across all scopes
+    };
+
+    struct TaskWatch {
+        TaskHandle_t handle;
+        const char* name;
+        uint32_t stackFree;          // Lowest free stack seen (bytes)
+    };
+
+    static const uint8_t MAX_TASKS = 6;
+    static Scope* currentScope;
+
+    SubsystemStats subsystems[SUB_COUNT];
+    TaskWatch tasks[MAX_TASKS];
+    uint8_t taskCount;
+
+    unsigned long lastSample;
+    uint32_t heapSize;
+    uint32_t heapFree;
+    uint32_t heapMinFree;
+    uint32_t heapMaxBlock;
+    uint32_t heapFreeAtStart;        // After setup(), the baseline for drift
+    uint32_t psramSize;
+    uint32_t psramFree;
+    uint32_t psramMinFree;
+
+    static const char* subsystemName(Subsystem subsystem);
+
+    void watchTask(TaskHandle_t handle, const char* name);
+
+public:
+    MemoryDiagnostics();
+
+    // Watches the calling (loop) task and the system tasks that exist; call at the end of setup()
+    void begin(unsigned long now);
+    void sample(unsigned long now, bool force = false);
+
+    // Called from the global operator new and JsonAllocator
+    static void countAllocation();
+
+    uint32_t getHeapFree() const { return heapFree; }
+    uint32_t getHeapMinFree() const { return heapMinFree; }
+    uint8_t getFragmentation() const;        // 0-100, 100 - largest block as a share of free heap
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef MOISTURE_TREND_H
+#define MOISTURE_TREND_H
+
+#include <Arduino.h>
+#include "utils/SensorCalibration.h"
+
+// Least-squares line of soil moisture over time, through the readings of a
+// sliding window, updated in O(1) per sample. Readings are summed into
+// Trend::BUCKETS time buckets and the window's totals are kept as running
+// sums: a new bucket pushes the oldest one out by subtracting its sums. A
+// change of regime (valve opened or closed) restarts the fit with a bucket
+// span to match, hours of drying against minutes of watering, so the line
+// never bends over the switch.
+class MoistureTrend {
+public:
+    enum Mode : uint8_t {
+        DRYING,
+        WETTING
+    };
+
+private:
+    // Sums of one bucket, with t in s from the bucket's start
+    struct Bucket {
+        unsigned long start;
+        uint16_t count;
+        double sumT;
+        double sumY;
+        double sumTT;
+        double sumTY;
+        double sumYY;
+    };
+
+    Bucket buckets[Trend::BUCKETS];
+    uint8_t oldest;
+    uint8_t used;
+    Mode mode;
+    unsigned long span;
+
+    // Window totals, with t in s from the oldest bucket's start
+    unsigned long origin;
+    double n;
+    double sumT;
+    double sumY;
+    double sumTT;
+    double sumTY;
+    double sumYY;
+
+    bool fitted;                     // Enough history; the fields below are valid
+    float slope;                     // %/s
+    float slopeError;                // Standard error of the slope
+    float current;                   // Line at the latest sample
+    unsigned long lastAt;
+
+    void dropOldest();
+    void rebase(unsigned long newOrigin);
+    void fit();
+
+public:
+    MoistureTrend();
+
+    void restart(Mode newMode);
+    void add(float moisture, unsigned long now);
+
+    Mode getMode() const { return mode; }
+    bool isFitted() const { return fitted; }
+    float getSlopePerHour() const;   // NaN until fitted
+    bool isSignificant() const;      // Slope clearly away from 0
+
+    // Seconds from the latest sample until the line reaches level; NaN if the
+    // trend isn't significant or the line has left the level behind
+    float secondsTo(float level) const;
+    // Moisture plus the trend over the next ahead ms; unchanged without a significant trend
+    float project(float moisture, unsigned long ahead) const;
+};
+
+#endif
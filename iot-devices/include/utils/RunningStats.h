@@ -0,0 +1,26 @@
+#ifndef RUNNING_STATS_H
+#define RUNNING_STATS_H
+
+#include <Arduino.h>
+
+// Streaming min/max/mean/variance of one field (Welford's algorithm), O(1) memory
+class RunningStats {
+private:
+    uint32_t count;
+    float minValue;
+    float maxValue;
+    float mean;
+    float m2;            // Sum of squared deviations from the mean
+
+public:
+    RunningStats();
+    void add(float value);
+    void reset();
+    uint32_t getCount() const;
+    float getMin() const;
+    float getMax() const;
+    float getMean() const;
+    float getVariance() const;   // Sample variance, 0 for fewer than two samples
+};
+
+#endif
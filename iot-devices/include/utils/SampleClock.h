@@ -0,0 +1,69 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <time.h>
+
+// Time service for sampling. Samples are stamped with esp_timer's monotonic
+// microsecond counter; wall time is derived from it through the last SNTP
+// sync, corrected by the crystal drift measured between syncs, so stamps
+// stay consistent between syncs and SNTP never has to block. Between loop()
+// passes the loop task sleeps on a one-shot timer that wakes it when the
+// next sample is due, rather than on a fixed delay.
+class SampleClock {
+private:
+    static const int32_t MAX_DRIFT_PPM = 500;            // ESP32 crystals are specified well inside this
+    static const int64_t MIN_DRIFT_INTERVAL = 60000000;  // Syncs closer than this (µs) don't update the drift
+
+    static SampleClock* instance;                        // SNTP's callback has no argument
+    static portMUX_TYPE syncLock;
+
+    esp_timer_handle_t wakeTimer;
+    TaskHandle_t loopTask;
+
+    // Written by the SNTP callback in the lwIP task, applied by loop()
+    volatile bool syncPending;
+    int64_t pendingMono;
+    int64_t pendingUnix;
+
+    bool synced;
+    int64_t syncMono;                // Monotonic µs of the last sync
+    int64_t syncUnix;                // Unix µs at syncMono
+    float driftPpm;                  // Local clock rate error, corrected for between syncs
+    int32_t lastCorrectionMs;        // How far the drift-corrected time was off at the last sync
+    uint16_t syncCount;
+
+    static void onSync(struct timeval* tv);
+    static void onWake(void* arg);
+    void applySync(int64_t mono, int64_t unixMicros);
+
+public:
+    SampleClock();
+
+    // Starts background SNTP and the wake timer; call from the loop task
+    void begin();
+    void loop();
+
+    static int64_t monotonicMicros() { return esp_timer_get_time(); }
+
+    // Before the first sync time() counts from 1970; anything earlier than this is not a date
+    static constexpr time_t WALL_CLOCK_VALID_FROM = 1600000000;
+    static bool isWallClockSet(time_t wallClock) { return wallClock >= WALL_CLOCK_VALID_FROM; }
+    static bool isWallClockSet() { return isWallClockSet(time(nullptr)); }
+
+    bool isSynced() const { return synced; }
+    uint64_t unixMillis(int64_t monoMicros) const;       // 0 while the wall time is unknown
+    uint64_t nowUnixMillis() const { return unixMillis(monotonicMicros()); }
+
+    // Sleeps until dueMillis (millis() time), at most maxWait ms, or until the loop task is notified
+    void sleepUntil(unsigned long dueMillis, unsigned long maxWait);
+
+    void serialize(JsonDocument& doc) const;
+    void printDebugInfo() const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define SENSOR_CALIBRATION_H
 
 #include <Arduino.h>
+#include "utils/CalibrationCurve.h"
 
 // GPIO Pin Definitions
 namespace Pins {
@@ -29,6 +30,8 @@ namespace SoilMoistureCalibration {
     extern const int DRY_VALUE;    // 0% moisture (completely dry)
     extern const int WET_VALUE;    // 100% moisture (completely wet)
     
+    extern CalibrationCurve curve;  // Per-probe curve, default built from DRY/WET at compile time
+    
     int convertToPercentage(int rawValue);
 }
 
@@ -38,23 +41,163 @@ namespace WaterLevelCalibration {
     const int WET_VALUE = 1050;       // Sensor value when sensor is fully submerged
     const int SENSOR_HEIGHT_CM = 5;   // Actual height of your sensor in cm
     
-    extern const int LOW_THRESHOLD;     
+    extern const int LOW_THRESHOLD;     // Defaults; the runtime configuration can move them
     extern const int MEDIUM_THRESHOLD;  
     
+    extern CalibrationCurve curve;    // Raw -> % of sensor height, default built from DRY/WET
+    
+    enum Level : uint8_t {
+        LEVEL_LOW = 0,
+        LEVEL_MEDIUM = 1,
+        LEVEL_HIGH = 2
+    };
+    
+    int convertToPercentage(int rawValue);
+    void setThresholds(int low, int medium);
+    int getLowThreshold();
+    int getMediumThreshold();
+    Level determineLevel(int rawValue);
+    const char* levelName(Level level);
     String determineStatus(int rawValue);
 }
 
 namespace RelayThresholds {
     const int SOIL_MOISTURE_THRESHOLD = 10;   // 0-10% soil moisture triggers pump
-    
+    const int SOIL_MOISTURE_OFF_THRESHOLD = 20;  // Pump stops once soil reaches 20% (hysteresis band)
+    const unsigned long MIN_ON_TIME = 60000;     // Pump runs at least 1 minute once started
+    const unsigned long MIN_OFF_TIME = 120000;   // Pump rests at least 2 minutes between runs
+    const bool INHIBIT_ON_RAIN = true;           // Don't irrigate while rain is detected
+    const bool INHIBIT_ON_LOW_WATER = true;      // Don't run the pump when the tank is "Low"
+}
+
+// Irrigation zones, one soil probe and one valve relay each. The first row is
+// the original bed: the board's soil probe and pump relay. Further probes need
+// ADC1 pins (ADC2 is unusable while WiFi is on) or an external multiplexer.
+struct ZoneConfig {
+    int soilPin;
+    int relayPin;                    // Low-triggered, like the pump relay
+};
+
+namespace Zones {
+    const ZoneConfig TABLE[] = {
+        {Pins::SOIL_MOISTURE_PIN, Pins::RELAY_PIN},
+    };
+    const uint8_t COUNT = sizeof(TABLE) / sizeof(TABLE[0]);
+    const uint8_t MAX_ZONES = 16;                // Zone masks are 16 bits wide
+    const uint8_t MAX_OPEN_VALVES = 2;           // Pump capacity: valves open at the same time
 }
 
 namespace Timing {
     const unsigned long SENSOR_INTERVAL = 2000;  
     const unsigned long SEND_INTERVAL = 300000;  
+    const long LOCAL_UTC_OFFSET = 7 * 3600;      // Local time (WIB, UTC+7) for day/night sampling
+    const int NIGHT_START_HOUR = 19;             // Night-time sampling from 19:00...
+    const int NIGHT_END_HOUR = 6;                // ...until 06:00 local time
+    const uint16_t ROLLUP_WINDOWS[] = {1, 12};   // Rollup windows in send intervals (5 min, 1 h)
+    const unsigned long MEMORY_SAMPLE_INTERVAL = 10000;  // Heap and stack high-water sampling (see MemoryDiagnostics)
+    const unsigned long LOOP_PERIOD = 100;       // Longest idle between loop() passes; sampling wakes it earlier
+    const char* const NTP_SERVER = "pool.ntp.org";
+    const uint32_t NTP_SYNC_INTERVAL = 900000;   // SNTP resync in the background (see SampleClock)
+}
+
+// Modem and WiFi duty cycling (see RadioManager)
+namespace RadioPolicy {
+    const bool DUTY_CYCLING = true;                      // false keeps the modem and WiFi on permanently
+    const unsigned long COMMAND_POLL_INTERVAL = 120000;  // Wake between uploads to collect commands held by the broker
+    const unsigned long LISTEN_TIME = 3000;              // Stay online after CONNACK for held commands to arrive
+    const unsigned long ASSOCIATE_TIMEOUT = 60000;       // Modem boot plus WiFi association
+    const unsigned long CONNECT_TIMEOUT = 20000;         // TLS handshake plus CONNACK
+    const unsigned long INITIAL_ASSOCIATE_ESTIMATE = 20000;
+    const unsigned long INITIAL_CONNECT_ESTIMATE = 3000;
+    const unsigned long WARMUP_MARGIN = 2000;            // Added to the measured warm-up when scheduling power-up
+    const bool STAY_ON_WHILE_PUMPING = true;             // Keep the link up so a running pump can be stopped remotely
+}
+
+namespace WiFiPolicy {
+    const unsigned long FAST_JOIN_TIMEOUT = 1500;        // Cached BSSID/channel not joined by then: scan instead
+    const unsigned long JOIN_TIMEOUT = 10000;            // Blocking join in setup()
+    const bool REUSE_ADDRESS = true;                     // Skip DHCP with the cached lease
+    const uint32_t ADDRESS_MAX_AGE = 6UL * 3600;         // Lease older than this (s) is renewed through DHCP
+}
+
+// Gateway role: leaf nodes report over ESP-NOW, the gateway uplinks for them (see LeafGateway)
+namespace Gateway {
+    const uint16_t MAX_LEAVES = 64;
+    const size_t BATCH_BYTES = 1280;                     // Leaf reports per MQTT message; fits MQTTTransport::MAX_PACKET_SIZE with the topic
+    const unsigned long BATCH_INTERVAL = 60000;          // Oldest report waits at most this long for the uplink
+    const uint8_t FRAMES_PER_LOOP = 32;                  // Bounds the time one loop() pass spends on leaves
+    const unsigned long POLL_PERIOD = 10;                // Longest idle between passes, well inside a leaf's ACK timeout
+}
+
+// Soil moisture trend of each zone (see MoistureTrend)
+namespace Trend {
+    const uint8_t BUCKETS = 12;                          // Window = BUCKETS bucket spans
+    const unsigned long DRYING_SPAN = 600000;            // Bucket span with the valve closed: a 2 h window
+    const unsigned long WETTING_SPAN = 15000;            // Bucket span while watering: a 3 min window
+    const uint8_t MIN_BUCKETS = 3;                       // History needed before the fit is used
+    const uint16_t MIN_SAMPLES = 6;
+    const float SIGNIFICANCE = 2.0f;                     // Predictions need a slope this many standard errors from 0
+    const unsigned long STOP_LEAD = 60000;               // An open zone is judged by the moisture expected this far ahead
+    const float QUIET_HORIZON = 7200.0f;                 // s; every closed zone at least this far from its ON threshold...
+    const unsigned long QUIET_PERIOD = 300000;           // ...lets the soil probes back off to this period
+}
+
+// Pump dry-run protection (see DryRunGuard); a trip lands within TRIP_SAMPLES x SAMPLE_PERIOD
+namespace DryRun {
+    const int TRIP_LEVEL = 30;                           // % of the water level sensor height, below the Low status
+    const int RESET_LEVEL = 40;                          // Valves are released once the tank is back here
+    const uint8_t TRIP_SAMPLES = 3;                      // Low reads in a row: a slosh is not an empty tank
+    const uint64_t SAMPLE_PERIOD = 100000;               // µs between water level reads while a valve is open
+}
+
+// Loop stall detection; per-stage deadlines are in LoopWatchdog.cpp
+namespace Watchdog {
+    const uint32_t TASK_TIMEOUT = 60;                    // s; ESP task watchdog on the loop task, above every stall limit
+    const uint64_t CHECK_PERIOD = 1000000;               // µs between supervisor checks of the running stage
+    const uint8_t LOG_SIZE = 8;                          // Overruns kept in RTC memory until published
+}
+
+// Firmware updates over MQTT (see FirmwareUpdater)
+namespace Ota {
+    const uint32_t WINDOW = 8192;                        // Bytes per request; the next one goes out half way through
+    const unsigned long CHUNK_TIMEOUT = 10000;           // No data this long: ask again from the last byte taken
+    const uint8_t MAX_IDLE_REQUESTS = 30;                // Timeouts in a row before the update is suspended
+    const uint32_t CHECKPOINT_BYTES = 32768;             // Flash written between NVS checkpoints; a reset repeats at most this
+    const unsigned long RESTART_DELAY = 10000;           // Longest wait for the "ready" report before restarting
+}
+
+// Per-sensor adaptive sampling policy (see SamplingScheduler)
+struct SamplingPolicy {
+    unsigned long basePeriod;        // Starting sampling period (ms)
+    unsigned long minPeriod;         // Fastest period while the signal changes or the pump runs (ms)
+    unsigned long maxPeriod;         // Slowest period while the signal is steady (ms)
+    float activityThreshold;         // Per-sample change (reading units) considered "changing"
+    bool fastWhilePumping;           // Sample at minPeriod while the relay is ON
+    bool slowAtNight;                // Sample at maxPeriod during the night
+    uint16_t maxSamplesPerHour;      // Energy budget: reads allowed per hour
+    uint32_t maxCpuMicrosPerHour;    // CPU budget: time allowed in readData() per hour
+};
+
+// Plausibility of one snapshot field, checked as samples stream in (see SignalMonitor); 0 turns a check off
+struct SignalLimits {
+    float resolution;                // Smallest step the sensor reports; smaller changes count as unchanged
+    uint32_t stuckTime;              // Unchanged this long (ms) means the input is stuck
+    float maxRate;                   // Largest credible change per second, on top of one resolution step
+    float noise;                     // Standard deviation of the reading noise
+    float drift;                     // Credible change of the true value per √s (Kalman process noise)
+    float low;                       // Ends of the reported range: a reading held there is saturated,
+    float high;                      // not stuck (low == high: unbounded)
+};
+
+namespace Anomaly {
+    const float OUTLIER_SIGMA = 4.0f;            // Kalman innovation gate
+    const uint16_t STUCK_MIN_SAMPLES = 10;       // A stuck verdict also needs this many unchanged reads
+    const uint8_t LEVEL_SHIFT_SAMPLES = 5;       // Rejected reads that agree with each other this often are a real step
 }
 
 namespace CalibrationUtils {
+    void loadCalibrationCurves();
+    CalibrationCurve* findCurve(const char* name);
     bool validateSoilMoistureReading(int rawValue);
     bool validateWaterLevelReading(int rawValue);
     bool validateTemperatureReading(float temperature);
@@ -0,0 +1,66 @@
+#ifndef SIGNAL_MONITOR_H
+#define SIGNAL_MONITOR_H
+
+#include <Arduino.h>
+#include "utils/SensorCalibration.h"
+
+// Streaming plausibility check of one field, O(1) time and memory per
+// sample. Each reading is compared with:
+//   - the last accepted reading, against SignalLimits::maxRate (RATE);
+//   - a scalar Kalman filter of the field, whose innovation must stay within
+//     Anomaly::OUTLIER_SIGMA standard deviations (OUTLIER);
+//   - the previous reading, to find an input that stopped moving (STUCK).
+// RATE and OUTLIER readings are rejected and leave the filter alone; both
+// gates widen with the time since the last accepted reading, and a run of
+// rejected readings that agree with each other is taken as a real step.
+// A STUCK reading is still accepted: it is the input, not the value, that
+// is suspect.
+class SignalMonitor {
+public:
+    enum Verdict : uint8_t {
+        OK = 0,
+        STUCK,
+        RATE,
+        OUTLIER,
+        VERDICT_COUNT
+    };
+
+private:
+    const SignalLimits* limits;      // Static; nullptr = no checks
+    bool started;
+    Verdict verdict;
+
+    float estimate;                  // Kalman state and its variance
+    float variance;
+    float accepted;                  // Last accepted reading
+    unsigned long acceptedAt;
+
+    float previous;                  // Last reading, accepted or not
+    unsigned long unchangedSince;
+    uint16_t unchangedSamples;
+
+    float shiftLevel;                // First of the rejected readings in a row
+    uint8_t shiftSamples;
+
+    uint16_t counts[VERDICT_COUNT];  // Suspect readings since the last resetCounts()
+
+    void restart(float value, unsigned long now);
+
+public:
+    explicit SignalMonitor(const SignalLimits* limits = nullptr);
+    void setLimits(const SignalLimits* signalLimits) { limits = signalLimits; }
+
+    Verdict add(float value, unsigned long now);
+
+    Verdict getVerdict() const { return verdict; }
+    bool isSuspect() const { return verdict != OK; }
+    float getAccepted() const { return accepted; }
+    float getEstimate() const { return estimate; }
+    uint16_t getCount(Verdict kind) const { return counts[kind]; }
+    bool hasCounts() const;
+    void resetCounts();
+
+    static const char* verdictName(Verdict verdict);
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "actuators/DryRunGuard.h"
+
+DryRunGuard::DryRunGuard(int waterLevelPin) : pin(waterLevelPin) {
+    config = {
+        DryRun::TRIP_LEVEL,
+        DryRun::RESET_LEVEL,
+        DryRun::TRIP_SAMPLES
+    };
+    bus = nullptr;
+    cut = nullptr;
+    cutContext = nullptr;
+    timer = nullptr;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    armed = false;
+    tripped = false;
+    acknowledged = true;
+    lowCount = 0;
+    firstLowAt = 0;
+    level = -1;
+    tripLevelSeen = 0;
+    tripLatency = 0;
+    trips = 0;
+    fastSamples = 0;
+}
+
+void DryRunGuard::begin(EventBus& eventBus, CutHandler handler, void* context) {
+    bus = &eventBus;
+    cut = handler;
+    cutContext = context;
+
+    esp_timer_create_args_t args = {};
+    args.callback = onSample;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "dry_run";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        timer = nullptr;
+        Serial.println("Dry-run guard: timer failed - the water level is only checked at its sampling period");
+    }
+    Serial.printf("Dry-run guard: pump cut at %d%% tank level after %u reads %lu ms apart\n", config.tripLevel,
+                  config.tripSamples, (unsigned long)(DryRun::SAMPLE_PERIOD / 1000));
+}
+
+void DryRunGuard::setConfig(const DryRunConfig& newConfig) {
+    portENTER_CRITICAL(&lock);
+    config = newConfig;
+    if (config.tripSamples == 0) config.tripSamples = 1;
+    if (config.resetLevel < config.tripLevel) config.resetLevel = config.tripLevel;
+    lowCount = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool DryRunGuard::check(int levelPercent, unsigned long now) {
+    // Called with the lock held; true when this read trips the guard
+    level = levelPercent;
+    if (tripped || !armed) return false;
+    if (levelPercent > config.tripLevel) {
+        lowCount = 0;
+        return false;
+    }
+
+    if (lowCount == 0) firstLowAt = now;
+    if (++lowCount < config.tripSamples) return false;
+
+    tripped = true;
+    acknowledged = false;
+    tripLevelSeen = levelPercent;
+    tripLatency = now - firstLowAt;
+    trips++;
+    lowCount = 0;
+    return true;
+}
+
+void DryRunGuard::raise(int levelPercent) {
+    // Pins first, the bookkeeping follows in the loop task
+    if (cut) cut(cutContext);
+    Event event;
+    event.type = Events::DRY_RUN_TRIP;
+    event.dryRun.level = static_cast<int16_t>(levelPercent);
+    event.dryRun.latency = static_cast<uint16_t>(tripLatency > 65535UL ? 65535UL : tripLatency);
+    if (bus) bus->post(event);
+}
+
+void DryRunGuard::onSample(void* arg) {
+    DryRunGuard& guard = *static_cast<DryRunGuard*>(arg);
+
+    // Until the loop task has closed the zones, a control pass could still drive a valve on
+    if (guard.tripped) {
+        if (!guard.acknowledged && guard.cut) guard.cut(guard.cutContext);
+        return;
+    }
+
+    int levelPercent = WaterLevelCalibration::convertToPercentage(analogRead(guard.pin));
+    portENTER_CRITICAL(&guard.lock);
+    guard.fastSamples++;
+    bool trip = guard.check(levelPercent, millis());
+    portEXIT_CRITICAL(&guard.lock);
+    if (trip) guard.raise(levelPercent);
+}
+
+void DryRunGuard::update(bool pumping) {
+    if (pumping == armed) return;
+
+    portENTER_CRITICAL(&lock);
+    armed = pumping;
+    lowCount = 0;
+    portEXIT_CRITICAL(&lock);
+
+    if (!timer) return;
+    if (pumping) {
+        esp_timer_start_periodic(timer, DryRun::SAMPLE_PERIOD);
+    } else {
+        esp_timer_stop(timer);
+    }
+}
+
+void DryRunGuard::sample(int levelPercent, unsigned long now) {
+    portENTER_CRITICAL(&lock);
+    bool trip = check(levelPercent, now);
+    bool cleared = tripped && acknowledged && levelPercent >= config.resetLevel;
+    if (cleared) tripped = false;
+    portEXIT_CRITICAL(&lock);
+
+    if (cleared) {
+        Serial.printf("Dry-run guard: tank back at %d%% - valves released\n", levelPercent);
+    }
+    // Also without the timer: the pipeline's own read saw the tank run low
+    if (trip) raise(levelPercent);
+}
+
+String DryRunGuard::describeTrip() const {
+    return "Dry-run trip: tank at " + String(tripLevelSeen) + "% (cut at " + String(config.tripLevel) +
+           "%), cut " + String(tripLatency) + " ms after the first low read";
+}
+
+void DryRunGuard::serialize(JsonDocument& doc) {
+    JsonObject dryRun = doc["dryRun"].to<JsonObject>();
+    dryRun["state"] = tripped ? "tripped" : (armed ? "armed" : "idle");
+    if (level >= 0) dryRun["level"] = level;
+    dryRun["tripLevel"] = config.tripLevel;
+    dryRun["trips"] = trips;
+    dryRun["fastReads"] = fastSamples;
+    fastSamples = 0;
+    if (trips) {
+        // [level %, ms from the first low read to the cut] of the latest trip
+        JsonArray last = dryRun["lastTrip"].to<JsonArray>();
+        last.add(tripLevelSeen);
+        last.add(tripLatency);
+    }
+}
@@ -1,41 +1,133 @@
 #include "actuators/RelayController.h"
+#include "utils/SensorCalibration.h"
+#include "utils/LatencyTrace.h"
 
 RelayController::RelayController(int relayPin) : pin(relayPin) {
     isActive = false;
     lastState = false;
+    config = {
+        RelayThresholds::SOIL_MOISTURE_THRESHOLD,
+        RelayThresholds::SOIL_MOISTURE_OFF_THRESHOLD,
+        RelayThresholds::MIN_ON_TIME,
+        RelayThresholds::MIN_OFF_TIME,
+        RelayThresholds::INHIBIT_ON_RAIN,
+        RelayThresholds::INHIBIT_ON_LOW_WATER
+    };
+    lastChangeTime = 0;
+    heldForCapacity = false;
+    statsWindowStart = 0;
+    decisionCount = 0;
+    toggleCount = 0;
+    lastHourDecisions = 0;
+    lastHourToggles = 0;
 }
 
-void RelayController::begin() {
+void RelayController::begin(bool initialState, unsigned long stateAge) {
+    // Level first, then output: the pin never drives the opposite state, not even for a cycle
+    digitalWrite(pin, initialState ? LOW : HIGH);  // LOW = ON, HIGH = OFF for low-triggered relay
     pinMode(pin, OUTPUT);
-    digitalWrite(pin, HIGH);  // Start with relay OFF (HIGH = OFF for low-triggered relay)
-    isActive = false;
-    lastState = false;
-    Serial.printf("Relay controller initialized on GPIO%d\n", pin);
+    isActive = initialState;
+    lastState = initialState;
+    // Without a known age, boot counts as the last change so a reset can't shortcut the dwell time
+    unsigned long now = millis();
+    lastChangeTime = now - stateAge;
+    statsWindowStart = now;
+    Serial.printf("Relay controller initialized on GPIO%d, %s\n", pin, initialState ? "ON" : "OFF");
+}
+
+void RelayController::setConfig(const PumpControlConfig& newConfig) {
+    config = newConfig;
+}
+
+const PumpControlConfig& RelayController::getConfig() const {
+    return config;
 }
 
 bool RelayController::shouldActivate(int soilMoisture) {
-    return (soilMoisture <= SOIL_THRESHOLD);  // Only check soil moisture
+    // Hysteresis: start at the ON threshold, keep running until the OFF threshold is reached
+    if (isActive) {
+        return (soilMoisture < config.offThreshold);
+    }
+    return (soilMoisture <= config.onThreshold);
 }
 
-void RelayController::control(int soilMoisture, String& reason) {
-    bool shouldActivate = this->shouldActivate(soilMoisture);
+void RelayController::control(int soilMoisture, bool rainDetected, bool waterLow, String& reason, bool mayOpen,
+                              bool demanded) {
+    unsigned long now = millis();
+    updateStatsWindow(now);
+    decisionCount++;
+    heldForCapacity = false;
+    
+    // Inhibitions switch the pump off immediately, regardless of dwell time
+    if (config.inhibitOnLowWater && waterLow) {
+        reason = "Water tank level Low - pump inhibited (" + String(soilMoisture) + "%)";
+        applyState(false);
+        return;
+    }
+    if (config.inhibitOnRain && rainDetected) {
+        reason = "Rain detected - irrigation inhibited (" + String(soilMoisture) + "%)";
+        applyState(false);
+        return;
+    }
     
-    if (shouldActivate) {
+    bool shouldActivate = demanded || this->shouldActivate(soilMoisture);
+    
+    if (demanded) {
+        reason = "Watering requested (" + String(soilMoisture) + "%)";
+    } else if (shouldActivate) {
         reason = "Low soil moisture detected (" + String(soilMoisture) + "%)";
     } else {
         reason = "Soil moisture sufficient (" + String(soilMoisture) + "%)";
     }
     
-    // Update relay state - LOW-triggered relay (LOW = ON, HIGH = OFF)
-    isActive = shouldActivate;
-    digitalWrite(pin, isActive ? LOW : HIGH);  // LOW = ON, HIGH = OFF for low-triggered relay
+    if (shouldActivate != isActive) {
+        unsigned long minDwell = isActive ? config.minOnTime : config.minOffTime;
+        if (now - lastChangeTime < minDwell) {
+            return;  // Hold current state until the minimum dwell time has elapsed
+        }
+    }
+    
+    if (shouldActivate && !isActive && !mayOpen) {
+        reason = "Waiting for pump capacity (" + String(soilMoisture) + "%)";
+        heldForCapacity = true;
+        return;
+    }
+    
+    applyState(shouldActivate);
+}
+
+void RelayController::failSafe() const {
+    // Only the pin: the loop task may be stuck halfway through changing the state
+    digitalWrite(pin, HIGH);  // HIGH = OFF for low-triggered relay
 }
 
 void RelayController::setRelayState(bool state) {
+    LATENCY_TRACE_POINT(STAGE_RELAY_SET);
+    updateStatsWindow(millis());
+    applyState(state);
+}
+
+void RelayController::applyState(bool state) {
+    if (state != isActive) {
+        lastChangeTime = millis();
+        toggleCount++;
+    }
+    
+    // Update relay state - LOW-triggered relay (LOW = ON, HIGH = OFF)
     isActive = state;
     digitalWrite(pin, isActive ? LOW : HIGH);  // LOW = ON, HIGH = OFF for low-triggered relay
 }
 
+void RelayController::updateStatsWindow(unsigned long now) {
+    if (now - statsWindowStart >= STATS_WINDOW) {
+        lastHourDecisions = decisionCount;
+        lastHourToggles = toggleCount;
+        decisionCount = 0;
+        toggleCount = 0;
+        statsWindowStart = now;
+    }
+}
+
 bool RelayController::isRelayActive() const {
     return isActive;
 }
@@ -48,10 +140,20 @@ void RelayController::updateLastState() {
     lastState = isActive;
 }
 
+unsigned long RelayController::getDecisionsPerHour() const {
+    return lastHourDecisions;
+}
+
+unsigned long RelayController::getTogglesPerHour() const {
+    return lastHourToggles;
+}
+
 void RelayController::printDebugInfo(const String& reason) const {
     String status = isActive ? "ACTIVATED" : "DEACTIVATED";
     Serial.println("=== WATER PUMP " + status + " ===");
     Serial.println("Reason: " + reason);
     Serial.printf("Relay Pin (GPIO%d) set to: %s\n", pin, isActive ? "LOW (ON)" : "HIGH (OFF)");
     Serial.printf("Expected LED behavior: %s\n", isActive ? "LED OFF (pump running)" : "LED ON (pump stopped)");
-}
\ No newline at end of file
+    Serial.printf("Control stats (current hour): %lu decisions, %lu toggles (last hour: %lu / %lu)\n",
+                  decisionCount, toggleCount, lastHourDecisions, lastHourToggles);
+}
@@ -0,0 +1,261 @@
+#include "actuators/ZoneController.h"
+
+ZoneController::ZoneController() : zones(makeZones(std::make_index_sequence<Zones::COUNT>{})) {
+    nextToOpen = 0;
+    capacityWaits = 0;
+}
+
+void ZoneController::begin(uint16_t openMask, uint16_t overrideMask, unsigned long stateAge) {
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        Zone& zone = zones[i];
+        zone.relay.begin((openMask >> i) & 1, stateAge);
+        zone.manualOverride = (overrideMask >> i) & 1;
+    }
+    for (uint8_t i = 1; i < Zones::COUNT; i++) {
+        zones[i].probe.begin();
+    }
+    Serial.printf("Zone controller: %u zone(s), at most %u valve(s) open\n", Zones::COUNT, Zones::MAX_OPEN_VALVES);
+}
+
+void ZoneController::updateTrend(Zone& zone, unsigned long now) {
+    // Opening or closing the valve starts a new regime
+    MoistureTrend::Mode mode = zone.relay.isRelayActive() ? MoistureTrend::WETTING : MoistureTrend::DRYING;
+    if (mode != zone.trend.getMode()) zone.trend.restart(mode);
+    if (zone.probeValid) zone.trend.add(zone.moisture, now);
+}
+
+void ZoneController::sample(int primaryMoisture, bool primaryValid) {
+    unsigned long now = millis();
+    zones[0].moisture = primaryMoisture;
+    zones[0].probeValid = primaryValid;
+    updateTrend(zones[0], now);
+    for (uint8_t i = 1; i < Zones::COUNT; i++) {
+        Zone& zone = zones[i];
+        zone.probeValid = zone.probe.readData();
+        zone.moisture = zone.probe.getPercentage();
+        if (!zone.probeValid) {
+            updateTrend(zone, now);
+            continue;
+        }
+
+        // Same checks as zone 1: a spike keeps the last credible value, a stuck probe is invalid
+        SignalMonitor::Verdict before = zone.monitor.getVerdict();
+        SignalMonitor::Verdict verdict = zone.monitor.add(zone.moisture, now);
+        if (verdict != before) {
+            Serial.printf("Zone %u probe: %s (%d%%)\n", i + 1, SignalMonitor::verdictName(verdict), zone.moisture);
+        }
+        if (verdict == SignalMonitor::STUCK) {
+            zone.probeValid = false;
+        } else if (verdict != SignalMonitor::OK) {
+            zone.moisture = lroundf(zone.monitor.getAccepted());
+        }
+        updateTrend(zone, now);
+    }
+}
+
+void ZoneController::control(bool rainDetected, bool waterLow, const RuleEngine::Decision& rules) {
+    // Open zones decide first, so capacity they give up goes to closed zones in the same pass
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        Zone& zone = zones[i];
+        if (!zone.relay.isRelayActive() || zone.manualOverride) continue;
+        if (!zone.probeValid) {
+            zone.reason = "Soil probe reading invalid - valve closed";
+            zone.relay.setRelayState(false);
+            continue;
+        }
+        if (rules.inhibits(i)) {
+            zone.reason = "Rule '" + String(rules.rule[i]) + "' - irrigation inhibited (" + String(zone.moisture) + "%)";
+            zone.relay.setRelayState(false);
+            continue;
+        }
+        // Judged by the moisture expected STOP_LEAD ahead, so the valve closes before the soil overshoots
+        int expected = lroundf(zone.trend.project(zone.moisture, Trend::STOP_LEAD));
+        int offThreshold = zone.relay.getConfig().offThreshold;
+        bool early = zone.moisture < offThreshold && expected >= offThreshold;
+        zone.relay.control(expected, rainDetected, waterLow, zone.reason, true, rules.demands(i));
+        if (early && !zone.relay.isRelayActive() && !rainDetected && !waterLow) {
+            zone.reason = "Soil reaches target within " + String(Trend::STOP_LEAD / 1000) + " s (" +
+                          String(zone.moisture) + "% now, " + String(expected) + "% expected)";
+        }
+        if (rules.demands(i)) zone.reason = "Rule '" + String(rules.rule[i]) + "': " + zone.reason;
+    }
+
+    uint8_t open = countOpen();
+    uint8_t first = nextToOpen;
+    for (uint8_t n = 0; n < Zones::COUNT; n++) {
+        uint8_t i = (first + n) % Zones::COUNT;
+        Zone& zone = zones[i];
+        if (zone.relay.isRelayActive() || zone.manualOverride || !zone.probeValid || rules.inhibits(i)) continue;
+
+        zone.relay.control(zone.moisture, rainDetected, waterLow, zone.reason, open < Zones::MAX_OPEN_VALVES,
+                           rules.demands(i));
+        if (rules.demands(i)) zone.reason = "Rule '" + String(rules.rule[i]) + "': " + zone.reason;
+        if (zone.relay.isRelayActive()) {
+            open++;
+            nextToOpen = (i + 1) % Zones::COUNT;
+        } else if (zone.relay.isHeldForCapacity()) {
+            capacityWaits++;
+        }
+    }
+}
+
+void ZoneController::failSafe() const {
+    for (const Zone& zone : zones) {
+        zone.relay.failSafe();
+    }
+}
+
+void ZoneController::cutOff(const String& reason) {
+    for (Zone& zone : zones) {
+        if (!zone.relay.isRelayActive() && !zone.manualOverride) continue;
+        zone.manualOverride = false;
+        zone.reason = reason;
+        zone.relay.setRelayState(false);
+    }
+}
+
+void ZoneController::setPumpConfig(const PumpControlConfig& config) {
+    for (Zone& zone : zones) {
+        zone.relay.setConfig(config);
+    }
+}
+
+bool ZoneController::command(uint8_t index, bool on, const String& reason) {
+    if (index >= Zones::COUNT) {
+        Serial.printf("Relay command for unknown zone %u ignored\n", index + 1);
+        return false;
+    }
+
+    Zone& zone = zones[index];
+    if (on && !zone.relay.isRelayActive() && countOpen() >= Zones::MAX_OPEN_VALVES) {
+        int preempted = findPreemptable();
+        if (preempted < 0) {
+            Serial.printf("Zone %u: pump capacity held by manual zones, command rejected\n", index + 1);
+            return false;
+        }
+        zones[preempted].reason = "Closed for manual zone " + String(index + 1) + " (pump capacity)";
+        zones[preempted].relay.setRelayState(false);
+    }
+
+    zone.manualOverride = on;
+    zone.reason = reason;
+    zone.relay.setRelayState(on);
+    return true;
+}
+
+void ZoneController::getRuleInputs(RuleEngine::ZoneInputs* inputs) const {
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        const Zone& zone = zones[i];
+        inputs[i].moisture = zone.probeValid ? static_cast<float>(zone.moisture) : NAN;
+        inputs[i].valve = zone.relay.isRelayActive() ? 1.0f : 0.0f;
+        inputs[i].manual = zone.manualOverride ? 1.0f : 0.0f;
+        inputs[i].trend = zone.probeValid ? zone.trend.getSlopePerHour() : NAN;
+
+        // Hours until the valve is expected to switch: to the OFF threshold while open, the ON threshold while closed
+        const PumpControlConfig& config = zone.relay.getConfig();
+        float level = zone.relay.isRelayActive() ? config.offThreshold : config.onThreshold;
+        inputs[i].eta = zone.probeValid ? zone.trend.secondsTo(level) / 3600.0f : NAN;
+    }
+}
+
+float ZoneController::getQuietSeconds() const {
+    float quiet = INFINITY;
+    for (const Zone& zone : zones) {
+        if (zone.relay.isRelayActive()) return 0.0f;
+        if (zone.manualOverride) continue;
+        if (!zone.probeValid || !zone.trend.isFitted()) return 0.0f;
+        if (zone.trend.getSlopePerHour() > 0.0f && zone.trend.isSignificant()) continue;   // Rain or a neighbour's water
+
+        float seconds = zone.trend.secondsTo(zone.relay.getConfig().onThreshold);
+        if (isnan(seconds)) {
+            // Flat soil: quiet only while well above the ON threshold
+            if (zone.moisture <= zone.relay.getConfig().offThreshold) return 0.0f;
+            continue;
+        }
+        quiet = fminf(quiet, seconds);
+    }
+    return quiet;
+}
+
+uint8_t ZoneController::countOpen() const {
+    uint8_t open = 0;
+    for (const Zone& zone : zones) {
+        if (zone.relay.isRelayActive()) open++;
+    }
+    return open;
+}
+
+int ZoneController::findPreemptable() const {
+    // The open automatic zone that needs water least
+    int best = -1;
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        const Zone& zone = zones[i];
+        if (!zone.relay.isRelayActive() || zone.manualOverride) continue;
+        if (best < 0 || zone.moisture > zones[best].moisture) best = i;
+    }
+    return best;
+}
+
+uint16_t ZoneController::getOpenMask() const {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        if (zones[i].relay.isRelayActive()) mask |= (1u << i);
+    }
+    return mask;
+}
+
+uint16_t ZoneController::getOverrideMask() const {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        if (zones[i].manualOverride) mask |= (1u << i);
+    }
+    return mask;
+}
+
+void ZoneController::serialize(JsonDocument& doc) const {
+    JsonObject zonesJson = doc["zones"].to<JsonObject>();
+    zonesJson["maxOpen"] = Zones::MAX_OPEN_VALVES;
+    zonesJson["capacityWaits"] = capacityWaits;
+
+    // [moisture, open, manual, waiting] per zone, zone 1 first
+    JsonArray valves = zonesJson["valves"].to<JsonArray>();
+    for (const Zone& zone : zones) {
+        JsonArray entry = valves.add<JsonArray>();
+        if (zone.probeValid) {
+            entry.add(zone.moisture);
+        } else {
+            entry.add(nullptr);
+        }
+        entry.add(zone.relay.isRelayActive() ? 1 : 0);
+        entry.add(zone.manualOverride ? 1 : 0);
+        entry.add(zone.relay.isHeldForCapacity() ? 1 : 0);
+    }
+
+    // [slope %/h, s until the valve is expected to switch] per zone; null until known
+    JsonArray trends = zonesJson["trend"].to<JsonArray>();
+    for (const Zone& zone : zones) {
+        JsonArray entry = trends.add<JsonArray>();
+        float slope = zone.trend.getSlopePerHour();
+        const PumpControlConfig& config = zone.relay.getConfig();
+        float eta = zone.trend.secondsTo(zone.relay.isRelayActive() ? config.offThreshold : config.onThreshold);
+        if (zone.probeValid && !isnan(slope)) {
+            entry.add(roundf(slope * 100.0f) / 100.0f);
+        } else {
+            entry.add(nullptr);
+        }
+        if (zone.probeValid && !isnan(eta)) {
+            entry.add(lroundf(eta));
+        } else {
+            entry.add(nullptr);
+        }
+    }
+}
+
+void ZoneController::printStatus() const {
+    for (uint8_t i = 0; i < Zones::COUNT; i++) {
+        const Zone& zone = zones[i];
+        Serial.printf(" zone%u=%d%%/%s%s", i + 1, zone.moisture, zone.relay.isRelayActive() ? "ON" : "OFF",
+                      zone.manualOverride ? "[MANUAL]" : (zone.relay.isHeldForCapacity() ? "[WAIT]" : ""));
+    }
+    Serial.println();
+}
@@ -0,0 +1,671 @@
+#include "app/IrrigationApp.h"
+#include "utils/LatencyTrace.h"
+
+IrrigationApp::IrrigationApp(const DeviceConfig& config)
+    : config(config), scheduler(sensors), rollup(sensors), anomalies(sensors),
+      modemRelay(Pins::MODEM_RELAY_PIN), oled(Pins::SDA_PIN, Pins::SCL_PIN),
+      mqttClient(config.mqttServer, config.mqttPort, config.mqttUser, config.mqttPassword,
+                 config.deviceId, config.sensorTopic, config.relayTopic, config.statusTopic,
+                 config.relayCommandTopic),
+      radio(modemRelay, wifi, mqttClient), ota(mqttClient) {
+    // Control first, so the display shows the relay state of the same pass
+    bus.subscribe("control", Events::bit(Events::SENSOR_SNAPSHOT) | Events::bit(Events::RAIN_EDGE) |
+                             Events::bit(Events::RELAY_COMMAND) | Events::bit(Events::RULES_UPDATE) |
+                             Events::bit(Events::DRY_RUN_TRIP) | Events::bit(Events::CONFIG_UPDATE),
+                  onControlEvent, this);
+    bus.subscribe("display", Events::bit(Events::SENSOR_SNAPSHOT) | Events::bit(Events::CONNECTIVITY),
+                  onDisplayEvent, this);
+    mqttClient.setEventBus(bus);
+    mqttClient.setFirmwareUpdater(ota);
+    
+    lastCommandId = 0;
+    pendingCommand = RelayCommand();
+    commandPending = false;
+    lastRainEdge = 0;
+    sensorDataValid = false;
+    lastSummaryPrint = 0;
+    lastDataSent = 0;
+    sendInterval = Timing::SEND_INTERVAL;
+    summaryInterval = Timing::SENSOR_INTERVAL;
+    oversizedPayloads = 0;
+    leafLink = nullptr;
+    gateway = nullptr;
+    leafCapacity = 0;
+}
+
+IrrigationApp::~IrrigationApp() {
+    delete gateway;
+}
+
+void IrrigationApp::setLeafLink(LeafLink* link, uint16_t capacity) {
+    leafLink = link;
+    leafCapacity = capacity;
+}
+
+void IrrigationApp::setup() {
+    // Armed first, so a hang anywhere from here on turns the valves off; the
+    // reset reason it reads decides what restoreControlState() brings back
+    watchdog.begin(onLoopStall, this);
+    LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_SETUP);
+    
+    // The pump goes back to its pre-reset state before anything else runs
+    restoreControlState();
+    
+    modemRelay.begin();  
+    delay(2000);
+    
+    Serial.println("=== Smart Irrigation System with MQTT ===");
+    
+    initializeComponents();
+    beginRules();
+    dryRun.begin(bus, onDryRunCut, this);
+    // The stored configuration is in force before the first reading; the broker's retained copy follows on connect
+    beginSettings();
+    // Before the first connect, so the retained offer finds an interrupted update restored
+    ota.begin();
+    
+    // SNTP runs in the background from here on; nothing waits for the first sync
+    clock.begin();
+    bus.setWakeTask(xTaskGetCurrentTaskHandle());
+    if (leafLink) {
+        // Leaves report whenever they wake, so the gateway's radio can't be duty cycled
+        gateway = new LeafGateway(*leafLink, mqttClient, leafCapacity);
+        bus.subscribe("gateway", Events::bit(Events::LEAF_COMMAND), onGatewayEvent, this);
+        mqttClient.enableGateway();
+        radio.setDutyCycling(false);
+    }
+    if constexpr (BoardSensors::has<RainSensor>()) {
+        attachInterruptArg(Pins::RAIN_SENSOR_PIN, onRainEdge, this, CHANGE);
+    }
+    
+    // The modem hotspot is still booting; the cached access point gets that long before a scan
+    {
+        LoopWatchdog::Scope connectStage(watchdog, LoopWatchdog::STAGE_MQTT);
+        wifi.begin(config.wifiSsid, config.wifiPassword);
+        wifi.connect(millis(), RadioPolicy::INITIAL_ASSOCIATE_ESTIMATE);
+        if (mqttClient.connectWiFi(wifi)) {
+            Serial.println("WiFi connected successfully!");
+            
+            if (mqttClient.connectMQTT()) {
+                Serial.println("MQTT connected successfully!");
+            } else {
+                Serial.println("MQTT connection failed - will retry automatically");
+            }
+        } else {
+            Serial.println("WiFi connection failed!");
+        }
+    }
+    
+    // ESP-NOW needs the station started; leaves follow the access point's channel
+    if (gateway && !gateway->begin()) {
+        Serial.println("Leaf link failed - gateway disabled");
+        delete gateway;
+        gateway = nullptr;
+    }
+
+    testSensors();
+    scheduler.begin(millis());
+    
+    // From here on the modem and WiFi are only powered around uploads and command polls
+    radio.begin(millis());
+    radio.scheduleUpload(lastDataSent + sendInterval);
+    
+    // Heap left after setup() is the baseline for drift
+    memory.begin(millis());
+    
+    Serial.println("Smart Irrigation System Ready!");
+}
+
+void IrrigationApp::loop() {
+    unsigned long currentTime = millis();
+    
+    // Sampling goes first so network and display work don't delay due reads;
+    // events are dispatched after the MQTT client has posted any remote command
+    {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_SENSORS);
+        MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_SENSORS);
+        uint32_t sampled = scheduler.poll(currentTime, zones.anyOpen());
+        uint32_t suspect = anomalies.add(sampled, currentTime);
+        if constexpr (BoardSensors::has<WaterLevelSensor>()) {
+            if ((sampled & BoardSensors::bit<WaterLevelSensor>()) && sensors.isValid<WaterLevelSensor>()) {
+                dryRun.sample(sensors.sensor<WaterLevelSensor>().getLevelPercent(), currentTime);
+            }
+        }
+        if (sampled & BoardSensors::bit<SoilMoistureSensor>()) {
+            sampleZones();
+            // Soil far from needing water in every zone: the probes can back off
+            bool quiet = zones.getQuietSeconds() >= Trend::QUIET_HORIZON;
+            scheduler.setMaxPeriod<SoilMoistureSensor>(quiet ? Trend::QUIET_PERIOD : 0, currentTime);
+        }
+        if (sampled) {
+            rollup.add(sampled);
+            sensorDataValid = sensors.allValid();
+            
+            Event event;
+            event.type = Events::SENSOR_SNAPSHOT;
+            event.snapshot.sampled = sampled;
+            event.snapshot.valid = sensorDataValid;
+            event.snapshot.suspect = suspect;
+            bus.post(event);
+        }
+    }
+    
+    {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_CLOCK);
+        clock.loop();
+    }
+    {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_MQTT);
+        MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_MQTT);
+        mqttClient.loop();
+        ota.loop(currentTime);
+    }
+    {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_RADIO);
+        MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_RADIO);
+        radio.setHoldAwake((RadioPolicy::STAY_ON_WHILE_PUMPING && zones.anyOpen()) || ota.isActive());
+        radio.loop(currentTime);
+    }
+    if (gateway) {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_GATEWAY);
+        MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_MQTT);
+        gateway->loop(currentTime);
+    }
+    
+    {
+        LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_EVENTS);
+        bus.dispatch();
+        // The fast water level reads run while any valve is open, manual ones included
+        dryRun.update(zones.anyOpen());
+        
+        if (currentTime - lastSummaryPrint >= summaryInterval) {
+            printSensorSummary();
+            lastSummaryPrint = currentTime;
+        }
+        
+        // A verified update takes effect between waterings, never in the middle of one
+        if (ota.isRestartDue() && !zones.anyOpen()) {
+            Serial.println("Restarting into the new firmware");
+            saveControlState();
+            {
+                // Up to FLUSH_RECORDS of history are still in RAM
+                LoopWatchdog::Scope flushStage(watchdog, LoopWatchdog::STAGE_STORAGE);
+                history.flush();
+            }
+            mqttClient.disconnect();
+            esp_restart();
+        }
+    }
+    
+    // An upload due while the radio is still warming up waits for the link
+    if (currentTime - lastDataSent >= sendInterval && !radio.isWarmingUp()) {
+        if (sensorDataValid) {
+            {
+                LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_STORAGE);
+                MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_STORAGE);
+                history.append(TimeSeriesStore::fromSnapshot(sensors));
+            }
+            LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_UPLOAD);
+            MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_UPLOAD);
+            sendDataToMQTT();
+        } else {
+            // Rollup windows advance with the send interval, published or not
+            rollup.skipDue();
+        }
+        {
+            LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_UPLOAD);
+            MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_UPLOAD);
+            sendMetricsToMQTT();
+        }
+        {
+            LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_STORAGE);
+            MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_STORAGE);
+            history.maintain();
+        }
+        lastDataSent = currentTime;
+        radio.scheduleUpload(lastDataSent + sendInterval);
+    }
+    
+    memory.sample(currentTime);
+}
+
+void IrrigationApp::idle() {
+    // An event posted since dispatch() (the rain interrupt) is handled on the next pass
+    if (bus.hasPending()) return;
+    LoopWatchdog::Scope stage(watchdog, LoopWatchdog::STAGE_IDLE);
+    clock.sleepUntil(scheduler.getNextDue(millis()), gateway ? Gateway::POLL_PERIOD : Timing::LOOP_PERIOD);
+}
+
+void IrrigationApp::onControlEvent(void* context, const Event& event) {
+    IrrigationApp& app = *static_cast<IrrigationApp*>(context);
+    MemoryDiagnostics::Scope scope(app.memory, MemoryDiagnostics::SUB_CONTROL);
+    
+    switch (event.type) {
+        case Events::SENSOR_SNAPSHOT:
+            if (event.snapshot.valid) app.controlPump();
+            break;
+        case Events::RAIN_EDGE:
+            // Read the rain sensor on the next pass rather than at its scheduled time
+            if constexpr (BoardSensors::has<RainSensor>()) {
+                app.scheduler.template expedite<RainSensor>(millis());
+            }
+            Serial.printf("Rain input changed (%s)\n", event.rain.raining ? "wet" : "dry");
+            break;
+        case Events::RELAY_COMMAND:
+            // Applied at once with the latest readings, or with the first valid snapshot
+            app.pendingCommand = event.command;
+            app.commandPending = true;
+            if (app.sensorDataValid) app.controlPump();
+            break;
+        case Events::RULES_UPDATE:
+            app.rules.update(*event.rules.json);
+            break;
+        case Events::CONFIG_UPDATE:
+            app.updateSettings(*event.config.json);
+            break;
+        case Events::DRY_RUN_TRIP:
+            // The valves are already off at the pin; this pass closes the zones and logs the trip
+            Serial.printf("Dry-run trip: tank at %d%%, valves cut %u ms after the first low read\n",
+                          event.dryRun.level, event.dryRun.latency);
+            app.controlPump();
+            break;
+        default:
+            break;
+    }
+}
+
+void IrrigationApp::onDisplayEvent(void* context, const Event& event) {
+    IrrigationApp& app = *static_cast<IrrigationApp*>(context);
+    if (!app.sensorDataValid) return;
+    if (event.type == Events::SENSOR_SNAPSHOT && !event.snapshot.valid) return;
+    
+    // Redrawn after each valid snapshot and when the MQTT indicator changes
+    MemoryDiagnostics::Scope scope(app.memory, MemoryDiagnostics::SUB_DISPLAY);
+    app.updateDisplay();
+}
+
+void IrrigationApp::onGatewayEvent(void* context, const Event& event) {
+    IrrigationApp& app = *static_cast<IrrigationApp*>(context);
+    if (app.gateway && event.type == Events::LEAF_COMMAND) {
+        app.gateway->queueCommand(event.leafCommand.leaf, event.leafCommand.command);
+    }
+}
+
+void IRAM_ATTR IrrigationApp::onRainEdge(void* arg) {
+    IrrigationApp* app = static_cast<IrrigationApp*>(arg);
+    int64_t now = esp_timer_get_time();
+    if (now - app->lastRainEdge < RAIN_EDGE_DEBOUNCE) return;
+    app->lastRainEdge = now;
+    
+    Event event;
+    event.type = Events::RAIN_EDGE;
+    event.rain.raining = digitalRead(Pins::RAIN_SENSOR_PIN) == LOW;    // MH-RD pulls low when wet
+    app->bus.postFromISR(event);
+}
+
+void IrrigationApp::onLoopStall(void* context) {
+    // Runs on the esp_timer task while the loop task is stuck
+    static_cast<IrrigationApp*>(context)->zones.failSafe();
+}
+
+void IrrigationApp::onDryRunCut(void* context) {
+    // Runs on the esp_timer task, possibly in the middle of a control pass
+    static_cast<IrrigationApp*>(context)->zones.failSafe();
+}
+
+void IrrigationApp::restoreControlState() {
+    ControlState state;
+    ControlStateStore::Source source = controlStore.restore(state);
+    
+    // The wall time survives a warm reset in the RTC, so the dwell timer can carry on
+    unsigned long stateAge = 0;
+    time_t now = time(nullptr);
+    if (source == ControlStateStore::SOURCE_RTC && state.changedAt != 0 && SampleClock::isWallClockSet(now) &&
+        static_cast<uint32_t>(now) >= state.changedAt) {
+        stateAge = (static_cast<uint32_t>(now) - state.changedAt) * 1000UL;
+    }
+    
+    // changedAt is the latest change of any zone, so the age is never longer than a zone's real one
+    // A run cut short by a hang isn't resumed: its readings are stale. Overrides are.
+    if (source == ControlStateStore::SOURCE_RTC && watchdog.wasUncleanReset() &&
+        (state.relayMask & ~state.overrideMask)) {
+        Serial.printf("Unclean reset - automatic runs 0x%04x not resumed\n", state.relayMask & ~state.overrideMask);
+        state.relayMask &= state.overrideMask;
+    }
+    
+    zones.begin(state.relayMask, state.overrideMask, stateAge);
+    lastCommandId = state.lastCommandId;
+    
+    Serial.printf("Control state restored from %s: relays 0x%04x, manual override 0x%04x, last command %lu\n",
+                  ControlStateStore::sourceName(source), state.relayMask, state.overrideMask,
+                  (unsigned long)lastCommandId);
+}
+
+void IrrigationApp::saveControlState() {
+    time_t now = time(nullptr);
+    ControlState state;
+    state.overrideMask = zones.getOverrideMask();
+    state.relayMask = zones.getOpenMask();
+    state.lastCommandId = lastCommandId;
+    state.changedAt = SampleClock::isWallClockSet(now) ? static_cast<uint32_t>(now) : 0;
+    controlStore.save(state);
+}
+
+void IrrigationApp::initializeComponents() {
+    Serial.println("Initializing components...");
+    
+    CalibrationUtils::loadCalibrationCurves();
+    
+    Wire.begin(Pins::SDA_PIN, Pins::SCL_PIN);
+    delay(100);
+    
+    bool displayReady;
+    {
+        MemoryDiagnostics::Scope scope(memory, MemoryDiagnostics::SUB_DISPLAY);
+        displayReady = oled.begin();
+    }
+    if (!displayReady) {
+        Serial.println("OLED initialization failed!");
+        Serial.println("Continuing without display...");
+    }
+    
+    sensors.begin();
+    offlineBatch.begin(sensors);
+    
+    if (!history.begin()) {
+        Serial.println("Local history unavailable - continuing without it");
+    }
+    
+    if (!mqttClient.begin()) {
+        Serial.println("MQTT outbound queue will not survive a reboot");
+    }
+    
+    Serial.printf("DHT11 on GPIO%d, Soil moisture on GPIO%d, Relay on GPIO%d\n", 
+                  Pins::DHT11_PIN, Pins::SOIL_MOISTURE_PIN, Pins::RELAY_PIN);
+    Serial.printf("Rain sensor on GPIO%d, Water level on GPIO%d, Modem relay on GPIO%d\n", 
+                  Pins::RAIN_SENSOR_PIN, Pins::WATER_LEVEL_PIN, Pins::MODEM_RELAY_PIN);
+    Serial.printf("OLED on SDA%d/SCL%d\n", Pins::SDA_PIN, Pins::SCL_PIN);
+}
+
+void IrrigationApp::printSensorSummary() {
+    if (sensors.allValid()) {
+        sensors.printSummary();
+        zones.printStatus();
+    } else {
+        Serial.println("Some sensor readings are invalid!");
+    }
+}
+
+void IrrigationApp::controlPump() {
+    int commandedZone = -1;
+    String commandReason;
+    
+    if (commandPending) {
+        RelayCommand command = pendingCommand;
+        commandPending = false;
+        LATENCY_TRACE_POINT(STAGE_COMMAND_TAKEN);
+        Serial.printf("Processing remote relay command: zone %u %s\n", command.zone + 1, command.status ? "ON" : "OFF");
+        
+        if (command.id != 0 && command.id == lastCommandId) {
+            // Redelivered after a reset that happened before the broker saw our ack
+            Serial.printf("Relay command %lu already applied, ignoring\n", (unsigned long)command.id);
+        } else {
+            if (command.id != 0) lastCommandId = command.id;
+            
+            if (command.status) {
+                commandReason = "Remote MQTT command: on (Manual Override Mode)";
+            } else {
+                commandReason = "Remote MQTT command: off (Returning to Automatic Mode)";
+            }
+            
+            if (command.status && dryRun.isTripped()) {
+                Serial.printf("Zone %u: tank below the dry-run level, command rejected\n", command.zone + 1);
+            } else if (zones.command(command.zone, command.status, commandReason)) {
+                commandedZone = command.zone;
+                if (command.status) {
+                    Serial.println("Manual Override Mode ACTIVATED - Zone will stay ON until manual OFF command");
+                } else {
+                    Serial.println("Manual Override Mode DEACTIVATED - Returning to automatic soil moisture control");
+                }
+            }
+        }
+    }
+    
+    bool rainDetected = false;
+    bool waterLow = false;
+    if constexpr (BoardSensors::has<RainSensor>()) {
+        rainDetected = sensors.reading<RainSensor>().rainDetected;
+    }
+    if constexpr (BoardSensors::has<WaterLevelSensor>()) {
+        waterLow = sensors.reading<WaterLevelSensor>().waterLevel == WaterLevelCalibration::LEVEL_LOW;
+    }
+    if (dryRun.isTripped()) {
+        // Every zone stays closed, manual ones too, until the tank refills
+        zones.cutOff(dryRun.describeTrip());
+        dryRun.acknowledge();
+    } else {
+        RuleEngine::Decision decision;
+        evaluateRules(decision);
+        zones.control(rainDetected, waterLow, decision);
+    }
+    
+    // A command is logged even when its zone was already in the commanded state
+    uint16_t changed = 0;
+    for (uint8_t i = 0; i < zones.count(); i++) {
+        if (zones.zone(i).relay.hasStateChanged() || i == commandedZone) changed |= (1u << i);
+    }
+    if (!changed) return;
+    
+    // Persist first: a reset during the log publish must not lose the new state
+    saveControlState();
+    // A valve that just opened needs a wetting trend quickly
+    if (zones.anyOpen()) scheduler.expedite<SoilMoistureSensor>(millis());
+    
+    for (uint8_t i = 0; i < zones.count(); i++) {
+        if (!(changed & (1u << i))) continue;
+        ZoneController::Zone& zone = zones.zone(i);
+        const String& reason = i == commandedZone ? commandReason : zone.reason;
+        bool active = zone.relay.isRelayActive();
+        
+        Serial.printf("Zone %u:\n", i + 1);
+        zone.relay.printDebugInfo(reason);
+        history.appendRelayEvent(active, zone.manualOverride, i);
+        
+        bool queued = mqttClient.publishRelayLog(i, active, reason) != 0;
+        if (i == commandedZone) LATENCY_TRACE_POINT(STAGE_RELAY_LOG_PUBLISHED);
+        if (!queued) {
+            Serial.println("Warning: Failed to queue relay log for MQTT");
+        }
+        
+        zone.relay.updateLastState();
+    }
+}
+
+void IrrigationApp::sampleZones() {
+    // Stuck probe reads as NaN: the zone closes its valve as for a failed read
+    float moisture = anomalies.controlValue<SoilMoistureSensor>();
+    zones.sample(isnan(moisture) ? 0 : lroundf(moisture), sensors.isValid<SoilMoistureSensor>() && !isnan(moisture));
+}
+
+void IrrigationApp::beginRules() {
+    // Rules see every snapshot field by its payload name, then the local hour and the open valve count
+    static_assert(BoardSensors::FIELD_COUNT + 2 <= RuleEngine::MAX_VARIABLES - RuleEngine::ZONE_VARIABLE_COUNT,
+                  "Too many rule variables");
+    const char* names[BoardSensors::FIELD_COUNT + 2];
+    SensorFields::KeyList keys{names, 0};
+    sensors.visitFields(keys);
+    names[keys.count++] = "hour";
+    names[keys.count++] = "openValves";
+    rules.begin(names, keys.count);
+}
+
+void IrrigationApp::beginSettings() {
+    // Sampling is tuned per scheduler entry, by sensor name
+    static_assert(BoardSensors::SENSOR_COUNT <= RuntimeConfig::MAX_SENSORS, "Too many sensors for RuntimeConfig");
+    const char* names[BoardSensors::SENSOR_COUNT];
+    const SamplingPolicy* defaults[BoardSensors::SENSOR_COUNT];
+    for (size_t i = 0; i < BoardSensors::SENSOR_COUNT; i++) {
+        names[i] = scheduler.getName(i);
+        defaults[i] = &scheduler.getDefaultPolicy(i);
+    }
+    settings.begin(names, defaults, BoardSensors::SENSOR_COUNT);
+    applySettings(millis());
+}
+
+void IrrigationApp::applySettings(unsigned long now) {
+    // Everything from one validated document, within a single control event
+    const RuntimeConfig::Settings& active = settings.get();
+    zones.setPumpConfig(active.pump);
+    dryRun.setConfig(active.dryRun);
+    WaterLevelCalibration::setThresholds(active.waterLow, active.waterMedium);
+    for (size_t i = 0; i < BoardSensors::SENSOR_COUNT; i++) {
+        scheduler.setPolicy(i, active.sampling[i], now);
+    }
+    radio.setCommandPollInterval(active.commandPollInterval, now);
+    sendInterval = active.sendInterval;
+    summaryInterval = active.summaryInterval;
+    radio.scheduleUpload(lastDataSent + sendInterval);
+}
+
+void IrrigationApp::updateSettings(const String& json) {
+    JsonDocument report;
+    if (settings.update(json, report) == RuntimeConfig::APPLIED) {
+        applySettings(millis());
+    }
+    if (!report.isNull()) mqttClient.publishConfigStatus(report);
+}
+
+void IrrigationApp::evaluateRules(RuleEngine::Decision& decision) {
+    float values[RuleEngine::MAX_VARIABLES];
+    SensorFields::ScalarList fields{values, 0};
+    sensors.visitFields(fields);
+    anomalies.substitute(values);
+    
+    time_t now = time(nullptr);
+    long secondOfDay = (static_cast<long>(now) + Timing::LOCAL_UTC_OFFSET) % 86400;
+    values[fields.count++] = SampleClock::isWallClockSet(now) ? secondOfDay / 3600.0f : NAN;
+    values[fields.count++] = __builtin_popcount(zones.getOpenMask());
+    
+    RuleEngine::ZoneInputs inputs[Zones::COUNT];
+    zones.getRuleInputs(inputs);
+    rules.evaluate(values, inputs, zones.count(), decision);
+}
+
+void IrrigationApp::updateDisplay() {
+    // Sensors this board doesn't fit show as N/A
+    float temperature = NAN;
+    float humidity = NAN;
+    float soilTemperature = NAN;
+    const char* waterLevel = "N/A";
+    const char* rain = "N/A";
+    if constexpr (BoardSensors::has<DHT11Sensor>()) {
+        temperature = sensors.reading<DHT11Sensor>().temperature;
+        humidity = sensors.reading<DHT11Sensor>().humidity;
+    }
+    if constexpr (BoardSensors::has<SoilTemperatureSensor>()) {
+        soilTemperature = sensors.reading<SoilTemperatureSensor>().soilTemperature;
+    }
+    if constexpr (BoardSensors::has<WaterLevelSensor>()) {
+        waterLevel = WaterLevelCalibration::levelName(sensors.reading<WaterLevelSensor>().waterLevel);
+    }
+    if constexpr (BoardSensors::has<RainSensor>()) {
+        rain = sensors.reading<RainSensor>().rainDetected ? "YES" : "NO";
+    }
+    oled.updateSensorData(temperature, humidity, sensors.reading<SoilMoistureSensor>().soilMoisture,
+                          soilTemperature, waterLevel, rain, zones.anyOpen(), mqttClient.isConnected());
+}
+
+void IrrigationApp::sendDataToMQTT() {  
+    // Upload snapshots buffered while the broker was unreachable first
+    if (!offlineBatch.isEmpty() && mqttClient.isConnected()) {
+        if (mqttClient.publishSensorBatch(offlineBatch.data(), offlineBatch.size())) {
+            Serial.printf("✓ Uploaded %u buffered snapshots\n", offlineBatch.count());
+            offlineBatch.clear();
+        }
+    }
+    
+    // Counted against SUB_UPLOAD like the operator new calls made here
+    JsonDocument doc(MemoryDiagnostics::JsonAllocator::instance());
+    uint64_t timestamp = clock.nowUnixMillis();
+    if (timestamp) doc["timestamp"] = timestamp;
+    sensors.serialize(doc);
+    anomalies.serialize(doc);
+    scheduler.serializeSampledAt(doc, clock);
+    zones.serialize(doc);
+    dryRun.serialize(doc);
+    ota.serialize(doc);
+    settings.serialize(doc);
+    rollup.serializeDue(doc, sendInterval);
+    
+    bool connected = mqttClient.isConnected();
+    size_t payloadSize = measureJson(doc);
+    bool oversized = payloadSize > mqttClient.getSensorDataLimit();
+    bool queued = connected && !oversized && mqttClient.publishSensorData(doc) != 0;
+    
+    if (queued) {
+        Serial.println("✓ Sensor data queued for MQTT");
+    } else {
+        if (oversized) {
+            // A payload the transport can't carry is a firmware fault, not a lost link; the readings
+            // still reach the broker through the offline batch, the JSON-only fields don't
+            oversizedPayloads++;
+            Serial.printf("✗ Sensor payload of %u bytes exceeds the %u byte MQTT packet limit\n",
+                          (unsigned)payloadSize, (unsigned)mqttClient.getSensorDataLimit());
+        } else if (connected) {
+            Serial.println("✗ Failed to queue sensor data for MQTT (queue full)");
+        } else {
+            Serial.println("✗ MQTT offline, sensor data not sent");
+        }
+        
+        uint32_t snapshotTime = timestamp ? static_cast<uint32_t>(timestamp / 1000)
+                                          : static_cast<uint32_t>(time(nullptr));
+        if (offlineBatch.append(sensors, snapshotTime)) {
+            Serial.printf("Snapshot buffered offline (%u snapshots, %u bytes)\n", 
+                          offlineBatch.count(), (unsigned)offlineBatch.size());
+        } else {
+            Serial.printf("Offline buffer full - %lu snapshots dropped\n", 
+                          (unsigned long)offlineBatch.getDroppedSamples());
+        }
+    }
+}
+
+void IrrigationApp::sendMetricsToMQTT() {
+    // Device health goes on its own topic, so the sensor publish stays within one packet
+    JsonDocument doc(MemoryDiagnostics::JsonAllocator::instance());
+    uint64_t timestamp = clock.nowUnixMillis();
+    if (timestamp) doc["timestamp"] = timestamp;
+    scheduler.serializeJitter(doc);
+    clock.serialize(doc);
+    rules.serialize(doc);
+    bus.serialize(doc);
+    if (gateway) gateway->serialize(doc);
+    radio.serialize(doc);
+    wifi.serialize(doc);
+    memory.serialize(doc);
+    watchdog.serialize(doc);
+    if (oversizedPayloads) doc["oversizedPayloads"] = oversizedPayloads;
+    if (mqttClient.publishMetrics(doc)) watchdog.markPublished();
+}
+
+void IrrigationApp::testSensors() {
+    Serial.println("Testing sensors...");
+    
+    sensors.readAll(false);
+    sampleZones();
+    
+    Serial.print("Initial readings -");
+    sensors.printSummary();
+    Serial.println();
+}
+
+MQTTClient& IrrigationApp::getMqttClient() {
+    return mqttClient;
+}
+
+RadioManager& IrrigationApp::getRadio() {
+    return radio;
+}
+
+const ZoneController& IrrigationApp::getZones() const {
+    return zones;
+}
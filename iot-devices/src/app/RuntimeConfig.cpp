@@ -0,0 +1,295 @@
+#include "app/RuntimeConfig.h"
+#include "utils/Fnv1a.h"
+#include <Preferences.h>
+
+namespace {
+    const unsigned long SECOND = 1000UL;
+    const unsigned long HOUR = 3600000UL;
+    const unsigned long DAY = 86400000UL;
+
+    // Keys of each section; anything else is most likely a typo and rejects the document
+    const char* const ROOT_KEYS[] = {"version", "sendInterval", "commandPoll", "summaryInterval",
+                                     "pump", "dryRun", "waterLevel", "sampling"};
+    const char* const PUMP_KEYS[] = {"on", "off", "minOn", "minOff", "inhibitOnRain", "inhibitOnLowWater"};
+    const char* const DRY_RUN_KEYS[] = {"trip", "reset", "samples"};
+    const char* const WATER_LEVEL_KEYS[] = {"low", "medium"};
+    const char* const SAMPLING_KEYS[] = {"base", "min", "max", "perHour"};
+
+    template <size_t N>
+    bool onlyKeys(JsonObjectConst object, const char* const (&keys)[N], const String& path, String& error) {
+        for (JsonPairConst pair : object) {
+            bool known = false;
+            for (const char* key : keys) {
+                if (strcmp(pair.key().c_str(), key) == 0) known = true;
+            }
+            if (!known) {
+                error = "unknown setting '" + path + pair.key().c_str() + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // An optional sub-object; missing is fine, anything but an object is not
+    bool section(JsonObjectConst parent, const char* key, JsonObjectConst& out, String& error) {
+        JsonVariantConst value = parent[key];
+        out = value.as<JsonObjectConst>();
+        if (!value.isNull() && out.isNull()) {
+            error = String("'") + key + "' must be an object";
+            return false;
+        }
+        return true;
+    }
+
+    // An optional whole number in [low, high]; the field keeps its default when it is missing
+    template <typename T>
+    bool readNumber(JsonObjectConst object, const char* key, long low, long high, T& field, const String& path,
+                    String& error) {
+        JsonVariantConst value = object[key];
+        if (value.isNull()) return true;
+        if (!value.is<long>() || value.as<long>() < low || value.as<long>() > high) {
+            error = "'" + path + key + "' must be a whole number from " + String(low) + " to " + String(high);
+            return false;
+        }
+        field = static_cast<T>(value.as<long>());
+        return true;
+    }
+
+    bool readFlag(JsonObjectConst object, const char* key, bool& field, const String& path, String& error) {
+        JsonVariantConst value = object[key];
+        if (value.isNull()) return true;
+        if (!value.is<bool>()) {
+            error = "'" + path + key + "' must be true or false";
+            return false;
+        }
+        field = value.as<bool>();
+        return true;
+    }
+
+    uint32_t hashDocument(const String& json) {
+        return Fnv1a::hash(json.c_str(), json.length());
+    }
+}
+
+RuntimeConfig::RuntimeConfig() {
+    sensorCount = 0;
+    acknowledged = false;
+    rejectedUpdates = 0;
+    rejectedHash = 0;
+    setDefaults(active);
+}
+
+void RuntimeConfig::setDefaults(Settings& settings) const {
+    memset(&settings, 0, sizeof(settings));
+    settings.version = 0;
+    settings.sendInterval = Timing::SEND_INTERVAL;
+    settings.commandPollInterval = RadioPolicy::COMMAND_POLL_INTERVAL;
+    settings.summaryInterval = Timing::SENSOR_INTERVAL;
+    settings.pump = {
+        RelayThresholds::SOIL_MOISTURE_THRESHOLD,
+        RelayThresholds::SOIL_MOISTURE_OFF_THRESHOLD,
+        RelayThresholds::MIN_ON_TIME,
+        RelayThresholds::MIN_OFF_TIME,
+        RelayThresholds::INHIBIT_ON_RAIN,
+        RelayThresholds::INHIBIT_ON_LOW_WATER
+    };
+    settings.dryRun = {DryRun::TRIP_LEVEL, DryRun::RESET_LEVEL, DryRun::TRIP_SAMPLES};
+    settings.waterLow = WaterLevelCalibration::LOW_THRESHOLD;
+    settings.waterMedium = WaterLevelCalibration::MEDIUM_THRESHOLD;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        settings.sampling[i] = *sensorDefaults[i];
+    }
+}
+
+void RuntimeConfig::begin(const char* const* names, const SamplingPolicy* const* defaults, uint8_t count) {
+    sensorCount = 0;
+    for (uint8_t i = 0; i < count && i < MAX_SENSORS; i++) {
+        sensorNames[sensorCount] = names[i];
+        sensorDefaults[sensorCount++] = defaults[i];
+    }
+    setDefaults(active);
+
+    String json;
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, true)) {
+        if (prefs.isKey(NVS_KEY)) json = prefs.getString(NVS_KEY);
+        prefs.end();
+    }
+
+    if (json.length()) {
+        Settings stored;
+        String error;
+        if (parse(json, stored, error)) {
+            active = stored;
+        } else {
+            // E.g. a sensor the document tunes is gone from this firmware
+            Serial.printf("Stored configuration doesn't fit this firmware (%s), defaults in force\n", error.c_str());
+            lastError = error;
+        }
+    }
+    printDebugInfo();
+}
+
+bool RuntimeConfig::parse(const String& json, Settings& candidate, String& error) const {
+    setDefaults(candidate);
+
+    JsonDocument doc;
+    if (deserializeJson(doc, json)) {
+        error = "not valid JSON";
+        return false;
+    }
+    JsonObjectConst root = doc.as<JsonObjectConst>();
+    if (root.isNull()) {
+        error = "not a JSON object";
+        return false;
+    }
+    if (!root["version"].is<uint32_t>() || root["version"].as<uint32_t>() == 0) {
+        error = "'version' must be a whole number above 0";
+        return false;
+    }
+    candidate.version = root["version"].as<uint32_t>();
+
+    JsonObjectConst pump, dryRun, waterLevel, sampling;
+    bool valid = onlyKeys(root, ROOT_KEYS, "", error) &&
+                 readNumber(root, "sendInterval", 10 * SECOND, DAY, candidate.sendInterval, "", error) &&
+                 readNumber(root, "commandPoll", 10 * SECOND, DAY, candidate.commandPollInterval, "", error) &&
+                 readNumber(root, "summaryInterval", SECOND, HOUR, candidate.summaryInterval, "", error) &&
+                 section(root, "pump", pump, error) && section(root, "dryRun", dryRun, error) &&
+                 section(root, "waterLevel", waterLevel, error) && section(root, "sampling", sampling, error);
+    if (!valid) return false;
+
+    PumpControlConfig& pumpConfig = candidate.pump;
+    valid = onlyKeys(pump, PUMP_KEYS, "pump.", error) &&
+            readNumber(pump, "on", 0, 100, pumpConfig.onThreshold, "pump.", error) &&
+            readNumber(pump, "off", 0, 100, pumpConfig.offThreshold, "pump.", error) &&
+            readNumber(pump, "minOn", 0, 6 * HOUR, pumpConfig.minOnTime, "pump.", error) &&
+            readNumber(pump, "minOff", 0, 6 * HOUR, pumpConfig.minOffTime, "pump.", error) &&
+            readFlag(pump, "inhibitOnRain", pumpConfig.inhibitOnRain, "pump.", error) &&
+            readFlag(pump, "inhibitOnLowWater", pumpConfig.inhibitOnLowWater, "pump.", error);
+    if (!valid) return false;
+    if (pumpConfig.onThreshold >= pumpConfig.offThreshold) {
+        error = "'pump.on' must be below 'pump.off'";
+        return false;
+    }
+
+    DryRunConfig& dryRunConfig = candidate.dryRun;
+    valid = onlyKeys(dryRun, DRY_RUN_KEYS, "dryRun.", error) &&
+            readNumber(dryRun, "trip", 0, 100, dryRunConfig.tripLevel, "dryRun.", error) &&
+            readNumber(dryRun, "reset", 0, 100, dryRunConfig.resetLevel, "dryRun.", error) &&
+            readNumber(dryRun, "samples", 1, 50, dryRunConfig.tripSamples, "dryRun.", error);
+    if (!valid) return false;
+    if (dryRunConfig.resetLevel < dryRunConfig.tripLevel) {
+        error = "'dryRun.reset' must not be below 'dryRun.trip'";
+        return false;
+    }
+
+    valid = onlyKeys(waterLevel, WATER_LEVEL_KEYS, "waterLevel.", error) &&
+            readNumber(waterLevel, "low", 0, CalibrationTable::ADC_MAX, candidate.waterLow, "waterLevel.", error) &&
+            readNumber(waterLevel, "medium", 0, CalibrationTable::ADC_MAX, candidate.waterMedium, "waterLevel.", error);
+    if (!valid) return false;
+    if (candidate.waterLow >= candidate.waterMedium) {
+        error = "'waterLevel.low' must be below 'waterLevel.medium'";
+        return false;
+    }
+
+    for (JsonPairConst pair : sampling) {
+        uint8_t index = 0;
+        while (index < sensorCount && strcmp(pair.key().c_str(), sensorNames[index]) != 0) index++;
+        String path = String("sampling.") + pair.key().c_str() + ".";
+        JsonObjectConst sensor = pair.value().as<JsonObjectConst>();
+        if (index == sensorCount || sensor.isNull()) {
+            error = "'sampling." + String(pair.key().c_str()) + "' is not a sensor of this board";
+            return false;
+        }
+
+        SamplingPolicy& policy = candidate.sampling[index];
+        valid = onlyKeys(sensor, SAMPLING_KEYS, path, error) &&
+                readNumber(sensor, "base", 100, DAY, policy.basePeriod, path, error) &&
+                readNumber(sensor, "min", 100, DAY, policy.minPeriod, path, error) &&
+                readNumber(sensor, "max", 100, DAY, policy.maxPeriod, path, error) &&
+                readNumber(sensor, "perHour", 1, 36000, policy.maxSamplesPerHour, path, error);
+        if (!valid) return false;
+        if (policy.minPeriod > policy.basePeriod || policy.basePeriod > policy.maxPeriod) {
+            error = "'" + path + "' needs min <= base <= max";
+            return false;
+        }
+    }
+    return true;
+}
+
+RuntimeConfig::Outcome RuntimeConfig::update(const String& json, JsonDocument& report) {
+    Settings candidate;
+    String error;
+    bool valid = parse(json, candidate, error);
+    if (valid && candidate.version < active.version) {
+        error = "version " + String(candidate.version) + " is older than the active " + String(active.version);
+        valid = false;
+    }
+
+    Outcome outcome;
+    if (!valid) {
+        // The broker sends a retained document again on every connect; report it once
+        uint32_t hash = hashDocument(json);
+        if (hash == rejectedHash) return IGNORED;
+        rejectedHash = hash;
+        rejectedUpdates++;
+        lastError = error;
+        Serial.printf("Configuration rejected: %s - version %lu stays in force\n", error.c_str(),
+                      (unsigned long)active.version);
+        outcome = REJECTED;
+    } else if (candidate.version == active.version) {
+        if (acknowledged) return IGNORED;
+        outcome = CURRENT;
+    } else {
+        active = candidate;
+        lastError = "";
+        if (!saveDocument(json)) {
+            Serial.println("Configuration applied but not saved - it will be lost on reboot");
+        }
+        Serial.printf("Configuration version %lu applied\n", (unsigned long)active.version);
+        printDebugInfo();
+        outcome = APPLIED;
+    }
+    if (outcome != REJECTED) acknowledged = true;
+
+    report["version"] = candidate.version;
+    report["active"] = active.version;
+    report["state"] = outcome == APPLIED ? "applied" : outcome == CURRENT ? "current" : "rejected";
+    if (outcome == REJECTED) report["error"] = error;
+    return outcome;
+}
+
+bool RuntimeConfig::saveDocument(const String& json) const {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open NVS config namespace");
+        return false;
+    }
+    bool success = prefs.putString(NVS_KEY, json) == json.length();
+    prefs.end();
+    return success;
+}
+
+void RuntimeConfig::serialize(JsonDocument& doc) const {
+    JsonObject config = doc["config"].to<JsonObject>();
+    config["version"] = active.version;
+    if (rejectedUpdates) config["rejected"] = rejectedUpdates;
+    if (lastError.length()) config["error"] = lastError;
+}
+
+void RuntimeConfig::printDebugInfo() const {
+    Serial.printf("Runtime config: version %lu%s\n", (unsigned long)active.version,
+                  active.version ? "" : " (compile-time defaults)");
+    Serial.printf("  Upload every %lu s, command poll every %lu s, summary every %lu s\n",
+                  active.sendInterval / 1000, active.commandPollInterval / 1000, active.summaryInterval / 1000);
+    Serial.printf("  Pump ON at %d%%, OFF at %d%%, dwell %lu s ON / %lu s OFF\n", active.pump.onThreshold,
+                  active.pump.offThreshold, active.pump.minOnTime / 1000, active.pump.minOffTime / 1000);
+    Serial.printf("  Dry-run cut at %d%% after %u reads, released at %d%%; water Low/Medium below %d/%d raw\n",
+                  active.dryRun.tripLevel, active.dryRun.tripSamples, active.dryRun.resetLevel, active.waterLow,
+                  active.waterMedium);
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        const SamplingPolicy& policy = active.sampling[i];
+        Serial.printf("  %-12s every %lu ms (%lu-%lu), %u reads/h at most\n", sensorNames[i], policy.basePeriod,
+                      policy.minPeriod, policy.maxPeriod, policy.maxSamplesPerHour);
+    }
+}
@@ -95,7 +95,7 @@ void OLEDDisplay::showStartupMessage() {
 }
 
 void OLEDDisplay::updateSensorData(float temp, float humidity, int soilMoisture, float soilTemp,
-                                  String waterLevel, bool rain, bool pumpActive, bool wifiConnected) {
+                                  String waterLevel, String rain, bool pumpActive, bool wifiConnected) {
     if (!display) return;
     
     display->clearDisplay();
@@ -109,13 +109,21 @@ void OLEDDisplay::updateSensorData(float temp, float humidity, int soilMoisture,
     display->printf("PUMP: %s", pumpActive ? "ON" : "OFF");
     
     display->setCursor(0, 24);
-    display->printf("Soil Temp: %.1fC", soilTemp);
+    if (isnan(soilTemp)) {
+        display->print("Soil Temp: N/A");
+    } else {
+        display->printf("Soil Temp: %.1fC", soilTemp);
+    }
     
     display->setCursor(0, 36);
-    display->printf("Air:%.0fC Hum:%.0f%%", temp, humidity);
+    if (isnan(temp) || isnan(humidity)) {
+        display->print("Air: N/A");
+    } else {
+        display->printf("Air:%.0fC Hum:%.0f%%", temp, humidity);
+    }
     
     display->setCursor(0, 48);
-    display->printf("Water:%s Rain:%s", waterLevel.c_str(), rain ? "YES" : "NO");
+    display->printf("Water:%s Rain:%s", waterLevel.c_str(), rain.c_str());
     
     display->setCursor(0, 56);
     display->printf("WiFi:%s", wifiConnected ? "OK" : "FAIL");
@@ -0,0 +1,96 @@
+#include "network/EspNowLink.h"
+#include <WiFi.h>
+
+EspNowLink* EspNowLink::instance = nullptr;
+portMUX_TYPE EspNowLink::receiveLock = portMUX_INITIALIZER_UNLOCKED;
+
+EspNowLink::EspNowLink() {
+    queueHead = 0;
+    queueCount = 0;
+    dropped = 0;
+    peerCount = 0;
+    nextEviction = 0;
+    memset(ownAddress, 0, sizeof(ownAddress));
+    sendFailures = 0;
+}
+
+bool EspNowLink::begin() {
+    if (esp_now_init() != ESP_OK) {
+        Serial.println("ESP-NOW init failed");
+        return false;
+    }
+
+    instance = this;
+    esp_now_register_recv_cb(onReceive);
+    WiFi.macAddress(ownAddress);
+    Serial.printf("ESP-NOW ready on %02x:%02x:%02x:%02x:%02x:%02x, channel %ld\n", ownAddress[0], ownAddress[1],
+                  ownAddress[2], ownAddress[3], ownAddress[4], ownAddress[5], (long)WiFi.channel());
+    return true;
+}
+
+#if defined(ESP_IDF_VERSION_MAJOR) && ESP_IDF_VERSION_MAJOR >= 5
+void EspNowLink::onReceive(const esp_now_recv_info_t* info, const uint8_t* data, int length) {
+    if (instance) instance->enqueue(info->src_addr, data, length);
+}
+#else
+void EspNowLink::onReceive(const uint8_t* mac, const uint8_t* data, int length) {
+    if (instance) instance->enqueue(mac, data, length);
+}
+#endif
+
+void EspNowLink::enqueue(const uint8_t* mac, const uint8_t* data, int length) {
+    if (length <= 0 || length > static_cast<int>(MAX_FRAME)) return;
+
+    portENTER_CRITICAL(&receiveLock);
+    if (queueCount >= RECEIVE_QUEUE) {
+        dropped++;
+    } else {
+        Frame& frame = queue[(queueHead + queueCount) % RECEIVE_QUEUE];
+        memcpy(frame.peer, mac, ADDRESS_LENGTH);
+        memcpy(frame.data, data, length);
+        frame.length = static_cast<uint8_t>(length);
+        queueCount++;
+    }
+    portEXIT_CRITICAL(&receiveLock);
+}
+
+bool EspNowLink::receive(Frame& frame) {
+    portENTER_CRITICAL(&receiveLock);
+    bool available = queueCount > 0;
+    if (available) {
+        frame = queue[queueHead];
+        queueHead = (queueHead + 1) % RECEIVE_QUEUE;
+        queueCount--;
+    }
+    portEXIT_CRITICAL(&receiveLock);
+    return available;
+}
+
+bool EspNowLink::ensurePeer(const uint8_t* peer) {
+    if (esp_now_is_peer_exist(peer)) return true;
+
+    uint8_t slot = peerCount;
+    if (peerCount >= MAX_PEERS) {
+        slot = nextEviction;
+        nextEviction = (nextEviction + 1) % MAX_PEERS;
+        esp_now_del_peer(peers[slot]);
+    } else {
+        peerCount++;
+    }
+
+    esp_now_peer_info_t info = {};
+    memcpy(info.peer_addr, peer, ADDRESS_LENGTH);
+    info.channel = 0;                // The station's current channel
+    info.ifidx = WIFI_IF_STA;
+    info.encrypt = false;
+    memcpy(peers[slot], peer, ADDRESS_LENGTH);
+    return esp_now_add_peer(&info) == ESP_OK;
+}
+
+bool EspNowLink::send(const uint8_t* peer, const uint8_t* data, size_t length) {
+    if (length > MAX_FRAME || !ensurePeer(peer) || esp_now_send(peer, data, length) != ESP_OK) {
+        sendFailures++;
+        return false;
+    }
+    return true;
+}
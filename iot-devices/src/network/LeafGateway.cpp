@@ -0,0 +1,256 @@
+#include "network/LeafGateway.h"
+#include "utils/SampleClock.h"
+#include <esp_timer.h>
+#include <time.h>
+
+using namespace LeafProtocol;
+
+LeafGateway::LeafGateway(LeafLink& link, MQTTClient& mqtt, uint16_t capacity)
+    : link(link), mqtt(mqtt) {
+    this->capacity = capacity;
+    leaves = new Leaf[capacity];
+    leafCount = 0;
+
+    batchLength = 0;
+    batchRecords = 0;
+    batchStartedAt = 0;
+    batchBaseTime = 0;
+    lastFlushAttempt = 0;
+
+    nextCommandId = esp_random() | 1;
+
+    framesReceived = 0;
+    framesRejected = 0;
+    duplicates = 0;
+    recordsDeferred = 0;
+    batchesSent = 0;
+    bytesUplinked = 0;
+    commandsRelayed = 0;
+    commandsConfirmed = 0;
+    maxLoopMicros = 0;
+}
+
+LeafGateway::~LeafGateway() {
+    delete[] leaves;
+}
+
+bool LeafGateway::begin() {
+    if (!link.begin()) return false;
+    Serial.printf("Leaf gateway ready for %u leaves\n", capacity);
+    return true;
+}
+
+LeafGateway::Leaf* LeafGateway::find(const uint8_t* address, bool create) {
+    for (uint16_t i = 0; i < leafCount; i++) {
+        if (memcmp(leaves[i].address, address, LeafLink::ADDRESS_LENGTH) == 0) return &leaves[i];
+    }
+    if (!create) return nullptr;
+
+    Leaf* leaf = nullptr;
+    if (leafCount < capacity) {
+        leaf = &leaves[leafCount++];
+    } else {
+        // Replace the leaf heard from least recently, unless a command is still owed to it
+        unsigned long now = millis();
+        for (uint16_t i = 0; i < leafCount; i++) {
+            if (leaves[i].command.id != 0) continue;
+            if (!leaf || now - leaves[i].lastSeen > now - leaf->lastSeen) leaf = &leaves[i];
+        }
+        if (!leaf) return nullptr;
+    }
+
+    memcpy(leaf->address, address, LeafLink::ADDRESS_LENGTH);
+    leaf->lastSequence = 0;
+    leaf->lastSeen = millis();
+    leaf->reports = 0;
+    leaf->command.id = 0;
+    leaf->reported = false;
+    return leaf;
+}
+
+void LeafGateway::loop(unsigned long now) {
+    int64_t start = esp_timer_get_time();
+
+    LeafLink::Frame frame;
+    for (uint8_t i = 0; i < Gateway::FRAMES_PER_LOOP && link.receive(frame); i++) {
+        framesReceived++;
+        const Header* header = reinterpret_cast<const Header*>(frame.data);
+        if (frame.length < sizeof(Header) || header->magic != MAGIC || header->type != FRAME_REPORT) {
+            framesRejected++;
+            continue;
+        }
+        handleReport(frame, now);
+    }
+
+    if (batchRecords > 0 && now - batchStartedAt >= Gateway::BATCH_INTERVAL &&
+        now - lastFlushAttempt >= Gateway::BATCH_INTERVAL / 4) {
+        flush(now);
+    }
+
+    uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+    if (elapsed > maxLoopMicros) maxLoopMicros = elapsed;
+}
+
+void LeafGateway::handleReport(const LeafLink::Frame& frame, unsigned long now) {
+    const Report* report = reinterpret_cast<const Report*>(frame.data);
+    if (frame.length < reportLength(0) || report->fieldCount > MAX_FIELDS ||
+        frame.length != reportLength(report->fieldCount)) {
+        framesRejected++;
+        return;
+    }
+
+    Leaf* leaf = find(frame.peer, true);
+    if (!leaf) {
+        framesRejected++;
+        return;
+    }
+
+    uint16_t sequence = report->header.sequence;
+    bool duplicate = leaf->reported && sequence == leaf->lastSequence;
+    leaf->lastSeen = now;
+
+    if (leaf->command.id != 0 && report->appliedCommand == leaf->command.id) {
+        Serial.printf("Leaf %02x%02x: command %lu applied\n", leaf->address[4], leaf->address[5],
+                      (unsigned long)leaf->command.id);
+        leaf->command.id = 0;
+        commandsConfirmed++;
+    }
+
+    // The ACK was lost and the leaf sent the same report again: acknowledge, don't uplink twice
+    if (duplicate) {
+        duplicates++;
+    } else if (append(frame, now)) {
+        leaf->lastSequence = sequence;
+        leaf->reported = true;
+        leaf->reports++;
+    } else {
+        // No room in the batch: leave the report unacknowledged so the leaf sends it again
+        recordsDeferred++;
+        return;
+    }
+
+    acknowledge(*leaf, sequence);
+}
+
+void LeafGateway::acknowledge(const Leaf& leaf, uint16_t sequence) {
+    Ack ack = {};
+    ack.header.magic = MAGIC;
+    ack.header.type = FRAME_ACK;
+    ack.header.sequence = sequence;
+    if (leaf.command.id != 0) {
+        ack.flags = ACK_HAS_COMMAND;
+        ack.commandId = leaf.command.id;
+        ack.zone = leaf.command.zone;
+        ack.status = leaf.command.status ? 1 : 0;
+        commandsRelayed++;
+    }
+    link.send(leaf.address, reinterpret_cast<const uint8_t*>(&ack), sizeof(ack));
+}
+
+bool LeafGateway::append(const LeafLink::Frame& frame, unsigned long now) {
+    size_t recordLength = sizeof(RecordHeader) + frame.length;
+
+    // Uplink a full batch first; if the broker is unreachable the batch stays and the report is refused
+    if (batchRecords > 0 && batchLength + recordLength > sizeof(batch) && !flush(now)) return false;
+
+    if (batchRecords == 0) {
+        batchStartedAt = now;
+        time_t wallClock = time(nullptr);
+        batchBaseTime = SampleClock::isWallClockSet(wallClock) ? static_cast<uint32_t>(wallClock) : 0;
+        batchLength = sizeof(BatchHeader);
+    }
+
+    // Record offsets are 16-bit seconds; a batch held back that long is closed to new records
+    unsigned long offset = (now - batchStartedAt) / 1000;
+    if (offset > UINT16_MAX || batchRecords == UINT16_MAX) return false;
+
+    RecordHeader record;
+    memcpy(record.address, frame.peer, LeafLink::ADDRESS_LENGTH);
+    record.offset = static_cast<uint16_t>(offset);
+    record.length = frame.length;
+    memcpy(batch + batchLength, &record, sizeof(record));
+    memcpy(batch + batchLength + sizeof(record), frame.data, frame.length);
+    batchLength += recordLength;
+    batchRecords++;
+    return true;
+}
+
+bool LeafGateway::flush(unsigned long now) {
+    BatchHeader header;
+    header.magic = BATCH_MAGIC;
+    header.version = BATCH_VERSION;
+    header.recordCount = batchRecords;
+    header.baseTime = batchBaseTime;
+    memcpy(batch, &header, sizeof(header));
+
+    // While offline new reports keep filling the batch until it is full
+    lastFlushAttempt = now;
+    if (!mqtt.publishLeafBatch(batch, batchLength)) return false;
+
+    batchesSent++;
+    bytesUplinked += batchLength;
+    batchRecords = 0;
+    batchLength = 0;
+    return true;
+}
+
+bool LeafGateway::queueCommand(const uint8_t* address, const RelayCommand& command) {
+    Leaf* leaf = find(address, true);
+    if (!leaf) {
+        Serial.println("Leaf table full, command dropped");
+        return false;
+    }
+
+    leaf->command = command;
+    if (leaf->command.id == 0) {
+        leaf->command.id = nextCommandId++;
+        if (nextCommandId == 0) nextCommandId = 1;
+    }
+    Serial.printf("Leaf %02x%02x: command %lu (zone %u %s) waits for its next report\n", address[4], address[5],
+                  (unsigned long)leaf->command.id, leaf->command.zone + 1, command.status ? "on" : "off");
+    return true;
+}
+
+void LeafGateway::serialize(JsonDocument& doc) {
+    JsonObject gateway = doc["gateway"].to<JsonObject>();
+    gateway["leaves"] = leafCount;
+    gateway["frames"] = framesReceived;
+    gateway["rejected"] = framesRejected;
+    gateway["duplicates"] = duplicates;
+    gateway["deferred"] = recordsDeferred;
+    gateway["linkDropped"] = link.getDropped();
+    gateway["batches"] = batchesSent;
+    gateway["bytes"] = bytesUplinked;
+    gateway["commandsRelayed"] = commandsRelayed;
+    gateway["commandsConfirmed"] = commandsConfirmed;
+    gateway["maxLoopUs"] = maxLoopMicros;
+
+    uint16_t pending = 0;
+    for (uint16_t i = 0; i < leafCount; i++) {
+        if (leaves[i].command.id != 0) pending++;
+    }
+    gateway["commandsPending"] = pending;
+
+    framesReceived = 0;
+    framesRejected = 0;
+    duplicates = 0;
+    recordsDeferred = 0;
+    batchesSent = 0;
+    bytesUplinked = 0;
+    commandsRelayed = 0;
+    commandsConfirmed = 0;
+    maxLoopMicros = 0;
+}
+
+void LeafGateway::printDebugInfo() const {
+    Serial.printf("Leaf gateway: %u/%u leaves, batch %u records (%u bytes), link dropped %lu\n", leafCount, capacity,
+                  batchRecords, (unsigned)batchLength, (unsigned long)link.getDropped());
+    unsigned long now = millis();
+    for (uint16_t i = 0; i < leafCount; i++) {
+        const Leaf& leaf = leaves[i];
+        Serial.printf("  %02x:%02x:%02x:%02x:%02x:%02x  %lu reports, last %lu s ago%s\n", leaf.address[0],
+                      leaf.address[1], leaf.address[2], leaf.address[3], leaf.address[4], leaf.address[5],
+                      (unsigned long)leaf.reports, (now - leaf.lastSeen) / 1000,
+                      leaf.command.id != 0 ? ", command pending" : "");
+    }
+}
@@ -0,0 +1,89 @@
+#include "network/LeafNode.h"
+
+using namespace LeafProtocol;
+
+LeafNode::LeafNode(LeafLink& link, const uint8_t* gatewayAddress) : link(link) {
+    memcpy(gateway, gatewayAddress, LeafLink::ADDRESS_LENGTH);
+    memset(&pending, 0, sizeof(pending));
+    pendingLength = 0;
+    awaitingAck = false;
+    attempts = 0;
+    sentAt = 0;
+    sequence = static_cast<uint16_t>(esp_random());
+    appliedCommand = 0;
+    deliveredCommand = 0;
+    reportsSent = 0;
+    retries = 0;
+    reportsAcked = 0;
+    reportsLost = 0;
+}
+
+bool LeafNode::report(const float* fields, uint8_t count, uint16_t layout, uint16_t relayMask, unsigned long now) {
+    if (count > MAX_FIELDS) return false;
+    if (awaitingAck) reportsLost++;
+
+    sequence++;
+    pending.header.magic = MAGIC;
+    pending.header.type = FRAME_REPORT;
+    pending.header.sequence = sequence;
+    pending.relayMask = relayMask;
+    pending.layout = layout;
+    pending.fieldCount = count;
+    for (uint8_t i = 0; i < count; i++) {
+        pending.fields[i] = encodeField(fields[i]);
+    }
+    pendingLength = reportLength(count);
+
+    awaitingAck = true;
+    attempts = 0;
+    reportsSent++;
+    transmit(now);
+    return true;
+}
+
+void LeafNode::transmit(unsigned long now) {
+    pending.appliedCommand = appliedCommand;     // May have changed since the first attempt
+    attempts++;
+    sentAt = now;
+    link.send(gateway, reinterpret_cast<const uint8_t*>(&pending), pendingLength);
+}
+
+bool LeafNode::poll(unsigned long now, RelayCommand& command) {
+    bool received = false;
+
+    LeafLink::Frame frame;
+    while (link.receive(frame)) {
+        const Ack* ack = reinterpret_cast<const Ack*>(frame.data);
+        if (frame.length != sizeof(Ack) || ack->header.magic != MAGIC || ack->header.type != FRAME_ACK ||
+            memcmp(frame.peer, gateway, LeafLink::ADDRESS_LENGTH) != 0) {
+            continue;
+        }
+
+        // A late ACK to an earlier report still carries the current command
+        if (awaitingAck && ack->header.sequence == sequence) {
+            awaitingAck = false;
+            reportsAcked++;
+        }
+
+        if ((ack->flags & ACK_HAS_COMMAND) && ack->commandId != deliveredCommand &&
+            ack->commandId != appliedCommand) {
+            deliveredCommand = ack->commandId;
+            command.status = ack->status != 0;
+            command.zone = ack->zone;
+            command.id = ack->commandId;
+            received = true;
+        }
+    }
+
+    if (awaitingAck && now - sentAt >= ACK_TIMEOUT) {
+        if (attempts < MAX_ATTEMPTS) {
+            retries++;
+            transmit(now);
+        } else {
+            awaitingAck = false;
+            reportsLost++;
+        }
+    }
+
+    return received;
+}
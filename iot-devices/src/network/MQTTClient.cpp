@@ -1,29 +1,55 @@
 #include "network/MQTTClient.h"
-#include <NTPClient.h>
-#include <WiFiUdp.h>
+#include "ota/FirmwareUpdater.h"
+#include "utils/SensorCalibration.h"
+#include "utils/LatencyTrace.h"
 #include <time.h>
 #include <SPIFFS.h>
 
-WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, "pool.ntp.org", 0, 60000);
-
-extern bool remoteRelayCommand;
-extern bool remoteRelayStatus;
-extern String remoteRelayReason;
-extern bool manualOverrideMode;
-
 MQTTClient::MQTTClient(const char* server, int port, const char* user, const char* password, 
                        const char* deviceId, const char* sensorTopic, const char* relayTopic, 
                        const char* statusTopic, const char* relayCommandTopic) 
     : mqttServer(server), mqttPort(port), mqttUser(user), mqttPassword(password), 
       deviceId(deviceId), sensorDataTopic(sensorTopic), relayLogTopic(relayTopic), 
-      statusTopic(statusTopic), relayCommandTopic(relayCommandTopic), lastReconnectAttempt(0), isConnectedFlag(false) {
+      statusTopic(statusTopic), relayCommandTopic(relayCommandTopic), 
+      calibrationTopic(String("sf/") + deviceId + "/calibration"),
+      rulesTopic(String("sf/") + deviceId + "/rules"),
+      batchTopic(String("sf/") + deviceId + "/batch"),
+      leafBatchTopic(String("sf/") + deviceId + "/leaves"),
+      leafCommandTopic(String("sf/") + deviceId + "/leaves/command"),
+      otaTopic(String("sf/") + deviceId + "/ota"),
+      otaDataTopic(String("sf/") + deviceId + "/ota/data"),
+      otaRequestTopic(String("sf/") + deviceId + "/ota/request"),
+      otaStatusTopic(String("sf/") + deviceId + "/ota/status"),
+      configTopic(String("sf/") + deviceId + "/config"),
+      configStatusTopic(String("sf/") + deviceId + "/config/status"),
+      metricsTopic(String("sf/") + deviceId + "/metrics"), gatewayEnabled(false),
+      transport(wifiClientSecure, outbox), bus(nullptr), updater(nullptr), lastReconnectAttempt(0), isConnectedFlag(false),
+      autoReconnect(true) {
     
     Serial.println("MQTT Client initialized for HiveMQ Cloud");
     Serial.printf("Server: %s:%d\n", mqttServer, mqttPort);
     Serial.printf("Device ID: %s\n", deviceId);
-    Serial.printf("Topics:\n  Sensor: %s\n  Relay: %s\n  Status: %s\n  Relay Command: %s\n", 
-                  sensorDataTopic, relayLogTopic, statusTopic, relayCommandTopic);
+    Serial.printf("Topics:\n  Sensor: %s\n  Relay: %s\n  Status: %s\n  Relay Command: %s\n  Calibration: %s\n  Rules: %s\n  Batch: %s\n  OTA: %s\n  Config: %s\n  Metrics: %s\n", 
+                  sensorDataTopic, relayLogTopic, statusTopic, relayCommandTopic, calibrationTopic.c_str(),
+                  rulesTopic.c_str(), batchTopic.c_str(), otaTopic.c_str(), configTopic.c_str(),
+                  metricsTopic.c_str());
+}
+
+bool MQTTClient::begin() {
+    if (!SPIFFS.begin(true)) {
+        Serial.println("Failed to mount SPIFFS - outbound MQTT queue is RAM only");
+        return false;
+    }
+    
+    outbox.begin(OUTBOX_PATH);
+    return true;
+}
+
+void MQTTClient::enableGateway() {
+    gatewayEnabled = true;
+    transport.subscribe(leafCommandTopic.c_str(), 1);
+    Serial.printf("Gateway topics:\n  Leaf batch: %s\n  Leaf command: %s\n", leafBatchTopic.c_str(),
+                  leafCommandTopic.c_str());
 }
 
 bool MQTTClient::loadCertificates() {
@@ -104,33 +130,18 @@ bool MQTTClient::loadCertificates() {
     return true;
 }
 
-bool MQTTClient::connectWiFi(const char* ssid, const char* password) {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
-    Serial.print("Connecting to WiFi");
+bool MQTTClient::connectWiFi(WiFiLink& wifi) {
+    Serial.println("Connecting to WiFi...");
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < MAX_WIFI_ATTEMPTS) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
+    unsigned long start = millis();
+    while (!wifi.poll(millis()) && millis() - start < WiFiPolicy::JOIN_TIMEOUT) {
+        delay(50);
     }
 
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println();
+    if (wifi.isConnected()) {
         Serial.println("WiFi connected!");
         printConnectionInfo();
         
-        Serial.println("Synchronizing time with NTP server...");
-        timeClient.begin();
-        timeClient.update();
-        
-        time_t epochTime = timeClient.getEpochTime();
-        struct timeval tv = {epochTime, 0};
-        settimeofday(&tv, NULL);
-        
-        Serial.printf("Current time: %s", ctime(&epochTime));
-        
         if (!loadCertificates()) {
             Serial.println("Certificate loading failed!");
             Serial.println("Cannot establish secure TLS connection without proper certificates");
@@ -139,14 +150,33 @@ bool MQTTClient::connectWiFi(const char* ssid, const char* password) {
         
         Serial.println("Certificates loaded - ready for secure TLS connection");
         
-        mqttClient.setClient(wifiClientSecure);
-        mqttClient.setServer(mqttServer, mqttPort);
-        mqttClient.setKeepAlive(60);
-        mqttClient.setSocketTimeout(30);
+        // A persistent session needs the same client id on every connect
+        clientId = String("ESP32-") + deviceId;
+        
+        transport.setServer(mqttServer, mqttPort);
+        transport.setCredentials(clientId.c_str(), mqttUser, mqttPassword);
+        transport.setSession(CLEAN_SESSION, KEEP_ALIVE);
+        transport.setInflightWindow(INFLIGHT_WINDOW);
         
-        mqttClient.setCallback([this](char* topic, byte* payload, unsigned int length) {
+        // QoS 1 so commands published while the device is offline are held by the broker
+        transport.subscribe(relayCommandTopic, 1);
+        transport.subscribe(calibrationTopic.c_str(), 1);
+        transport.subscribe(rulesTopic.c_str(), 1);
+        transport.subscribe(otaTopic.c_str(), 1);
+        // Retained: the broker hands over the current document on every connect
+        transport.subscribe(configTopic.c_str(), 1);
+        // Firmware chunks are re-requested when lost, so they skip the PUBACK round trip
+        transport.subscribe(otaDataTopic.c_str(), 0);
+        
+        transport.setMessageCallback([this](char* topic, byte* payload, unsigned int length) {
             this->handleMessage(topic, payload, length);
         });
+        transport.setConnectCallback([this](bool sessionPresent) {
+            this->handleConnected(sessionPresent);
+        });
+        transport.setDeliveryCallback([](MessageId id) {
+            Serial.printf("MQTT message %lu delivered\n", (unsigned long)id);
+        });
         
         return true;
     } else {
@@ -157,32 +187,26 @@ bool MQTTClient::connectWiFi(const char* ssid, const char* password) {
 }
 
 bool MQTTClient::connectMQTT() {
-    if (mqttClient.connected()) {
-        isConnectedFlag = true;
+    if (transport.connected()) {
+        setConnected(true);
         return true;
     }
 
     Serial.print("Connecting to HiveMQ Cloud MQTT broker with TLS...");
     
-    String clientId = String("ESP32-") + deviceId + "-" + String(random(0xffff), HEX);
-    
-    bool connected = mqttClient.connect(clientId.c_str(), mqttUser, mqttPassword);
-    
-    if (connected) {
-        Serial.println(" connected successfully with TLS!");
-        isConnectedFlag = true;
-        
-        if (mqttClient.subscribe(relayCommandTopic)) {
-            Serial.printf("Successfully subscribed to relay command topic: %s\n", relayCommandTopic);
-        } else {
-            Serial.printf("Failed to subscribe to relay command topic: %s\n", relayCommandTopic);
+    // Only setup waits for the CONNACK; reconnects from loop() complete in the background
+    if (startConnect()) {
+        unsigned long start = millis();
+        while (transport.connecting() && millis() - start < CONNECT_WAIT) {
+            transport.loop();
+            delay(10);
         }
-        
-        publishStatus("online");
-        
+    }
+    
+    if (transport.connected()) {
         return true;
     } else {
-        Serial.printf(" failed with TLS, rc=%d\n", mqttClient.state());
+        Serial.printf(" failed with TLS, rc=%d\n", transport.getState());
         Serial.println("MQTT Connection Error Codes:");
         Serial.println("-4: Connection timeout");
         Serial.println("-3: Connection lost");
@@ -196,27 +220,79 @@ bool MQTTClient::connectMQTT() {
         Serial.println(" 5: Not authorized");
         Serial.println("If rc=-2, check certificate store and ensure proper CA certificates are loaded");
         
-        isConnectedFlag = false;
+        setConnected(false);
         return false;
     }
 }
 
+bool MQTTClient::startConnect() {
+    if (CLEAN_SESSION) {
+        clientId = String("ESP32-") + deviceId + "-" + String(random(0xffff), HEX);
+        transport.setCredentials(clientId.c_str(), mqttUser, mqttPassword);
+    }
+    return transport.connect();
+}
+
+void MQTTClient::handleConnected(bool sessionPresent) {
+    Serial.printf(" connected successfully with TLS! (session %s)\n", sessionPresent ? "resumed" : "new");
+    setConnected(true);
+    lastReconnectAttempt = 0;
+    
+    Serial.printf("Subscribed to relay command topic: %s\n", relayCommandTopic);
+    Serial.printf("Subscribed to calibration topic: %s\n", calibrationTopic.c_str());
+    Serial.printf("Subscribed to rules topic: %s\n", rulesTopic.c_str());
+    Serial.printf("Subscribed to OTA topics: %s, %s\n", otaTopic.c_str(), otaDataTopic.c_str());
+    Serial.printf("Subscribed to config topic: %s\n", configTopic.c_str());
+    if (gatewayEnabled) Serial.printf("Subscribed to leaf command topic: %s\n", leafCommandTopic.c_str());
+    outbox.printDebugInfo();
+    
+    publishStatus("online");
+}
+
+void MQTTClient::setConnected(bool connected) {
+    if (connected == isConnectedFlag) return;
+    isConnectedFlag = connected;
+    
+    Event event;
+    event.type = Events::CONNECTIVITY;
+    event.link.connected = connected;
+    if (bus) bus->post(event);
+}
+
 void MQTTClient::loop() {
-    if (!mqttClient.connected()) {
+    transport.loop();
+    
+    if (!transport.connected() && !transport.connecting()) {
+        setConnected(false);
+        if (!autoReconnect) return;
+        
         unsigned long now = millis();
         if (now - lastReconnectAttempt > RECONNECT_INTERVAL) {
             lastReconnectAttempt = now;
-            Serial.println("MQTT connection lost, attempting to reconnect...");
-            if (connectMQTT()) {
-                lastReconnectAttempt = 0;
+            if (transport.getState() == MQTTTransport::DISCONNECTED) {
+                Serial.print("Connecting to MQTT broker...");     // Planned, e.g. a radio window
+            } else {
+                Serial.printf("MQTT connection lost (rc=%d), attempting to reconnect...\n", transport.getState());
             }
+            startConnect();
         }
-    } else {
-        mqttClient.loop();
     }
 }
 
 void MQTTClient::handleMessage(char* topic, byte* payload, unsigned int length) {
+    LATENCY_TRACE_POINT(STAGE_MESSAGE_RECEIVED);
+    
+    // Firmware data is binary and arrives a thousand chunks at a time: no copy, no echo
+    if (otaDataTopic == topic) {
+        if (updater) updater->handleChunk(payload, length);
+        return;
+    }
+    if (otaTopic == topic) {
+        Serial.printf("OTA offer received (%u bytes)\n", length);
+        if (updater) updater->handleOffer(payload, length);
+        return;
+    }
+    
     // Convert payload to string
     String message = "";
     for (int i = 0; i < length; i++) {
@@ -242,17 +318,26 @@ void MQTTClient::handleMessage(char* topic, byte* payload, unsigned int length)
         
         if (doc["relayStatus"].is<bool>()) {
             bool relayStatus = doc["relayStatus"];
-            String state = relayStatus ? "on" : "off";
             
-            Serial.printf("Relay command received - RelayStatus: %s\n", relayStatus ? "true" : "false");
+            int zone = doc["zone"] | 1;
+            
+            Serial.printf("Relay command received - RelayStatus: %s, zone %d\n", relayStatus ? "true" : "false", zone);
+            if (zone < 1 || zone > 255) {
+                Serial.println("Relay command zone out of range, ignored");
+                return;
+            }
             
-            remoteRelayCommand = true;
-            remoteRelayStatus = relayStatus;
-            remoteRelayReason = "Remote MQTT command: " + state;
+            Event event;
+            event.type = Events::RELAY_COMMAND;
+            event.command.status = relayStatus;
+            event.command.zone = static_cast<uint8_t>(zone - 1);
+            event.command.id = doc["commandId"] | 0u;
+            if (!bus || !bus->post(event)) {
+                Serial.println("Relay command not queued, event bus full");
+                return;
+            }
             
-            Serial.printf("Global variables set: command=%s, status=%s\n", 
-                         remoteRelayCommand ? "true" : "false",
-                         remoteRelayStatus ? "true" : "false");
+            Serial.printf("Relay command queued: status=%s\n", relayStatus ? "true" : "false");
             
             if (relayStatus) {
                 Serial.println("Will activate Manual Override Mode (ignore soil moisture)");
@@ -267,84 +352,282 @@ void MQTTClient::handleMessage(char* topic, byte* payload, unsigned int length)
         } else {
             Serial.println("No 'relayStatus' field found in relay command");
         }
+    } else if (calibrationTopic == topic) {
+        handleCalibrationCommand(message);
+    } else if (rulesTopic == topic) {
+        // Compiled by the control loop; a newer rule set replaces one not dispatched yet
+        rulesUpdate = message;
+        Event event;
+        event.type = Events::RULES_UPDATE;
+        event.rules.json = &rulesUpdate;
+        if (bus) bus->post(event);
+    } else if (configTopic == topic) {
+        // Validated and applied by the control loop, like rule sets
+        configUpdate = message;
+        Event event;
+        event.type = Events::CONFIG_UPDATE;
+        event.config.json = &configUpdate;
+        if (bus) bus->post(event);
+    } else if (gatewayEnabled && leafCommandTopic == topic) {
+        handleLeafCommand(message);
     }
 }
 
-bool MQTTClient::publishSensorData(float temp, float humidity, int soilMoisture, float soilTemp, bool rain, String waterLevel) {
-    if (!mqttClient.connected()) {
-        Serial.println("MQTT not connected, cannot publish sensor data");
-        return false;
+void MQTTClient::handleLeafCommand(const String& message) {
+    // Expected: {"leaf":"a4cf12000001","relayStatus":true,"zone":1,"commandId":17}
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, message);
+    
+    if (error || !doc["leaf"].is<const char*>() || !doc["relayStatus"].is<bool>()) {
+        Serial.println("Invalid leaf command, expected leaf address and relayStatus");
+        return;
+    }
+    
+    Event event;
+    event.type = Events::LEAF_COMMAND;
+    
+    const char* leaf = doc["leaf"];
+    size_t digits = 0;
+    for (const char* c = leaf; *c; c++) {
+        if (*c == ':') continue;
+        int nibble = isdigit(*c) ? *c - '0' : isxdigit(*c) ? (tolower(*c) - 'a' + 10) : -1;
+        if (nibble < 0 || digits >= 2 * sizeof(event.leafCommand.leaf)) {
+            digits = 0;
+            break;
+        }
+        if (digits % 2 == 0) event.leafCommand.leaf[digits / 2] = nibble << 4;
+        else event.leafCommand.leaf[digits / 2] |= nibble;
+        digits++;
     }
+    
+    int zone = doc["zone"] | 1;
+    if (digits != 2 * sizeof(event.leafCommand.leaf) || zone < 1 || zone > 255) {
+        Serial.printf("Leaf command for '%s' zone %d ignored\n", leaf, zone);
+        return;
+    }
+    
+    event.leafCommand.command.status = doc["relayStatus"];
+    event.leafCommand.command.zone = static_cast<uint8_t>(zone - 1);
+    event.leafCommand.command.id = doc["commandId"] | 0u;
+    if (!bus || !bus->post(event)) {
+        Serial.println("Leaf command not queued, event bus full");
+    }
+}
 
+void MQTTClient::handleCalibrationCommand(const String& message) {
+    // Expected: {"sensor":"soilMoisture","points":[[1390,100],[2100,55],[2945,0]]}
+    //       or: {"sensor":"soilMoisture","reset":true}
     JsonDocument doc;
-    doc["temperature"] = temp;
-    doc["humidity"] = humidity;
-    doc["soilMoisture"] = soilMoisture;
-    doc["soilTemperature"] = soilTemp;
-    doc["rainDetected"] = rain;
-    doc["waterLevel"] = waterLevel;
+    DeserializationError error = deserializeJson(doc, message);
+    
+    if (error) {
+        Serial.println("Failed to parse calibration command JSON");
+        return;
+    }
+    
+    const char* sensor = doc["sensor"] | "";
+    CalibrationCurve* curve = CalibrationUtils::findCurve(sensor);
+    if (!curve) {
+        Serial.printf("Unknown calibration sensor: '%s'\n", sensor);
+        return;
+    }
+    
+    if (doc["reset"] | false) {
+        curve->resetToDefault();
+        curve->clearNVS();
+        Serial.printf("Calibration curve '%s' reset to default\n", sensor);
+        curve->printDebugInfo();
+        return;
+    }
+    
+    JsonArray pointsJson = doc["points"];
+    CalibrationPoint points[CalibrationCurve::MAX_POINTS];
+    int count = 0;
+    
+    for (JsonVariant point : pointsJson) {
+        if (count >= CalibrationCurve::MAX_POINTS) {
+            count = 0;  // Too many points, reject the whole curve
+            break;
+        }
+        // Read wide so an out-of-range value is rejected rather than wrapped into the point
+        int raw = point[0] | -1;
+        int value = point[1] | -1;
+        if (raw < 0 || raw > CalibrationTable::ADC_MAX || value < 0 || value > CalibrationTable::VALUE_MAX) {
+            count = 0;  // Out of range, reject the whole curve
+            break;
+        }
+        points[count].raw = static_cast<uint16_t>(raw);
+        points[count].value = static_cast<uint8_t>(value);
+        count++;
+    }
+    
+    if (curve->setPoints(points, count) && curve->saveToNVS()) {
+        Serial.printf("Calibration curve '%s' updated and saved to NVS\n", sensor);
+    } else {
+        Serial.printf("Calibration update for '%s' failed\n", sensor);
+    }
+    curve->printDebugInfo();
+}
+
+MQTTClient::MessageId MQTTClient::publishSensorData(const JsonDocument& doc) {
+    if (!transport.connected()) {
+        Serial.println("MQTT not connected, cannot publish sensor data");
+        return 0;
+    }
 
     String jsonString;
     serializeJson(doc, jsonString);
 
-    if (mqttClient.publish(sensorDataTopic, jsonString.c_str())) {
-        Serial.println("Sensor data published successfully");
+    MessageId id = transport.publish(sensorDataTopic, reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 1, false);
+    if (id) {
+        Serial.printf("Sensor data queued (message %lu)\n", (unsigned long)id);
         Serial.println("Data: " + jsonString);
-        return true;
     } else {
-        Serial.println("Failed to publish sensor data");
-        return false;
+        Serial.println("Failed to queue sensor data");
     }
+    return id;
 }
 
-bool MQTTClient::publishRelayLog(bool relayStatus, String reason) {
-    if (!mqttClient.connected()) {
-        Serial.println("MQTT not connected, cannot publish relay log");
-        return false;
+MQTTClient::MessageId MQTTClient::publishMetrics(const JsonDocument& doc) {
+    if (!transport.connected()) {
+        Serial.println("MQTT not connected, cannot publish metrics");
+        return 0;
+    }
+
+    String jsonString;
+    serializeJson(doc, jsonString);
+
+    MessageId id = transport.publish(metricsTopic.c_str(), reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 1, false);
+    if (id) {
+        Serial.printf("Metrics queued (message %lu, %u bytes)\n", (unsigned long)id, (unsigned)jsonString.length());
+    } else {
+        Serial.println("Failed to queue metrics");
+    }
+    return id;
+}
+
+MQTTClient::MessageId MQTTClient::publishSensorBatch(const uint8_t* data, size_t length) {
+    if (!transport.connected()) {
+        Serial.println("MQTT not connected, cannot publish sensor batch");
+        return 0;
+    }
+
+    MessageId id = transport.publish(batchTopic.c_str(), data, length, 1, false);
+    if (id) {
+        Serial.printf("Sensor batch queued (message %lu, %u bytes)\n", (unsigned long)id, (unsigned)length);
+    } else {
+        Serial.println("Failed to queue sensor batch");
+    }
+    return id;
+}
+
+MQTTClient::MessageId MQTTClient::publishLeafBatch(const uint8_t* data, size_t length) {
+    // Offline the gateway keeps the batch and retries
+    if (!transport.connected()) return 0;
+
+    MessageId id = transport.publish(leafBatchTopic.c_str(), data, length, 1, false);
+    if (id) {
+        Serial.printf("Leaf batch queued (message %lu, %u bytes)\n", (unsigned long)id, (unsigned)length);
+    } else {
+        Serial.println("Failed to queue leaf batch");
     }
+    return id;
+}
 
+MQTTClient::MessageId MQTTClient::publishRelayLog(uint8_t zone, bool relayStatus, String reason) {
+    // Queued even while offline: the log is delivered once the broker is back
     JsonDocument doc;
+    doc["zone"] = zone + 1;
     doc["relayStatus"] = relayStatus;
     doc["triggerReason"] = reason;
 
     String jsonString;
     serializeJson(doc, jsonString);
 
-    if (mqttClient.publish(relayLogTopic, jsonString.c_str())) {
-        Serial.println("Relay log published successfully");
+    MessageId id = transport.publish(relayLogTopic, reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 1, false);
+    if (id) {
+        Serial.printf("Relay log queued (message %lu)\n", (unsigned long)id);
         Serial.println("Data: " + jsonString);
-        return true;
     } else {
-        Serial.println("Failed to publish relay log");
-        return false;
+        Serial.println("Failed to queue relay log");
     }
+    return id;
 }
 
-bool MQTTClient::publishStatus(String status) {
-    if (!mqttClient.connected()) {
+MQTTClient::MessageId MQTTClient::publishStatus(String status) {
+    if (!transport.connected()) {
         Serial.println("MQTT not connected, cannot publish status");
-        return false;
+        return 0;
     }
 
+    // UTC time of day, as NTPClient::getFormattedTime() used to report it
+    time_t now = time(nullptr);
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+    char timestamp[9];
+    strftime(timestamp, sizeof(timestamp), "%H:%M:%S", &timeinfo);
+
     JsonDocument doc;
     doc["device_id"] = deviceId;
-    doc["timestamp"] = timeClient.getFormattedTime();
+    doc["timestamp"] = timestamp;
     doc["status"] = status;
 
     String jsonString;
     serializeJson(doc, jsonString);
 
-    if (mqttClient.publish(statusTopic, jsonString.c_str())) {
-        Serial.println("Status published successfully: " + status);
-        return true;
+    MessageId id = transport.publish(statusTopic, reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 0, false);
+    if (id) {
+        Serial.println("Status queued: " + status);
     } else {
-        Serial.println("Failed to publish status");
-        return false;
+        Serial.println("Failed to queue status");
+    }
+    return id;
+}
+
+MQTTClient::MessageId MQTTClient::publishOtaRequest(uint32_t offset, uint32_t length) {
+    // A request lost with the link is sent again by the updater after reconnecting
+    if (!transport.connected()) return 0;
+
+    char payload[48];
+    int size = snprintf(payload, sizeof(payload), "{\"offset\":%lu,\"length\":%lu}", (unsigned long)offset,
+                        (unsigned long)length);
+    return transport.publish(otaRequestTopic.c_str(), reinterpret_cast<const uint8_t*>(payload), size, 0, false);
+}
+
+MQTTClient::MessageId MQTTClient::publishOtaStatus(const JsonDocument& doc) {
+    String jsonString;
+    serializeJson(doc, jsonString);
+
+    MessageId id = transport.publish(otaStatusTopic.c_str(), reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 1, false);
+    if (id) {
+        Serial.println("OTA status queued: " + jsonString);
+    } else {
+        Serial.println("Failed to queue OTA status");
+    }
+    return id;
+}
+
+MQTTClient::MessageId MQTTClient::publishConfigStatus(const JsonDocument& doc) {
+    String jsonString;
+    serializeJson(doc, jsonString);
+
+    MessageId id = transport.publish(configStatusTopic.c_str(), reinterpret_cast<const uint8_t*>(jsonString.c_str()),
+                                     jsonString.length(), 1, false);
+    if (id) {
+        Serial.println("Config status queued: " + jsonString);
+    } else {
+        Serial.println("Failed to queue config status");
     }
+    return id;
 }
 
 bool MQTTClient::isConnected() {
-    return isConnectedFlag && mqttClient.connected();
+    return isConnectedFlag && transport.connected();
 }
 
 void MQTTClient::printConnectionInfo() {
@@ -364,10 +647,23 @@ void MQTTClient::printConnectionInfo() {
 }
 
 void MQTTClient::disconnect() {
-    if (mqttClient.connected()) {
+    if (transport.connected()) {
         publishStatus("offline");
-        mqttClient.disconnect();
+        transport.disconnect();
     }
-    isConnectedFlag = false;
+    setConnected(false);
     Serial.println("MQTT client disconnected");
 }
+
+void MQTTClient::suspend() {
+    // Unacknowledged messages stay queued (and journaled) for the next connection
+    transport.disconnect();
+    setConnected(false);
+}
+
+void MQTTClient::setAutoReconnect(bool enabled) {
+    if (enabled && !autoReconnect) {
+        lastReconnectAttempt = millis() - RECONNECT_INTERVAL - 1;    // Try on the next loop()
+    }
+    autoReconnect = enabled;
+}
@@ -0,0 +1,438 @@
+#include "network/MQTTTransport.h"
+
+namespace {
+    const uint8_t MQTT_CONNECT = 0x10;
+    const uint8_t MQTT_CONNACK = 0x20;
+    const uint8_t MQTT_PUBLISH = 0x30;
+    const uint8_t MQTT_PUBACK = 0x40;
+    const uint8_t MQTT_SUBSCRIBE = 0x82;     // Reserved flags 0b0010
+    const uint8_t MQTT_SUBACK = 0x90;
+    const uint8_t MQTT_PINGREQ = 0xC0;
+    const uint8_t MQTT_PINGRESP = 0xD0;
+    const uint8_t MQTT_DISCONNECT = 0xE0;
+
+    const uint8_t PUBLISH_DUP = 0x08;
+    const uint8_t PUBLISH_RETAIN = 0x01;
+
+    size_t putString(uint8_t* out, const char* text, size_t length) {
+        out[0] = length >> 8;
+        out[1] = length & 0xFF;
+        memcpy(out + 2, text, length);
+        return length + 2;
+    }
+}
+
+MQTTTransport::MQTTTransport(Client& client, OutboundQueue& queue) : client(client), queue(queue) {
+    host = nullptr;
+    port = 1883;
+    clientId = "";
+    user = nullptr;
+    password = nullptr;
+    cleanSession = true;
+    keepAlive = 60;
+    inflightWindow = 1;
+
+    state = DISCONNECTED;
+    awaitingConnack = false;
+    connectStartedAt = 0;
+    lastOutbound = 0;
+    lastInbound = 0;
+    pingOutstanding = false;
+    nextPacketId = 1;
+    inflight = 0;
+    subscriptionCount = 0;
+
+    rxState = RX_HEADER;
+    rxHeader = 0;
+    rxLength = 0;
+    rxMultiplier = 1;
+    rxReceived = 0;
+}
+
+void MQTTTransport::setServer(const char* host, uint16_t port) {
+    this->host = host;
+    this->port = port;
+}
+
+void MQTTTransport::setCredentials(const char* clientId, const char* user, const char* password) {
+    this->clientId = clientId;
+    this->user = user;
+    this->password = password;
+}
+
+void MQTTTransport::setSession(bool cleanSession, uint16_t keepAliveSeconds) {
+    this->cleanSession = cleanSession;
+    this->keepAlive = keepAliveSeconds;
+}
+
+void MQTTTransport::setInflightWindow(uint8_t window) {
+    inflightWindow = window > 0 ? window : 1;
+}
+
+uint16_t MQTTTransport::takePacketId() {
+    uint16_t id = nextPacketId++;
+    if (nextPacketId == 0) nextPacketId = 1;
+    return id;
+}
+
+bool MQTTTransport::sendPacket(uint8_t header, size_t bodyLength) {
+    // The body was built at txBuffer + HEADER_RESERVE; prepend the fixed header
+    // so the whole packet goes out in a single write
+    uint8_t lengthBytes[4];
+    size_t lengthSize = 0;
+    size_t remaining = bodyLength;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) digit |= 0x80;
+        lengthBytes[lengthSize++] = digit;
+    } while (remaining > 0);
+
+    uint8_t* start = txBuffer + HEADER_RESERVE - lengthSize - 1;
+    start[0] = header;
+    memcpy(start + 1, lengthBytes, lengthSize);
+
+    size_t packetSize = bodyLength + lengthSize + 1;
+    if (client.write(start, packetSize) != packetSize) {
+        return false;
+    }
+    lastOutbound = millis();
+    return true;
+}
+
+bool MQTTTransport::connect() {
+    if (connected() || awaitingConnack) return true;
+    if (!host) return false;
+
+    if (!client.connect(host, port)) {
+        state = CONNECT_FAILED;
+        return false;
+    }
+
+    uint8_t* body = txBuffer + HEADER_RESERVE;
+    size_t length = putString(body, "MQTT", 4);
+    body[length++] = 4;                                      // Protocol level 3.1.1
+
+    uint8_t flags = cleanSession ? 0x02 : 0x00;
+    if (user) flags |= 0x80;
+    if (user && password) flags |= 0x40;
+    body[length++] = flags;
+    body[length++] = keepAlive >> 8;
+    body[length++] = keepAlive & 0xFF;
+
+    length += putString(body + length, clientId, strlen(clientId));
+    if (user) length += putString(body + length, user, strlen(user));
+    if (user && password) length += putString(body + length, password, strlen(password));
+
+    rxState = RX_HEADER;
+    if (!sendPacket(MQTT_CONNECT, length)) {
+        client.stop();
+        state = CONNECT_FAILED;
+        return false;
+    }
+
+    awaitingConnack = true;
+    connectStartedAt = millis();
+    lastInbound = connectStartedAt;
+    pingOutstanding = false;
+    return true;
+}
+
+void MQTTTransport::disconnect() {
+    if (connected()) {
+        // Give queued messages (the "offline" status, usually) one chance to go out first
+        sendPendingMessages(millis());
+        sendPacket(MQTT_DISCONNECT, 0);
+    }
+    connectionLost(DISCONNECTED);
+}
+
+void MQTTTransport::connectionLost(State reason) {
+    client.stop();
+    state = reason;
+    awaitingConnack = false;
+    rxState = RX_HEADER;
+
+    // Unacknowledged publishes go back in line and are resent with DUP on the next connection
+    for (OutboundQueue::Entry* entry = queue.first(); entry; entry = queue.next(entry)) {
+        if (entry->flags & OutboundQueue::FLAG_SENT) {
+            entry->flags &= ~OutboundQueue::FLAG_SENT;
+            entry->flags |= OutboundQueue::FLAG_DUP;
+        }
+    }
+    inflight = 0;
+    queue.persistOlderThan(millis(), 0);
+}
+
+bool MQTTTransport::connected() {
+    if (state == CONNECTED && !client.connected()) {
+        connectionLost(CONNECTION_LOST);
+    }
+    return state == CONNECTED;
+}
+
+MQTTTransport::MessageId MQTTTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                                                uint8_t qos, bool retain) {
+    if (length > maxPayload(topic, qos)) {
+        Serial.printf("MQTT publish to %s dropped: %u byte payload exceeds the packet buffer\n", topic,
+                      (unsigned)length);
+        return 0;
+    }
+    return queue.push(topic, payload, length, qos > 1 ? 1 : qos, retain);
+}
+
+bool MQTTTransport::subscribe(const char* topic, uint8_t qos) {
+    Subscription* subscription = nullptr;
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        if (strcmp(subscriptions[i].topic, topic) == 0) subscription = &subscriptions[i];
+    }
+    if (!subscription) {
+        if (subscriptionCount >= MAX_SUBSCRIPTIONS) return false;
+        subscription = &subscriptions[subscriptionCount++];
+    }
+    subscription->topic = topic;
+    subscription->qos = qos > 1 ? 1 : qos;
+
+    return !connected() || sendSubscribe(*subscription);
+}
+
+bool MQTTTransport::sendSubscribe(const Subscription& subscription) {
+    uint8_t* body = txBuffer + HEADER_RESERVE;
+    uint16_t packetId = takePacketId();
+    body[0] = packetId >> 8;
+    body[1] = packetId & 0xFF;
+    size_t length = 2 + putString(body + 2, subscription.topic, strlen(subscription.topic));
+    body[length++] = subscription.qos;
+    return sendPacket(MQTT_SUBSCRIBE, length);
+}
+
+bool MQTTTransport::sendPublish(OutboundQueue::Entry* entry) {
+    uint8_t* body = txBuffer + HEADER_RESERVE;
+    size_t length = putString(body, entry->topic(), entry->topicLength);
+
+    uint8_t header = MQTT_PUBLISH | (entry->qos << 1);
+    if (entry->flags & OutboundQueue::FLAG_RETAIN) header |= PUBLISH_RETAIN;
+    if (entry->qos > 0) {
+        if (entry->packetId == 0) entry->packetId = takePacketId();
+        if (entry->flags & OutboundQueue::FLAG_DUP) header |= PUBLISH_DUP;
+        body[length++] = entry->packetId >> 8;
+        body[length++] = entry->packetId & 0xFF;
+    }
+    memcpy(body + length, entry->payload(), entry->payloadLength);
+    return sendPacket(header, length + entry->payloadLength);
+}
+
+bool MQTTTransport::sendPendingMessages(unsigned long now) {
+    uint8_t sent = 0;
+    OutboundQueue::Entry* entry = queue.first();
+    while (entry && sent < MAX_SENDS_PER_LOOP) {
+        if (entry->flags & OutboundQueue::FLAG_SENT) {
+            entry = queue.next(entry);
+            continue;
+        }
+        // Strict FIFO: nothing overtakes a QoS 1 message held back by the window
+        if (entry->qos > 0 && inflight >= inflightWindow) break;
+
+        if (!sendPublish(entry)) return false;
+        sent++;
+
+        if (entry->qos == 0) {
+            entry = queue.remove(entry);
+            continue;
+        }
+        entry->flags |= OutboundQueue::FLAG_SENT;
+        entry->sentAt = now;
+        inflight++;
+        entry = queue.next(entry);
+    }
+    return true;
+}
+
+bool MQTTTransport::readPackets(unsigned long now) {
+    while (client.available() > 0) {
+        switch (rxState) {
+            case RX_HEADER: {
+                int byte = client.read();
+                if (byte < 0) return true;
+                rxHeader = byte;
+                rxLength = 0;
+                rxMultiplier = 1;
+                rxReceived = 0;
+                rxState = RX_LENGTH;
+                break;
+            }
+            case RX_LENGTH: {
+                int byte = client.read();
+                if (byte < 0) return true;
+                rxLength += (byte & 0x7F) * rxMultiplier;
+                rxMultiplier *= 128;
+                if (byte & 0x80) {
+                    if (rxMultiplier > 128 * 128 * 128) return false;     // Malformed length
+                    break;
+                }
+                if (rxLength > MAX_PACKET_SIZE) {
+                    Serial.printf("MQTT packet of %lu bytes exceeds the buffer, skipping it\n", (unsigned long)rxLength);
+                    rxState = RX_DISCARD;
+                } else {
+                    rxState = RX_BODY;
+                }
+                if (rxLength == 0) {
+                    rxState = RX_HEADER;
+                    lastInbound = now;
+                    handlePacket();
+                }
+                break;
+            }
+            case RX_BODY: {
+                int n = client.read(rxBuffer + rxReceived, rxLength - rxReceived);
+                if (n <= 0) return true;
+                rxReceived += n;
+                if (rxReceived == rxLength) {
+                    rxState = RX_HEADER;
+                    lastInbound = now;
+                    handlePacket();
+                }
+                break;
+            }
+            case RX_DISCARD: {
+                uint8_t scratch[64];
+                uint32_t chunk = rxLength - rxReceived;
+                int n = client.read(scratch, chunk < sizeof(scratch) ? chunk : sizeof(scratch));
+                if (n <= 0) return true;
+                rxReceived += n;
+                if (rxReceived == rxLength) {
+                    rxState = RX_HEADER;
+                    lastInbound = now;
+                }
+                break;
+            }
+        }
+        if (state != CONNECTED && !awaitingConnack) return true;   // Refused by the broker
+    }
+    return true;
+}
+
+void MQTTTransport::handlePacket() {
+    switch (rxHeader & 0xF0) {
+        case MQTT_CONNACK:
+            handleConnack();
+            break;
+        case MQTT_PUBLISH:
+            handlePublish();
+            break;
+        case MQTT_PUBACK:
+            handlePuback();
+            break;
+        case MQTT_SUBACK:
+            for (uint32_t i = 2; i < rxLength; i++) {
+                if (rxBuffer[i] == 0x80) Serial.println("MQTT subscription refused by the broker");
+            }
+            break;
+        case MQTT_PINGRESP:
+            pingOutstanding = false;
+            break;
+        default:
+            break;
+    }
+}
+
+void MQTTTransport::handleConnack() {
+    if (!awaitingConnack || rxLength < 2) return;
+    awaitingConnack = false;
+
+    uint8_t returnCode = rxBuffer[1];
+    if (returnCode != 0) {
+        connectionLost(returnCode <= UNAUTHORIZED ? static_cast<State>(returnCode) : CONNECT_FAILED);
+        return;
+    }
+
+    bool sessionPresent = rxBuffer[0] & 0x01;
+    state = CONNECTED;
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        if (!sendSubscribe(subscriptions[i])) {
+            connectionLost(CONNECTION_LOST);
+            return;
+        }
+    }
+    if (connectCallback) connectCallback(sessionPresent);
+}
+
+void MQTTTransport::handlePublish() {
+    if (rxLength < 2) return;
+
+    uint8_t qos = (rxHeader >> 1) & 0x03;
+    uint16_t topicLength = (rxBuffer[0] << 8) | rxBuffer[1];
+    size_t offset = 2 + topicLength;
+    uint16_t packetId = 0;
+    if (qos > 0) {
+        if (offset + 2 > rxLength) return;
+        packetId = (rxBuffer[offset] << 8) | rxBuffer[offset + 1];
+        offset += 2;
+    }
+    if (offset > rxLength) return;
+
+    // Shift the topic over its length prefix to NUL-terminate it in place
+    memmove(rxBuffer, rxBuffer + 2, topicLength);
+    rxBuffer[topicLength] = '\0';
+    if (messageCallback) {
+        messageCallback(reinterpret_cast<char*>(rxBuffer), rxBuffer + offset, rxLength - offset);
+    }
+
+    // Acknowledged after the callback: a reset while handling it gets the message redelivered
+    if (qos == 1) {
+        uint8_t* body = txBuffer + HEADER_RESERVE;
+        body[0] = packetId >> 8;
+        body[1] = packetId & 0xFF;
+        if (!sendPacket(MQTT_PUBACK, 2)) connectionLost(CONNECTION_LOST);
+    }
+}
+
+void MQTTTransport::handlePuback() {
+    if (rxLength < 2) return;
+
+    uint16_t packetId = (rxBuffer[0] << 8) | rxBuffer[1];
+    OutboundQueue::Entry* entry = queue.findPacket(packetId);
+    if (!entry || entry->qos == 0) return;
+
+    MessageId id = entry->id;
+    queue.remove(entry);
+    inflight--;
+    if (deliveryCallback) deliveryCallback(id);
+}
+
+void MQTTTransport::loop() {
+    unsigned long now = millis();
+
+    if (state == CONNECTED || awaitingConnack) {
+        if (!client.connected() || !readPackets(now)) {
+            connectionLost(CONNECTION_LOST);
+        } else if (awaitingConnack && now - connectStartedAt > CONNACK_TIMEOUT) {
+            connectionLost(CONNECTION_TIMEOUT);
+        }
+    }
+
+    if (state == CONNECTED) {
+        unsigned long keepAliveMs = keepAlive * 1000UL;
+        OutboundQueue::Entry* oldest = queue.first();
+        while (oldest && !(oldest->flags & OutboundQueue::FLAG_SENT)) oldest = queue.next(oldest);
+
+        if (keepAliveMs > 0 && now - lastInbound > keepAliveMs + keepAliveMs / 2) {
+            Serial.println("MQTT keepalive timed out");
+            connectionLost(CONNECTION_TIMEOUT);
+        } else if (oldest && now - oldest->sentAt > ACK_TIMEOUT) {
+            Serial.println("MQTT PUBACK overdue, dropping the connection");
+            connectionLost(CONNECTION_TIMEOUT);
+        } else if (!sendPendingMessages(now)) {
+            connectionLost(CONNECTION_LOST);
+        } else if (keepAliveMs > 0 && !pingOutstanding &&
+                   (now - lastOutbound >= keepAliveMs || now - lastInbound >= keepAliveMs)) {
+            if (sendPacket(MQTT_PINGREQ, 0)) {
+                pingOutstanding = true;
+            } else {
+                connectionLost(CONNECTION_LOST);
+            }
+        }
+    }
+
+    queue.persistOlderThan(now, PERSIST_DELAY);
+}
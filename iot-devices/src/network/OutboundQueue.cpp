@@ -0,0 +1,279 @@
+#include "network/OutboundQueue.h"
+#include <SPIFFS.h>
+
+OutboundQueue::OutboundQueue() {
+    used = 0;
+    count = 0;
+    nextId = 1;
+    droppedMessages = 0;
+    journalPath = nullptr;
+    compactPath[0] = '\0';
+    journalBytes = 0;
+    journalLive = 0;
+}
+
+size_t OutboundQueue::entrySize(size_t topicLength, size_t payloadLength) {
+    size_t size = sizeof(Entry) + topicLength + 1 + payloadLength;
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+uint8_t OutboundQueue::computeCrc(const JournalHeader& header, const char* topic, const uint8_t* payload) {
+    // CRC-8 (Dallas/Maxim) over the header with the crc byte zeroed, then topic and payload
+    JournalHeader copy = header;
+    copy.crc = 0;
+
+    uint8_t crc = 0;
+    auto feed = [&crc](const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            uint8_t byte = data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                uint8_t mix = (crc ^ byte) & 0x01;
+                crc >>= 1;
+                if (mix) crc ^= 0x8C;
+                byte >>= 1;
+            }
+        }
+    };
+    feed(reinterpret_cast<const uint8_t*>(&copy), sizeof(copy));
+    feed(reinterpret_cast<const uint8_t*>(topic), header.topicLength);
+    feed(payload, header.payloadLength);
+    return crc;
+}
+
+bool OutboundQueue::begin(const char* journalPath) {
+    snprintf(compactPath, sizeof(compactPath), "%s.tmp", journalPath);
+
+    // SPIFFS can't rename over a file, so compaction removes the old journal first; a reset
+    // right then leaves only the compacted copy. With both present the old one is complete.
+    if (!SPIFFS.exists(journalPath) && SPIFFS.exists(compactPath)) {
+        SPIFFS.rename(compactPath, journalPath);
+    }
+
+    // journalPath stays unset while replaying so remove() doesn't touch the file being read
+    loadJournal(journalPath);
+    this->journalPath = journalPath;
+    compactJournal();
+    return true;
+}
+
+void OutboundQueue::loadJournal(const char* path) {
+    File file = SPIFFS.open(path, "r");
+    if (!file) return;
+
+    JournalHeader header;
+    while (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)) {
+        if (header.type == JOURNAL_DONE) {
+            Entry* entry = find(header.id);
+            if (entry) remove(entry);
+            continue;
+        }
+        if (header.type != JOURNAL_ADD) break;
+
+        // Read straight into the arena slot; it only becomes part of the queue once the CRC matches
+        size_t size = entrySize(header.topicLength, header.payloadLength);
+        if (used + size > CAPACITY) {
+            droppedMessages++;
+            if (!file.seek(file.position() + header.topicLength + header.payloadLength)) break;
+            continue;
+        }
+
+        Entry* entry = reinterpret_cast<Entry*>(arena + used);
+        uint8_t* topic = reinterpret_cast<uint8_t*>(entry + 1);
+        uint8_t* payload = topic + header.topicLength + 1;
+        if (file.read(topic, header.topicLength) != header.topicLength ||
+            file.read(payload, header.payloadLength) != header.payloadLength) {
+            break;                          // Torn tail from a power loss
+        }
+        if (header.crc != computeCrc(header, reinterpret_cast<const char*>(topic), payload)) break;
+
+        topic[header.topicLength] = '\0';
+        entry->id = header.id;
+        entry->queuedAt = millis();
+        entry->sentAt = 0;
+        entry->packetId = 0;
+        entry->topicLength = header.topicLength;
+        entry->payloadLength = header.payloadLength;
+        entry->qos = header.qos;
+        // Anything in the journal may already have reached the broker before the reset
+        entry->flags = (header.flags & FLAG_RETAIN) | FLAG_DUP;
+        used += size;
+        count++;
+
+        if (header.id >= nextId) nextId = header.id + 1;
+    }
+    file.close();
+
+    // Mark survivors so compactJournal() rewrites them into a fresh file
+    for (Entry* entry = first(); entry; entry = next(entry)) {
+        entry->flags |= FLAG_JOURNALED;
+    }
+    Serial.printf("Outbound queue: %u message(s) restored from %s\n", (unsigned)count, path);
+}
+
+OutboundQueue::MessageId OutboundQueue::push(const char* topic, const uint8_t* payload, size_t length,
+                                             uint8_t qos, bool retain) {
+    size_t topicLength = strlen(topic);
+    size_t size = entrySize(topicLength, length);
+    if (topicLength > 0xFFFF || length > 0xFFFF || used + size > CAPACITY) {
+        droppedMessages++;
+        return 0;
+    }
+
+    Entry* entry = reinterpret_cast<Entry*>(arena + used);
+    entry->id = nextId;
+    entry->queuedAt = millis();
+    entry->sentAt = 0;
+    entry->packetId = 0;
+    entry->topicLength = topicLength;
+    entry->payloadLength = length;
+    entry->qos = qos;
+    entry->flags = retain ? FLAG_RETAIN : 0;
+
+    char* topicCopy = reinterpret_cast<char*>(entry + 1);
+    memcpy(topicCopy, topic, topicLength + 1);
+    if (length > 0) memcpy(topicCopy + topicLength + 1, payload, length);
+
+    used += size;
+    count++;
+    if (++nextId == 0) nextId = 1;
+    return entry->id;
+}
+
+OutboundQueue::Entry* OutboundQueue::remove(Entry* entry) {
+    if ((entry->flags & FLAG_JOURNALED) && journalPath) {
+        JournalHeader header = {JOURNAL_DONE, 0, 0, 0, entry->id, 0, 0};
+        writeJournal(header, nullptr, nullptr);
+        journalLive--;
+    }
+
+    uint8_t* start = reinterpret_cast<uint8_t*>(entry);
+    size_t size = entrySize(entry->topicLength, entry->payloadLength);
+    memmove(start, start + size, used - (start - arena) - size);
+    used -= size;
+    count--;
+
+    if (journalLive == 0 && journalBytes > 0) {
+        compactJournal();
+    }
+    return start < arena + used ? entry : nullptr;
+}
+
+OutboundQueue::Entry* OutboundQueue::first() {
+    return used > 0 ? reinterpret_cast<Entry*>(arena) : nullptr;
+}
+
+OutboundQueue::Entry* OutboundQueue::next(Entry* entry) {
+    uint8_t* following = reinterpret_cast<uint8_t*>(entry) + entrySize(entry->topicLength, entry->payloadLength);
+    return following < arena + used ? reinterpret_cast<Entry*>(following) : nullptr;
+}
+
+OutboundQueue::Entry* OutboundQueue::find(MessageId id) {
+    for (Entry* entry = first(); entry; entry = next(entry)) {
+        if (entry->id == id) return entry;
+    }
+    return nullptr;
+}
+
+OutboundQueue::Entry* OutboundQueue::findPacket(uint16_t packetId) {
+    for (Entry* entry = first(); entry; entry = next(entry)) {
+        if ((entry->flags & FLAG_SENT) && entry->packetId == packetId) return entry;
+    }
+    return nullptr;
+}
+
+OutboundQueue::JournalHeader OutboundQueue::addRecord(const Entry* entry) {
+    return {JOURNAL_ADD, entry->qos, static_cast<uint8_t>(entry->flags & FLAG_RETAIN), 0,
+            entry->id, entry->topicLength, entry->payloadLength};
+}
+
+size_t OutboundQueue::appendRecord(const char* path, const JournalHeader& header, const char* topic,
+                                   const uint8_t* payload) {
+    File file = SPIFFS.open(path, "a");
+    if (!file) return 0;
+
+    JournalHeader record = header;
+    record.crc = computeCrc(record, topic, payload);
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    if (header.topicLength) written += file.write(reinterpret_cast<const uint8_t*>(topic), header.topicLength);
+    if (header.payloadLength) written += file.write(payload, header.payloadLength);
+    file.close();
+    return written;
+}
+
+bool OutboundQueue::writeJournal(const JournalHeader& header, const char* topic, const uint8_t* payload) {
+    if (!journalPath) return false;
+
+    size_t written = appendRecord(journalPath, header, topic, payload);
+    journalBytes += written;
+    return written == sizeof(header) + header.topicLength + header.payloadLength;
+}
+
+void OutboundQueue::persist(Entry* entry) {
+    if (entry->qos == 0 || (entry->flags & FLAG_JOURNALED)) return;
+
+    if (writeJournal(addRecord(entry), entry->topic(), entry->payload())) {
+        entry->flags |= FLAG_JOURNALED;
+        journalLive++;
+    }
+
+    if (journalBytes > JOURNAL_COMPACT_BYTES) {
+        compactJournal();
+    }
+}
+
+void OutboundQueue::persistOlderThan(unsigned long now, unsigned long age) {
+    if (!journalPath) return;
+
+    for (Entry* entry = first(); entry; entry = next(entry)) {
+        if (now - entry->queuedAt >= age) persist(entry);
+    }
+}
+
+void OutboundQueue::compactJournal() {
+    if (!journalPath) return;
+
+    // Rewrite only what is still queued, next to the old journal
+    SPIFFS.remove(compactPath);
+    uint32_t bytes = 0;
+    uint16_t live = 0;
+    bool complete = true;
+    for (Entry* entry = first(); entry && complete; entry = next(entry)) {
+        if (!(entry->flags & FLAG_JOURNALED)) continue;
+
+        JournalHeader header = addRecord(entry);
+        size_t written = appendRecord(compactPath, header, entry->topic(), entry->payload());
+        complete = written == sizeof(header) + header.topicLength + header.payloadLength;
+        bytes += written;
+        live++;
+    }
+
+    // The old journal stays in force until the new one is complete and in its place
+    if (!complete) {
+        SPIFFS.remove(compactPath);
+        Serial.println("Outbound journal compaction failed - keeping the old journal");
+        return;
+    }
+    SPIFFS.remove(journalPath);
+    if (live > 0 && !SPIFFS.rename(compactPath, journalPath)) {
+        // Flash error: journal the live entries again from scratch
+        Serial.println("Outbound journal rename failed - rewriting the journal");
+        SPIFFS.remove(compactPath);
+        journalBytes = 0;
+        journalLive = 0;
+        for (Entry* entry = first(); entry; entry = next(entry)) {
+            if (entry->flags & FLAG_JOURNALED) {
+                entry->flags &= ~FLAG_JOURNALED;
+                persist(entry);
+            }
+        }
+        return;
+    }
+    journalBytes = bytes;
+    journalLive = live;
+}
+
+void OutboundQueue::printDebugInfo() const {
+    Serial.printf("Outbound queue: %u message(s), %u/%u bytes, %u journaled (%lu bytes on flash), %lu dropped\n",
+                  (unsigned)count, (unsigned)used, (unsigned)CAPACITY, journalLive, (unsigned long)journalBytes,
+                  (unsigned long)droppedMessages);
+}
@@ -0,0 +1,204 @@
+#include "network/RadioManager.h"
+#include "utils/SensorCalibration.h"
+#include "utils/SampleClock.h"
+#include <time.h>
+
+RadioManager::RadioManager(ModemRelay& modem, WiFiLink& wifi, MQTTClient& mqtt)
+    : modem(modem), wifi(wifi), mqtt(mqtt) {
+    state = RADIO_OFF;
+    dutyCycling = RadioPolicy::DUTY_CYCLING;
+    holdAwake = false;
+    measuring = false;
+    poweredAt = 0;
+    associatedAt = 0;
+    onlineAt = 0;
+    phaseStartedAt = 0;
+    nextUpload = 0;
+    nextPoll = 0;
+    pollInterval = RadioPolicy::COMMAND_POLL_INTERVAL;
+    associateEstimate = RadioPolicy::INITIAL_ASSOCIATE_ESTIMATE;
+    connectEstimate = RadioPolicy::INITIAL_CONNECT_ESTIMATE;
+    accountedDay = 0;
+    accountedAt = 0;
+    onMsToday = 0;
+    onMsYesterday = 0;
+    windowsToday = 0;
+    failedWindowsToday = 0;
+}
+
+void RadioManager::begin(unsigned long now) {
+    // The modem has been on since boot; setup() time counts as the first window
+    accountedDay = currentDay(now);
+    accountedAt = 0;
+    windowsToday = 1;
+    nextPoll = now + pollInterval;
+
+    measuring = false;
+    phaseStartedAt = now;
+    if (mqtt.isConnected()) {
+        state = RADIO_ONLINE;
+        onlineAt = now;
+    } else if (wifi.isConnected()) {
+        state = RADIO_CONNECTING;
+    } else {
+        state = RADIO_ASSOCIATING;
+    }
+    mqtt.setAutoReconnect(true);
+
+    Serial.printf("Radio manager: duty cycling %s, command poll every %lu s\n",
+                  dutyCycling ? "on" : "off", pollInterval / 1000);
+}
+
+void RadioManager::setCommandPollInterval(unsigned long interval, unsigned long now) {
+    pollInterval = interval;
+    if (static_cast<long>(nextPoll - (now + interval)) > 0) {
+        nextPoll = now + interval;
+    }
+}
+
+long RadioManager::currentDay(unsigned long now) {
+    time_t wallClock = time(nullptr);
+    if (SampleClock::isWallClockSet(wallClock)) {
+        return (wallClock + Timing::LOCAL_UTC_OFFSET) / 86400;
+    }
+    return now / 86400000UL;     // Wall clock not synchronized: days since boot
+}
+
+uint32_t RadioManager::smooth(uint32_t estimate, uint32_t sample) {
+    return (estimate * 3 + sample) / 4;
+}
+
+unsigned long RadioManager::getWarmupLead() const {
+    return associateEstimate + connectEstimate + RadioPolicy::WARMUP_MARGIN;
+}
+
+bool RadioManager::wantsWindow(unsigned long now) const {
+    if (!dutyCycling || holdAwake) return true;
+    if (static_cast<long>(nextUpload - now) <= static_cast<long>(getWarmupLead())) return true;
+    return static_cast<long>(now - nextPoll) >= 0;
+}
+
+bool RadioManager::windowDone(unsigned long now) const {
+    if (!dutyCycling || holdAwake) return false;
+    if (now - onlineAt < RadioPolicy::LISTEN_TIME) return false;
+    if (mqtt.hasPendingMessages()) return false;
+
+    // Stay up if the next upload would need the radio again before it could power back up
+    return static_cast<long>(nextUpload - now) > static_cast<long>(getWarmupLead());
+}
+
+void RadioManager::powerUp(unsigned long now) {
+    bool upload = static_cast<long>(nextUpload - now) <= static_cast<long>(getWarmupLead());
+    Serial.printf("Radio: powering up for %s (warm-up estimate %lu ms)\n",
+                  upload ? "upload" : (holdAwake ? "pump run" : "command poll"), getWarmupLead());
+
+    // The hotspot boots with the modem; the cached access point is tried for that long before scanning
+    modem.turnOn();
+    wifi.connect(now, associateEstimate);
+
+    state = RADIO_ASSOCIATING;
+    measuring = true;
+    poweredAt = now;
+    phaseStartedAt = now;
+    windowsToday++;
+}
+
+void RadioManager::powerDown(unsigned long now, bool failed) {
+    account(now);
+
+    mqtt.setAutoReconnect(false);
+    mqtt.suspend();
+    wifi.disconnect();
+    modem.turnOff();
+
+    if (failed) {
+        failedWindowsToday++;
+        Serial.printf("Radio: window failed while %s, powering down\n",
+                      state == RADIO_ASSOCIATING ? "associating" : "connecting");
+    } else {
+        Serial.printf("Radio: off after %lu ms, %lu ms on today\n", now - poweredAt, (unsigned long)onMsToday);
+    }
+
+    state = RADIO_OFF;
+    nextPoll = now + pollInterval;
+}
+
+void RadioManager::account(unsigned long now) {
+    if (modem.isRelayActive()) {
+        onMsToday += now - accountedAt;
+    }
+    accountedAt = now;
+
+    long day = currentDay(now);
+    if (day != accountedDay) {
+        onMsYesterday = onMsToday;
+        onMsToday = 0;
+        windowsToday = 0;
+        failedWindowsToday = 0;
+        accountedDay = day;
+    }
+}
+
+void RadioManager::loop(unsigned long now) {
+    account(now);
+
+    switch (state) {
+        case RADIO_OFF:
+            if (wantsWindow(now)) powerUp(now);
+            break;
+
+        case RADIO_ASSOCIATING:
+            if (wifi.poll(now)) {
+                if (measuring) associateEstimate = smooth(associateEstimate, now - poweredAt);
+                associatedAt = now;
+                phaseStartedAt = now;
+                state = RADIO_CONNECTING;
+                mqtt.setAutoReconnect(true);
+            } else if (dutyCycling && now - phaseStartedAt > RadioPolicy::ASSOCIATE_TIMEOUT) {
+                powerDown(now, true);
+            }
+            break;
+
+        case RADIO_CONNECTING:
+            if (mqtt.isConnected()) {
+                if (measuring) connectEstimate = smooth(connectEstimate, now - associatedAt);
+                onlineAt = now;
+                state = RADIO_ONLINE;
+            } else if (dutyCycling && now - phaseStartedAt > RadioPolicy::CONNECT_TIMEOUT) {
+                wifi.forgetAddress();
+                powerDown(now, true);
+            }
+            break;
+
+        case RADIO_ONLINE:
+            if (!mqtt.isConnected()) {
+                // Link lost inside the window: wait for it again, without timing it as a warm-up
+                measuring = false;
+                phaseStartedAt = now;
+                state = wifi.isConnected() ? RADIO_CONNECTING : RADIO_ASSOCIATING;
+            } else if (windowDone(now)) {
+                powerDown(now, false);
+            }
+            break;
+    }
+}
+
+void RadioManager::serialize(JsonDocument& doc) const {
+    JsonObject radio = doc["radio"].to<JsonObject>();
+    radio["onMsToday"] = onMsToday;
+    radio["onMsYesterday"] = onMsYesterday;
+    radio["windowsToday"] = windowsToday;
+    radio["failedWindowsToday"] = failedWindowsToday;
+    radio["warmupMs"] = getWarmupLead();
+}
+
+void RadioManager::printDebugInfo() const {
+    Serial.println("=== RADIO ===");
+    Serial.printf("  On today: %lu ms (%.1f%%), yesterday: %lu ms\n", (unsigned long)onMsToday,
+                  onMsToday / 864000.0f, (unsigned long)onMsYesterday);
+    Serial.printf("  Windows today: %u (%u failed), duty cycling %s\n", windowsToday, failedWindowsToday,
+                  dutyCycling ? "on" : "off");
+    Serial.printf("  Warm-up estimate: associate %lu ms + connect %lu ms\n", (unsigned long)associateEstimate,
+                  (unsigned long)connectEstimate);
+    Serial.println("=============");
+}
@@ -0,0 +1,202 @@
+#include "network/WiFiLink.h"
+#include "utils/SensorCalibration.h"
+#include "utils/SampleClock.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <time.h>
+
+WiFiLink::WiFiLink() {
+    ssid = nullptr;
+    password = nullptr;
+    memset(&cache, 0, sizeof(cache));
+    cacheValid = false;
+    addressReused = false;
+    joinState = JOIN_IDLE;
+    joinStartedAt = 0;
+    fastWindow = WiFiPolicy::FAST_JOIN_TIMEOUT;
+    lastJoinMs = 0;
+    lastJoinFast = false;
+    fastJoins = 0;
+    scanJoins = 0;
+    fastMisses = 0;
+    fastJoinTotalMs = 0;
+    scanJoinTotalMs = 0;
+}
+
+void WiFiLink::begin(const char* ssid, const char* password) {
+    this->ssid = ssid;
+    this->password = password;
+    cacheValid = loadCache();
+
+    if (cacheValid) {
+        Serial.printf("WiFi cache: %02X:%02X:%02X:%02X:%02X:%02X on channel %u, address %s\n",
+                      cache.bssid[0], cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4],
+                      cache.bssid[5], cache.channel, IPAddress(cache.ip).toString().c_str());
+    } else {
+        Serial.println("WiFi cache empty - first join scans");
+    }
+}
+
+bool WiFiLink::loadCache() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    size_t length = prefs.isKey(NVS_KEY) ? prefs.getBytes(NVS_KEY, &cache, sizeof(cache)) : 0;
+    prefs.end();
+
+    return length == sizeof(cache) && cache.version == STORAGE_VERSION && cache.channel != 0;
+}
+
+void WiFiLink::saveCache() {
+    CachedNetwork current = {};
+    current.version = STORAGE_VERSION;
+    current.channel = static_cast<uint8_t>(WiFi.channel());
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) memcpy(current.bssid, bssid, sizeof(current.bssid));
+    current.ip = WiFi.localIP();
+    current.gateway = WiFi.gatewayIP();
+    current.subnet = WiFi.subnetMask();
+    current.dns = WiFi.dnsIP(0);
+
+    if (addressReused) {
+        current.leasedAt = cache.leasedAt;
+    } else {
+        time_t wallClock = time(nullptr);
+        current.leasedAt = SampleClock::isWallClockSet(wallClock) ? static_cast<uint32_t>(wallClock) : 0;
+    }
+
+    // Flash is only written when the access point or the lease changed
+    if (cacheValid && memcmp(&current, &cache, sizeof(current)) == 0) return;
+
+    cache = current;
+    cacheValid = current.channel != 0;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open NVS WiFi namespace");
+        return;
+    }
+    prefs.putBytes(NVS_KEY, &cache, sizeof(cache));
+    prefs.end();
+}
+
+void WiFiLink::useDhcp() {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    addressReused = false;
+}
+
+void WiFiLink::connect(unsigned long now, unsigned long apBootTime) {
+    WiFi.mode(WIFI_STA);
+    joinStartedAt = now;
+    fastWindow = apBootTime + WiFiPolicy::FAST_JOIN_TIMEOUT;
+
+    if (!cacheValid) {
+        startScan();
+        return;
+    }
+
+    // The lease age can only be checked once the clock is set; otherwise ask DHCP
+    time_t wallClock = time(nullptr);
+    bool leaseFresh = cache.leasedAt != 0 && SampleClock::isWallClockSet(wallClock) &&
+                      static_cast<uint32_t>(wallClock) - cache.leasedAt < WiFiPolicy::ADDRESS_MAX_AGE;
+    if (WiFiPolicy::REUSE_ADDRESS && leaseFresh && cache.ip != 0) {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+        addressReused = true;
+    } else {
+        useDhcp();
+    }
+
+    WiFi.begin(ssid, password, cache.channel, cache.bssid);
+    joinState = JOIN_FAST;
+}
+
+void WiFiLink::startScan() {
+    useDhcp();
+    WiFi.begin(ssid, password);
+    joinState = JOIN_SCAN;
+}
+
+void WiFiLink::joined(unsigned long now) {
+    lastJoinMs = now - joinStartedAt;
+    lastJoinFast = joinState == JOIN_FAST;
+    if (lastJoinFast) {
+        fastJoins++;
+        fastJoinTotalMs += lastJoinMs;
+    } else {
+        scanJoins++;
+        scanJoinTotalMs += lastJoinMs;
+    }
+    Serial.printf("WiFi joined in %lu ms (%s%s)\n", (unsigned long)lastJoinMs,
+                  lastJoinFast ? "cached access point" : "scan",
+                  addressReused ? ", cached address" : ", DHCP");
+
+    joinState = JOIN_DONE;
+    saveCache();
+}
+
+bool WiFiLink::poll(unsigned long now) {
+    switch (joinState) {
+        case JOIN_IDLE:
+            return false;
+
+        case JOIN_FAST:
+            if (WiFi.status() == WL_CONNECTED) {
+                joined(now);
+                return true;
+            }
+            if (now - joinStartedAt > fastWindow) {
+                // Access point moved or changed channel; the scan result replaces the cache
+                fastMisses++;
+                Serial.println("WiFi: cached access point not found, scanning");
+                WiFi.disconnect();
+                startScan();
+            }
+            return false;
+
+        case JOIN_SCAN:
+            if (WiFi.status() == WL_CONNECTED) {
+                joined(now);
+                return true;
+            }
+            return false;
+
+        case JOIN_DONE:
+            break;
+    }
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void WiFiLink::disconnect() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    joinState = JOIN_IDLE;
+}
+
+bool WiFiLink::isConnected() const {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void WiFiLink::forgetAddress() {
+    // Associated but unreachable on the cached address: the next join asks DHCP
+    if (addressReused) cache.leasedAt = 0;
+}
+
+void WiFiLink::serialize(JsonDocument& doc) const {
+    JsonObject wifi = doc["wifi"].to<JsonObject>();
+    wifi["joinMs"] = lastJoinMs;
+    wifi["fastJoins"] = fastJoins;
+    wifi["scanJoins"] = scanJoins;
+    wifi["fastMisses"] = fastMisses;
+}
+
+void WiFiLink::printDebugInfo() const {
+    Serial.println("=== WIFI ===");
+    Serial.printf("  Last join: %lu ms (%s)\n", (unsigned long)lastJoinMs, lastJoinFast ? "cached" : "scan");
+    Serial.printf("  Cached joins: %u, avg %lu ms, %u missed\n", fastJoins,
+                  fastJoins ? (unsigned long)(fastJoinTotalMs / fastJoins) : 0UL, fastMisses);
+    Serial.printf("  Scan joins: %u, avg %lu ms\n", scanJoins,
+                  scanJoins ? (unsigned long)(scanJoinTotalMs / scanJoins) : 0UL);
+    Serial.println("============");
+}
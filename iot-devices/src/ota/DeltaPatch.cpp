@@ -0,0 +1,182 @@
+#include "ota/DeltaPatch.h"
+#include <string.h>
+
+DeltaPatch::DeltaPatch() {
+    memset(&state, 0, sizeof(state));
+    state.phase = PHASE_DONE;
+    sink = nullptr;
+    sourceSize = 0;
+}
+
+void DeltaPatch::begin(Sink& output, bool raw, uint32_t imageSize, uint32_t sourceBytes) {
+    memset(&state, 0, sizeof(state));
+    sink = &output;
+    sourceSize = sourceBytes;
+    state.raw = raw ? 1 : 0;
+    state.imageSize = imageSize;
+    if (raw) {
+        state.phase = imageSize ? PHASE_INSERTING : PHASE_DONE;
+        state.remaining = imageSize;
+    } else {
+        state.phase = PHASE_MAGIC;
+    }
+}
+
+void DeltaPatch::resume(Sink& output, const State& saved, uint32_t sourceBytes) {
+    state = saved;
+    sink = &output;
+    sourceSize = sourceBytes;
+}
+
+bool DeltaPatch::readVarint(uint8_t byte, Result& result) {
+    // True once the last byte is in; a varint over 32 bits is a format error
+    if (state.shift > 28 || (state.shift == 28 && (byte & 0x70))) {
+        result = BAD_FORMAT;
+        return false;
+    }
+    state.value |= static_cast<uint32_t>(byte & 0x7F) << state.shift;
+    state.shift += 7;
+    return (byte & 0x80) == 0;
+}
+
+DeltaPatch::Result DeltaPatch::startOp(uint8_t opcode) {
+    switch (opcode) {
+        case OP_END:
+            if (state.produced != state.imageSize) return BAD_FORMAT;
+            state.phase = PHASE_DONE;
+            return DONE;
+        case OP_COPY:
+            state.phase = PHASE_COPY_SOURCE;
+            return OK;
+        case OP_INSERT:
+            state.phase = PHASE_INSERT_LENGTH;
+            return OK;
+        default:
+            return BAD_FORMAT;
+    }
+}
+
+DeltaPatch::Result DeltaPatch::copy() {
+    uint8_t buffer[COPY_BLOCK];
+    while (state.remaining > 0) {
+        size_t room = sink->room();
+        size_t length = state.remaining < COPY_BLOCK ? state.remaining : COPY_BLOCK;
+        if (length > room) length = room;
+        if (length == 0) return WRITE_FAILED;
+        if (!sink->readSource(state.source, buffer, length)) return BAD_SOURCE;
+
+        // Advanced before the write, which may checkpoint
+        state.source += length;
+        state.remaining -= length;
+        state.produced += length;
+        if (state.remaining == 0) state.phase = PHASE_OPCODE;
+        if (!sink->write(buffer, length)) return WRITE_FAILED;
+    }
+    state.phase = PHASE_OPCODE;
+    return OK;
+}
+
+DeltaPatch::Result DeltaPatch::feed(const uint8_t* data, size_t length) {
+    if (!sink) return WRITE_FAILED;
+
+    size_t i = 0;
+    while (true) {
+        // A copy needs no input; one interrupted by a checkpoint carries on first
+        if (state.phase == PHASE_COPYING) {
+            Result result = copy();
+            if (result != OK) return result;
+            continue;
+        }
+        if (state.phase == PHASE_DONE) return i < length ? TOO_LONG : DONE;
+        if (i >= length) return OK;
+
+        if (state.phase == PHASE_INSERTING) {
+            size_t room = sink->room();
+            size_t count = length - i;
+            if (count > state.remaining) count = state.remaining;
+            if (count > room) count = room;
+            if (count == 0) return WRITE_FAILED;
+
+            state.remaining -= count;
+            state.produced += count;
+            state.consumed += count;
+            if (state.remaining == 0) state.phase = state.raw ? PHASE_DONE : PHASE_OPCODE;
+            if (!sink->write(data + i, count)) return WRITE_FAILED;
+            i += count;
+            continue;
+        }
+
+        uint8_t byte = data[i++];
+        state.consumed++;
+        Result result = OK;
+        switch (state.phase) {
+            case PHASE_MAGIC:
+                if (byte != static_cast<uint8_t>(MAGIC >> (8 * state.value))) return BAD_FORMAT;
+                if (++state.value == 4) {
+                    state.value = 0;
+                    state.phase = PHASE_IMAGE_SIZE;
+                }
+                break;
+
+            case PHASE_IMAGE_SIZE:
+                if (readVarint(byte, result)) {
+                    state.imageSize = state.value;
+                    state.value = 0;
+                    state.shift = 0;
+                    state.phase = PHASE_OPCODE;
+                }
+                break;
+
+            case PHASE_OPCODE:
+                result = startOp(byte);
+                break;
+
+            case PHASE_COPY_SOURCE:
+                if (readVarint(byte, result)) {
+                    state.source = state.value;
+                    state.value = 0;
+                    state.shift = 0;
+                    state.phase = PHASE_COPY_LENGTH;
+                }
+                break;
+
+            case PHASE_COPY_LENGTH:
+                if (readVarint(byte, result)) {
+                    state.remaining = state.value;
+                    state.value = 0;
+                    state.shift = 0;
+                    if (state.remaining > state.imageSize - state.produced) return BAD_FORMAT;
+                    if (state.source > sourceSize || state.remaining > sourceSize - state.source) return BAD_SOURCE;
+                    state.phase = state.remaining ? PHASE_COPYING : PHASE_OPCODE;
+                }
+                break;
+
+            case PHASE_INSERT_LENGTH:
+                if (readVarint(byte, result)) {
+                    state.remaining = state.value;
+                    state.value = 0;
+                    state.shift = 0;
+                    if (state.remaining > state.imageSize - state.produced) return BAD_FORMAT;
+                    state.phase = state.remaining ? PHASE_INSERTING : PHASE_OPCODE;
+                }
+                break;
+
+            default:
+                return BAD_FORMAT;
+        }
+        if (result == DONE) return i < length ? TOO_LONG : DONE;
+        if (result != OK) return result;
+    }
+}
+
+const char* DeltaPatch::resultName(Result result) {
+    switch (result) {
+        case OK:           return "ok";
+        case DONE:         return "done";
+        case BAD_FORMAT:   return "bad format";
+        case BAD_SOURCE:   return "copy outside the running image";
+        case WRITE_FAILED: return "flash write failed";
+        case TOO_LONG:     return "data past the end";
+        default:           return "unknown";
+    }
+}
@@ -0,0 +1,455 @@
+#include "ota/FirmwareUpdater.h"
+#include "network/MQTTClient.h"
+#include <Preferences.h>
+
+FirmwareUpdater::FirmwareUpdater(MQTTClient& mqtt) : mqtt(mqtt) {
+    memset(&offer, 0, sizeof(offer));
+    phase = PHASE_IDLE;
+    running = nullptr;
+    target = nullptr;
+    memset(runningSha, 0, sizeof(runningSha));
+    runningShaKnown = false;
+    currentReported = false;
+    sector = nullptr;
+    sectorFill = 0;
+    written = 0;
+    checkpointedAt = 0;
+    requestedTo = 0;
+    lastProgress = 0;
+    requestNow = false;
+    wasConnected = false;
+    idleRequests = 0;
+    sessionStart = 0;
+    elapsedBefore = 0;
+    received = 0;
+    resumes = 0;
+    retries = 0;
+    heapBefore = 0;
+    peakHeap = 0;
+    readyAt = 0;
+    readyReport = 0;
+    restartDue = false;
+}
+
+void FirmwareUpdater::begin() {
+    running = esp_ota_get_running_partition();
+    target = esp_ota_get_next_update_partition(nullptr);
+    if (!running || !target) {
+        Serial.println("OTA: no update partition - firmware updates disabled");
+        return;
+    }
+
+    Checkpoint checkpoint;
+    if (!loadCheckpoint(checkpoint)) return;
+
+    // A reset between switching the boot partition and clearing the checkpoint
+    if (memcmp(getRunningSha(), checkpoint.offer.sha256, sizeof(runningSha)) == 0) {
+        Serial.printf("OTA: firmware %s is already running\n", checkpoint.offer.version);
+        clearCheckpoint();
+        return;
+    }
+
+    offer = checkpoint.offer;
+    checkpoint.resumes++;
+    Serial.printf("OTA: resuming firmware %s at %lu of %lu bytes\n", offer.version,
+                  (unsigned long)checkpoint.decoder.consumed, (unsigned long)offer.size);
+    start(&checkpoint);
+}
+
+bool FirmwareUpdater::parseHex(const char* hex, uint8_t* out, size_t length) {
+    if (!hex || strlen(hex) != 2 * length) return false;
+    for (size_t i = 0; i < 2 * length; i++) {
+        char c = hex[i];
+        int nibble = isdigit(c) ? c - '0' : isxdigit(c) ? (tolower(c) - 'a' + 10) : -1;
+        if (nibble < 0) return false;
+        if (i % 2 == 0) out[i / 2] = nibble << 4;
+        else out[i / 2] |= nibble;
+    }
+    return true;
+}
+
+String FirmwareUpdater::toHex(const uint8_t* data, size_t length) {
+    static const char DIGITS[] = "0123456789abcdef";
+    String hex;
+    hex.reserve(2 * length);
+    for (size_t i = 0; i < length; i++) {
+        hex += DIGITS[data[i] >> 4];
+        hex += DIGITS[data[i] & 0x0F];
+    }
+    return hex;
+}
+
+const uint8_t* FirmwareUpdater::getRunningSha() {
+    // Hashing the running image reads all of it from flash, so once per boot
+    if (!runningShaKnown && running) {
+        runningShaKnown = esp_partition_get_sha256(running, runningSha) == ESP_OK;
+    }
+    return runningSha;
+}
+
+void FirmwareUpdater::handleOffer(const uint8_t* payload, size_t length) {
+    // Expected: {"version":"1.4.0","type":"delta","size":211337,"image":1048800,
+    //            "sha256":"<new image>","base":"<running image>"}, or {"cancel":true}
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length)) {
+        Serial.println("OTA: failed to parse offer JSON");
+        return;
+    }
+    if (!running || !target) return;
+
+    if (doc["cancel"] | false) {
+        if (phase == PHASE_IDLE || phase == PHASE_READY) return;
+        Serial.printf("OTA: update to %s cancelled\n", offer.version);
+        release();
+        clearCheckpoint();
+        phase = PHASE_IDLE;
+        lastError = "";
+        report("cancelled");
+        return;
+    }
+
+    Offer incoming;
+    memset(&incoming, 0, sizeof(incoming));
+    const char* type = doc["type"] | "full";
+    incoming.delta = strcmp(type, "delta") == 0;
+    incoming.size = doc["size"] | 0u;
+    incoming.imageSize = doc["image"] | incoming.size;
+    strncpy(incoming.version, doc["version"] | "?", sizeof(incoming.version) - 1);
+    bool valid = parseHex(doc["sha256"] | "", incoming.sha256, sizeof(incoming.sha256)) &&
+                 incoming.size > 0 && incoming.imageSize > 0 &&
+                 (incoming.delta ? parseHex(doc["base"] | "", incoming.base, sizeof(incoming.base))
+                                 : incoming.size == incoming.imageSize);
+    if (!valid) {
+        Serial.println("OTA: offer needs sha256 and size, and base for a delta");
+        return;
+    }
+
+    bool sameImage = memcmp(incoming.sha256, offer.sha256, sizeof(offer.sha256)) == 0;
+    if (sameImage && (phase == PHASE_DOWNLOADING || phase == PHASE_READY)) return;     // Redelivered
+
+    // The offer is retained, so it comes back on every connect after the update too
+    if (memcmp(getRunningSha(), incoming.sha256, sizeof(runningSha)) == 0) {
+        // Offering the running image again withdraws an update not restarted into yet
+        if (phase == PHASE_READY) esp_ota_set_boot_partition(running);
+        if (phase != PHASE_IDLE) {
+            Serial.printf("OTA: update to %s withdrawn\n", offer.version);
+            release();
+            clearCheckpoint();
+            phase = PHASE_IDLE;
+            restartDue = false;
+            currentReported = false;
+        }
+        if (!currentReported) {
+            Serial.printf("OTA: firmware %s is running\n", incoming.version);
+            offer = incoming;
+            currentReported = report("current") != 0;
+        }
+        return;
+    }
+    if (phase == PHASE_DOWNLOADING) {
+        Serial.printf("OTA: offer for %s replaces the update to %s\n", incoming.version, offer.version);
+        release();
+    }
+
+    // The same image again picks up where the checkpoint left off
+    Checkpoint checkpoint;
+    if (loadCheckpoint(checkpoint) && memcmp(checkpoint.offer.sha256, incoming.sha256, sizeof(incoming.sha256)) == 0 &&
+        checkpoint.offer.delta == incoming.delta && checkpoint.offer.size == incoming.size) {
+        offer = checkpoint.offer;
+        checkpoint.resumes++;
+        Serial.printf("OTA: resuming firmware %s at %lu of %lu bytes\n", offer.version,
+                      (unsigned long)checkpoint.decoder.consumed, (unsigned long)offer.size);
+        start(&checkpoint);
+        return;
+    }
+
+    offer = incoming;
+    Serial.printf("OTA: firmware %s offered, %s of %lu bytes for a %lu byte image\n", offer.version,
+                  offer.delta ? "delta" : "full image", (unsigned long)offer.size, (unsigned long)offer.imageSize);
+    start(nullptr);
+}
+
+void FirmwareUpdater::start(const Checkpoint* resumeFrom) {
+    lastError = "";
+    restartDue = false;
+    if (offer.imageSize > target->size) {
+        fail("image larger than the update partition");
+        return;
+    }
+    // Copies read the running image, so it must be the one the delta was made against
+    if (offer.delta && memcmp(getRunningSha(), offer.base, sizeof(runningSha)) != 0) {
+        fail("running image is not the delta's base");
+        return;
+    }
+
+    heapBefore = ESP.getFreeHeap();
+    sector = static_cast<uint8_t*>(malloc(SECTOR_SIZE));
+    if (!sector) {
+        fail("no memory for the sector buffer");
+        return;
+    }
+    sectorFill = 0;
+
+    if (resumeFrom) {
+        decoder.resume(*this, resumeFrom->decoder, running->size);
+        written = resumeFrom->written;
+        elapsedBefore = resumeFrom->elapsed;
+        received = resumeFrom->received;
+        resumes = resumeFrom->resumes;
+        retries = resumeFrom->retries;
+        peakHeap = resumeFrom->peakHeap;
+    } else {
+        decoder.begin(*this, !offer.delta, offer.imageSize, running->size);
+        written = 0;
+        elapsedBefore = 0;
+        received = 0;
+        resumes = 0;
+        retries = 0;
+        peakHeap = 0;
+    }
+    phase = PHASE_DOWNLOADING;
+    sessionStart = millis();
+    // Saved at once: a resumed count survives another reset, a new offer replaces an old checkpoint
+    saveCheckpoint();
+    trackHeap();
+
+    requestedTo = decoder.getState().consumed;
+    requestNow = true;
+    idleRequests = 0;
+    report(resumeFrom ? "resumed" : "downloading");
+}
+
+void FirmwareUpdater::handleChunk(const uint8_t* payload, size_t length) {
+    // 4-byte big-endian input offset, then the data
+    if (phase != PHASE_DOWNLOADING || length <= 4) return;
+    uint32_t offset = (static_cast<uint32_t>(payload[0]) << 24) | (static_cast<uint32_t>(payload[1]) << 16) |
+                      (static_cast<uint32_t>(payload[2]) << 8) | payload[3];
+    const uint8_t* data = payload + 4;
+    size_t count = length - 4;
+    received += count;
+
+    // Only the next bytes in order are taken; a gap is filled by the re-request on timeout
+    uint32_t consumed = decoder.getState().consumed;
+    if (offset > consumed || offset + count <= consumed) return;
+    size_t skip = consumed - offset;
+
+    DeltaPatch::Result result = decoder.feed(data + skip, count - skip);
+    lastProgress = millis();
+    idleRequests = 0;
+    trackHeap();
+    if (result == DeltaPatch::DONE) {
+        finish();
+    } else if (result != DeltaPatch::OK) {
+        fail(String("patch: ") + DeltaPatch::resultName(result));
+    }
+}
+
+size_t FirmwareUpdater::room() {
+    return SECTOR_SIZE - sectorFill;
+}
+
+bool FirmwareUpdater::write(const uint8_t* data, size_t length) {
+    if (!sector || length > SECTOR_SIZE - sectorFill) return false;
+    memcpy(sector + sectorFill, data, length);
+    sectorFill += length;
+    return sectorFill < SECTOR_SIZE || flushSector();
+}
+
+bool FirmwareUpdater::readSource(uint32_t offset, uint8_t* buffer, size_t length) {
+    return esp_partition_read(running, offset, buffer, length) == ESP_OK;
+}
+
+bool FirmwareUpdater::flushSector() {
+    // written stays sector aligned until the last, partial sector
+    if (esp_partition_erase_range(target, written, SECTOR_SIZE) != ESP_OK ||
+        esp_partition_write(target, written, sector, sectorFill) != ESP_OK) {
+        return false;
+    }
+    written += sectorFill;
+    sectorFill = 0;
+    if (written - checkpointedAt >= Ota::CHECKPOINT_BYTES) saveCheckpoint();
+    return true;
+}
+
+void FirmwareUpdater::finish() {
+    if (sectorFill && !flushSector()) {
+        fail(DeltaPatch::resultName(DeltaPatch::WRITE_FAILED));
+        return;
+    }
+    trackHeap();
+
+    uint8_t sha[32];
+    if (esp_partition_get_sha256(target, sha) != ESP_OK || memcmp(sha, offer.sha256, sizeof(sha)) != 0) {
+        fail("SHA-256 of the new image does not match the offer");
+        return;
+    }
+    esp_err_t err = esp_ota_set_boot_partition(target);
+    if (err != ESP_OK) {
+        fail(String("not a bootable image (") + esp_err_to_name(err) + ")");
+        return;
+    }
+
+    elapsedBefore = getElapsed();
+    release();
+    clearCheckpoint();
+    phase = PHASE_READY;
+    readyAt = millis();
+    Serial.printf("OTA: firmware %s verified, %lu bytes in %lu ms (%u resumes, %u retries, %lu bytes of heap)\n",
+                  offer.version, (unsigned long)offer.size, (unsigned long)elapsedBefore, resumes, retries,
+                  (unsigned long)peakHeap);
+    readyReport = report("ready");
+}
+
+void FirmwareUpdater::fail(const String& reason) {
+    Serial.printf("OTA: update to %s failed - %s\n", offer.version, reason.c_str());
+    if (phase == PHASE_DOWNLOADING) elapsedBefore = getElapsed();
+    release();
+    clearCheckpoint();
+    phase = PHASE_IDLE;
+    lastError = reason;
+    report("failed");
+}
+
+void FirmwareUpdater::suspend() {
+    // The flash up to the checkpoint is kept; the retained offer resumes it on a later connect
+    Serial.printf("OTA: no data for %u requests - update to %s suspended\n", idleRequests, offer.version);
+    elapsedBefore = getElapsed();
+    release();
+    phase = PHASE_SUSPENDED;
+    report("suspended");
+}
+
+void FirmwareUpdater::release() {
+    free(sector);
+    sector = nullptr;
+    sectorFill = 0;
+}
+
+void FirmwareUpdater::request(uint32_t from, unsigned long now) {
+    uint32_t length = offer.size - from < Ota::WINDOW ? offer.size - from : Ota::WINDOW;
+    if (!mqtt.publishOtaRequest(from, length)) return;
+    requestedTo = from + length;
+    lastProgress = now;
+    requestNow = false;
+}
+
+void FirmwareUpdater::loop(unsigned long now) {
+    if (phase == PHASE_READY) {
+        // Restart once the report is out, or without it after a while
+        restartDue = !mqtt.isPending(readyReport) || now - readyAt >= Ota::RESTART_DELAY;
+        return;
+    }
+    if (phase != PHASE_DOWNLOADING) return;
+
+    // Chunks in flight when the link dropped are gone; ask again from the last byte taken
+    bool connected = mqtt.isConnected();
+    if (connected && !wasConnected) requestNow = true;
+    wasConnected = connected;
+    if (!connected) return;
+
+    uint32_t consumed = decoder.getState().consumed;
+    if (requestNow || consumed >= requestedTo) {
+        request(consumed, now);
+    } else if (now - lastProgress >= Ota::CHUNK_TIMEOUT) {
+        retries++;
+        if (++idleRequests > Ota::MAX_IDLE_REQUESTS) {
+            suspend();
+            return;
+        }
+        Serial.printf("OTA: no data for %lu ms, asking again from %lu\n", now - lastProgress, (unsigned long)consumed);
+        request(consumed, now);
+    } else if (requestedTo < offer.size && requestedTo - consumed <= Ota::WINDOW / 2) {
+        // The next window goes out while half of this one is still coming, so the link never idles
+        request(requestedTo, now);
+    }
+}
+
+void FirmwareUpdater::saveCheckpoint() {
+    // Only called with the sector buffer empty, so the decoder state matches the flash
+    Checkpoint checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.magic = MAGIC;
+    checkpoint.storageVersion = STORAGE_VERSION;
+    checkpoint.offer = offer;
+    checkpoint.decoder = decoder.getState();
+    checkpoint.written = written;
+    checkpoint.elapsed = getElapsed();
+    checkpoint.received = received;
+    checkpoint.resumes = resumes;
+    checkpoint.retries = retries;
+    checkpoint.peakHeap = peakHeap;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) return;
+    if (prefs.putBytes(NVS_KEY, &checkpoint, sizeof(checkpoint)) == sizeof(checkpoint)) {
+        checkpointedAt = written;
+    } else {
+        Serial.println("OTA: failed to save checkpoint");
+    }
+    prefs.end();
+}
+
+bool FirmwareUpdater::loadCheckpoint(Checkpoint& checkpoint) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+    size_t length = prefs.getBytesLength(NVS_KEY) == sizeof(checkpoint)
+                        ? prefs.getBytes(NVS_KEY, &checkpoint, sizeof(checkpoint))
+                        : 0;
+    prefs.end();
+    return length == sizeof(checkpoint) && checkpoint.magic == MAGIC &&
+           checkpoint.storageVersion == STORAGE_VERSION && checkpoint.written <= checkpoint.offer.imageSize;
+}
+
+void FirmwareUpdater::clearCheckpoint() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) return;
+    prefs.remove(NVS_KEY);
+    prefs.end();
+    checkpointedAt = 0;
+}
+
+void FirmwareUpdater::trackHeap() {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (heapBefore > freeHeap && heapBefore - freeHeap > peakHeap) peakHeap = heapBefore - freeHeap;
+}
+
+uint32_t FirmwareUpdater::getElapsed() const {
+    return phase == PHASE_DOWNLOADING ? elapsedBefore + (millis() - sessionStart) : elapsedBefore;
+}
+
+OutboundQueue::MessageId FirmwareUpdater::report(const char* state) {
+    JsonDocument doc;
+    doc["state"] = state;
+    doc["version"] = offer.version;
+    doc["type"] = offer.delta ? "delta" : "full";
+    doc["offset"] = decoder.getState().consumed;
+    doc["size"] = offer.size;
+    doc["image"] = offer.imageSize;
+    doc["ms"] = getElapsed();
+    doc["received"] = received;
+    doc["resumes"] = resumes;
+    doc["retries"] = retries;
+    doc["peakHeap"] = peakHeap;
+    if (lastError.length()) doc["error"] = lastError;
+    if (strcmp(state, "current") == 0) doc["sha256"] = toHex(runningSha, sizeof(runningSha));
+    return mqtt.publishOtaStatus(doc);
+}
+
+void FirmwareUpdater::serialize(JsonDocument& doc) const {
+    if (phase == PHASE_IDLE && lastError.length() == 0) return;
+    JsonObject ota = doc["ota"].to<JsonObject>();
+    ota["state"] = lastError.length() && phase == PHASE_IDLE ? "failed" : phaseName(phase);
+    ota["version"] = offer.version;
+    ota["progress"] = offer.size ? static_cast<uint8_t>(100ULL * decoder.getState().consumed / offer.size) : 0;
+    if (lastError.length()) ota["error"] = lastError;
+}
+
+const char* FirmwareUpdater::phaseName(Phase phase) {
+    switch (phase) {
+        case PHASE_IDLE:        return "idle";
+        case PHASE_DOWNLOADING: return "downloading";
+        case PHASE_SUSPENDED:   return "suspended";
+        case PHASE_READY:       return "ready";
+        default:                return "unknown";
+    }
+}
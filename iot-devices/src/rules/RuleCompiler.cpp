@@ -0,0 +1,215 @@
+#include "rules/RuleCompiler.h"
+#include "utils/SensorCalibration.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+using namespace RuleOps;
+
+RuleCompiler::RuleCompiler(RuleProgram& program, const char* const* variables, uint8_t variableCount,
+                           uint8_t firstZoneVariable)
+    : program(program), variables(variables), variableCount(variableCount), firstZoneVariable(firstZoneVariable) {
+    source = nullptr;
+    pos = nullptr;
+    stackDepth = 0;
+    nesting = 0;
+    usesZoneVariables = false;
+}
+
+bool RuleCompiler::addRule(const char* name, const char* condition, RuleProgram::Action action, uint8_t zone) {
+    source = nullptr;
+    error = "";
+    if (program.ruleCount >= RuleProgram::MAX_RULES) return fail("too many rules");
+    if (zone > Zones::COUNT) return fail("no such zone");
+    if (strlen(condition) > MAX_CONDITION_LENGTH) return fail("condition too long");
+
+    // Compiled straight into the program; rolled back if the rule doesn't compile
+    uint8_t codeStart = program.codeLength;
+    uint8_t constantCount = program.constantCount;
+
+    source = condition;
+    pos = condition;
+    stackDepth = 0;
+    nesting = 0;
+    usesZoneVariables = false;
+
+    bool ok = parseOr();
+    skipSpace();
+    if (ok && *pos != '\0') ok = fail("unexpected input");
+    if (!ok) {
+        program.codeLength = codeStart;
+        program.constantCount = constantCount;
+        return false;
+    }
+
+    RuleProgram::Rule& rule = program.rules[program.ruleCount++];
+    memset(&rule, 0, sizeof(rule));
+    strncpy(rule.name, name, RuleProgram::NAME_LENGTH - 1);
+    rule.zone = zone;
+    rule.action = action;
+    rule.codeStart = codeStart;
+    rule.codeLength = program.codeLength - codeStart;
+    rule.usesZoneVariables = usesZoneVariables;
+    return true;
+}
+
+void RuleCompiler::skipSpace() {
+    while (*pos == ' ' || *pos == '\t') pos++;
+}
+
+bool RuleCompiler::accept(const char* token) {
+    skipSpace();
+    size_t length = strlen(token);
+    if (strncmp(pos, token, length) != 0) return false;
+    // "<" must not match the start of "<="
+    if (length == 1 && (token[0] == '<' || token[0] == '>' || token[0] == '!') && pos[1] == '=') return false;
+    pos += length;
+    return true;
+}
+
+bool RuleCompiler::fail(const char* message) {
+    if (error.length() == 0) {
+        error = String(message);
+        if (source) error += " at column " + String(static_cast<int>(pos - source) + 1);
+    }
+    return false;
+}
+
+bool RuleCompiler::emit(uint8_t op) {
+    if (program.codeLength >= RuleProgram::MAX_CODE) return fail("rules too long");
+    program.code[program.codeLength++] = op;
+
+    // Unary ops leave the depth alone, binary ops pop one
+    if (op != OP_NOT && op != OP_NEG) stackDepth--;
+    return true;
+}
+
+bool RuleCompiler::emit(uint8_t op, uint8_t operand) {
+    if (program.codeLength + 2 > RuleProgram::MAX_CODE) return fail("rules too long");
+    if (stackDepth >= RuleProgram::MAX_STACK) return fail("expression too deep");
+    program.code[program.codeLength++] = op;
+    program.code[program.codeLength++] = operand;
+    stackDepth++;
+    return true;
+}
+
+bool RuleCompiler::emitConstant(float value) {
+    // Constants are shared between rules
+    for (uint8_t i = 0; i < program.constantCount; i++) {
+        if (program.constants[i] == value) return emit(OP_CONST, i);
+    }
+    if (program.constantCount >= RuleProgram::MAX_CONSTANTS) return fail("too many constants");
+    program.constants[program.constantCount] = value;
+    return emit(OP_CONST, program.constantCount++);
+}
+
+bool RuleCompiler::emitName(const char* name, size_t length) {
+    for (uint8_t i = 0; i < variableCount; i++) {
+        if (strlen(variables[i]) == length && strncmp(variables[i], name, length) == 0) {
+            if (i >= firstZoneVariable) usesZoneVariables = true;
+            return emit(OP_LOAD, i);
+        }
+    }
+
+    if (length == 4 && strncmp(name, "true", 4) == 0) return emitConstant(1.0f);
+    if (length == 5 && strncmp(name, "false", 5) == 0) return emitConstant(0.0f);
+    for (uint8_t level = WaterLevelCalibration::LEVEL_LOW; level <= WaterLevelCalibration::LEVEL_HIGH; level++) {
+        const char* levelName = WaterLevelCalibration::levelName(static_cast<WaterLevelCalibration::Level>(level));
+        if (strlen(levelName) == length && strncmp(levelName, name, length) == 0) return emitConstant(level);
+    }
+    pos = name;
+    return fail("unknown name");
+}
+
+bool RuleCompiler::parseOr() {
+    if (!parseAnd()) return false;
+    while (accept("||")) {
+        if (!parseAnd() || !emit(OP_OR)) return false;
+    }
+    return true;
+}
+
+bool RuleCompiler::parseAnd() {
+    if (!parseNot()) return false;
+    while (accept("&&")) {
+        if (!parseNot() || !emit(OP_AND)) return false;
+    }
+    return true;
+}
+
+bool RuleCompiler::parseNot() {
+    if (accept("!")) {
+        return parseNot() && emit(OP_NOT);
+    }
+    return parseComparison();
+}
+
+bool RuleCompiler::parseComparison() {
+    if (!parseSum()) return false;
+
+    static const struct { const char* token; uint8_t op; } COMPARISONS[] = {
+        {"<=", OP_LE}, {">=", OP_GE}, {"==", OP_EQ}, {"!=", OP_NE}, {"<", OP_LT}, {">", OP_GT}
+    };
+    for (const auto& comparison : COMPARISONS) {
+        if (accept(comparison.token)) {
+            return parseSum() && emit(comparison.op);
+        }
+    }
+    return true;
+}
+
+bool RuleCompiler::parseSum() {
+    if (!parseTerm()) return false;
+    while (true) {
+        if (accept("+")) {
+            if (!parseTerm() || !emit(OP_ADD)) return false;
+        } else if (accept("-")) {
+            if (!parseTerm() || !emit(OP_SUB)) return false;
+        } else {
+            return true;
+        }
+    }
+}
+
+bool RuleCompiler::parseTerm() {
+    if (!parseUnary()) return false;
+    while (true) {
+        if (accept("*")) {
+            if (!parseUnary() || !emit(OP_MUL)) return false;
+        } else if (accept("/")) {
+            if (!parseUnary() || !emit(OP_DIV)) return false;
+        } else {
+            return true;
+        }
+    }
+}
+
+bool RuleCompiler::parseUnary() {
+    if (accept("-")) {
+        return parseUnary() && emit(OP_NEG);
+    }
+
+    if (accept("(")) {
+        if (++nesting > MAX_NESTING) return fail("too many parentheses");
+        if (!parseOr()) return false;
+        if (!accept(")")) return fail("expected ')'");
+        nesting--;
+        return true;
+    }
+
+    skipSpace();
+    if (isdigit(static_cast<unsigned char>(*pos)) || *pos == '.') {
+        char* end;
+        float value = strtof(pos, &end);
+        if (end == pos) return fail("bad number");
+        pos = end;
+        return emitConstant(value);
+    }
+
+    if (isalpha(static_cast<unsigned char>(*pos)) || *pos == '_') {
+        const char* start = pos;
+        while (isalnum(static_cast<unsigned char>(*pos)) || *pos == '_') pos++;
+        return emitName(start, pos - start);
+    }
+
+    return fail(*pos ? "expected a value" : "unexpected end");
+}
@@ -0,0 +1,246 @@
+#include "rules/RuleEngine.h"
+#include "rules/RuleCompiler.h"
+#include "utils/Fnv1a.h"
+#include <Preferences.h>
+
+using namespace RuleOps;
+
+const char* const RuleEngine::ZONE_VARIABLES[ZONE_VARIABLE_COUNT] = {"moisture", "valve", "manual", "trend", "eta"};
+
+RuleEngine::RuleEngine() {
+    program.clear();
+    programValid = false;
+    variableCount = 0;
+    firstZoneVariable = 0;
+    layoutHash = 0;
+    opsPerPass = 0;
+    activeMask = 0;
+    rejectedUpdates = 0;
+}
+
+void RuleEngine::begin(const char* const* globals, uint8_t count) {
+    variableCount = 0;
+    for (uint8_t i = 0; i < count && variableCount < MAX_VARIABLES - ZONE_VARIABLE_COUNT; i++) {
+        variables[variableCount++] = globals[i];
+    }
+    firstZoneVariable = variableCount;
+    for (const char* name : ZONE_VARIABLES) {
+        variables[variableCount++] = name;
+    }
+
+    // Reordered or renamed snapshot fields invalidate stored code
+    layoutHash = Fnv1a::hashNames(variables, variableCount);
+
+    programValid = loadProgram();
+    computeCost();
+    Serial.printf("Rule engine: %u variable(s), %u rule(s) loaded, %u ops per pass at most\n",
+                  variableCount, getRuleCount(), opsPerPass);
+}
+
+bool RuleEngine::loadProgram() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    size_t length = prefs.isKey(NVS_KEY) ? prefs.getBytes(NVS_KEY, &program, sizeof(program)) : 0;
+    prefs.end();
+
+    if (length != sizeof(program) || program.layoutHash != layoutHash || !program.verify(variableCount)) {
+        if (length) Serial.println("Stored rules don't match this firmware, ignored");
+        program.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RuleEngine::saveProgram() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open NVS rules namespace");
+        return false;
+    }
+
+    bool success = prefs.putBytes(NVS_KEY, &program, sizeof(program)) == sizeof(program);
+    prefs.end();
+    return success;
+}
+
+bool RuleEngine::update(const String& json) {
+    JsonDocument doc;
+    if (deserializeJson(doc, json)) {
+        Serial.println("Failed to parse rules JSON");
+        rejectedUpdates++;
+        return false;
+    }
+
+    RuleProgram compiled;
+    compiled.clear();
+    compiled.layoutHash = layoutHash;
+    RuleCompiler compiler(compiled, variables, variableCount, firstZoneVariable);
+
+    if (!doc["rules"].is<JsonArray>()) {
+        Serial.println("Rules update without a 'rules' array ignored");
+        rejectedUpdates++;
+        return false;
+    }
+
+    JsonArray rules = doc["rules"];
+    uint8_t index = 0;
+    for (JsonObject rule : rules) {
+        index++;
+        char fallbackName[RuleProgram::NAME_LENGTH];
+        snprintf(fallbackName, sizeof(fallbackName), "rule%u", index);
+
+        const char* name = rule["name"] | fallbackName;
+        const char* condition = rule["when"] | "";
+        const char* action = rule["do"] | "";
+        int zone = rule["zone"] | 0;
+        if (zone < 0 || zone > Zones::COUNT) {
+            Serial.printf("Rule %u: no zone %d, rules unchanged\n", index, zone);
+            rejectedUpdates++;
+            return false;
+        }
+
+        bool ok;
+        if (strcmp(action, "inhibit") == 0) {
+            ok = compiler.addRule(name, condition, RuleProgram::ACTION_INHIBIT, zone);
+        } else if (strcmp(action, "water") == 0) {
+            ok = compiler.addRule(name, condition, RuleProgram::ACTION_WATER, zone);
+        } else {
+            Serial.printf("Rule %u: unknown action '%s', rules unchanged\n", index, action);
+            rejectedUpdates++;
+            return false;
+        }
+
+        if (!ok) {
+            Serial.printf("Rule %u '%s': %s, rules unchanged\n", index, condition, compiler.getError().c_str());
+            rejectedUpdates++;
+            return false;
+        }
+    }
+
+    program = compiled;
+    programValid = true;
+    computeCost();
+    if (!saveProgram()) {
+        Serial.println("Rules applied but not saved - they will be lost on reboot");
+    }
+
+    Serial.printf("Rules updated: %u rule(s), %u bytes of code, %u ops per pass at most\n",
+                  program.ruleCount, program.codeLength, opsPerPass);
+    return true;
+}
+
+void RuleEngine::computeCost() {
+    opsPerPass = 0;
+    if (!programValid) return;
+    for (uint8_t r = 0; r < program.ruleCount; r++) {
+        const RuleProgram::Rule& rule = program.rules[r];
+        uint8_t runs = (rule.usesZoneVariables && rule.zone == 0) ? Zones::COUNT : 1;
+        opsPerPass += rule.codeLength * runs;
+    }
+}
+
+bool RuleEngine::run(const RuleProgram::Rule& rule, const float* values) const {
+    // verify() has checked operands and stack depth, so nothing is checked here
+    float stack[RuleProgram::MAX_STACK];
+    uint8_t sp = 0;
+    const uint8_t* pc = program.code + rule.codeStart;
+    const uint8_t* end = pc + rule.codeLength;
+
+    while (pc < end) {
+        switch (*pc++) {
+            case OP_CONST: stack[sp++] = program.constants[*pc++]; break;
+            case OP_LOAD:  stack[sp++] = values[*pc++]; break;
+            case OP_NOT:   stack[sp - 1] = stack[sp - 1] == 0.0f; break;
+            case OP_NEG:   stack[sp - 1] = -stack[sp - 1]; break;
+            case OP_AND:   sp--; stack[sp - 1] = stack[sp - 1] != 0.0f && stack[sp] != 0.0f; break;
+            case OP_OR:    sp--; stack[sp - 1] = stack[sp - 1] != 0.0f || stack[sp] != 0.0f; break;
+            case OP_ADD:   sp--; stack[sp - 1] += stack[sp]; break;
+            case OP_SUB:   sp--; stack[sp - 1] -= stack[sp]; break;
+            case OP_MUL:   sp--; stack[sp - 1] *= stack[sp]; break;
+            case OP_DIV:   sp--; stack[sp - 1] /= stack[sp]; break;
+            case OP_LT:    sp--; stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+            case OP_LE:    sp--; stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+            case OP_GT:    sp--; stack[sp - 1] = stack[sp - 1] > stack[sp]; break;
+            case OP_GE:    sp--; stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+            case OP_EQ:    sp--; stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+            case OP_NE:    sp--; stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+        }
+    }
+    return stack[0] != 0.0f;
+}
+
+void RuleEngine::evaluate(float* values, const ZoneInputs* zones, uint8_t zoneCount, Decision& decision) {
+    decision.inhibitMask = 0;
+    decision.demandMask = 0;
+    activeMask = 0;
+    if (!programValid) return;
+
+    uint16_t allZones = static_cast<uint16_t>((1u << zoneCount) - 1);
+    for (uint8_t r = 0; r < program.ruleCount; r++) {
+        const RuleProgram::Rule& rule = program.rules[r];
+        uint16_t targets = rule.zone ? static_cast<uint16_t>(1u << (rule.zone - 1)) : allZones;
+        uint16_t held = 0;
+
+        if (!rule.usesZoneVariables) {
+            if (run(rule, values)) held = targets;
+        } else {
+            for (uint8_t zone = 0; zone < zoneCount; zone++) {
+                if (!((targets >> zone) & 1)) continue;
+                values[firstZoneVariable] = zones[zone].moisture;
+                values[firstZoneVariable + 1] = zones[zone].valve;
+                values[firstZoneVariable + 2] = zones[zone].manual;
+                values[firstZoneVariable + 3] = zones[zone].trend;
+                values[firstZoneVariable + 4] = zones[zone].eta;
+                if (run(rule, values)) held |= (1u << zone);
+            }
+        }
+        if (!held) continue;
+        activeMask |= (1u << r);
+
+        // Inhibit wins over water, so an inhibiting rule always names itself
+        for (uint8_t zone = 0; zone < zoneCount; zone++) {
+            uint16_t bit = 1u << zone;
+            if (!(held & bit) || (decision.inhibitMask & bit)) continue;
+            if (rule.action == RuleProgram::ACTION_INHIBIT) {
+                decision.inhibitMask |= bit;
+                decision.demandMask &= ~bit;
+                decision.rule[zone] = rule.name;
+            } else if (!(decision.demandMask & bit)) {
+                decision.demandMask |= bit;
+                decision.rule[zone] = rule.name;
+            }
+        }
+    }
+}
+
+void RuleEngine::serialize(JsonDocument& doc) const {
+    JsonObject rules = doc["rules"].to<JsonObject>();
+    rules["count"] = getRuleCount();
+    rules["active"] = activeMask;
+    rules["opsPerPass"] = opsPerPass;
+    rules["rejected"] = rejectedUpdates;
+}
+
+void RuleEngine::printDebugInfo() const {
+    Serial.println("=== RULES ===");
+    if (!programValid || program.ruleCount == 0) {
+        Serial.println("  No rules loaded");
+    }
+    for (uint8_t r = 0; programValid && r < program.ruleCount; r++) {
+        const RuleProgram::Rule& rule = program.rules[r];
+        char zone[8];
+        if (rule.zone) {
+            snprintf(zone, sizeof(zone), "%u", rule.zone);
+        } else {
+            strcpy(zone, "all");
+        }
+        Serial.printf("  %-11s %-7s zone %-3s %u bytes%s\n", rule.name,
+                      rule.action == RuleProgram::ACTION_INHIBIT ? "inhibit" : "water", zone,
+                      rule.codeLength, (activeMask >> r) & 1 ? " [ACTIVE]" : "");
+    }
+    Serial.printf("  %u ops per pass at most, %lu update(s) rejected\n", opsPerPass, (unsigned long)rejectedUpdates);
+    Serial.println("=============");
+}
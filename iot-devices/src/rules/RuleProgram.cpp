@@ -0,0 +1,44 @@
+#include "rules/RuleProgram.h"
+#include "utils/SensorCalibration.h"
+
+using namespace RuleOps;
+
+void RuleProgram::clear() {
+    memset(this, 0, sizeof(*this));
+    magic = MAGIC;
+    version = STORAGE_VERSION;
+}
+
+bool RuleProgram::verify(uint8_t variableCount) const {
+    if (magic != MAGIC || version != STORAGE_VERSION) return false;
+    if (ruleCount > MAX_RULES || constantCount > MAX_CONSTANTS || codeLength > MAX_CODE) return false;
+
+    for (uint8_t r = 0; r < ruleCount; r++) {
+        const Rule& rule = rules[r];
+        if (rule.action > ACTION_WATER || rule.zone > Zones::COUNT) return false;
+        if (rule.codeLength == 0 || rule.codeStart + rule.codeLength > codeLength) return false;
+
+        // Walk the code once with a symbolic stack: every op must have its operands
+        // and the rule must leave exactly one value
+        uint8_t depth = 0;
+        uint8_t end = rule.codeStart + rule.codeLength;
+        for (uint8_t pc = rule.codeStart; pc < end; pc++) {
+            uint8_t op = code[pc];
+            if (op == OP_CONST || op == OP_LOAD) {
+                if (pc + 1 >= end) return false;
+                uint8_t operand = code[++pc];
+                if (operand >= (op == OP_CONST ? constantCount : variableCount)) return false;
+                if (++depth > MAX_STACK) return false;
+            } else if (op == OP_NOT || op == OP_NEG) {
+                if (depth < 1) return false;
+            } else if (op < OP_COUNT) {
+                if (depth < 2) return false;
+                depth--;
+            } else {
+                return false;
+            }
+        }
+        if (depth != 1) return false;
+    }
+    return true;
+}
@@ -40,6 +40,10 @@ bool DHT11Sensor::isDataValid() const {
     return dataValid;
 }
 
+DHT11Sensor::Reading DHT11Sensor::getReading() const {
+    return {temperature, humidity};
+}
+
 void DHT11Sensor::printDebugInfo() const {
     if (dataValid) {
         Serial.printf("DHT11 - Temperature: %.2f°C, Humidity: %.2f%%\n", temperature, humidity);
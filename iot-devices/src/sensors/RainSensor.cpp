@@ -24,6 +24,10 @@ bool RainSensor::isRainDetected() const {
     return rainDetected;
 }
 
+RainSensor::Reading RainSensor::getReading() const {
+    return {rainDetected};
+}
+
 void RainSensor::printDebugInfo() const {
     int digitalValue = digitalRead(pin);
     Serial.printf("DEBUG: Rain sensor GPIO%d = %d (Rain: %s)\n", 
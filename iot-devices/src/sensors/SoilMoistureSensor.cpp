@@ -6,6 +6,10 @@ SoilMoistureSensor::SoilMoistureSensor(int analogPin) : pin(analogPin) {
     percentage = 0;
 }
 
+void SoilMoistureSensor::begin() {
+    Serial.printf("Soil moisture sensor initialized on GPIO%d\n", pin);
+}
+
 bool SoilMoistureSensor::readData() {
     rawValue = analogRead(pin);
     percentage = convertToPercentage(rawValue);
@@ -20,6 +24,10 @@ int SoilMoistureSensor::getPercentage() const {
     return percentage;
 }
 
+SoilMoistureSensor::Reading SoilMoistureSensor::getReading() const {
+    return {percentage};
+}
+
 int SoilMoistureSensor::convertToPercentage(int rawValue) {
     return SoilMoistureCalibration::convertToPercentage(rawValue);
 }
@@ -55,12 +55,23 @@ bool SoilTemperatureSensor::isDataValid() const {
     return dataValid;
 }
 
+SoilTemperatureSensor::Reading SoilTemperatureSensor::getReading() const {
+    return {temperature};
+}
+
 bool SoilTemperatureSensor::validateReading(float temp) {
     if (temp == DEVICE_DISCONNECTED_C) {
         Serial.println("DS18B20 sensor disconnected");
         return false;
     }
     
+    // Power-on value of the scratchpad: the conversion never ran (brown-out
+    // or a parasite-power probe losing its supply). Soil never gets this hot.
+    if (temp == 85.0f) {
+        Serial.println("DS18B20 returned its power-on value");
+        return false;
+    }
+    
     if (temp < MIN_SOIL_TEMP || temp > MAX_SOIL_TEMP) {
         Serial.printf("Unusual soil temperature: %.2f°C\n", temp);
     }
@@ -3,12 +3,18 @@
 
 WaterLevelSensor::WaterLevelSensor(int analogPin) : pin(analogPin) {
     rawValue = 0;
-    status = "Low";
+    levelPercent = 0;
+    level = WaterLevelCalibration::LEVEL_LOW;
+}
+
+void WaterLevelSensor::begin() {
+    Serial.printf("Water level sensor initialized on GPIO%d\n", pin);
 }
 
 bool WaterLevelSensor::readData() {
     rawValue = analogRead(pin);
-    status = determineStatus(rawValue);
+    levelPercent = WaterLevelCalibration::convertToPercentage(rawValue);
+    level = WaterLevelCalibration::determineLevel(rawValue);
     return isValidReading();
 }
 
@@ -16,8 +22,20 @@ int WaterLevelSensor::getRawValue() const {
     return rawValue;
 }
 
+int WaterLevelSensor::getLevelPercent() const {
+    return levelPercent;
+}
+
 String WaterLevelSensor::getStatus() const {
-    return status;
+    return WaterLevelCalibration::levelName(level);
+}
+
+WaterLevelCalibration::Level WaterLevelSensor::getLevel() const {
+    return level;
+}
+
+WaterLevelSensor::Reading WaterLevelSensor::getReading() const {
+    return {level};
 }
 
 String WaterLevelSensor::determineStatus(int rawValue) {
@@ -25,9 +43,10 @@ String WaterLevelSensor::determineStatus(int rawValue) {
 }
 
 void WaterLevelSensor::printDebugInfo() const {
-    Serial.printf("Water Level - Raw Value: %d | Status: %s\n", rawValue, status.c_str());
+    Serial.printf("Water Level - Raw Value: %d (%d%%) | Status: %s\n", 
+                  rawValue, levelPercent, WaterLevelCalibration::levelName(level));
 }
 
 bool WaterLevelSensor::isValidReading() const {
     return CalibrationUtils::validateWaterLevelReading(rawValue);
-}
\ No newline at end of file
+}
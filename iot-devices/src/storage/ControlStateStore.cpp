@@ -0,0 +1,118 @@
+#include "storage/ControlStateStore.h"
+#include "utils/Fnv1a.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+
+RTC_NOINIT_ATTR ControlStateStore::Record ControlStateStore::rtcRecord;
+
+ControlStateStore::ControlStateStore() {
+    memset(&durable, 0, sizeof(durable));
+    durableValid = false;
+    nvsWrites = 0;
+}
+
+uint32_t ControlStateStore::checksum(const Record& record) {
+    // Over everything but the checksum itself
+    return Fnv1a::hash(&record, offsetof(Record, checksum));
+}
+
+bool ControlStateStore::valid(const Record& record) {
+    return record.magic == MAGIC && record.version == STORAGE_VERSION && record.checksum == checksum(record);
+}
+
+void ControlStateStore::seal(Record& record) {
+    record.magic = MAGIC;
+    record.version = STORAGE_VERSION;
+    record.reserved = 0;
+    record.reserved2 = 0;
+    record.checksum = checksum(record);
+}
+
+bool ControlStateStore::loadDurable() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    Record record;
+    size_t length = prefs.isKey(NVS_KEY) ? prefs.getBytes(NVS_KEY, &record, sizeof(record)) : 0;
+    prefs.end();
+
+    if (length != sizeof(record) || !valid(record)) {
+        return false;
+    }
+    durable = record;
+    return true;
+}
+
+bool ControlStateStore::writeDurable(const Record& record) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open NVS control namespace");
+        return false;
+    }
+
+    bool success = prefs.putBytes(NVS_KEY, &record, sizeof(record)) == sizeof(record);
+    prefs.end();
+
+    if (success) {
+        durable = record;
+        durableValid = true;
+        nvsWrites++;
+    }
+    return success;
+}
+
+ControlStateStore::Source ControlStateStore::restore(ControlState& state) {
+    state = ControlState();
+    durableValid = loadDurable();
+    if (!durableValid) {
+        return SOURCE_NONE;
+    }
+
+    // The RTC copy is only trusted if it belongs to this device's NVS record
+    const Record& rtc = rtcRecord;
+    bool rtcValid = valid(rtc) && rtc.tag == durable.tag;
+    const Record& record = rtcValid ? rtc : durable;
+
+    state.overrideMask = record.overrideMask;
+    state.relayMask = record.relayMask;
+    state.lastCommandId = record.lastCommandId;
+    state.changedAt = record.changedAt;
+
+    if (!rtcValid) {
+        // After a power loss only an explicit override brings the pump back on
+        state.relayMask &= state.overrideMask;
+        return SOURCE_NVS;
+    }
+    return SOURCE_RTC;
+}
+
+void ControlStateStore::save(const ControlState& state) {
+    Record record = {};
+    record.overrideMask = state.overrideMask;
+    record.relayMask = state.relayMask;
+    record.lastCommandId = state.lastCommandId;
+    record.changedAt = state.changedAt;
+    record.tag = durableValid ? durable.tag : esp_random();
+    seal(record);
+
+    rtcRecord = record;
+
+    // NVS only when the durable part changed; relay states count only for override zones
+    uint16_t overrideRelays = state.overrideMask & state.relayMask;
+    uint16_t durableOverrideRelays = durable.overrideMask & durable.relayMask;
+    if (durableValid && durable.overrideMask == record.overrideMask &&
+        durableOverrideRelays == overrideRelays && durable.lastCommandId == record.lastCommandId) {
+        return;
+    }
+    writeDurable(record);
+}
+
+const char* ControlStateStore::sourceName(Source source) {
+    switch (source) {
+        case SOURCE_RTC: return "RTC memory";
+        case SOURCE_NVS: return "NVS";
+        default:         return "none";
+    }
+}
@@ -0,0 +1,386 @@
+#include "storage/SnapshotCodec.h"
+#include <string.h>
+
+namespace SnapshotCodec {
+
+    namespace {
+        const uint8_t MAGIC_0 = 'S';
+        const uint8_t MAGIC_1 = 'C';
+        const uint8_t LEADING_BITS = 5;     // Leading zeros of a XOR, 0-31
+        const uint8_t LENGTH_BITS = 5;      // Meaningful XOR bits minus one, 1-32
+
+        // Delta buckets: prefix '0' = zero, '10' = 7 bits, '110' = 9 bits, '1110' = 12 bits, '1111' = 32 bits
+        struct Bucket {
+            uint8_t prefix;
+            uint8_t prefixBits;
+            uint8_t valueBits;
+        };
+        const Bucket BUCKETS[] = {
+            {0x2, 2, 7},
+            {0x6, 3, 9},
+            {0xE, 4, 12},
+            {0xF, 4, 32}
+        };
+
+        uint8_t countLeadingZeros(uint32_t value) {
+            return value == 0 ? 32 : static_cast<uint8_t>(__builtin_clz(value));
+        }
+
+        uint8_t countTrailingZeros(uint32_t value) {
+            return value == 0 ? 32 : static_cast<uint8_t>(__builtin_ctz(value));
+        }
+
+        bool fitsSigned(int32_t value, uint8_t bits) {
+            if (bits >= 32) return true;
+            int32_t limit = 1 << (bits - 1);
+            return value >= -limit && value < limit;
+        }
+
+        int32_t signExtend(uint32_t value, uint8_t bits) {
+            if (bits >= 32) return static_cast<int32_t>(value);
+            uint32_t sign = 1u << (bits - 1);
+            return static_cast<int32_t>((value ^ sign) - sign);
+        }
+    }
+
+    uint32_t floatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float bitsToFloat(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // ---------------------------------------------------------------- Encoder
+
+    Encoder::Encoder(uint8_t* buffer, size_t capacity)
+        : buffer(buffer), capacity(capacity), bitPos(0), headerSize(0), sampleCount(0), schema() {
+        prevTimestamp = 0;
+        prevDelta = 0;
+    }
+
+    bool Encoder::writeBits(uint32_t value, uint8_t bits) {
+        if (bitPos + bits > capacity * 8) return false;
+
+        for (int i = bits - 1; i >= 0; i--) {
+            size_t byteIndex = bitPos >> 3;
+            uint8_t mask = 0x80 >> (bitPos & 7);
+            if ((value >> i) & 1) {
+                buffer[byteIndex] |= mask;
+            } else {
+                buffer[byteIndex] &= ~mask;
+            }
+            bitPos++;
+        }
+        return true;
+    }
+
+    bool Encoder::writeBucketed(int32_t value) {
+        if (value == 0) return writeBits(0, 1);
+
+        for (const Bucket& bucket : BUCKETS) {
+            if (fitsSigned(value, bucket.valueBits)) {
+                uint32_t mask = bucket.valueBits >= 32 ? 0xFFFFFFFFu : ((1u << bucket.valueBits) - 1);
+                return writeBits(bucket.prefix, bucket.prefixBits) &&
+                       writeBits(static_cast<uint32_t>(value) & mask, bucket.valueBits);
+            }
+        }
+        return false;
+    }
+
+    bool Encoder::writeFloat(uint8_t field, uint32_t value) {
+        uint32_t xorValue = value ^ prevValues[field];
+        if (xorValue == 0) return writeBits(0, 1);
+
+        uint8_t leading = countLeadingZeros(xorValue);
+        uint8_t trailing = countTrailingZeros(xorValue);
+        if (leading > 31) leading = 31;
+
+        // Reuse the previous window when the meaningful bits fit inside it
+        if (prevLeading[field] <= 31 && leading >= prevLeading[field] && trailing >= prevTrailing[field]) {
+            uint8_t meaningful = 32 - prevLeading[field] - prevTrailing[field];
+            return writeBits(0x2, 2) && writeBits(xorValue >> prevTrailing[field], meaningful);
+        }
+
+        uint8_t meaningful = 32 - leading - trailing;
+        prevLeading[field] = leading;
+        prevTrailing[field] = trailing;
+        return writeBits(0x3, 2) && writeBits(leading, LEADING_BITS) &&
+               writeBits(meaningful - 1, LENGTH_BITS) && writeBits(xorValue >> trailing, meaningful);
+    }
+
+    bool Encoder::begin(const Schema& newSchema) {
+        if (newSchema.fieldCount > MAX_FIELDS) return false;
+        schema = newSchema;
+        bitPos = 0;
+
+        bool ok = writeBits(MAGIC_0, 8) && writeBits(MAGIC_1, 8) && writeBits(VERSION, 8) &&
+                  writeBits(schema.fieldCount, 8) && writeBits(0, 16);
+        for (uint8_t i = 0; ok && i < schema.fieldCount; i++) {
+            size_t keyLength = strnlen(schema.keys[i], MAX_KEY_LENGTH);
+            ok = writeBits(schema.types[i], 8) && writeBits(keyLength, 8);
+            for (size_t c = 0; ok && c < keyLength; c++) {
+                ok = writeBits(static_cast<uint8_t>(schema.keys[i][c]), 8);
+            }
+        }
+        if (!ok) return false;
+
+        headerSize = bitPos / 8;
+        reset();
+        return true;
+    }
+
+    void Encoder::reset() {
+        bitPos = headerSize * 8;
+        sampleCount = 0;
+        if (headerSize >= HEADER_FIXED_SIZE) {
+            buffer[4] = 0;
+            buffer[5] = 0;
+        }
+        prevTimestamp = 0;
+        prevDelta = 0;
+        for (uint8_t i = 0; i < MAX_FIELDS; i++) {
+            prevValues[i] = 0;
+            prevLeading[i] = 0xFF;   // No window yet
+            prevTrailing[i] = 0;
+        }
+    }
+
+    bool Encoder::encodeSample(const Sample& sample) {
+        if (sampleCount == 0) {
+            if (!writeBits(sample.timestamp, 32)) return false;
+        } else {
+            int32_t delta = static_cast<int32_t>(sample.timestamp - prevTimestamp);
+            if (!writeBucketed(delta - prevDelta)) return false;
+            prevDelta = delta;
+        }
+        prevTimestamp = sample.timestamp;
+
+        for (uint8_t i = 0; i < schema.fieldCount; i++) {
+            uint32_t value = sample.values[i];
+            bool ok = true;
+
+            switch (schema.types[i]) {
+                case FIELD_FLOAT:
+                    ok = writeFloat(i, value);
+                    break;
+                case FIELD_INT:
+                    ok = writeBucketed(static_cast<int32_t>(value - prevValues[i]));
+                    break;
+                case FIELD_BOOL:
+                    ok = writeBits(value != prevValues[i] ? 1 : 0, 1);
+                    value = value ? 1 : 0;
+                    break;
+                case FIELD_ENUM:
+                    ok = (value == prevValues[i]) ? writeBits(0, 1) : (writeBits(1, 1) && writeBits(value, 8));
+                    break;
+            }
+            if (!ok) return false;
+            prevValues[i] = value;
+        }
+        return true;
+    }
+
+    bool Encoder::append(const Sample& sample) {
+        if (headerSize == 0 || sampleCount == 0xFFFF) return false;
+
+        // Snapshot the state so a sample that doesn't fit leaves no partial bits behind
+        size_t savedBitPos = bitPos;
+        uint32_t savedTimestamp = prevTimestamp;
+        int32_t savedDelta = prevDelta;
+        uint32_t savedValues[MAX_FIELDS];
+        uint8_t savedLeading[MAX_FIELDS];
+        uint8_t savedTrailing[MAX_FIELDS];
+        memcpy(savedValues, prevValues, sizeof(prevValues));
+        memcpy(savedLeading, prevLeading, sizeof(prevLeading));
+        memcpy(savedTrailing, prevTrailing, sizeof(prevTrailing));
+
+        if (!encodeSample(sample)) {
+            bitPos = savedBitPos;
+            prevTimestamp = savedTimestamp;
+            prevDelta = savedDelta;
+            memcpy(prevValues, savedValues, sizeof(prevValues));
+            memcpy(prevLeading, savedLeading, sizeof(prevLeading));
+            memcpy(prevTrailing, savedTrailing, sizeof(prevTrailing));
+            return false;
+        }
+
+        sampleCount++;
+        buffer[4] = static_cast<uint8_t>(sampleCount >> 8);
+        buffer[5] = static_cast<uint8_t>(sampleCount & 0xFF);
+        return true;
+    }
+
+    size_t Encoder::size() const {
+        return (bitPos + 7) / 8;
+    }
+
+    uint16_t Encoder::count() const {
+        return sampleCount;
+    }
+
+    const uint8_t* Encoder::data() const {
+        return buffer;
+    }
+
+    // ---------------------------------------------------------------- Decoder
+
+    Decoder::Decoder(const uint8_t* data, size_t length)
+        : data(data), length(length), bitPos(0), sampleCount(0), decoded(0), schema() {
+        prevTimestamp = 0;
+        prevDelta = 0;
+        for (uint8_t i = 0; i < MAX_FIELDS; i++) {
+            prevValues[i] = 0;
+            prevLeading[i] = 0xFF;
+            prevTrailing[i] = 0;
+        }
+    }
+
+    bool Decoder::readBits(uint8_t bits, uint32_t& value) {
+        if (bitPos + bits > length * 8) return false;
+
+        value = 0;
+        for (uint8_t i = 0; i < bits; i++) {
+            uint8_t bit = (data[bitPos >> 3] >> (7 - (bitPos & 7))) & 1;
+            value = (value << 1) | bit;
+            bitPos++;
+        }
+        return true;
+    }
+
+    bool Decoder::readBucketed(int32_t& value) {
+        uint32_t bit;
+        if (!readBits(1, bit)) return false;
+        if (bit == 0) {
+            value = 0;
+            return true;
+        }
+
+        // Count further '1' prefix bits to pick the bucket
+        size_t bucket = 0;
+        while (bucket < 3) {
+            if (!readBits(1, bit)) return false;
+            if (bit == 0) break;
+            bucket++;
+        }
+
+        uint32_t raw;
+        if (!readBits(BUCKETS[bucket].valueBits, raw)) return false;
+        value = signExtend(raw, BUCKETS[bucket].valueBits);
+        return true;
+    }
+
+    bool Decoder::readFloat(uint8_t field, uint32_t& value) {
+        uint32_t control;
+        if (!readBits(1, control)) return false;
+        if (control == 0) {
+            value = prevValues[field];
+            return true;
+        }
+
+        if (!readBits(1, control)) return false;
+        if (control == 1) {
+            uint32_t leading;
+            uint32_t lengthMinusOne;
+            if (!readBits(LEADING_BITS, leading) || !readBits(LENGTH_BITS, lengthMinusOne)) return false;
+            prevLeading[field] = static_cast<uint8_t>(leading);
+            prevTrailing[field] = static_cast<uint8_t>(32 - leading - (lengthMinusOne + 1));
+        } else if (prevLeading[field] > 31) {
+            return false;   // Window reuse before any window was sent
+        }
+
+        uint8_t meaningful = 32 - prevLeading[field] - prevTrailing[field];
+        uint32_t bits;
+        if (!readBits(meaningful, bits)) return false;
+        value = prevValues[field] ^ (prevTrailing[field] >= 32 ? 0 : bits << prevTrailing[field]);
+        return true;
+    }
+
+    bool Decoder::readHeader() {
+        uint32_t magic0, magic1, version, fieldCount, count;
+        if (!readBits(8, magic0) || !readBits(8, magic1) || !readBits(8, version) ||
+            !readBits(8, fieldCount) || !readBits(16, count)) {
+            return false;
+        }
+        if (magic0 != MAGIC_0 || magic1 != MAGIC_1 || version != VERSION || fieldCount > MAX_FIELDS) {
+            return false;
+        }
+
+        schema.fieldCount = static_cast<uint8_t>(fieldCount);
+        sampleCount = static_cast<uint16_t>(count);
+
+        for (uint8_t i = 0; i < schema.fieldCount; i++) {
+            uint32_t type, keyLength;
+            if (!readBits(8, type) || !readBits(8, keyLength) || type > FIELD_ENUM || keyLength > MAX_KEY_LENGTH) {
+                return false;
+            }
+            schema.types[i] = static_cast<FieldType>(type);
+            for (uint32_t c = 0; c < keyLength; c++) {
+                uint32_t ch;
+                if (!readBits(8, ch)) return false;
+                schema.keys[i][c] = static_cast<char>(ch);
+            }
+            schema.keys[i][keyLength] = '\0';
+        }
+        return true;
+    }
+
+    bool Decoder::next(Sample& sample) {
+        if (decoded >= sampleCount) return false;
+
+        if (decoded == 0) {
+            if (!readBits(32, sample.timestamp)) return false;
+        } else {
+            int32_t deltaOfDelta;
+            if (!readBucketed(deltaOfDelta)) return false;
+            prevDelta += deltaOfDelta;
+            sample.timestamp = prevTimestamp + static_cast<uint32_t>(prevDelta);
+        }
+        prevTimestamp = sample.timestamp;
+
+        for (uint8_t i = 0; i < schema.fieldCount; i++) {
+            uint32_t value = 0;
+            uint32_t bit;
+            int32_t delta;
+
+            switch (schema.types[i]) {
+                case FIELD_FLOAT:
+                    if (!readFloat(i, value)) return false;
+                    break;
+                case FIELD_INT:
+                    if (!readBucketed(delta)) return false;
+                    value = prevValues[i] + static_cast<uint32_t>(delta);
+                    break;
+                case FIELD_BOOL:
+                    if (!readBits(1, bit)) return false;
+                    value = bit ? !prevValues[i] : prevValues[i];
+                    break;
+                case FIELD_ENUM:
+                    if (!readBits(1, bit)) return false;
+                    if (bit) {
+                        if (!readBits(8, value)) return false;
+                    } else {
+                        value = prevValues[i];
+                    }
+                    break;
+            }
+            prevValues[i] = value;
+            sample.values[i] = value;
+        }
+
+        decoded++;
+        return true;
+    }
+
+    const Schema& Decoder::getSchema() const {
+        return schema;
+    }
+
+    uint16_t Decoder::count() const {
+        return sampleCount;
+    }
+}
@@ -0,0 +1,307 @@
+#include "storage/TimeSeriesStore.h"
+#include <SPIFFS.h>
+
+TimeSeriesStore::TimeSeriesStore() {
+    raw = {'r', 0, 0, 0};
+    downsampled = {'d', 0, 0, 0};
+    bufferedCount = 0;
+    mounted = false;
+    budgetWindowStart = 0;
+    bytesThisWindow = 0;
+    totalBytesWritten = 0;
+    droppedRecords = 0;
+    compactions = 0;
+}
+
+uint8_t TimeSeriesStore::computeCrc(const Record& record) {
+    // CRC-8 (Dallas/Maxim) over the record with the crc byte zeroed
+    Record copy = record;
+    copy.crc = 0;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&copy);
+
+    uint8_t crc = 0;
+    for (size_t i = 0; i < sizeof(Record); i++) {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+bool TimeSeriesStore::isValid(const Record& record) {
+    return record.type != 0 && record.fieldCount <= MAX_FIELDS && record.crc == computeCrc(record);
+}
+
+void TimeSeriesStore::segmentPath(char* path, size_t size, char prefix, uint32_t seq) {
+    snprintf(path, size, "/ts_%c%08lu.bin", prefix, (unsigned long)seq);
+}
+
+bool TimeSeriesStore::begin() {
+    if (!SPIFFS.begin(true)) {
+        Serial.println("Time-series store: failed to mount SPIFFS");
+        return false;
+    }
+    mounted = true;
+    budgetWindowStart = millis();
+
+    // Recover segment ranges from the file names left on flash
+    bool foundRaw = false;
+    bool foundDownsampled = false;
+    File root = SPIFFS.open("/");
+    File file = root.openNextFile();
+    while (file) {
+        const char* name = file.name();
+        const char* base = strrchr(name, '/');
+        base = base ? base + 1 : name;
+
+        char prefix;
+        unsigned long seq;
+        if (sscanf(base, "ts_%c%08lu.bin", &prefix, &seq) == 2 &&
+            (prefix == raw.prefix || prefix == downsampled.prefix)) {
+            Tier& tier = (prefix == raw.prefix) ? raw : downsampled;
+            bool& found = (prefix == raw.prefix) ? foundRaw : foundDownsampled;
+            
+            if (!found || seq < tier.firstSeq) tier.firstSeq = seq;
+            if (!found || seq + 1 > tier.nextSeq) {
+                tier.nextSeq = seq + 1;
+                tier.tailRecords = file.size() / sizeof(Record);
+                // A write cut off by a power loss leaves a partial record. Appending after it would put
+                // every later record off the record grid, so the next write starts a new segment.
+                if (file.size() % sizeof(Record) != 0) tier.tailRecords = SEGMENT_RECORDS;
+            }
+            found = true;
+        }
+        file = root.openNextFile();
+    }
+
+    Serial.printf("Time-series store ready: %lu raw + %lu downsampled segments\n",
+                  (unsigned long)(raw.nextSeq - raw.firstSeq),
+                  (unsigned long)(downsampled.nextSeq - downsampled.firstSeq));
+    return true;
+}
+
+bool TimeSeriesStore::append(Record record) {
+    unsigned long now = millis();
+    if (now - budgetWindowStart >= BUDGET_WINDOW) {
+        budgetWindowStart = now;
+        bytesThisWindow = 0;
+    }
+
+    // Buffered bytes count against the budget up front so a burst can't exceed it
+    uint32_t pending = (bufferedCount + 1) * sizeof(Record);
+    if (bytesThisWindow + pending > WRITE_BUDGET_BYTES_PER_HOUR) {
+        droppedRecords++;
+        return false;
+    }
+
+    record.crc = computeCrc(record);
+    buffer[bufferedCount++] = record;
+
+    if (bufferedCount >= FLUSH_RECORDS) {
+        return flush();
+    }
+    return true;
+}
+
+bool TimeSeriesStore::appendRelayEvent(bool relayStatus, bool manualOverride, uint8_t zone) {
+    Record record = {};
+    record.timestamp = static_cast<uint32_t>(time(nullptr));
+    record.type = RECORD_RELAY_EVENT;
+    record.fieldCount = 3;
+    record.sampleCount = 1;
+    record.values[0] = relayStatus ? 1 : 0;
+    record.values[1] = manualOverride ? 1 : 0;
+    record.values[2] = zone;
+    return append(record);
+}
+
+bool TimeSeriesStore::flush() {
+    if (!mounted || bufferedCount == 0) return mounted;
+
+    bool success = writeToTier(raw, buffer, bufferedCount);
+    if (success) {
+        bytesThisWindow += bufferedCount * sizeof(Record);
+        bufferedCount = 0;
+    }
+    return success;
+}
+
+bool TimeSeriesStore::writeToTier(Tier& tier, const Record* records, size_t count) {
+    char path[32];
+
+    while (count > 0) {
+        if (tier.nextSeq == tier.firstSeq || tier.tailRecords >= SEGMENT_RECORDS) {
+            tier.nextSeq++;             // Start a new segment
+            tier.tailRecords = 0;
+        }
+
+        size_t chunk = min(count, (size_t)(SEGMENT_RECORDS - tier.tailRecords));
+        segmentPath(path, sizeof(path), tier.prefix, tier.nextSeq - 1);
+
+        File file = SPIFFS.open(path, "a");
+        if (!file) {
+            Serial.printf("Time-series store: cannot open %s\n", path);
+            return false;
+        }
+        size_t bytes = chunk * sizeof(Record);
+        size_t written = file.write(reinterpret_cast<const uint8_t*>(records), bytes);
+        file.close();
+
+        totalBytesWritten += written;
+        if (written != bytes) {
+            // The retry goes to a new segment, off the partial record this left
+            Serial.printf("Time-series store: short write to %s\n", path);
+            tier.tailRecords = SEGMENT_RECORDS;
+            return false;
+        }
+
+        tier.tailRecords += chunk;
+        records += chunk;
+        count -= chunk;
+    }
+    return true;
+}
+
+void TimeSeriesStore::maintain() {
+    if (!mounted) return;
+
+    while (raw.nextSeq - raw.firstSeq > MAX_RAW_SEGMENTS) {
+        if (!compactOldestRaw()) break;
+    }
+
+    char path[32];
+    while (downsampled.nextSeq - downsampled.firstSeq > MAX_DOWNSAMPLED_SEGMENTS) {
+        segmentPath(path, sizeof(path), downsampled.prefix, downsampled.firstSeq);
+        SPIFFS.remove(path);
+        downsampled.firstSeq++;
+    }
+}
+
+bool TimeSeriesStore::compactOldestRaw() {
+    // Output is written in small batches to keep the stack footprint low
+    Record out[16];
+    size_t outCount = 0;
+    bool writeOk = true;
+    
+    auto emit = [&](const Record& record) {
+        out[outCount++] = record;
+        if (outCount == sizeof(out) / sizeof(out[0])) {
+            writeOk = writeOk && writeToTier(downsampled, out, outCount);
+            outCount = 0;
+        }
+    };
+
+    int32_t sums[MAX_FIELDS] = {0};
+    Record bucket = {};
+    uint32_t bucketStart = 0;
+
+    auto emitBucket = [&]() {
+        if (bucket.sampleCount == 0) return;
+        for (uint8_t i = 0; i < bucket.fieldCount; i++) {
+            bucket.values[i] = static_cast<int16_t>(sums[i] / bucket.sampleCount);
+            sums[i] = 0;
+        }
+        bucket.crc = computeCrc(bucket);
+        emit(bucket);
+        bucket = {};
+    };
+
+    // Average snapshots into hourly buckets; relay events are kept as-is
+    readSegment(raw.prefix, raw.firstSeq, 0, UINT32_MAX, [&](const Record& record) {
+        if (record.type != RECORD_SNAPSHOT) {
+            emitBucket();
+            emit(record);
+            return true;
+        }
+
+        uint32_t start = record.timestamp - (record.timestamp % DOWNSAMPLE_SECONDS);
+        if (bucket.sampleCount > 0 && (start != bucketStart || bucket.sampleCount == UINT8_MAX)) {
+            emitBucket();
+        }
+        if (bucket.sampleCount == 0) {
+            bucketStart = start;
+            bucket.timestamp = start;
+            bucket.type = RECORD_DOWNSAMPLED;
+            bucket.fieldCount = record.fieldCount;
+        }
+        for (uint8_t i = 0; i < record.fieldCount; i++) {
+            sums[i] += record.values[i];
+        }
+        bucket.sampleCount++;
+        return true;
+    });
+    emitBucket();
+
+    if (outCount > 0) {
+        writeOk = writeOk && writeToTier(downsampled, out, outCount);
+    }
+    if (!writeOk) {
+        return false;   // Keep the raw segment; compaction is retried on the next maintain()
+    }
+
+    char path[32];
+    segmentPath(path, sizeof(path), raw.prefix, raw.firstSeq);
+    SPIFFS.remove(path);
+    raw.firstSeq++;
+    compactions++;
+    return true;
+}
+
+bool TimeSeriesStore::readSegment(char prefix, uint32_t seq, uint32_t from, uint32_t to,
+                                  const RecordCallback& callback) {
+    char path[32];
+    segmentPath(path, sizeof(path), prefix, seq);
+
+    File file = SPIFFS.open(path, "r");
+    if (!file) return true;
+
+    Record record;
+    bool keepGoing = true;
+    while (keepGoing && file.read(reinterpret_cast<uint8_t*>(&record), sizeof(Record)) == sizeof(Record)) {
+        if (!isValid(record)) continue;  // Torn or corrupted write
+        if (record.timestamp < from || record.timestamp > to) continue;
+        keepGoing = callback(record);
+    }
+    file.close();
+    return keepGoing;
+}
+
+size_t TimeSeriesStore::query(uint32_t from, uint32_t to, const RecordCallback& callback) {
+    size_t matched = 0;
+    RecordCallback counting = [&](const Record& record) {
+        matched++;
+        return callback(record);
+    };
+
+    if (mounted) {
+        // Oldest data first: hourly averages, then raw segments
+        for (uint32_t seq = downsampled.firstSeq; seq < downsampled.nextSeq; seq++) {
+            if (!readSegment(downsampled.prefix, seq, from, to, counting)) return matched;
+        }
+        for (uint32_t seq = raw.firstSeq; seq < raw.nextSeq; seq++) {
+            if (!readSegment(raw.prefix, seq, from, to, counting)) return matched;
+        }
+    }
+
+    for (uint8_t i = 0; i < bufferedCount; i++) {
+        if (buffer[i].timestamp < from || buffer[i].timestamp > to) continue;
+        if (!counting(buffer[i])) break;
+    }
+    return matched;
+}
+
+void TimeSeriesStore::printDebugInfo() const {
+    Serial.println("=== TIME-SERIES STORE ===");
+    Serial.printf("  Raw segments: %lu (%u records in newest), downsampled segments: %lu\n",
+                  (unsigned long)(raw.nextSeq - raw.firstSeq), raw.tailRecords,
+                  (unsigned long)(downsampled.nextSeq - downsampled.firstSeq));
+    Serial.printf("  Buffered: %u records, written this hour: %lu / %lu bytes\n",
+                  bufferedCount, (unsigned long)bytesThisWindow, (unsigned long)WRITE_BUDGET_BYTES_PER_HOUR);
+    Serial.printf("  Total written: %lu bytes, compactions: %lu, dropped (over budget): %lu\n",
+                  (unsigned long)totalBytesWritten, (unsigned long)compactions, (unsigned long)droppedRecords);
+    Serial.println("=========================");
+}
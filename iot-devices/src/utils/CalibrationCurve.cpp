@@ -0,0 +1,148 @@
+#include "utils/CalibrationCurve.h"
+#include <Preferences.h>
+#include <new>
+
+const char* CalibrationCurve::NVS_NAMESPACE = "calibration";
+
+namespace {
+    // Fixed-size record persisted per curve in NVS
+    struct StoredCurve {
+        uint8_t version;
+        uint8_t count;
+        CalibrationPoint points[CalibrationCurve::MAX_POINTS];
+    };
+}
+
+CalibrationCurve::CalibrationCurve(const char* name, const CalibrationPoint* defaultPoints, int defaultCount,
+                                   const CalibrationTable::Table& defaultTable)
+    : name(name), defaultPoints(defaultPoints), defaultCount(defaultCount), defaultTable(defaultTable),
+      pointCount(0), customTable(nullptr), table(defaultTable.data()) {
+    resetToDefault();
+}
+
+CalibrationCurve::~CalibrationCurve() {
+    if (customTable) {
+        delete customTable;
+        customTable = nullptr;
+    }
+}
+
+bool CalibrationCurve::validatePoints(const CalibrationPoint* points, int count) {
+    if (count < 2 || count > MAX_POINTS) return false;
+
+    for (int i = 0; i < count; i++) {
+        if (points[i].raw > CalibrationTable::ADC_MAX) return false;
+        if (points[i].value > CalibrationTable::VALUE_MAX) return false;
+        if (i > 0 && points[i].raw <= points[i - 1].raw) return false;  // Must be strictly ascending
+    }
+    return true;
+}
+
+bool CalibrationCurve::setPoints(const CalibrationPoint* newPoints, int count) {
+    if (!validatePoints(newPoints, count)) {
+        Serial.printf("Rejected calibration curve for %s (need 2-%d points with ascending raw values, values 0-%d)\n",
+                      name, MAX_POINTS, CalibrationTable::VALUE_MAX);
+        return false;
+    }
+
+    if (!customTable) {
+        customTable = new (std::nothrow) CalibrationTable::Table();
+        if (!customTable) {
+            Serial.printf("Failed to allocate calibration table for %s\n", name);
+            return false;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        points[i] = newPoints[i];
+    }
+    pointCount = count;
+
+    *customTable = CalibrationTable::build(points, pointCount);
+    table = customTable->data();
+    return true;
+}
+
+void CalibrationCurve::resetToDefault() {
+    for (int i = 0; i < defaultCount; i++) {
+        points[i] = defaultPoints[i];
+    }
+    pointCount = defaultCount;
+    table = defaultTable.data();
+
+    if (customTable) {
+        delete customTable;
+        customTable = nullptr;
+    }
+}
+
+bool CalibrationCurve::loadFromNVS() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    StoredCurve stored;
+    size_t length = prefs.isKey(name) ? prefs.getBytes(name, &stored, sizeof(stored)) : 0;
+    prefs.end();
+
+    if (length != sizeof(stored) || stored.version != STORAGE_VERSION) {
+        return false;
+    }
+
+    return setPoints(stored.points, stored.count);
+}
+
+bool CalibrationCurve::saveToNVS() const {
+    StoredCurve stored = {};
+    stored.version = STORAGE_VERSION;
+    stored.count = static_cast<uint8_t>(pointCount);
+    for (int i = 0; i < pointCount; i++) {
+        stored.points[i] = points[i];
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open NVS calibration namespace");
+        return false;
+    }
+
+    bool success = prefs.putBytes(name, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    return success;
+}
+
+bool CalibrationCurve::clearNVS() const {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        return false;
+    }
+
+    bool success = !prefs.isKey(name) || prefs.remove(name);
+    prefs.end();
+    return success;
+}
+
+const char* CalibrationCurve::getName() const {
+    return name;
+}
+
+int CalibrationCurve::getPointCount() const {
+    return pointCount;
+}
+
+const CalibrationPoint* CalibrationCurve::getPoints() const {
+    return points;
+}
+
+bool CalibrationCurve::isCustom() const {
+    return customTable != nullptr;
+}
+
+void CalibrationCurve::printDebugInfo() const {
+    Serial.printf("  Curve '%s' (%s, %d points):", name, isCustom() ? "custom" : "default", pointCount);
+    for (int i = 0; i < pointCount; i++) {
+        Serial.printf(" %u->%u", points[i].raw, points[i].value);
+    }
+    Serial.println();
+}
@@ -0,0 +1,185 @@
+#include "utils/EventBus.h"
+#include "utils/SampleClock.h"
+
+EventBus::EventBus() {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    memset(references, 0, sizeof(references));
+    memset(subscribers, 0, sizeof(subscribers));
+    subscriberCount = 0;
+    sequence = 0;
+    posted = 0;
+    poolFull = 0;
+    wakeTask = nullptr;
+}
+
+bool EventBus::subscribe(const char* name, uint32_t mask, Handler handler, void* context) {
+    if (subscriberCount >= MAX_SUBSCRIBERS || !handler) {
+        Serial.printf("Event bus: no room for subscriber '%s'\n", name);
+        return false;
+    }
+
+    Subscriber& subscriber = subscribers[subscriberCount++];
+    subscriber.name = name;
+    subscriber.mask = mask;
+    subscriber.handler = handler;
+    subscriber.context = context;
+    return true;
+}
+
+// Caller holds the lock; in IRAM because postFromISR() calls it
+bool IRAM_ATTR EventBus::enqueue(const Event& event) {
+    uint8_t slot = 0;
+    while (slot < POOL_SIZE && references[slot] != 0) slot++;
+    if (slot == POOL_SIZE) {
+        poolFull++;
+        return false;
+    }
+
+    uint8_t taken = 0;
+    for (uint8_t i = 0; i < subscriberCount; i++) {
+        Subscriber& subscriber = subscribers[i];
+        if (!(subscriber.mask & Events::bit(event.type))) continue;
+        if (subscriber.count >= QUEUE_DEPTH) {
+            subscriber.dropped++;
+            continue;
+        }
+        subscriber.queue[(subscriber.head + subscriber.count) % QUEUE_DEPTH] = slot;
+        subscriber.count++;
+        if (subscriber.count > subscriber.highWater) subscriber.highWater = subscriber.count;
+        taken++;
+    }
+    if (!taken) return false;
+
+    pool[slot] = event;
+    pool[slot].sequence = ++sequence;
+    pool[slot].postedAt = esp_timer_get_time();
+    references[slot] = taken;
+    posted++;
+    return true;
+}
+
+bool EventBus::post(const Event& event) {
+    portENTER_CRITICAL(&lock);
+    bool queued = enqueue(event);
+    portEXIT_CRITICAL(&lock);
+
+    if (queued && wakeTask) xTaskNotifyGive(wakeTask);
+    return queued;
+}
+
+bool IRAM_ATTR EventBus::postFromISR(const Event& event) {
+    portENTER_CRITICAL_ISR(&lock);
+    bool queued = enqueue(event);
+    portEXIT_CRITICAL_ISR(&lock);
+
+    if (queued && wakeTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(wakeTask, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+    return queued;
+}
+
+uint16_t EventBus::dispatch() {
+    uint16_t deliveries = 0;
+    bool more = true;
+
+    // Handlers may post; keep going until every queue is empty
+    while (more) {
+        more = false;
+        for (uint8_t i = 0; i < subscriberCount; i++) {
+            Subscriber& subscriber = subscribers[i];
+
+            portENTER_CRITICAL(&lock);
+            if (subscriber.count == 0) {
+                portEXIT_CRITICAL(&lock);
+                continue;
+            }
+            uint8_t slot = subscriber.queue[subscriber.head];
+            subscriber.head = (subscriber.head + 1) % QUEUE_DEPTH;
+            subscriber.count--;
+            portEXIT_CRITICAL(&lock);
+
+            // The slot can't be reused before its reference is released below
+            const Event& event = pool[slot];
+            int64_t start = SampleClock::monotonicMicros();
+            subscriber.handler(subscriber.context, event);
+            uint32_t elapsed = static_cast<uint32_t>(SampleClock::monotonicMicros() - start);
+            uint32_t waited = static_cast<uint32_t>(start - event.postedAt);
+
+            subscriber.delivered++;
+            subscriber.handlerMicros += elapsed;
+            if (elapsed > subscriber.maxHandlerMicros) subscriber.maxHandlerMicros = elapsed;
+            if (waited > subscriber.maxWaitMicros) subscriber.maxWaitMicros = waited;
+
+            portENTER_CRITICAL(&lock);
+            references[slot]--;
+            portEXIT_CRITICAL(&lock);
+
+            deliveries++;
+            more = true;
+        }
+    }
+    return deliveries;
+}
+
+bool EventBus::hasPending() const {
+    for (uint8_t i = 0; i < subscriberCount; i++) {
+        if (subscribers[i].count) return true;
+    }
+    return false;
+}
+
+void EventBus::serialize(JsonDocument& doc) {
+    // Counters are taken and restarted under the lock; the JSON allocates, so it is written after
+    Subscriber snapshot[MAX_SUBSCRIBERS];
+    portENTER_CRITICAL(&lock);
+    uint8_t count = subscriberCount;
+    uint32_t postedCount = posted;
+    uint32_t poolFullCount = poolFull;
+    for (uint8_t i = 0; i < count; i++) {
+        Subscriber& subscriber = subscribers[i];
+        snapshot[i] = subscriber;
+
+        subscriber.delivered = 0;
+        subscriber.dropped = 0;
+        subscriber.highWater = subscriber.count;
+        subscriber.handlerMicros = 0;
+        subscriber.maxHandlerMicros = 0;
+        subscriber.maxWaitMicros = 0;
+    }
+    posted = 0;
+    poolFull = 0;
+    portEXIT_CRITICAL(&lock);
+
+    JsonObject bus = doc["bus"].to<JsonObject>();
+    bus["posted"] = postedCount;
+    bus["poolFull"] = poolFullCount;
+
+    // Per subscriber: [delivered, dropped, max queued, mean µs, max µs, max wait µs]
+    JsonObject handlers = bus["subscribers"].to<JsonObject>();
+    for (uint8_t i = 0; i < count; i++) {
+        const Subscriber& subscriber = snapshot[i];
+        JsonArray stats = handlers[subscriber.name].to<JsonArray>();
+        stats.add(subscriber.delivered);
+        stats.add(subscriber.dropped);
+        stats.add(subscriber.highWater);
+        stats.add(subscriber.delivered ? subscriber.handlerMicros / subscriber.delivered : 0);
+        stats.add(subscriber.maxHandlerMicros);
+        stats.add(subscriber.maxWaitMicros);
+    }
+}
+
+void EventBus::printDebugInfo() const {
+    Serial.println("=== EVENT BUS ===");
+    Serial.printf("  %lu posted, %lu lost to a full pool\n", (unsigned long)posted, (unsigned long)poolFull);
+    for (uint8_t i = 0; i < subscriberCount; i++) {
+        const Subscriber& subscriber = subscribers[i];
+        Serial.printf("  %-8s %lu delivered, %lu dropped, %u max queued | handler %lu us mean, %lu us max | wait %lu us max\n",
+                      subscriber.name, (unsigned long)subscriber.delivered, (unsigned long)subscriber.dropped,
+                      subscriber.highWater,
+                      (unsigned long)(subscriber.delivered ? subscriber.handlerMicros / subscriber.delivered : 0),
+                      (unsigned long)subscriber.maxHandlerMicros, (unsigned long)subscriber.maxWaitMicros);
+    }
+    Serial.println("=================");
+}
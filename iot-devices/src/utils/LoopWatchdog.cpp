@@ -0,0 +1,261 @@
+#include "utils/LoopWatchdog.h"
+#include "utils/Fnv1a.h"
+#include <esp_attr.h>
+#include <esp_task_wdt.h>
+
+namespace {
+    struct Deadline {
+        uint32_t deadline;           // ms; a longer run is logged as an overrun
+        uint32_t stall;              // ms; still running then, the supervisor fails safe and restarts
+    };
+
+    // Stall limits stay below Watchdog::TASK_TIMEOUT, so the supervisor acts before the task watchdog
+    const Deadline DEADLINES[LoopWatchdog::STAGE_COUNT] = {
+        {0, 0},                      // none
+        {30000, 45000},              // setup: modem boot wait, WiFi join, first TLS connect
+        {2000, 15000},               // sensors: DS18B20 conversion, DHT11 read
+        {500, 10000},                // clock
+        {5000, 40000},               // mqtt: a reconnect does the TLS handshake in line
+        {5000, 40000},               // radio: connects on power-up
+        {500, 10000},                // gateway: FRAMES_PER_LOOP bounds the leaf work
+        {2000, 15000},               // events: relay control, display over I2C
+        {3000, 20000},               // upload
+        {2000, 20000},               // storage: flash sector erase
+        {1000, 10000}                // idle: at most Timing::LOOP_PERIOD
+    };
+}
+
+RTC_NOINIT_ATTR LoopWatchdog::Log LoopWatchdog::rtcLog;
+RTC_NOINIT_ATTR LoopWatchdog::Running LoopWatchdog::rtcRunning;
+
+LoopWatchdog::Scope::Scope(LoopWatchdog& watchdog, Stage stage) : watchdog(watchdog) {
+    previous = static_cast<Stage>(rtcRunning.stage);
+    previousStart = rtcRunning.startedAt;
+    enter(stage, millis());
+}
+
+LoopWatchdog::Scope::~Scope() {
+    uint32_t startedAt = rtcRunning.startedAt;
+    watchdog.finish(static_cast<Stage>(rtcRunning.stage), startedAt);
+    // The enclosing stage's clock stood still while this one ran
+    enter(previous, previousStart + (millis() - startedAt));
+}
+
+LoopWatchdog::LoopWatchdog() {
+    supervisor = nullptr;
+    failSafe = nullptr;
+    failSafeContext = nullptr;
+    resetReason = ESP_RST_UNKNOWN;
+    uncleanReset = false;
+    resetReported = false;
+    subscribed = false;
+    tripped = false;
+    publishedCount = 0;
+}
+
+uint32_t LoopWatchdog::checksum(const Log& log) {
+    // Over everything but the checksum itself
+    return Fnv1a::hash(&log, offsetof(Log, checksum));
+}
+
+void LoopWatchdog::seal(Log& log) {
+    log.magic = MAGIC;
+    log.version = STORAGE_VERSION;
+    log.reserved = 0;
+    log.checksum = checksum(log);
+}
+
+void LoopWatchdog::append(Stage stage, Kind kind, uint32_t duration, uint32_t startedAt, uint32_t boot) {
+    if (rtcLog.count >= Watchdog::LOG_SIZE) {
+        rtcLog.dropped++;
+    } else {
+        Entry& entry = rtcLog.entries[rtcLog.count++];
+        entry.stage = stage;
+        entry.kind = kind;
+        entry.boot = static_cast<uint16_t>(boot);
+        entry.duration = duration;
+        entry.startedAt = startedAt;
+    }
+    seal(rtcLog);
+}
+
+void LoopWatchdog::enter(Stage stage, uint32_t startedAt) {
+    // The supervisor reads these from another task: the start goes first, so it never
+    // pairs a new stage with the previous stage's start time
+    rtcRunning.stage = STAGE_NONE;
+    rtcRunning.startedAt = startedAt;
+    rtcRunning.check = static_cast<uint8_t>(~stage);
+    rtcRunning.stage = stage;
+}
+
+void LoopWatchdog::finish(Stage stage, uint32_t startedAt) {
+    uint32_t elapsed = millis() - startedAt;
+    if (stage != STAGE_NONE && elapsed > DEADLINES[stage].deadline) {
+        append(stage, KIND_OVERRUN, elapsed, startedAt / 1000, rtcLog.boots);
+        Serial.printf("Loop stage '%s' overran: %lu ms (deadline %lu ms)\n", stageName(stage),
+                      (unsigned long)elapsed, (unsigned long)DEADLINES[stage].deadline);
+    }
+    feed();
+}
+
+void LoopWatchdog::onCheck(void* arg) {
+    LoopWatchdog& watchdog = *static_cast<LoopWatchdog*>(arg);
+    Stage stage = static_cast<Stage>(rtcRunning.stage);
+    if (watchdog.tripped || stage == STAGE_NONE || stage >= STAGE_COUNT) return;
+
+    uint32_t startedAt = rtcRunning.startedAt;
+    uint32_t elapsed = millis() - startedAt;
+    if (elapsed <= DEADLINES[stage].stall) return;
+
+    // The loop task is stuck somewhere in this stage: make the outputs safe before anything else
+    watchdog.tripped = true;
+    if (watchdog.failSafe) watchdog.failSafe(watchdog.failSafeContext);
+    append(stage, KIND_STALL, elapsed, startedAt / 1000, rtcLog.boots);
+    rtcLog.stalled = 1;
+    seal(rtcLog);
+
+    Serial.printf("Loop stalled in '%s' for %lu ms - valves off, restarting\n", stageName(stage),
+                  (unsigned long)elapsed);
+    Serial.flush();
+    esp_restart();
+}
+
+void LoopWatchdog::begin(FailSafeHandler handler, void* context) {
+    failSafe = handler;
+    failSafeContext = context;
+    resetReason = esp_reset_reason();
+
+    // RTC memory is garbage after power-on; a bad checksum starts a new log
+    bool logValid = rtcLog.magic == MAGIC && rtcLog.version == STORAGE_VERSION &&
+                    rtcLog.checksum == checksum(rtcLog) && rtcLog.count <= Watchdog::LOG_SIZE;
+    if (!logValid || resetReason == ESP_RST_POWERON) {
+        memset(&rtcLog, 0, sizeof(rtcLog));
+        seal(rtcLog);
+    }
+
+    bool crashed = resetReason == ESP_RST_TASK_WDT || resetReason == ESP_RST_INT_WDT ||
+                   resetReason == ESP_RST_WDT || resetReason == ESP_RST_PANIC;
+    Stage interrupted = static_cast<Stage>(rtcRunning.stage);
+    bool runningValid = rtcRunning.check == static_cast<uint8_t>(~interrupted) && interrupted < STAGE_COUNT;
+    if (crashed && logValid && runningValid && interrupted != STAGE_NONE) {
+        append(interrupted, KIND_WATCHDOG, 0, rtcRunning.startedAt / 1000, rtcLog.boots);
+    }
+    uncleanReset = crashed || (logValid && rtcLog.stalled);
+
+    rtcLog.boots++;
+    rtcLog.stalled = 0;
+    seal(rtcLog);
+    enter(STAGE_NONE, millis());
+
+    if (uncleanReset) {
+        Serial.printf("Loop watchdog: reset by %s, %u stage overrun(s) logged\n",
+                      resetReasonName(resetReason), rtcLog.count);
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = onCheck;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "loop_watchdog";
+    if (esp_timer_create(&args, &supervisor) != ESP_OK ||
+        esp_timer_start_periodic(supervisor, Watchdog::CHECK_PERIOD) != ESP_OK) {
+        Serial.println("Loop watchdog: supervisor timer failed");
+    }
+
+    // Reconfigures the watchdog the Arduino core started (idle tasks only) and adds this task
+#if defined(ESP_IDF_VERSION_MAJOR) && ESP_IDF_VERSION_MAJOR >= 5
+    esp_task_wdt_config_t config = {};
+    config.timeout_ms = Watchdog::TASK_TIMEOUT * 1000;
+    config.trigger_panic = true;
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU0
+    config.idle_core_mask |= 1 << 0;
+#endif
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU1
+    config.idle_core_mask |= 1 << 1;
+#endif
+    if (esp_task_wdt_reconfigure(&config) != ESP_OK) esp_task_wdt_init(&config);
+#else
+    esp_task_wdt_init(Watchdog::TASK_TIMEOUT, true);
+#endif
+    subscribed = esp_task_wdt_add(nullptr) == ESP_OK;
+    if (!subscribed) {
+        Serial.println("Loop watchdog: task watchdog subscription failed");
+    }
+}
+
+void LoopWatchdog::feed() {
+    if (subscribed) esp_task_wdt_reset();
+}
+
+void LoopWatchdog::serialize(JsonDocument& doc) {
+    publishedCount = 0;
+    if (resetReported && rtcLog.count == 0 && rtcLog.dropped == 0) return;
+
+    JsonObject watchdog = doc["watchdog"].to<JsonObject>();
+    watchdog["reset"] = resetReasonName(resetReason);
+    watchdog["boots"] = rtcLog.boots;
+    if (rtcLog.dropped) watchdog["dropped"] = rtcLog.dropped;
+
+    JsonArray log = watchdog["log"].to<JsonArray>();
+    for (uint8_t i = 0; i < rtcLog.count; i++) {
+        const Entry& entry = rtcLog.entries[i];
+        JsonObject item = log.add<JsonObject>();
+        item["stage"] = stageName(static_cast<Stage>(entry.stage));
+        item["kind"] = kindName(static_cast<Kind>(entry.kind));
+        item["ms"] = entry.duration;
+        item["boot"] = entry.boot;
+        item["at"] = entry.startedAt;
+    }
+    publishedCount = rtcLog.count;
+}
+
+void LoopWatchdog::markPublished() {
+    // Entries logged after serialize() stay for the next payload
+    uint8_t remaining = rtcLog.count - publishedCount;
+    memmove(rtcLog.entries, rtcLog.entries + publishedCount, remaining * sizeof(Entry));
+    rtcLog.count = remaining;
+    rtcLog.dropped = 0;
+    seal(rtcLog);
+    publishedCount = 0;
+    resetReported = true;
+}
+
+const char* LoopWatchdog::stageName(Stage stage) {
+    switch (stage) {
+        case STAGE_SETUP:   return "setup";
+        case STAGE_SENSORS: return "sensors";
+        case STAGE_CLOCK:   return "clock";
+        case STAGE_MQTT:    return "mqtt";
+        case STAGE_RADIO:   return "radio";
+        case STAGE_GATEWAY: return "gateway";
+        case STAGE_EVENTS:  return "events";
+        case STAGE_UPLOAD:  return "upload";
+        case STAGE_STORAGE: return "storage";
+        case STAGE_IDLE:    return "idle";
+        default:            return "none";
+    }
+}
+
+const char* LoopWatchdog::kindName(Kind kind) {
+    switch (kind) {
+        case KIND_STALL:    return "stall";
+        case KIND_WATCHDOG: return "watchdog";
+        default:            return "overrun";
+    }
+}
+
+const char* LoopWatchdog::resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "power-on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "interrupt watchdog";
+        case ESP_RST_TASK_WDT:  return "task watchdog";
+        case ESP_RST_WDT:       return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "SDIO";
+        default:                return "unknown";
+    }
+}
@@ -0,0 +1,204 @@
+#include "utils/MemoryDiagnostics.h"
+#include "utils/SensorCalibration.h"
+#include <new>
+
+namespace {
+    // ESP-IDF / Arduino system tasks worth watching; names that don't exist are skipped
+    const char* const SYSTEM_TASKS[] = {"tiT", "wifi", "sys_evt", "arduino_events", "esp_timer"};
+}
+
+MemoryDiagnostics::Scope* MemoryDiagnostics::currentScope = nullptr;
+
+// Every operator new in the firmware goes through here (new[] and sized forms
+// forward to it in libstdc++); the default operator delete frees with free()
+void* operator new(size_t size) {
+    MemoryDiagnostics::countAllocation();
+    void* block = malloc(size ? size : 1);
+    if (!block) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return block;
+}
+
+// libstdc++ forwards the nothrow form to the one above, which aborts without exceptions
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    MemoryDiagnostics::countAllocation();
+    return malloc(size ? size : 1);
+}
+
+void* MemoryDiagnostics::JsonAllocator::allocate(size_t size) {
+    countAllocation();
+    return malloc(size);
+}
+
+void MemoryDiagnostics::JsonAllocator::deallocate(void* pointer) {
+    free(pointer);
+}
+
+void* MemoryDiagnostics::JsonAllocator::reallocate(void* pointer, size_t size) {
+    countAllocation();
+    return realloc(pointer, size);
+}
+
+MemoryDiagnostics::JsonAllocator* MemoryDiagnostics::JsonAllocator::instance() {
+    static JsonAllocator allocator;
+    return &allocator;
+}
+
+MemoryDiagnostics::Scope::Scope(MemoryDiagnostics& diagnostics, Subsystem subsystem)
+    : diagnostics(diagnostics), subsystem(subsystem) {
+    previous = currentScope;
+    task = xTaskGetCurrentTaskHandle();
+    allocations = 0;
+    freeAtEntry = ESP.getFreeHeap();
+    currentScope = this;
+}
+
+MemoryDiagnostics::Scope::~Scope() {
+    currentScope = previous;
+    uint32_t retained = freeAtEntry - ESP.getFreeHeap();
+
+    SubsystemStats& stats = diagnostics.subsystems[subsystem];
+    stats.calls++;
+    stats.allocations += allocations;
+    stats.retainedBytes += static_cast<int32_t>(retained);
+
+    // What this scope kept is not charged to the enclosing one as well
+    if (previous) previous->freeAtEntry -= retained;
+}
+
+MemoryDiagnostics::MemoryDiagnostics() {
+    memset(subsystems, 0, sizeof(subsystems));
+    memset(tasks, 0, sizeof(tasks));
+    taskCount = 0;
+    lastSample = 0;
+    heapSize = 0;
+    heapFree = 0;
+    heapMinFree = 0;
+    heapMaxBlock = 0;
+    heapFreeAtStart = 0;
+    psramSize = 0;
+    psramFree = 0;
+    psramMinFree = 0;
+}
+
+const char* MemoryDiagnostics::subsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+        case SUB_SENSORS: return "sensors";
+        case SUB_CONTROL: return "control";
+        case SUB_DISPLAY: return "display";
+        case SUB_MQTT:    return "mqtt";
+        case SUB_RADIO:   return "radio";
+        case SUB_UPLOAD:  return "upload";
+        case SUB_STORAGE: return "storage";
+        default:          return "unknown";
+    }
+}
+
+void MemoryDiagnostics::countAllocation() {
+    Scope* scope = currentScope;
+    if (scope && scope->task == xTaskGetCurrentTaskHandle()) {
+        scope->allocations++;
+    }
+}
+
+void MemoryDiagnostics::watchTask(TaskHandle_t handle, const char* name) {
+    if (!handle || taskCount >= MAX_TASKS) return;
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (tasks[i].handle == handle) return;
+    }
+    tasks[taskCount].handle = handle;
+    tasks[taskCount].name = name;
+    tasks[taskCount].stackFree = UINT32_MAX;
+    taskCount++;
+}
+
+void MemoryDiagnostics::begin(unsigned long now) {
+    TaskHandle_t loopTask = xTaskGetCurrentTaskHandle();
+    watchTask(loopTask, pcTaskGetName(loopTask));
+    for (const char* name : SYSTEM_TASKS) {
+        watchTask(xTaskGetHandle(name), name);
+    }
+
+    sample(now, true);
+    heapFreeAtStart = heapFree;
+
+    Serial.printf("Memory: %lu/%lu bytes heap free, largest block %lu, %u task stack(s) watched\n",
+                  (unsigned long)heapFree, (unsigned long)heapSize, (unsigned long)heapMaxBlock, taskCount);
+}
+
+void MemoryDiagnostics::sample(unsigned long now, bool force) {
+    if (!force && now - lastSample < Timing::MEMORY_SAMPLE_INTERVAL) return;
+    lastSample = now;
+
+    heapSize = ESP.getHeapSize();
+    heapFree = ESP.getFreeHeap();
+    heapMinFree = ESP.getMinFreeHeap();
+    heapMaxBlock = ESP.getMaxAllocHeap();
+    psramSize = ESP.getPsramSize();
+    if (psramSize > 0) {
+        psramFree = ESP.getFreePsram();
+        psramMinFree = ESP.getMinFreePsram();
+    }
+
+    // High-water marks only ever go down; keeping the minimum survives a task being recreated
+    for (uint8_t i = 0; i < taskCount; i++) {
+        uint32_t stackFree = uxTaskGetStackHighWaterMark(tasks[i].handle);
+        if (stackFree < tasks[i].stackFree) tasks[i].stackFree = stackFree;
+    }
+}
+
+uint8_t MemoryDiagnostics::getFragmentation() const {
+    if (heapFree == 0) return 0;
+    return static_cast<uint8_t>(100 - static_cast<uint64_t>(heapMaxBlock) * 100 / heapFree);
+}
+
+void MemoryDiagnostics::serialize(JsonDocument& doc) const {
+    JsonObject memory = doc["memory"].to<JsonObject>();
+    memory["heapFree"] = heapFree;
+    memory["heapMinFree"] = heapMinFree;
+    memory["heapMaxBlock"] = heapMaxBlock;
+    memory["fragmentation"] = getFragmentation();
+    memory["heapDrift"] = static_cast<int32_t>(heapFreeAtStart - heapFree);
+    if (psramSize > 0) {
+        memory["psramFree"] = psramFree;
+        memory["psramMinFree"] = psramMinFree;
+    }
+
+    JsonObject stacks = memory["stackFree"].to<JsonObject>();
+    for (uint8_t i = 0; i < taskCount; i++) {
+        stacks[tasks[i].name] = tasks[i].stackFree;
+    }
+
+    // [allocations, retained bytes] per subsystem, kept short for the payload
+    JsonObject subsystemsJson = memory["subsystems"].to<JsonObject>();
+    for (uint8_t i = 0; i < SUB_COUNT; i++) {
+        JsonArray entry = subsystemsJson[subsystemName(static_cast<Subsystem>(i))].to<JsonArray>();
+        entry.add(subsystems[i].allocations);
+        entry.add(subsystems[i].retainedBytes);
+    }
+}
+
+void MemoryDiagnostics::printDebugInfo() const {
+    Serial.println("=== MEMORY ===");
+    Serial.printf("  Heap: %lu/%lu free (min %lu), largest block %lu, %u%% fragmented, drift %ld\n",
+                  (unsigned long)heapFree, (unsigned long)heapSize, (unsigned long)heapMinFree,
+                  (unsigned long)heapMaxBlock, getFragmentation(), (long)(int32_t)(heapFreeAtStart - heapFree));
+    if (psramSize > 0) {
+        Serial.printf("  PSRAM: %lu/%lu free (min %lu)\n", (unsigned long)psramFree, (unsigned long)psramSize,
+                      (unsigned long)psramMinFree);
+    }
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Serial.printf("  Stack %-14s %lu bytes free at worst\n", tasks[i].name, (unsigned long)tasks[i].stackFree);
+    }
+    for (uint8_t i = 0; i < SUB_COUNT; i++) {
+        Serial.printf("  %-8s %lu calls, %lu allocations, %ld bytes retained\n",
+                      subsystemName(static_cast<Subsystem>(i)), (unsigned long)subsystems[i].calls,
+                      (unsigned long)subsystems[i].allocations, (long)subsystems[i].retainedBytes);
+    }
+    Serial.println("==============");
+}
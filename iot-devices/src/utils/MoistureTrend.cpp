@@ -0,0 +1,125 @@
+#include "utils/MoistureTrend.h"
+
+MoistureTrend::MoistureTrend() {
+    mode = DRYING;
+    span = Trend::DRYING_SPAN;
+    restart(DRYING);
+}
+
+void MoistureTrend::restart(Mode newMode) {
+    mode = newMode;
+    span = mode == WETTING ? Trend::WETTING_SPAN : Trend::DRYING_SPAN;
+    memset(buckets, 0, sizeof(buckets));
+    oldest = 0;
+    used = 0;
+    origin = 0;
+    n = sumT = sumY = sumTT = sumTY = sumYY = 0.0;
+    fitted = false;
+    slope = NAN;
+    slopeError = NAN;
+    current = NAN;
+    lastAt = 0;
+}
+
+void MoistureTrend::dropOldest() {
+    const Bucket& bucket = buckets[oldest];
+    double offset = (bucket.start - origin) / 1000.0;
+
+    n -= bucket.count;
+    sumT -= bucket.count * offset + bucket.sumT;
+    sumTT -= bucket.count * offset * offset + 2.0 * offset * bucket.sumT + bucket.sumTT;
+    sumTY -= offset * bucket.sumY + bucket.sumTY;
+    sumY -= bucket.sumY;
+    sumYY -= bucket.sumYY;
+
+    oldest = (oldest + 1) % Trend::BUCKETS;
+    used--;
+}
+
+void MoistureTrend::rebase(unsigned long newOrigin) {
+    // Same sums with t counted from the new origin
+    double shift = (newOrigin - origin) / 1000.0;
+    sumTT += -2.0 * shift * sumT + n * shift * shift;
+    sumTY -= shift * sumY;
+    sumT -= n * shift;
+    origin = newOrigin;
+}
+
+void MoistureTrend::add(float moisture, unsigned long now) {
+    if (isnan(moisture)) return;
+
+    // Buckets older than the window leave it, several at once after a gap in the readings
+    while (used > 0 && now - buckets[oldest].start >= span * Trend::BUCKETS) {
+        dropOldest();
+    }
+    if (used == 0) {
+        n = sumT = sumY = sumTT = sumTY = sumYY = 0.0;
+        origin = now;
+    }
+
+    uint8_t newest = (oldest + used + Trend::BUCKETS - 1) % Trend::BUCKETS;
+    if (used == 0 || now - buckets[newest].start >= span) {
+        if (used == Trend::BUCKETS) dropOldest();
+        newest = (oldest + used) % Trend::BUCKETS;
+        buckets[newest] = Bucket();
+        buckets[newest].start = now;
+        used++;
+    }
+    if (buckets[oldest].start != origin) rebase(buckets[oldest].start);
+
+    Bucket& bucket = buckets[newest];
+    double y = moisture;
+    double local = (now - bucket.start) / 1000.0;
+    bucket.count++;
+    bucket.sumT += local;
+    bucket.sumY += y;
+    bucket.sumTT += local * local;
+    bucket.sumTY += local * y;
+    bucket.sumYY += y * y;
+
+    double t = (now - origin) / 1000.0;
+    n += 1.0;
+    sumT += t;
+    sumY += y;
+    sumTT += t * t;
+    sumTY += t * y;
+    sumYY += y * y;
+
+    lastAt = now;
+    fit();
+}
+
+void MoistureTrend::fit() {
+    double spread = sumTT - sumT * sumT / n;         // n times the variance of t
+    fitted = used >= Trend::MIN_BUCKETS && n >= Trend::MIN_SAMPLES && spread > 0.0;
+    if (!fitted) {
+        slope = slopeError = current = NAN;
+        return;
+    }
+
+    double b = (sumTY - sumT * sumY / n) / spread;
+    double a = (sumY - b * sumT) / n;
+    double residual = sumYY - a * sumY - b * sumTY;
+    slope = static_cast<float>(b);
+    slopeError = static_cast<float>(sqrt(fmax(residual, 0.0) / (n - 2.0) / spread));
+    current = static_cast<float>(a + b * ((lastAt - origin) / 1000.0));
+}
+
+float MoistureTrend::getSlopePerHour() const {
+    return fitted ? slope * 3600.0f : NAN;
+}
+
+bool MoistureTrend::isSignificant() const {
+    return fitted && fabsf(slope) > Trend::SIGNIFICANCE * slopeError;
+}
+
+float MoistureTrend::secondsTo(float level) const {
+    if (!isSignificant()) return NAN;
+    float seconds = (level - current) / slope;
+    return seconds >= 0.0f ? seconds : NAN;
+}
+
+float MoistureTrend::project(float moisture, unsigned long ahead) const {
+    if (!isSignificant()) return moisture;
+    return moisture + slope * (ahead / 1000.0f);
+}
@@ -0,0 +1,48 @@
+#include "utils/RunningStats.h"
+
+RunningStats::RunningStats() {
+    reset();
+}
+
+void RunningStats::add(float value) {
+    if (count == 0) {
+        minValue = value;
+        maxValue = value;
+    } else {
+        if (value < minValue) minValue = value;
+        if (value > maxValue) maxValue = value;
+    }
+    
+    count++;
+    float delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+void RunningStats::reset() {
+    count = 0;
+    minValue = 0.0f;
+    maxValue = 0.0f;
+    mean = 0.0f;
+    m2 = 0.0f;
+}
+
+uint32_t RunningStats::getCount() const {
+    return count;
+}
+
+float RunningStats::getMin() const {
+    return minValue;
+}
+
+float RunningStats::getMax() const {
+    return maxValue;
+}
+
+float RunningStats::getMean() const {
+    return mean;
+}
+
+float RunningStats::getVariance() const {
+    return count > 1 ? m2 / (count - 1) : 0.0f;
+}
@@ -0,0 +1,152 @@
+#include "utils/SampleClock.h"
+#include "utils/SensorCalibration.h"
+#include <esp_sntp.h>
+#include <sys/time.h>
+#include <time.h>
+
+SampleClock* SampleClock::instance = nullptr;
+portMUX_TYPE SampleClock::syncLock = portMUX_INITIALIZER_UNLOCKED;
+
+SampleClock::SampleClock() {
+    wakeTimer = nullptr;
+    loopTask = nullptr;
+    syncPending = false;
+    pendingMono = 0;
+    pendingUnix = 0;
+    synced = false;
+    syncMono = 0;
+    syncUnix = 0;
+    driftPpm = 0.0f;
+    lastCorrectionMs = 0;
+    syncCount = 0;
+}
+
+void SampleClock::begin() {
+    instance = this;
+    loopTask = xTaskGetCurrentTaskHandle();
+
+    esp_timer_create_args_t args = {};
+    args.callback = onWake;
+    args.arg = loopTask;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "sample_wake";
+    if (esp_timer_create(&args, &wakeTimer) != ESP_OK) {
+        wakeTimer = nullptr;
+        Serial.println("Sample clock: no wake timer, idle waits round to the tick");
+    }
+
+    // Smooth mode slews small corrections so time() never runs backwards; the interval
+    // must be set before configTime() starts the client
+    sntp_set_time_sync_notification_cb(onSync);
+    sntp_set_sync_interval(Timing::NTP_SYNC_INTERVAL);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    configTime(0, 0, Timing::NTP_SERVER);
+
+    Serial.printf("Sample clock: SNTP from %s every %lu s\n", Timing::NTP_SERVER,
+                  (unsigned long)(Timing::NTP_SYNC_INTERVAL / 1000));
+}
+
+void SampleClock::onSync(struct timeval* tv) {
+    int64_t mono = esp_timer_get_time();
+    SampleClock* clock = instance;
+    if (!clock || !tv) return;
+
+    portENTER_CRITICAL(&syncLock);
+    clock->pendingMono = mono;
+    clock->pendingUnix = static_cast<int64_t>(tv->tv_sec) * 1000000 + tv->tv_usec;
+    clock->syncPending = true;
+    portEXIT_CRITICAL(&syncLock);
+}
+
+void SampleClock::onWake(void* arg) {
+    xTaskNotifyGive(static_cast<TaskHandle_t>(arg));
+}
+
+void SampleClock::loop() {
+    if (!syncPending) return;
+
+    portENTER_CRITICAL(&syncLock);
+    int64_t mono = pendingMono;
+    int64_t unixMicros = pendingUnix;
+    syncPending = false;
+    portEXIT_CRITICAL(&syncLock);
+
+    applySync(mono, unixMicros);
+}
+
+void SampleClock::applySync(int64_t mono, int64_t unixMicros) {
+    if (synced) {
+        int64_t interval = mono - syncMono;
+        int64_t error = unixMicros - static_cast<int64_t>(unixMillis(mono)) * 1000;
+        lastCorrectionMs = static_cast<int32_t>(error / 1000);
+
+        // A correction over a second means the server stepped the time, not that the crystal drifted
+        if (interval >= MIN_DRIFT_INTERVAL && error > -1000000 && error < 1000000) {
+            float measured = static_cast<float>(error) * 1e6f / static_cast<float>(interval);
+            driftPpm = constrain(driftPpm + measured / 2, -static_cast<float>(MAX_DRIFT_PPM),
+                                 static_cast<float>(MAX_DRIFT_PPM));
+        }
+    }
+
+    syncMono = mono;
+    syncUnix = unixMicros;
+    synced = true;
+    syncCount++;
+
+    Serial.printf("Sample clock: SNTP sync #%u, correction %ld ms, drift %.1f ppm\n", syncCount,
+                  (long)lastCorrectionMs, driftPpm);
+}
+
+uint64_t SampleClock::unixMillis(int64_t monoMicros) const {
+    if (synced) {
+        int64_t elapsed = monoMicros - syncMono;
+        int64_t corrected = elapsed + static_cast<int64_t>(static_cast<double>(elapsed) * driftPpm / 1e6);
+        return static_cast<uint64_t>((syncUnix + corrected) / 1000);
+    }
+
+    // Not synced since boot, but the RTC may have kept the time across a soft reset
+    if (!isWallClockSet()) return 0;
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t nowUnix = static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_usec;
+    return static_cast<uint64_t>((nowUnix - (monotonicMicros() - monoMicros)) / 1000);
+}
+
+void SampleClock::sleepUntil(unsigned long dueMillis, unsigned long maxWait) {
+    long wait = static_cast<long>(dueMillis - millis());
+    if (wait <= 0) return;
+
+    // A notification (the timer, or an event posted to the bus) ends the wait early
+    bool timed = wakeTimer && wait < static_cast<long>(maxWait);
+    if (timed) {
+        // The timer fires on the due millisecond; the tick timeout alone would round to a tick
+        uint64_t remaining = static_cast<uint64_t>(wait) * 1000 - esp_timer_get_time() % 1000;
+        esp_timer_start_once(wakeTimer, remaining);
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timed ? wait : static_cast<long>(maxWait)));
+    if (timed) esp_timer_stop(wakeTimer);
+}
+
+void SampleClock::serialize(JsonDocument& doc) const {
+    JsonObject clock = doc["clock"].to<JsonObject>();
+    clock["synced"] = synced;
+    clock["syncs"] = syncCount;
+    clock["driftPpm"] = roundf(driftPpm * 10) / 10;
+    clock["correctionMs"] = lastCorrectionMs;
+    if (synced) {
+        clock["sinceSyncS"] = static_cast<uint32_t>((monotonicMicros() - syncMono) / 1000000);
+    }
+}
+
+void SampleClock::printDebugInfo() const {
+    Serial.println("=== SAMPLE CLOCK ===");
+    if (synced) {
+        Serial.printf("  Synced %u time(s), last %lu s ago, correction %ld ms\n", syncCount,
+                      (unsigned long)((monotonicMicros() - syncMono) / 1000000), (long)lastCorrectionMs);
+    } else {
+        Serial.println("  Not synced yet");
+    }
+    Serial.printf("  Drift: %.1f ppm\n", driftPpm);
+    Serial.println("====================");
+}
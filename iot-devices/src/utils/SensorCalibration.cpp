@@ -5,20 +5,18 @@ namespace SoilMoistureCalibration {
     const int DRY_VALUE = 2945;    // 0% moisture (completely dry)
     const int WET_VALUE = 1390;    // 100% moisture (completely wet)
     
+    // Default curve: 2945 (dry) = 0% moisture, 1390 (wet) = 100% moisture
+    // Lower values = more wet, Higher values = more dry
+    constexpr CalibrationPoint DEFAULT_POINTS[] = {
+        {static_cast<uint16_t>(WET_VALUE), 100},
+        {static_cast<uint16_t>(DRY_VALUE), 0}
+    };
+    constexpr CalibrationTable::Table DEFAULT_TABLE = CalibrationTable::build(DEFAULT_POINTS);
+    
+    CalibrationCurve curve("soilMoisture", DEFAULT_POINTS, sizeof(DEFAULT_POINTS) / sizeof(DEFAULT_POINTS[0]), DEFAULT_TABLE);
+    
     int convertToPercentage(int rawValue) {
-        // Convert raw soil moisture value to percentage
-        // 4095 (dry) = 0% moisture, 1600 (wet) = 100% moisture
-        // Lower values = more wet, Higher values = more dry
-        
-        // Handle extreme cases
-        if (rawValue >= DRY_VALUE) return 0;    // Completely dry (0% moisture)
-        if (rawValue <= WET_VALUE) return 100;  // Completely wet (100% moisture)
-        
-        // Map the value between dry and wet points: 4095->0%, 1600->100%
-        // Formula: percentage = 100 * (DRY_VALUE - rawValue) / (DRY_VALUE - WET_VALUE)
-        int percentage = 100 * (DRY_VALUE - rawValue) / (DRY_VALUE - WET_VALUE);
-        
-        return percentage;
+        return curve.convert(rawValue);
     }
 }
 
@@ -27,23 +25,80 @@ namespace WaterLevelCalibration {
     const int LOW_THRESHOLD = 350;     // Below this = Low
     const int MEDIUM_THRESHOLD = 400;  // Below this = Medium, above = High
     
-    String determineStatus(int rawValue) {
+    int lowThreshold = LOW_THRESHOLD;
+    int mediumThreshold = MEDIUM_THRESHOLD;
+    
+    constexpr CalibrationPoint DEFAULT_POINTS[] = {
+        {static_cast<uint16_t>(DRY_VALUE), 0},
+        {static_cast<uint16_t>(WET_VALUE), 100}
+    };
+    constexpr CalibrationTable::Table DEFAULT_TABLE = CalibrationTable::build(DEFAULT_POINTS);
+    
+    CalibrationCurve curve("waterLevel", DEFAULT_POINTS, sizeof(DEFAULT_POINTS) / sizeof(DEFAULT_POINTS[0]), DEFAULT_TABLE);
+    
+    int convertToPercentage(int rawValue) {
+        return curve.convert(rawValue);
+    }
+    
+    void setThresholds(int low, int medium) {
+        lowThreshold = low;
+        mediumThreshold = medium;
+    }
+    
+    int getLowThreshold() {
+        return lowThreshold;
+    }
+    
+    int getMediumThreshold() {
+        return mediumThreshold;
+    }
+    
+    Level determineLevel(int rawValue) {
         // Determine water level status based on raw value
-        if (rawValue < LOW_THRESHOLD) {
-            return "Low";
-        } else if (rawValue < MEDIUM_THRESHOLD) {
-            return "Medium";
+        if (rawValue < lowThreshold) {
+            return LEVEL_LOW;
+        } else if (rawValue < mediumThreshold) {
+            return LEVEL_MEDIUM;
         } else {
-            return "High";
+            return LEVEL_HIGH;
+        }
+    }
+    
+    const char* levelName(Level level) {
+        switch (level) {
+            case LEVEL_LOW: return "Low";
+            case LEVEL_MEDIUM: return "Medium";
+            default: return "High";
         }
     }
+    
+    String determineStatus(int rawValue) {
+        return levelName(determineLevel(rawValue));
+    }
 }
 
 // Validation utility functions
 namespace CalibrationUtils {
     
+    void loadCalibrationCurves() {
+        CalibrationCurve* curves[] = {&SoilMoistureCalibration::curve, &WaterLevelCalibration::curve};
+        for (CalibrationCurve* curve : curves) {
+            if (curve->loadFromNVS()) {
+                Serial.printf("Loaded custom calibration curve '%s' from NVS\n", curve->getName());
+            }
+        }
+    }
+    
+    CalibrationCurve* findCurve(const char* name) {
+        if (strcmp(name, SoilMoistureCalibration::curve.getName()) == 0) return &SoilMoistureCalibration::curve;
+        if (strcmp(name, WaterLevelCalibration::curve.getName()) == 0) return &WaterLevelCalibration::curve;
+        return nullptr;
+    }
+    
     bool validateSoilMoistureReading(int rawValue) {
-        return (rawValue >= 0 && rawValue <= 4095);
+        // The capacitive probe never reaches the ADC rails: 4095 is an open
+        // (unplugged) signal line, 0 a short to ground
+        return (rawValue > 0 && rawValue < 4095);
     }
     
     bool validateWaterLevelReading(int rawValue) {
@@ -76,6 +131,7 @@ namespace CalibrationUtils {
         Serial.println("Soil Moisture Calibration:");
         Serial.printf("  Dry Value (0%% moisture): %d\n", SoilMoistureCalibration::DRY_VALUE);
         Serial.printf("  Wet Value (100%% moisture): %d\n", SoilMoistureCalibration::WET_VALUE);
+        SoilMoistureCalibration::curve.printDebugInfo();
         Serial.println("DS18B20 Soil Temperature Configuration:");
         Serial.printf("  Resolution: %d-bit (0.0625°C precision)\n", DS18B20Config::RESOLUTION_BITS);
         Serial.printf("  Conversion Time: %lu ms\n", DS18B20Config::CONVERSION_TIME);
@@ -83,10 +139,15 @@ namespace CalibrationUtils {
         Serial.printf("  Dry Value: %d\n", WaterLevelCalibration::DRY_VALUE);
         Serial.printf("  Wet Value: %d\n", WaterLevelCalibration::WET_VALUE);
         Serial.printf("  Sensor Height: %d cm\n", WaterLevelCalibration::SENSOR_HEIGHT_CM);
-        Serial.printf("  Low Threshold: %d\n", WaterLevelCalibration::LOW_THRESHOLD);
-        Serial.printf("  Medium Threshold: %d\n", WaterLevelCalibration::MEDIUM_THRESHOLD);
+        WaterLevelCalibration::curve.printDebugInfo();
+        Serial.printf("  Low Threshold: %d\n", WaterLevelCalibration::getLowThreshold());
+        Serial.printf("  Medium Threshold: %d\n", WaterLevelCalibration::getMediumThreshold());
         Serial.println("Relay Control Thresholds:");
-        Serial.printf("  Soil Moisture Threshold: %d%%\n", RelayThresholds::SOIL_MOISTURE_THRESHOLD);
+        Serial.printf("  Soil Moisture Threshold: %d%% (ON) / %d%% (OFF)\n", 
+                      RelayThresholds::SOIL_MOISTURE_THRESHOLD, RelayThresholds::SOIL_MOISTURE_OFF_THRESHOLD);
+        Serial.printf("  Minimum ON/OFF Time: %lu ms / %lu ms\n", RelayThresholds::MIN_ON_TIME, RelayThresholds::MIN_OFF_TIME);
+        Serial.printf("  Inhibit on Rain: %s, Inhibit on Low Water: %s\n", 
+                      RelayThresholds::INHIBIT_ON_RAIN ? "yes" : "no", RelayThresholds::INHIBIT_ON_LOW_WATER ? "yes" : "no");
         Serial.println("Timing Configuration:");
         Serial.printf("  Sensor Reading Interval: %lu ms\n", Timing::SENSOR_INTERVAL);
         Serial.printf("  Data Send Interval: %lu ms\n", Timing::SEND_INTERVAL);
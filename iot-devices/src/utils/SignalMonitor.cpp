@@ -0,0 +1,114 @@
+#include "utils/SignalMonitor.h"
+
+SignalMonitor::SignalMonitor(const SignalLimits* limits) : limits(limits) {
+    started = false;
+    verdict = OK;
+    estimate = 0.0f;
+    variance = 0.0f;
+    accepted = 0.0f;
+    acceptedAt = 0;
+    previous = 0.0f;
+    unchangedSince = 0;
+    unchangedSamples = 0;
+    shiftLevel = 0.0f;
+    shiftSamples = 0;
+    resetCounts();
+}
+
+void SignalMonitor::restart(float value, unsigned long now) {
+    estimate = value;
+    variance = limits->noise * limits->noise;
+    accepted = value;
+    acceptedAt = now;
+    shiftSamples = 0;
+    started = true;
+}
+
+SignalMonitor::Verdict SignalMonitor::add(float value, unsigned long now) {
+    if (!limits || isnan(value)) return verdict;
+
+    if (!started) {
+        restart(value, now);
+        previous = value;
+        unchangedSince = now;
+        unchangedSamples = 0;
+        return verdict = OK;
+    }
+
+    // Stuck: the input repeats itself for longer than the field ever stays still
+    bool saturated = limits->low < limits->high && (value <= limits->low || value >= limits->high);
+    if (fabsf(value - previous) <= limits->resolution * 0.5f && !saturated) {
+        if (unchangedSamples < UINT16_MAX) unchangedSamples++;
+    } else {
+        unchangedSamples = 0;
+        unchangedSince = now;
+    }
+    previous = value;
+    bool stuck = limits->stuckTime > 0 && unchangedSamples >= Anomaly::STUCK_MIN_SAMPLES &&
+                 now - unchangedSince >= limits->stuckTime;
+
+    // Both gates widen with the time since the last accepted reading
+    float seconds = (now - acceptedAt) / 1000.0f;
+    Verdict result = OK;
+    if (limits->maxRate > 0 && fabsf(value - accepted) > limits->maxRate * seconds + limits->resolution) {
+        result = RATE;
+    }
+
+    float predicted = variance + limits->drift * limits->drift * seconds;
+    float spread = predicted + limits->noise * limits->noise;
+    float innovation = value - estimate;
+    if (result == OK && limits->noise > 0 && fabsf(innovation) > limits->resolution &&
+        innovation * innovation > Anomaly::OUTLIER_SIGMA * Anomaly::OUTLIER_SIGMA * spread) {
+        result = OUTLIER;
+    }
+
+    if (result != OK) {
+        // Rejected readings that keep agreeing with each other are a real step, e.g. a probe moved
+        float tolerance = Anomaly::OUTLIER_SIGMA * limits->noise + limits->resolution;
+        if (shiftSamples > 0 && fabsf(value - shiftLevel) <= tolerance) {
+            shiftSamples++;
+        } else {
+            shiftLevel = value;
+            shiftSamples = 1;
+        }
+        if (shiftSamples < Anomaly::LEVEL_SHIFT_SAMPLES) {
+            counts[result]++;
+            return verdict = result;
+        }
+        restart(value, now);
+        result = OK;
+    } else {
+        shiftSamples = 0;
+        float gain = spread > 0 ? predicted / spread : 1.0f;
+        estimate += gain * innovation;
+        variance = (1.0f - gain) * predicted;
+        accepted = value;
+        acceptedAt = now;
+    }
+
+    if (stuck) {
+        result = STUCK;
+        counts[STUCK]++;
+    }
+    return verdict = result;
+}
+
+bool SignalMonitor::hasCounts() const {
+    for (uint16_t count : counts) {
+        if (count) return true;
+    }
+    return false;
+}
+
+void SignalMonitor::resetCounts() {
+    memset(counts, 0, sizeof(counts));
+}
+
+const char* SignalMonitor::verdictName(Verdict verdict) {
+    switch (verdict) {
+        case STUCK: return "stuck";
+        case RATE: return "rate";
+        case OUTLIER: return "outlier";
+        default: return "ok";
+    }
+}
@@ -0,0 +1,278 @@
+// Host tests of the streaming firmware delta decoder: pio test -e native_test
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "ota/DeltaPatch.h"
+
+namespace {
+    const size_t SECTOR = 128;           // Small, so a patch crosses many flushes
+
+    // Collects the image like FirmwareUpdater does: a sector buffer, flushed when full,
+    // with the decoder state checkpointed at every flush
+    class SectorSink : public DeltaPatch::Sink {
+    public:
+        struct Checkpoint {
+            DeltaPatch::State state;
+            size_t flushed;
+        };
+
+        const std::vector<uint8_t>& source;
+        const DeltaPatch* patch;
+        std::vector<uint8_t> flushed;
+        std::vector<Checkpoint> checkpoints;
+        uint8_t sector[SECTOR];
+        size_t buffered;
+
+        explicit SectorSink(const std::vector<uint8_t>& runningImage) : source(runningImage) {
+            patch = nullptr;
+            buffered = 0;
+        }
+
+        size_t room() override {
+            return SECTOR - buffered;
+        }
+
+        bool write(const uint8_t* data, size_t length) override {
+            if (length > room()) return false;
+            memcpy(sector + buffered, data, length);
+            buffered += length;
+            if (buffered == SECTOR) flush();
+            return true;
+        }
+
+        bool readSource(uint32_t offset, uint8_t* buffer, size_t length) override {
+            if (offset + length > source.size()) return false;
+            memcpy(buffer, source.data() + offset, length);
+            return true;
+        }
+
+        void flush() {
+            flushed.insert(flushed.end(), sector, sector + buffered);
+            buffered = 0;
+            checkpoints.push_back({patch->getState(), flushed.size()});
+        }
+    };
+
+    std::vector<uint8_t> source;
+    std::vector<uint8_t> target;
+    std::vector<uint8_t> delta;
+
+    void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void putHeader(std::vector<uint8_t>& out, uint32_t imageSize) {
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(DeltaPatch::MAGIC >> (8 * i)));
+        putVarint(out, imageSize);
+    }
+
+    void putCopy(std::vector<uint8_t>& out, uint32_t offset, uint32_t length) {
+        out.push_back(DeltaPatch::OP_COPY);
+        putVarint(out, offset);
+        putVarint(out, length);
+        target.insert(target.end(), source.begin() + offset, source.begin() + offset + length);
+    }
+
+    void putInsert(std::vector<uint8_t>& out, const std::vector<uint8_t>& bytes) {
+        out.push_back(DeltaPatch::OP_INSERT);
+        putVarint(out, bytes.size());
+        out.insert(out.end(), bytes.begin(), bytes.end());
+        target.insert(target.end(), bytes.begin(), bytes.end());
+    }
+
+    std::vector<uint8_t> pattern(size_t length, uint32_t seed) {
+        std::vector<uint8_t> bytes(length);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            bytes[i] = static_cast<uint8_t>(seed >> 16);
+        }
+        return bytes;
+    }
+
+    // Feeds the input from offset in chunks of chunk bytes; DONE once the image is complete
+    DeltaPatch::Result feedChunks(DeltaPatch& patch, const std::vector<uint8_t>& input, size_t offset,
+                                  size_t chunk) {
+        DeltaPatch::Result result = DeltaPatch::OK;
+        while (offset < input.size()) {
+            size_t length = input.size() - offset < chunk ? input.size() - offset : chunk;
+            result = patch.feed(input.data() + offset, length);
+            offset += length;
+            if (result != DeltaPatch::OK) break;
+        }
+        return result;
+    }
+
+    DeltaPatch::Result apply(SectorSink& sink, const std::vector<uint8_t>& input, size_t chunk) {
+        DeltaPatch patch;
+        sink.patch = &patch;
+        patch.begin(sink, false, target.size(), source.size());
+        DeltaPatch::Result result = feedChunks(patch, input, 0, chunk);
+        if (result == DeltaPatch::DONE) sink.flush();
+        return result;
+    }
+}
+
+void setUp() {
+    // A running image, and a delta mixing copies (some of them long, some overlapping
+    // sector boundaries) with inserts, including empty ones
+    source = pattern(3000, 1);
+    target.clear();
+    std::vector<uint8_t> ops;
+    putCopy(ops, 100, 700);
+    putInsert(ops, pattern(50, 2));
+    putCopy(ops, 0, 900);
+    putInsert(ops, pattern(300, 3));
+    putCopy(ops, 2999, 1);
+    putInsert(ops, std::vector<uint8_t>());
+    putCopy(ops, 2000, 1000);
+    putInsert(ops, pattern(1, 4));
+
+    delta.clear();
+    putHeader(delta, target.size());
+    delta.insert(delta.end(), ops.begin(), ops.end());
+    delta.push_back(DeltaPatch::OP_END);
+}
+
+void tearDown() {
+}
+
+void test_applies_delta_in_one_feed() {
+    SectorSink sink(source);
+    TEST_ASSERT_EQUAL(DeltaPatch::DONE, apply(sink, delta, delta.size()));
+    TEST_ASSERT_EQUAL_size_t(target.size(), sink.flushed.size());
+    TEST_ASSERT_EQUAL_MEMORY(target.data(), sink.flushed.data(), target.size());
+}
+
+void test_applies_delta_split_at_any_boundary() {
+    const size_t CHUNKS[] = {1, 2, 3, 5, 7, 13, 64, 127, 128, 129, 1000};
+    for (size_t chunk : CHUNKS) {
+        SectorSink sink(source);
+        TEST_ASSERT_EQUAL(DeltaPatch::DONE, apply(sink, delta, chunk));
+        TEST_ASSERT_EQUAL_size_t(target.size(), sink.flushed.size());
+        TEST_ASSERT_EQUAL_MEMORY(target.data(), sink.flushed.data(), target.size());
+    }
+
+    // Every single split point of a two-piece feed, which cuts each varint and opcode once
+    for (size_t split = 1; split < delta.size(); split++) {
+        SectorSink sink(source);
+        DeltaPatch patch;
+        sink.patch = &patch;
+        patch.begin(sink, false, target.size(), source.size());
+        TEST_ASSERT_EQUAL(DeltaPatch::OK, patch.feed(delta.data(), split));
+        TEST_ASSERT_EQUAL(DeltaPatch::DONE, patch.feed(delta.data() + split, delta.size() - split));
+        sink.flush();
+        TEST_ASSERT_EQUAL_MEMORY(target.data(), sink.flushed.data(), target.size());
+    }
+}
+
+void test_checkpoint_describes_flushed_output() {
+    SectorSink sink(source);
+    TEST_ASSERT_EQUAL(DeltaPatch::DONE, apply(sink, delta, 37));
+    TEST_ASSERT_TRUE(sink.checkpoints.size() > target.size() / SECTOR);
+    for (const SectorSink::Checkpoint& checkpoint : sink.checkpoints) {
+        TEST_ASSERT_EQUAL_UINT32(checkpoint.flushed, checkpoint.state.produced);
+    }
+}
+
+void test_resumes_from_every_checkpoint() {
+    SectorSink first(source);
+    TEST_ASSERT_EQUAL(DeltaPatch::DONE, apply(first, delta, 37));
+
+    // A reset after any flush: the unflushed sector is gone, the input is fetched again
+    // from the checkpointed offset, in differently sized chunks
+    for (const SectorSink::Checkpoint& checkpoint : first.checkpoints) {
+        SectorSink sink(source);
+        sink.flushed.assign(first.flushed.begin(), first.flushed.begin() + checkpoint.flushed);
+
+        DeltaPatch patch;
+        sink.patch = &patch;
+        patch.resume(sink, checkpoint.state, source.size());
+        DeltaPatch::Result result = patch.isDone() ? DeltaPatch::DONE
+                                                   : feedChunks(patch, delta, checkpoint.state.consumed, 11);
+        TEST_ASSERT_EQUAL(DeltaPatch::DONE, result);
+        sink.flush();
+        TEST_ASSERT_EQUAL_size_t(target.size(), sink.flushed.size());
+        TEST_ASSERT_EQUAL_MEMORY(target.data(), sink.flushed.data(), target.size());
+    }
+}
+
+void test_raw_image_goes_through_the_same_decoder() {
+    std::vector<uint8_t> image = pattern(1000, 5);
+    for (size_t chunk : {size_t(1), size_t(100), size_t(1000)}) {
+        SectorSink sink(source);
+        DeltaPatch patch;
+        sink.patch = &patch;
+        patch.begin(sink, true, image.size(), 0);
+        TEST_ASSERT_EQUAL(DeltaPatch::DONE, feedChunks(patch, image, 0, chunk));
+        sink.flush();
+        TEST_ASSERT_EQUAL_size_t(image.size(), sink.flushed.size());
+        TEST_ASSERT_EQUAL_MEMORY(image.data(), sink.flushed.data(), image.size());
+    }
+}
+
+void test_rejects_malformed_deltas() {
+    SectorSink sink(source);
+
+    std::vector<uint8_t> input = delta;
+    input[0] ^= 1;
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_FORMAT, apply(sink, input, input.size()));
+
+    // Data after the end marker
+    input = delta;
+    input.push_back(0);
+    TEST_ASSERT_EQUAL(DeltaPatch::TOO_LONG, apply(sink, input, input.size()));
+
+    // End marker before the image is complete
+    input.clear();
+    putHeader(input, 10);
+    input.push_back(DeltaPatch::OP_END);
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_FORMAT, apply(sink, input, input.size()));
+
+    // Unknown opcode
+    input.clear();
+    putHeader(input, 10);
+    input.push_back(0x03);
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_FORMAT, apply(sink, input, input.size()));
+
+    // Varint over 32 bits
+    input.clear();
+    putHeader(input, 10);
+    input.push_back(DeltaPatch::OP_INSERT);
+    input.insert(input.end(), {0xFF, 0xFF, 0xFF, 0xFF, 0x7F});
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_FORMAT, apply(sink, input, input.size()));
+
+    // Insert longer than the image
+    input.clear();
+    putHeader(input, 10);
+    input.push_back(DeltaPatch::OP_INSERT);
+    putVarint(input, 11);
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_FORMAT, apply(sink, input, input.size()));
+}
+
+void test_rejects_copy_outside_running_image() {
+    SectorSink sink(source);
+    std::vector<uint8_t> input;
+    putHeader(input, 10);
+    input.push_back(DeltaPatch::OP_COPY);
+    putVarint(input, source.size() - 5);
+    putVarint(input, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::BAD_SOURCE, apply(sink, input, 1));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_applies_delta_in_one_feed);
+    RUN_TEST(test_applies_delta_split_at_any_boundary);
+    RUN_TEST(test_checkpoint_describes_flushed_output);
+    RUN_TEST(test_resumes_from_every_checkpoint);
+    RUN_TEST(test_raw_image_goes_through_the_same_decoder);
+    RUN_TEST(test_rejects_malformed_deltas);
+    RUN_TEST(test_rejects_copy_outside_running_image);
+    return UNITY_END();
+}
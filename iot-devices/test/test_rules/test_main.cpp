@@ -0,0 +1,236 @@
+// Host tests of the rule compiler and the bytecode verifier: pio test -e native_test
+#include <unity.h>
+#include "rules/RuleCompiler.h"
+#include "rules/RuleProgram.h"
+
+using namespace RuleOps;
+
+namespace {
+    const char* const VARIABLES[] = {"rain", "level", "hour", "moisture", "valve"};
+    const uint8_t VARIABLE_COUNT = sizeof(VARIABLES) / sizeof(VARIABLES[0]);
+    const uint8_t FIRST_ZONE_VARIABLE = 3;
+
+    RuleProgram program;
+
+    bool compile(const char* condition, uint8_t zone = 0) {
+        RuleCompiler compiler(program, VARIABLES, VARIABLE_COUNT, FIRST_ZONE_VARIABLE);
+        return compiler.addRule("test", condition, RuleProgram::ACTION_INHIBIT, zone);
+    }
+
+    // Runs the rule the way RuleEngine does, on a verified program
+    float evaluate(const RuleProgram::Rule& rule, const float* values) {
+        float stack[RuleProgram::MAX_STACK];
+        uint8_t sp = 0;
+        uint8_t end = rule.codeStart + rule.codeLength;
+        for (uint8_t pc = rule.codeStart; pc < end; pc++) {
+            switch (program.code[pc]) {
+                case OP_CONST: stack[sp++] = program.constants[program.code[++pc]]; break;
+                case OP_LOAD:  stack[sp++] = values[program.code[++pc]]; break;
+                case OP_NOT:   stack[sp - 1] = stack[sp - 1] == 0; break;
+                case OP_NEG:   stack[sp - 1] = -stack[sp - 1]; break;
+                case OP_AND:   sp--; stack[sp - 1] = stack[sp - 1] != 0 && stack[sp] != 0; break;
+                case OP_OR:    sp--; stack[sp - 1] = stack[sp - 1] != 0 || stack[sp] != 0; break;
+                case OP_ADD:   sp--; stack[sp - 1] = stack[sp - 1] + stack[sp]; break;
+                case OP_SUB:   sp--; stack[sp - 1] = stack[sp - 1] - stack[sp]; break;
+                case OP_MUL:   sp--; stack[sp - 1] = stack[sp - 1] * stack[sp]; break;
+                case OP_DIV:   sp--; stack[sp - 1] = stack[sp - 1] / stack[sp]; break;
+                case OP_LT:    sp--; stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+                case OP_LE:    sp--; stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+                case OP_GT:    sp--; stack[sp - 1] = stack[sp - 1] > stack[sp]; break;
+                case OP_GE:    sp--; stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+                case OP_EQ:    sp--; stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+                case OP_NE:    sp--; stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+            }
+        }
+        return stack[0];
+    }
+
+    float evaluateLast(const float* values) {
+        return evaluate(program.rules[program.ruleCount - 1], values);
+    }
+
+    void assertCode(const uint8_t* expected, uint8_t length) {
+        const RuleProgram::Rule& rule = program.rules[program.ruleCount - 1];
+        TEST_ASSERT_EQUAL_UINT8(length, rule.codeLength);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, program.code + rule.codeStart, length);
+    }
+}
+
+void setUp() {
+    program.clear();
+}
+
+void tearDown() {
+}
+
+void test_compiled_program_verifies() {
+    TEST_ASSERT_TRUE(compile("rain || level == Low"));
+    TEST_ASSERT_TRUE(compile("!(hour >= 6 && hour < 20)"));
+    TEST_ASSERT_TRUE(compile("moisture < 25 && -hour + 3 * 2 != 0", 1));
+    TEST_ASSERT_EQUAL_UINT8(3, program.ruleCount);
+    TEST_ASSERT_TRUE(program.verify(VARIABLE_COUNT));
+
+    // Zone variables mark the rule for per-zone evaluation
+    TEST_ASSERT_FALSE(program.rules[1].usesZoneVariables);
+    TEST_ASSERT_TRUE(program.rules[2].usesZoneVariables);
+}
+
+void test_product_binds_tighter_than_sum() {
+    TEST_ASSERT_TRUE(compile("hour + level * 2"));
+    const uint8_t expected[] = {OP_LOAD, 2, OP_LOAD, 1, OP_CONST, 0, OP_MUL, OP_ADD};
+    assertCode(expected, sizeof(expected));
+
+    const float values[VARIABLE_COUNT] = {0, 3, 4, 0, 0};
+    TEST_ASSERT_EQUAL_FLOAT(10, evaluateLast(values));
+}
+
+void test_sum_is_left_associative() {
+    TEST_ASSERT_TRUE(compile("hour - level - 1"));
+    const float values[VARIABLE_COUNT] = {0, 2, 10, 0, 0};
+    TEST_ASSERT_EQUAL_FLOAT(7, evaluateLast(values));
+}
+
+void test_and_binds_tighter_than_or() {
+    TEST_ASSERT_TRUE(compile("rain || level && hour"));
+    const uint8_t expected[] = {OP_LOAD, 0, OP_LOAD, 1, OP_LOAD, 2, OP_AND, OP_OR};
+    assertCode(expected, sizeof(expected));
+}
+
+void test_not_applies_to_the_comparison() {
+    TEST_ASSERT_TRUE(compile("!hour < 6"));
+    const uint8_t expected[] = {OP_LOAD, 2, OP_CONST, 0, OP_LT, OP_NOT};
+    assertCode(expected, sizeof(expected));
+}
+
+void test_parentheses_override_precedence() {
+    TEST_ASSERT_TRUE(compile("(hour + level) * 2"));
+    const uint8_t expected[] = {OP_LOAD, 2, OP_LOAD, 1, OP_ADD, OP_CONST, 0, OP_MUL};
+    assertCode(expected, sizeof(expected));
+}
+
+void test_less_than_and_less_or_equal_differ() {
+    TEST_ASSERT_TRUE(compile("hour < 6"));
+    TEST_ASSERT_EQUAL_UINT8(OP_LT, program.code[program.codeLength - 1]);
+    TEST_ASSERT_TRUE(compile("hour <= 6"));
+    TEST_ASSERT_EQUAL_UINT8(OP_LE, program.code[program.codeLength - 1]);
+    TEST_ASSERT_TRUE(compile("hour>=6"));
+    TEST_ASSERT_EQUAL_UINT8(OP_GE, program.code[program.codeLength - 1]);
+    TEST_ASSERT_TRUE(compile("hour!=6"));
+    TEST_ASSERT_EQUAL_UINT8(OP_NE, program.code[program.codeLength - 1]);
+    TEST_ASSERT_TRUE(program.verify(VARIABLE_COUNT));
+
+    const float values[VARIABLE_COUNT] = {0, 0, 6, 0, 0};
+    TEST_ASSERT_EQUAL_FLOAT(0, evaluate(program.rules[0], values));
+    TEST_ASSERT_EQUAL_FLOAT(1, evaluate(program.rules[1], values));
+}
+
+void test_constants_and_names_are_shared() {
+    TEST_ASSERT_TRUE(compile("level == Low || hour < 0"));
+    TEST_ASSERT_TRUE(compile("level != Low && !false"));
+    TEST_ASSERT_EQUAL_UINT8(1, program.constantCount);     // Low and false are both 0
+    TEST_ASSERT_EQUAL_FLOAT(0, program.constants[0]);
+}
+
+void test_rejects_bad_input_and_leaves_program_unchanged() {
+    TEST_ASSERT_TRUE(compile("rain"));
+    uint8_t codeLength = program.codeLength;
+
+    const char* const BAD[] = {"", "hour <", "hour < 6)", "(hour < 6", "sunny", "hour < < 6", "3 $ 4"};
+    for (const char* condition : BAD) {
+        TEST_ASSERT_FALSE_MESSAGE(compile(condition), condition);
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, program.ruleCount);
+    TEST_ASSERT_EQUAL_UINT8(codeLength, program.codeLength);
+    TEST_ASSERT_EQUAL_UINT8(0, program.constantCount);
+}
+
+void test_rejects_too_much_nesting() {
+    // Eight levels of parentheses compile, nine don't
+    TEST_ASSERT_TRUE(compile("((((((((rain))))))))"));
+    TEST_ASSERT_FALSE(compile("(((((((((rain)))))))))"));
+
+    RuleCompiler compiler(program, VARIABLES, VARIABLE_COUNT, FIRST_ZONE_VARIABLE);
+    TEST_ASSERT_FALSE(compiler.addRule("deep", "(((((((((rain)))))))))", RuleProgram::ACTION_INHIBIT, 0));
+    TEST_ASSERT_TRUE(compiler.getError().startsWith("too many parentheses"));
+}
+
+void test_rejects_too_deep_stack() {
+    // Right-nested operands keep every value on the stack until the innermost sum is done
+    TEST_ASSERT_TRUE(compile("hour+(hour+(hour+(hour+(hour+(hour+(hour+hour))))))"));
+    TEST_ASSERT_FALSE(compile("hour+(hour+(hour+(hour+(hour+(hour+(hour+(hour+hour)))))))"));
+}
+
+void test_rejects_too_long_condition() {
+    char condition[200];
+    memset(condition, ' ', sizeof(condition));
+    memcpy(condition, "rain", 4);
+    condition[120] = '\0';
+    TEST_ASSERT_TRUE(compile(condition));
+    condition[120] = ' ';
+    condition[121] = '\0';
+    TEST_ASSERT_FALSE(compile(condition));
+}
+
+void test_rejects_program_over_code_budget() {
+    // Each rule is 8 loads of 2 bytes and 7 adds; the code budget runs out before the rule limit
+    const char* condition = "hour+hour+hour+hour+hour+hour+hour+hour";
+    uint8_t compiled = 0;
+    while (compiled < RuleProgram::MAX_RULES && compile(condition)) compiled++;
+    TEST_ASSERT_EQUAL_UINT8(RuleProgram::MAX_CODE / 23, compiled);
+    TEST_ASSERT_TRUE(program.verify(VARIABLE_COUNT));
+}
+
+void test_verify_rejects_corrupted_code() {
+    TEST_ASSERT_TRUE(compile("hour < 6"));
+    TEST_ASSERT_TRUE(program.verify(VARIABLE_COUNT));
+
+    // A variable the layout doesn't have
+    TEST_ASSERT_FALSE(program.verify(2));
+
+    // An unknown opcode
+    RuleProgram saved = program;
+    program.code[program.codeLength - 1] = OP_COUNT;
+    TEST_ASSERT_FALSE(program.verify(VARIABLE_COUNT));
+
+    // A binary op short of an operand
+    program = saved;
+    program.code[0] = OP_NOT;
+    program.code[1] = OP_NOT;
+    TEST_ASSERT_FALSE(program.verify(VARIABLE_COUNT));
+
+    // A constant index past the table
+    program = saved;
+    program.constantCount = 0;
+    TEST_ASSERT_FALSE(program.verify(VARIABLE_COUNT));
+
+    // Two values left on the stack
+    program = saved;
+    program.code[program.codeLength - 1] = OP_NEG;
+    TEST_ASSERT_FALSE(program.verify(VARIABLE_COUNT));
+
+    // Code running past the program
+    program = saved;
+    program.rules[0].codeLength++;
+    TEST_ASSERT_FALSE(program.verify(VARIABLE_COUNT));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_compiled_program_verifies);
+    RUN_TEST(test_product_binds_tighter_than_sum);
+    RUN_TEST(test_sum_is_left_associative);
+    RUN_TEST(test_and_binds_tighter_than_or);
+    RUN_TEST(test_not_applies_to_the_comparison);
+    RUN_TEST(test_parentheses_override_precedence);
+    RUN_TEST(test_less_than_and_less_or_equal_differ);
+    RUN_TEST(test_constants_and_names_are_shared);
+    RUN_TEST(test_rejects_bad_input_and_leaves_program_unchanged);
+    RUN_TEST(test_rejects_too_much_nesting);
+    RUN_TEST(test_rejects_too_deep_stack);
+    RUN_TEST(test_rejects_too_long_condition);
+    RUN_TEST(test_rejects_program_over_code_budget);
+    RUN_TEST(test_verify_rejects_corrupted_code);
+    return UNITY_END();
+}
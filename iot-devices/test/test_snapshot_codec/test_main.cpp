@@ -0,0 +1,218 @@
+// Host tests of the snapshot time-series codec: pio test -e native_test
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "storage/SnapshotCodec.h"
+
+using namespace SnapshotCodec;
+
+namespace {
+    Schema schema;
+    std::vector<Sample> samples;
+    uint8_t buffer[4096];
+
+    void addField(const char* key, FieldType type) {
+        strncpy(schema.keys[schema.fieldCount], key, MAX_KEY_LENGTH);
+        schema.types[schema.fieldCount++] = type;
+    }
+
+    Sample makeSample(uint32_t timestamp, float temperature, float moisture, int32_t raw, bool rain, uint8_t level) {
+        Sample sample = {};
+        sample.timestamp = timestamp;
+        sample.values[0] = floatBits(temperature);
+        sample.values[1] = floatBits(moisture);
+        sample.values[2] = static_cast<uint32_t>(raw);
+        sample.values[3] = rain ? 1 : 0;
+        sample.values[4] = level;
+        return sample;
+    }
+
+    // Decodes the whole stream and checks it against the samples, bit for bit
+    void assertDecodes(const uint8_t* data, size_t length, const std::vector<Sample>& expected) {
+        Decoder decoder(data, length);
+        TEST_ASSERT_TRUE(decoder.readHeader());
+        TEST_ASSERT_EQUAL_UINT16(expected.size(), decoder.count());
+
+        const Schema& decoded = decoder.getSchema();
+        TEST_ASSERT_EQUAL_UINT8(schema.fieldCount, decoded.fieldCount);
+        for (uint8_t i = 0; i < schema.fieldCount; i++) {
+            TEST_ASSERT_EQUAL_UINT8(schema.types[i], decoded.types[i]);
+            TEST_ASSERT_EQUAL_STRING(schema.keys[i], decoded.keys[i]);
+        }
+
+        Sample sample;
+        for (const Sample& want : expected) {
+            TEST_ASSERT_TRUE(decoder.next(sample));
+            TEST_ASSERT_EQUAL_UINT32(want.timestamp, sample.timestamp);
+            for (uint8_t i = 0; i < schema.fieldCount; i++) {
+                TEST_ASSERT_EQUAL_HEX32(want.values[i], sample.values[i]);
+            }
+        }
+        TEST_ASSERT_FALSE(decoder.next(sample));
+    }
+
+    size_t encodeAll(Encoder& encoder) {
+        TEST_ASSERT_TRUE(encoder.begin(schema));
+        for (const Sample& sample : samples) {
+            TEST_ASSERT_TRUE(encoder.append(sample));
+        }
+        TEST_ASSERT_EQUAL_UINT16(samples.size(), encoder.count());
+        return encoder.size();
+    }
+}
+
+void setUp() {
+    memset(&schema, 0, sizeof(schema));
+    addField("temperature", FIELD_FLOAT);
+    addField("soilMoisture", FIELD_FLOAT);
+    addField("soilRaw", FIELD_INT);
+    addField("rain", FIELD_BOOL);
+    addField("waterLevel", FIELD_ENUM);
+
+    // A slow drift sampled every 30 s, with jitter, a missed sample and repeated values
+    samples.clear();
+    uint32_t timestamp = 1700000000;
+    for (int i = 0; i < 200; i++) {
+        timestamp += 30 + (i % 7 == 0 ? 1 : 0) + (i == 120 ? 30 : 0);
+        float temperature = 21.5f + 0.1f * (i / 10);
+        float moisture = 40.0f - 0.05f * i;
+        int32_t raw = 2100 + (i % 13) * 3 - i;
+        samples.push_back(makeSample(timestamp, temperature, moisture, raw, i >= 80 && i < 95, i < 150 ? 2 : 1));
+    }
+}
+
+void tearDown() {
+}
+
+void test_round_trips_a_sensor_trace() {
+    Encoder encoder(buffer, sizeof(buffer));
+    size_t size = encodeAll(encoder);
+    assertDecodes(buffer, size, samples);
+
+    // Steady values are what the codec is for: well under the raw struct size
+    TEST_ASSERT_TRUE(size < samples.size() * (4 + 4 * schema.fieldCount) / 4);
+}
+
+void test_round_trips_extreme_values() {
+    samples.clear();
+    samples.push_back(makeSample(0, 0.0f, -0.0f, 0, false, 0));
+    samples.push_back(makeSample(1, -273.15f, INFINITY, INT32_MAX, true, 255));
+    samples.push_back(makeSample(0xFFFFFFF0u, NAN, -INFINITY, INT32_MIN, false, 3));
+    samples.push_back(makeSample(0xFFFFFFF1u, 1e-38f, 3.4e38f, -1, true, 0));
+    samples.push_back(makeSample(0xFFFFFFF1u, 1e-38f, 3.4e38f, -1, true, 0));
+    samples.push_back(makeSample(7, 1.0f, 1.0000001f, 64, false, 1));
+
+    // Integer deltas right at each bucket edge
+    const int32_t DELTAS[] = {63, 64, -64, -65, 255, 256, -256, -257, 2047, 2048, -2048, -2049};
+    int32_t raw = 64;
+    for (int32_t delta : DELTAS) {
+        raw += delta;
+        samples.push_back(makeSample(8 + samples.size(), 1.0f, 1.0f, raw, false, 1));
+    }
+
+    Encoder encoder(buffer, sizeof(buffer));
+    size_t size = encodeAll(encoder);
+    assertDecodes(buffer, size, samples);
+}
+
+void test_round_trips_every_field_count() {
+    Schema full = schema;
+    for (uint8_t count = 0; count <= MAX_FIELDS; count++) {
+        memset(&schema, 0, sizeof(schema));
+        for (uint8_t i = 0; i < count; i++) {
+            char key[MAX_KEY_LENGTH + 1];
+            snprintf(key, sizeof(key), "field%u", i);
+            addField(key, full.types[i % full.fieldCount]);
+        }
+
+        std::vector<Sample> trace = samples;
+        for (Sample& sample : trace) {
+            for (uint8_t i = full.fieldCount; i < count; i++) sample.values[i] = sample.values[i % full.fieldCount];
+            for (uint8_t i = count; i < MAX_FIELDS; i++) sample.values[i] = 0;
+        }
+        samples.swap(trace);
+
+        Encoder encoder(buffer, sizeof(buffer));
+        size_t size = encodeAll(encoder);
+        assertDecodes(buffer, size, samples);
+        samples.swap(trace);
+    }
+}
+
+void test_full_buffer_keeps_the_stream_decodable() {
+    uint8_t small[96];
+    Encoder encoder(small, sizeof(small));
+    TEST_ASSERT_TRUE(encoder.begin(schema));
+
+    std::vector<Sample> accepted;
+    for (const Sample& sample : samples) {
+        if (!encoder.append(sample)) break;
+        accepted.push_back(sample);
+    }
+    TEST_ASSERT_TRUE(accepted.size() > 1);
+    TEST_ASSERT_TRUE(accepted.size() < samples.size());
+    TEST_ASSERT_TRUE(encoder.size() <= sizeof(small));
+
+    // The sample that didn't fit left no bits behind, and trying again changes nothing
+    TEST_ASSERT_FALSE(encoder.append(samples[accepted.size()]));
+    assertDecodes(small, encoder.size(), accepted);
+}
+
+void test_reset_keeps_the_header() {
+    Encoder encoder(buffer, sizeof(buffer));
+    encodeAll(encoder);
+
+    encoder.reset();
+    TEST_ASSERT_EQUAL_UINT16(0, encoder.count());
+    assertDecodes(buffer, encoder.size(), std::vector<Sample>());
+
+    // The next batch starts from a fresh state: first timestamp in full, no carried window
+    std::vector<Sample> second(samples.begin() + 50, samples.begin() + 120);
+    for (const Sample& sample : second) {
+        TEST_ASSERT_TRUE(encoder.append(sample));
+    }
+    assertDecodes(buffer, encoder.size(), second);
+}
+
+void test_rejects_bad_or_truncated_streams() {
+    Encoder encoder(buffer, sizeof(buffer));
+    size_t size = encodeAll(encoder);
+
+    uint8_t copy[sizeof(buffer)];
+    memcpy(copy, buffer, size);
+    copy[0] = 'X';
+    Decoder badMagic(copy, size);
+    TEST_ASSERT_FALSE(badMagic.readHeader());
+
+    memcpy(copy, buffer, size);
+    copy[2] = VERSION + 1;
+    Decoder badVersion(copy, size);
+    TEST_ASSERT_FALSE(badVersion.readHeader());
+
+    Decoder shortHeader(buffer, HEADER_FIXED_SIZE + 1);
+    TEST_ASSERT_FALSE(shortHeader.readHeader());
+
+    // A stream cut short decodes what is complete, then stops
+    Decoder truncated(buffer, size / 2);
+    TEST_ASSERT_TRUE(truncated.readHeader());
+    Sample sample;
+    uint16_t decoded = 0;
+    while (truncated.next(sample)) decoded++;
+    TEST_ASSERT_TRUE(decoded > 0);
+    TEST_ASSERT_TRUE(decoded < samples.size());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trips_a_sensor_trace);
+    RUN_TEST(test_round_trips_extreme_values);
+    RUN_TEST(test_round_trips_every_field_count);
+    RUN_TEST(test_full_buffer_keeps_the_stream_decodable);
+    RUN_TEST(test_reset_keeps_the_header);
+    RUN_TEST(test_rejects_bad_or_truncated_streams);
+    return UNITY_END();
+}
@@ -0,0 +1,321 @@
+// Host-side decoder and benchmark for SnapshotCodec.
+//
+//   codec_bench bench <trace.csv>...    encode/decode traces, verify, report size and speed
+//   codec_bench decode <batch.bin>      print a device batch (sf/<id>/batch payload) as CSV
+//   codec_bench generate <samples>      write a synthetic trace to stdout
+//
+// Traces are CSV with a header row; the first column is the Unix timestamp,
+// the rest are snapshot fields named as in the MQTT payload (see README.md).
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "storage/SnapshotCodec.h"
+
+using namespace SnapshotCodec;
+
+namespace {
+    const size_t DEVICE_BATCH_BYTES = 1024;     // SnapshotBatch capacity on the device
+    const size_t HISTORY_RECORD_BYTES = 24;     // TimeSeriesStore::Record
+    const char* LEVEL_NAMES[] = {"Low", "Medium", "High"};
+
+    struct Trace {
+        Schema schema;
+        std::vector<Sample> samples;
+    };
+
+    FieldType typeForKey(const std::string& key) {
+        if (key == "soilMoisture") return FIELD_INT;
+        if (key == "rainDetected") return FIELD_BOOL;
+        if (key == "waterLevel") return FIELD_ENUM;
+        return FIELD_FLOAT;
+    }
+
+    uint32_t parseValue(FieldType type, const std::string& text) {
+        switch (type) {
+            case FIELD_FLOAT:
+                return floatBits(strtof(text.c_str(), nullptr));
+            case FIELD_INT:
+                return static_cast<uint32_t>(strtol(text.c_str(), nullptr, 10));
+            case FIELD_BOOL:
+                return (text == "true" || text == "t" || text == "1") ? 1 : 0;
+            case FIELD_ENUM:
+                for (uint32_t i = 0; i < 3; i++) {
+                    if (text == LEVEL_NAMES[i]) return i;
+                }
+                return static_cast<uint32_t>(strtoul(text.c_str(), nullptr, 10));
+        }
+        return 0;
+    }
+
+    void formatValue(char* out, size_t size, const Schema& schema, uint8_t field, uint32_t value) {
+        switch (schema.types[field]) {
+            case FIELD_FLOAT:
+                snprintf(out, size, "%.9g", bitsToFloat(value));
+                break;
+            case FIELD_INT:
+                snprintf(out, size, "%d", static_cast<int32_t>(value));
+                break;
+            case FIELD_BOOL:
+                snprintf(out, size, "%s", value ? "true" : "false");
+                break;
+            case FIELD_ENUM:
+                if (strcmp(schema.keys[field], "waterLevel") == 0 && value < 3) {
+                    snprintf(out, size, "%s", LEVEL_NAMES[value]);
+                } else {
+                    snprintf(out, size, "%u", value);
+                }
+                break;
+        }
+    }
+
+    bool loadTrace(const char* path, Trace& trace) {
+        std::ifstream in(path);
+        if (!in) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+
+        std::string line;
+        if (!std::getline(in, line)) return false;
+
+        std::vector<std::string> columns;
+        std::stringstream header(line);
+        std::string column;
+        while (std::getline(header, column, ',')) columns.push_back(column);
+        if (columns.size() < 2 || columns.size() - 1 > MAX_FIELDS) {
+            fprintf(stderr, "%s: expected a timestamp column and 1-%u fields\n", path, MAX_FIELDS);
+            return false;
+        }
+
+        trace.schema = {};
+        for (size_t i = 1; i < columns.size(); i++) {
+            uint8_t field = trace.schema.fieldCount++;
+            strncpy(trace.schema.keys[field], columns[i].c_str(), MAX_KEY_LENGTH);
+            trace.schema.types[field] = typeForKey(columns[i]);
+        }
+
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            std::stringstream row(line);
+            std::string cell;
+            Sample sample = {};
+
+            std::getline(row, cell, ',');
+            sample.timestamp = static_cast<uint32_t>(strtoul(cell.c_str(), nullptr, 10));
+            for (uint8_t i = 0; i < trace.schema.fieldCount && std::getline(row, cell, ','); i++) {
+                sample.values[i] = parseValue(trace.schema.types[i], cell);
+            }
+            trace.samples.push_back(sample);
+        }
+        return !trace.samples.empty();
+    }
+
+    // Approximate size of the per-snapshot JSON publish the device sends today
+    size_t jsonSize(const Schema& schema, const Sample& sample) {
+        size_t bytes = 2;
+        char value[32];
+        for (uint8_t i = 0; i < schema.fieldCount; i++) {
+            formatValue(value, sizeof(value), schema, i, sample.values[i]);
+            bytes += strlen(schema.keys[i]) + strlen(value) + 4;
+            if (schema.types[i] == FIELD_ENUM) bytes += 2;   // Level is published as a quoted name
+        }
+        return bytes - 1;
+    }
+
+    // Encodes the trace into device-sized batches like SnapshotBatch; returns the total bytes
+    size_t encodeBatches(const Trace& trace, std::vector<std::vector<uint8_t>>& batches) {
+        std::vector<uint8_t> buffer(DEVICE_BATCH_BYTES);
+        Encoder encoder(buffer.data(), buffer.size());
+        encoder.begin(trace.schema);
+
+        size_t total = 0;
+        for (const Sample& sample : trace.samples) {
+            if (!encoder.append(sample)) {
+                batches.emplace_back(encoder.data(), encoder.data() + encoder.size());
+                total += encoder.size();
+                encoder.reset();
+                encoder.append(sample);
+            }
+        }
+        if (encoder.count() > 0) {
+            batches.emplace_back(encoder.data(), encoder.data() + encoder.size());
+            total += encoder.size();
+        }
+        return total;
+    }
+
+    bool verify(const Trace& trace, const std::vector<std::vector<uint8_t>>& batches) {
+        size_t index = 0;
+        for (const std::vector<uint8_t>& batch : batches) {
+            Decoder decoder(batch.data(), batch.size());
+            if (!decoder.readHeader()) return false;
+
+            Sample sample;
+            while (decoder.next(sample)) {
+                if (index >= trace.samples.size()) return false;
+                const Sample& expected = trace.samples[index++];
+                if (sample.timestamp != expected.timestamp) return false;
+                for (uint8_t i = 0; i < trace.schema.fieldCount; i++) {
+                    uint32_t want = expected.values[i];
+                    if (trace.schema.types[i] == FIELD_BOOL) want = want ? 1 : 0;
+                    if (sample.values[i] != want) return false;
+                }
+            }
+        }
+        return index == trace.samples.size();
+    }
+
+    template <typename Fn>
+    double nanosPerSample(size_t samples, Fn fn) {
+        using Clock = std::chrono::steady_clock;
+        size_t rounds = 0;
+        Clock::time_point start = Clock::now();
+        Clock::duration elapsed;
+        do {
+            fn();
+            rounds++;
+            elapsed = Clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(200));
+
+        double nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+        return nanos / (static_cast<double>(rounds) * samples);
+    }
+
+    int bench(const char* path) {
+        Trace trace;
+        if (!loadTrace(path, trace)) {
+            fprintf(stderr, "%s: no samples\n", path);
+            return 1;
+        }
+
+        std::vector<std::vector<uint8_t>> batches;
+        size_t encoded = encodeBatches(trace, batches);
+        bool lossless = verify(trace, batches);
+
+        size_t samples = trace.samples.size();
+        size_t jsonBytes = 0;
+        for (const Sample& sample : trace.samples) jsonBytes += jsonSize(trace.schema, sample);
+        size_t structBytes = samples * (4 + 4 * trace.schema.fieldCount);
+        size_t recordBytes = samples * HISTORY_RECORD_BYTES;
+
+        double encodeNs = nanosPerSample(samples, [&]() {
+            std::vector<std::vector<uint8_t>> scratch;
+            encodeBatches(trace, scratch);
+        });
+        double decodeNs = nanosPerSample(samples, [&]() {
+            for (const std::vector<uint8_t>& batch : batches) {
+                Decoder decoder(batch.data(), batch.size());
+                decoder.readHeader();
+                Sample sample;
+                while (decoder.next(sample)) {}
+            }
+        });
+
+        printf("== %s ==\n", path);
+        printf("  samples           %zu (%u fields), %zu batches of <= %zu bytes\n",
+               samples, trace.schema.fieldCount, batches.size(), DEVICE_BATCH_BYTES);
+        printf("  encoded           %zu bytes, %.1f bits/sample (headers included)\n",
+               encoded, encoded * 8.0 / samples);
+        printf("  vs JSON publish   %zu bytes -> %.1fx smaller\n", jsonBytes, (double)jsonBytes / encoded);
+        printf("  vs raw struct     %zu bytes -> %.1fx smaller\n", structBytes, (double)structBytes / encoded);
+        printf("  vs history record %zu bytes -> %.1fx smaller\n", recordBytes, (double)recordBytes / encoded);
+        printf("  encode            %.0f ns/sample (host)\n", encodeNs);
+        printf("  decode            %.0f ns/sample (host)\n", decodeNs);
+        printf("  round trip        %s\n", lossless ? "lossless" : "MISMATCH");
+        return lossless ? 0 : 1;
+    }
+
+    int decode(const char* path) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        Decoder decoder(data.data(), data.size());
+        if (!decoder.readHeader()) {
+            fprintf(stderr, "%s: not a snapshot batch\n", path);
+            return 1;
+        }
+
+        const Schema& schema = decoder.getSchema();
+        printf("timestamp");
+        for (uint8_t i = 0; i < schema.fieldCount; i++) printf(",%s", schema.keys[i]);
+        printf("\n");
+
+        Sample sample;
+        uint16_t rows = 0;
+        char value[32];
+        while (decoder.next(sample)) {
+            printf("%u", sample.timestamp);
+            for (uint8_t i = 0; i < schema.fieldCount; i++) {
+                formatValue(value, sizeof(value), schema, i, sample.values[i]);
+                printf(",%s", value);
+            }
+            printf("\n");
+            rows++;
+        }
+        if (rows != decoder.count()) {
+            fprintf(stderr, "%s: truncated batch (%u of %u samples)\n", path, rows, decoder.count());
+            return 1;
+        }
+        return 0;
+    }
+
+    // Slow diurnal temperatures, DS18B20 0.0625 °C steps, stepwise soil drying
+    // with watering events, occasional rain, rare water level changes
+    int generate(long count) {
+        srand(42);
+        printf("timestamp,temperature,humidity,soilMoisture,soilTemperature,rainDetected,waterLevel\n");
+
+        uint32_t timestamp = 1735689600;
+        int soil = 45;
+        int level = 2;
+        bool rain = false;
+        for (long i = 0; i < count; i++) {
+            double hour = fmod(i * 300.0 / 3600.0, 24.0);
+            double diurnal = sin((hour - 9.0) / 24.0 * 2.0 * M_PI);
+            float temperature = roundf((27.0f + 5.0f * diurnal) * 10.0f) / 10.0f;
+            float humidity = roundf(70.0f - 15.0f * diurnal + (rand() % 3 - 1));
+            float soilTemperature = roundf((25.0f + 2.0f * diurnal) * 16.0f) / 16.0f;
+
+            if (rand() % 12 == 0) soil--;
+            if (soil < 10) soil = 45;
+            if (rand() % 200 == 0) rain = !rain;
+            if (rand() % 500 == 0) level = rand() % 3;
+
+            uint32_t jitter = (rand() % 20 == 0) ? 1 : 0;
+            printf("%u,%.1f,%.0f,%d,%.4f,%s,%s\n", timestamp + jitter, temperature, humidity, soil,
+                   soilTemperature, rain ? "true" : "false", LEVEL_NAMES[level]);
+            timestamp += 300;
+        }
+        return 0;
+    }
+
+    void usage() {
+        fprintf(stderr, "usage: codec_bench bench <trace.csv>... | decode <batch.bin> | generate <samples>\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+
+    if (strcmp(argv[1], "bench") == 0) {
+        int status = 0;
+        for (int i = 2; i < argc; i++) status |= bench(argv[i]);
+        return status;
+    }
+    if (strcmp(argv[1], "decode") == 0) return decode(argv[2]);
+    if (strcmp(argv[1], "generate") == 0) return generate(strtol(argv[2], nullptr, 10));
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,116 @@
+#include "FieldModel.h"
+#include <math.h>
+#include <DallasTemperature.h>
+#include "utils/SensorCalibration.h"
+
+namespace {
+    const float DRYING_PER_HOUR = 1.5f;          // Soil moisture lost per hour (evaporation at noon)
+    const float PUMP_WETTING_PER_HOUR = 60.0f;   // Soil moisture gained per hour of pumping
+    const float RAIN_WETTING_PER_HOUR = 8.0f;
+    const float TANK_DRAIN_PER_HOUR = 40.0f;
+    const float TANK_REFILL_PER_HOUR = 3.0f;
+    const double RAIN_STARTS_PER_HOUR = 0.02;
+    const double RAIN_STOPS_PER_HOUR = 1.5;
+    const int WATER_ADC_FULL = 800;              // Tank level -> ADC; 350/400 are the Low/Medium thresholds
+}
+
+FieldModel::FieldModel(uint32_t seed) : rng(seed) {
+    std::uniform_real_distribution<float> moisture(20.0f, 60.0f);
+    std::uniform_real_distribution<float> phase(-1.5f, 1.5f);
+    soilMoisture = moisture(rng);
+    tankLevel = 80.0f;
+    raining = false;
+    phaseHours = phase(rng);
+    lastUpdate = 0;
+    activeFault = FAULT_NONE;
+    faultUntil = 0;
+    stuckWaterValue = 0;
+    stuckSoilValue = 0;
+    outageUntil = 0;
+    faultsInjected = 0;
+    disconnectsInjected = 0;
+}
+
+bool FieldModel::chance(double probability) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+}
+
+void FieldModel::injectFault(unsigned long now) {
+    activeFault = static_cast<Fault>(std::uniform_int_distribution<int>(FAULT_DHT_READ, FAULT_COUNT - 1)(rng));
+    faultUntil = now + (activeFault == FAULT_SOIL_STUCK
+        ? 43200000UL : std::uniform_int_distribution<unsigned long>(60000, 600000)(rng));
+    faultsInjected++;
+}
+
+void FieldModel::update(HostBoard& board, unsigned long now, const FaultConfig& faults) {
+    if (lastUpdate == 0) lastUpdate = now;
+    float hours = (now - lastUpdate) / 3600000.0f;
+    lastUpdate = now;
+
+    bool pumping = board.digitalLevels[Pins::RELAY_PIN] == 0;    // Low-triggered relay
+    float hourOfDay = fmodf(now / 3600000.0f + 12.0f + phaseHours, 24.0f);
+    float sun = fmaxf(0.0f, sinf((hourOfDay - 6.0f) / 12.0f * static_cast<float>(M_PI)));
+
+    // Weather
+    if (raining ? chance(RAIN_STOPS_PER_HOUR * hours) : chance(RAIN_STARTS_PER_HOUR * hours)) {
+        raining = !raining;
+    }
+
+    // Soil and tank
+    soilMoisture -= DRYING_PER_HOUR * (0.2f + sun) * hours;
+    if (raining) soilMoisture += RAIN_WETTING_PER_HOUR * hours;
+    if (pumping && tankLevel > 0.0f) {
+        soilMoisture += PUMP_WETTING_PER_HOUR * hours;
+        tankLevel -= TANK_DRAIN_PER_HOUR * hours;
+    } else {
+        tankLevel += TANK_REFILL_PER_HOUR * hours;
+    }
+    soilMoisture = fminf(fmaxf(soilMoisture, 0.0f), 100.0f);
+    tankLevel = fminf(fmaxf(tankLevel, 0.0f), 100.0f);
+
+    // Faults
+    if (activeFault != FAULT_NONE && (long)(now - faultUntil) >= 0) {
+        activeFault = FAULT_NONE;
+    }
+    if (activeFault == FAULT_NONE && chance(faults.sensorFaultsPerHour * hours)) {
+        injectFault(now);
+        stuckWaterValue = board.analogValues[Pins::WATER_LEVEL_PIN];
+        stuckSoilValue = board.analogValues[Pins::SOIL_MOISTURE_PIN];
+    }
+    if (outageUntil != 0 && (long)(now - outageUntil) >= 0) {
+        board.wifiAvailable = true;
+        outageUntil = 0;
+    }
+    if (outageUntil == 0 && chance(faults.disconnectsPerHour * hours)) {
+        board.dropNetwork();
+        if (faults.outageSeconds > 0) {
+            board.wifiAvailable = false;
+            outageUntil = now + static_cast<unsigned long>(faults.outageSeconds * 1000.0);
+        }
+        disconnectsInjected++;
+    }
+
+    // Sensor inputs
+    std::normal_distribution<float> adcNoise(0.0f, 8.0f);
+    float soilRaw = SoilMoistureCalibration::DRY_VALUE -
+                    (SoilMoistureCalibration::DRY_VALUE - SoilMoistureCalibration::WET_VALUE) * soilMoisture / 100.0f;
+    if (activeFault == FAULT_SOIL_SPIKES && chance(0.2)) {
+        soilRaw += std::uniform_real_distribution<float>(-1000.0f, 1000.0f)(rng);
+    }
+    board.analogValues[Pins::SOIL_MOISTURE_PIN] = activeFault == FAULT_SOIL_OPEN_CIRCUIT ? 4095
+        : activeFault == FAULT_SOIL_STUCK ? stuckSoilValue : static_cast<int>(soilRaw + adcNoise(rng));
+    board.analogValues[Pins::WATER_LEVEL_PIN] = activeFault == FAULT_WATER_STUCK
+        ? stuckWaterValue : static_cast<int>(WATER_ADC_FULL * tankLevel / 100.0f + adcNoise(rng));
+    board.setInput(Pins::RAIN_SENSOR_PIN, raining ? 0 : 1);    // MH-RD pulls low when wet
+
+    board.airTemperature = activeFault == FAULT_DHT_READ ? NAN : roundf(24.0f + 8.0f * sun);
+    board.airHumidity = activeFault == FAULT_DHT_READ ? NAN : roundf(raining ? 95.0f : 80.0f - 30.0f * sun);
+
+    float soilTemperature = 23.0f + 3.0f * sun;
+    if (activeFault == FAULT_PROBE_MISSING) {
+        soilTemperature = DEVICE_DISCONNECTED_C;
+    } else if (activeFault == FAULT_PROBE_POWER_ON) {
+        soilTemperature = 85.0f;
+    }
+    board.soilTemperature = roundf(soilTemperature * 16.0f) / 16.0f;   // 12-bit DS18B20 steps
+}
@@ -0,0 +1,63 @@
+#ifndef FIELD_MODEL_H
+#define FIELD_MODEL_H
+
+#include <stdint.h>
+#include <random>
+#include "HostBoard.h"
+
+struct FaultConfig {
+    double sensorFaultsPerHour;      // Sensor faults injected per device per (virtual) hour
+    double disconnectsPerHour;       // Network drops per device per (virtual) hour
+    double outageSeconds;            // Access point stays away this long after a drop
+};
+
+// Plant, tank and weather behind one virtual board. Soil dries out and is
+// wetted by the pump (relay GPIO low) and rain, the tank drains while pumping
+// and refills slowly, air and soil temperatures follow the day. The model
+// writes raw sensor inputs (ADC counts, pin levels, DHT/DS18B20 values) into
+// the board and can inject the faults the firmware has to survive.
+class FieldModel {
+public:
+    enum Fault : uint8_t {
+        FAULT_NONE = 0,
+        FAULT_DHT_READ,              // DHT11 returns NaN
+        FAULT_PROBE_MISSING,         // DS18B20 reports -127
+        FAULT_PROBE_POWER_ON,        // DS18B20 reports its 85 °C power-on value
+        FAULT_SOIL_OPEN_CIRCUIT,     // Soil probe ADC pinned at full scale
+        FAULT_WATER_STUCK,           // Water level ADC frozen
+        FAULT_SOIL_SPIKES,           // Soil probe reads glitch now and then (loose connector)
+        FAULT_SOIL_STUCK,            // Soil probe ADC frozen mid-scale, for half a day
+        FAULT_COUNT
+    };
+
+private:
+    std::mt19937 rng;
+    float soilMoisture;              // %
+    float tankLevel;                 // %
+    bool raining;
+    float phaseHours;                // Per-device offset so the fleet isn't in lockstep
+
+    unsigned long lastUpdate;
+    Fault activeFault;
+    unsigned long faultUntil;
+    int stuckWaterValue;
+    int stuckSoilValue;
+    unsigned long outageUntil;
+
+    uint32_t faultsInjected;
+    uint32_t disconnectsInjected;
+
+    bool chance(double probability);
+    void injectFault(unsigned long now);
+
+public:
+    explicit FieldModel(uint32_t seed);
+    void update(HostBoard& board, unsigned long now, const FaultConfig& faults);
+
+    float getSoilMoisture() const { return soilMoisture; }
+    Fault getActiveFault() const { return activeFault; }
+    uint32_t getFaultsInjected() const { return faultsInjected; }
+    uint32_t getDisconnectsInjected() const { return disconnectsInjected; }
+};
+
+#endif
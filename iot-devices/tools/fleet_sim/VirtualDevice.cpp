@@ -0,0 +1,45 @@
+#include "VirtualDevice.h"
+
+namespace {
+    // MQTTClient refuses to connect without a PEM file on flash; TLS itself is not simulated
+    const char PLACEHOLDER_CA[] =
+        "-----BEGIN CERTIFICATE-----\n"
+        "c2ltdWxhdGVkIGRldmljZSAtIG5vIFRMUw==\n"
+        "-----END CERTIFICATE-----\n";
+}
+
+VirtualDevice::VirtualDevice(const std::string& id, const BrokerConfig& broker, uint32_t seed, bool verbose)
+    : id(id), sensorTopic("sf/" + id + "/sensor"), relayTopic("sf/" + id + "/relay"),
+      statusTopic("sf/" + id + "/status"), relayCommandTopic("sf/" + id + "/relay/command"), field(seed) {
+    board.name = id;
+    board.serialEnabled = verbose;
+    board.files["/hivemq_ca.crt"] = std::vector<uint8_t>(PLACEHOLDER_CA, PLACEHOLDER_CA + sizeof(PLACEHOLDER_CA) - 1);
+
+    DeviceConfig config = {"fleet-sim", "", broker.host.c_str(), broker.port, broker.user.c_str(),
+                           broker.password.c_str(), this->id.c_str(), sensorTopic.c_str(), relayTopic.c_str(),
+                           statusTopic.c_str(), relayCommandTopic.c_str()};
+
+    HostBoard::select(&board);
+    app = new IrrigationApp(config);
+    HostBoard::select(nullptr);
+}
+
+VirtualDevice::~VirtualDevice() {
+    HostBoard::select(&board);
+    delete app;
+    HostBoard::select(nullptr);
+}
+
+void VirtualDevice::setup(const FaultConfig& faults) {
+    HostBoard::select(&board);
+    field.update(board, millis(), faults);
+    app->setup();
+    HostBoard::select(nullptr);
+}
+
+void VirtualDevice::tick(const FaultConfig& faults) {
+    HostBoard::select(&board);
+    field.update(board, millis(), faults);
+    app->loop();
+    HostBoard::select(nullptr);
+}
@@ -0,0 +1,45 @@
+#ifndef VIRTUAL_DEVICE_H
+#define VIRTUAL_DEVICE_H
+
+#include <string>
+#include "HostBoard.h"
+#include "FieldModel.h"
+#include "app/IrrigationApp.h"
+
+struct BrokerConfig {
+    std::string host;
+    int port;
+    std::string user;
+    std::string password;
+};
+
+// One simulated controller: the real IrrigationApp (sensors, control loop,
+// MQTTClient) running on its own HostBoard, fed by a FieldModel
+class VirtualDevice {
+private:
+    std::string id;
+    std::string sensorTopic;
+    std::string relayTopic;
+    std::string statusTopic;
+    std::string relayCommandTopic;
+    HostBoard board;
+    FieldModel field;
+    IrrigationApp* app;
+
+public:
+    VirtualDevice(const std::string& id, const BrokerConfig& broker, uint32_t seed, bool verbose);
+    VirtualDevice(const VirtualDevice&) = delete;
+    VirtualDevice& operator=(const VirtualDevice&) = delete;
+    ~VirtualDevice();
+
+    void setup(const FaultConfig& faults);
+    void tick(const FaultConfig& faults);
+
+    const std::string& getId() const { return id; }
+    const std::string& getRelayCommandTopic() const { return relayCommandTopic; }
+    HostBoard& getBoard() { return board; }
+    const FieldModel& getField() const { return field; }
+    IrrigationApp& getApp() { return *app; }
+};
+
+#endif
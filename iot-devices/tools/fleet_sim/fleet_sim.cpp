@@ -0,0 +1,281 @@
+// Fleet load simulator: many virtual irrigation controllers in one process,
+// each running the firmware's IrrigationApp against a real MQTT broker.
+//
+//   fleet_sim --devices 2000 --broker 127.0.0.1 --speed 60 --ramp-step 250 --ramp-interval 30
+//
+// Devices are ticked from a single event loop; every tick runs one pass of
+// the firmware loop() for that device. See README.md for the options.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "VirtualDevice.h"
+
+namespace {
+    struct Options {
+        BrokerConfig broker;
+        int devices;
+        int startDevices;
+        int rampStep;
+        double rampInterval;        // Real seconds between ramp steps
+        std::string idPrefix;
+        int idOffset;
+        double speed;               // Virtual time per real time
+        double tickMs;              // Real time between loop() passes per device
+        double duration;            // Real seconds, 0 = until interrupted
+        double statsInterval;       // Real seconds
+        int verboseDevice;
+        bool alwaysOn;              // Disable radio duty cycling on the devices
+        uint32_t seed;
+        FaultConfig faults;
+    };
+
+    volatile sig_atomic_t stopRequested = 0;
+
+    void onSignal(int) {
+        stopRequested = 1;
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: fleet_sim [options]\n"
+                "  --devices N            virtual devices (default 100)\n"
+                "  --start-devices N      devices started immediately (default: all)\n"
+                "  --ramp-step N          devices added per ramp step (default 0)\n"
+                "  --ramp-interval S      real seconds between ramp steps (default 60)\n"
+                "  --broker HOST          MQTT broker host (default 127.0.0.1)\n"
+                "  --port P               MQTT broker port (default 1883)\n"
+                "  --user U --password P  MQTT credentials\n"
+                "  --id-prefix S          device id prefix (default sim-)\n"
+                "  --id-offset N          first device number, to run several processes (default 0)\n"
+                "  --speed X              firmware clock speed-up; scales sample and publish rates (default 1)\n"
+                "  --tick-ms MS           real ms between loop() passes per device (default 100)\n"
+                "  --sensor-faults R      sensor faults per device per virtual hour (default 0)\n"
+                "  --disconnects R        network drops per device per virtual hour (default 0)\n"
+                "  --outage S             seconds the access point stays away after a drop (default 0)\n"
+                "  --duration S           stop after S real seconds (default: run until Ctrl-C)\n"
+                "  --stats S              real seconds between reports (default 5)\n"
+                "  --verbose-device N     print Serial output of device N\n"
+                "  --always-on            keep the devices' modem and WiFi on (no radio duty cycling)\n"
+                "  --seed N               random seed (default 1)\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        options.broker = {"127.0.0.1", 1883, "", ""};
+        options.devices = 100;
+        options.startDevices = -1;
+        options.rampStep = 0;
+        options.rampInterval = 60;
+        options.idPrefix = "sim-";
+        options.idOffset = 0;
+        options.speed = 1;
+        options.tickMs = 100;
+        options.duration = 0;
+        options.statsInterval = 5;
+        options.verboseDevice = -1;
+        options.alwaysOn = false;
+        options.seed = 1;
+        options.faults = {0, 0, 0};
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--always-on") {
+                options.alwaysOn = true;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+            const char* value = argv[++i];
+
+            if (arg == "--devices") options.devices = atoi(value);
+            else if (arg == "--start-devices") options.startDevices = atoi(value);
+            else if (arg == "--ramp-step") options.rampStep = atoi(value);
+            else if (arg == "--ramp-interval") options.rampInterval = atof(value);
+            else if (arg == "--broker") options.broker.host = value;
+            else if (arg == "--port") options.broker.port = atoi(value);
+            else if (arg == "--user") options.broker.user = value;
+            else if (arg == "--password") options.broker.password = value;
+            else if (arg == "--id-prefix") options.idPrefix = value;
+            else if (arg == "--id-offset") options.idOffset = atoi(value);
+            else if (arg == "--speed") options.speed = atof(value);
+            else if (arg == "--tick-ms") options.tickMs = atof(value);
+            else if (arg == "--sensor-faults") options.faults.sensorFaultsPerHour = atof(value);
+            else if (arg == "--disconnects") options.faults.disconnectsPerHour = atof(value);
+            else if (arg == "--outage") options.faults.outageSeconds = atof(value);
+            else if (arg == "--duration") options.duration = atof(value);
+            else if (arg == "--stats") options.statsInterval = atof(value);
+            else if (arg == "--verbose-device") options.verboseDevice = atoi(value);
+            else if (arg == "--seed") options.seed = strtoul(value, nullptr, 10);
+            else return false;
+        }
+
+        if (options.startDevices < 0 || options.startDevices > options.devices) {
+            options.startDevices = options.rampStep > 0 ? options.rampStep : options.devices;
+        }
+        return options.devices > 0 && options.speed > 0 && options.tickMs > 0;
+    }
+
+    void raiseFileLimit() {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    struct TickStats {
+        uint64_t ticks;
+        uint64_t lateTicks;         // Ticks started more than one period late: the simulator is saturated
+        uint64_t tickMicros;
+    };
+
+    struct Report {
+        uint64_t startMicros;
+        HostNetStats startNet;
+        TickStats total;
+        uint64_t lastMicros;
+        HostNetStats lastNet;
+        TickStats interval;
+    };
+
+    // Rates cover the last interval, or the whole run for the final report
+    void printReport(std::vector<std::unique_ptr<VirtualDevice>>& devices, size_t active, Report& report, bool final) {
+        uint64_t now = HostClock::realMicros();
+        const HostNetStats& net = HostNet::stats();
+        const HostNetStats& since = final ? report.startNet : report.lastNet;
+        const TickStats& ticks = final ? report.total : report.interval;
+        double seconds = std::max((now - (final ? report.startMicros : report.lastMicros)) / 1e6, 1e-3);
+
+        size_t connected = 0;
+        size_t pumping = 0;
+        size_t faulted = 0;
+        uint64_t faults = 0;
+        uint64_t drops = 0;
+        for (size_t i = 0; i < active; i++) {
+            VirtualDevice& device = *devices[i];
+            if (device.getApp().getMqttClient().isConnected()) connected++;
+            if (device.getApp().getZones().anyOpen()) pumping++;
+            if (device.getField().getActiveFault() != FieldModel::FAULT_NONE) faulted++;
+            faults += device.getField().getFaultsInjected();
+            drops += device.getField().getDisconnectsInjected();
+        }
+
+        double publishRate = (net.mqttPublishes - since.mqttPublishes) / seconds;
+        double sentRate = (net.bytesSent - since.bytesSent) / seconds / 1024.0;
+        double receivedRate = (net.bytesReceived - since.bytesReceived) / seconds / 1024.0;
+        double tickAverage = ticks.ticks ? static_cast<double>(ticks.tickMicros) / ticks.ticks : 0;
+
+        printf("%s t=%6.0fs devices=%zu connected=%zu pumping=%zu faulted=%zu | publish %.1f/s, "
+               "out %.1f KiB/s, in %.1f KiB/s | connects %llu (%llu failed), disconnects %llu | "
+               "faults %llu, drops %llu | tick %.0f us avg, %llu late\n",
+               final ? "TOTAL" : "stats", (now - report.startMicros) / 1e6, active, connected, pumping, faulted, publishRate,
+               sentRate, receivedRate, (unsigned long long)net.connects, (unsigned long long)net.connectFailures,
+               (unsigned long long)net.disconnects, (unsigned long long)faults, (unsigned long long)drops,
+               tickAverage, (unsigned long long)ticks.lateTicks);
+        fflush(stdout);
+
+        report.lastMicros = now;
+        report.lastNet = net;
+        report.interval = {0, 0, 0};
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+    raiseFileLimit();
+    HostClock::setSpeed(options.speed);
+    randomSeed(options.seed);
+
+    printf("fleet_sim: %d devices (%d at start, +%d every %.0fs) -> %s:%d, speed x%.1f, tick %.0f ms\n",
+           options.devices, options.startDevices, options.rampStep, options.rampInterval,
+           options.broker.host.c_str(), options.broker.port, options.speed, options.tickMs);
+
+    std::vector<std::unique_ptr<VirtualDevice>> devices;
+    std::vector<uint64_t> nextTick;
+    devices.reserve(options.devices);
+    nextTick.reserve(options.devices);
+
+    uint64_t tickPeriod = static_cast<uint64_t>(options.tickMs * 1000.0);
+    uint64_t statsPeriod = static_cast<uint64_t>(options.statsInterval * 1e6);
+    uint64_t rampPeriod = static_cast<uint64_t>(options.rampInterval * 1e6);
+    uint64_t start = HostClock::realMicros();
+    uint64_t nextStats = start + statsPeriod;
+    uint64_t nextRamp = start;
+    Report report = {start, HostNet::stats(), {0, 0, 0}, start, HostNet::stats(), {0, 0, 0}};
+
+    auto startDevices = [&](int count) {
+        for (int n = 0; n < count && static_cast<int>(devices.size()) < options.devices; n++) {
+            int number = options.idOffset + static_cast<int>(devices.size());
+            char id[64];
+            snprintf(id, sizeof(id), "%s%05d", options.idPrefix.c_str(), number);
+
+            devices.emplace_back(new VirtualDevice(id, options.broker, options.seed * 7919u + number,
+                                                   number == options.verboseDevice));
+            devices.back()->getApp().getRadio().setDutyCycling(!options.alwaysOn);
+            devices.back()->setup(options.faults);
+            // Spread the ticks of new devices over one period
+            nextTick.push_back(HostClock::realMicros() + tickPeriod * n / std::max(count, 1));
+        }
+    };
+
+    while (!stopRequested) {
+        uint64_t now = HostClock::realMicros();
+        if (options.duration > 0 && now - start >= options.duration * 1e6) break;
+
+        if (now >= nextRamp && static_cast<int>(devices.size()) < options.devices) {
+            startDevices(devices.empty() ? options.startDevices : options.rampStep);
+            nextRamp = options.rampStep > 0 ? now + rampPeriod : UINT64_MAX;
+        }
+
+        uint64_t earliest = UINT64_MAX;
+        for (size_t i = 0; i < devices.size(); i++) {
+            now = HostClock::realMicros();
+            if (now >= nextTick[i]) {
+                bool late = now - nextTick[i] > tickPeriod;
+                if (late) nextTick[i] = now;
+                devices[i]->tick(options.faults);
+                uint64_t elapsed = HostClock::realMicros() - now;
+                for (TickStats* stats : {&report.interval, &report.total}) {
+                    stats->ticks++;
+                    stats->lateTicks += late ? 1 : 0;
+                    stats->tickMicros += elapsed;
+                }
+                nextTick[i] += tickPeriod;
+            }
+            earliest = std::min(earliest, nextTick[i]);
+        }
+
+        now = HostClock::realMicros();
+        if (now >= nextStats) {
+            printReport(devices, devices.size(), report, false);
+            nextStats += statsPeriod;
+        }
+
+        uint64_t wake = std::min(std::min(earliest, nextStats), nextRamp);
+        if (wake > now) usleep(static_cast<useconds_t>(std::min<uint64_t>(wake - now, 10000)));
+    }
+
+    printReport(devices, devices.size(), report, true);
+
+    // Say goodbye so the broker and backend see clean offline transitions
+    for (std::unique_ptr<VirtualDevice>& device : devices) {
+        HostBoard::select(&device->getBoard());
+        device->getApp().getMqttClient().disconnect();
+        HostBoard::select(nullptr);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "UdpLeafLink.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+UdpLeafLink::UdpLeafLink(uint16_t port) : port(port), sock(-1), sendFailures(0), loss(0) {
+    addressOf(port, ownAddress);
+}
+
+UdpLeafLink::~UdpLeafLink() {
+    if (sock >= 0) close(sock);
+}
+
+void UdpLeafLink::addressOf(uint16_t port, uint8_t* address) {
+    const uint8_t prefix[4] = {0x02, 0x00, 0x7f, 0x00};     // Locally administered
+    memcpy(address, prefix, sizeof(prefix));
+    address[4] = port >> 8;
+    address[5] = port & 0xFF;
+}
+
+bool UdpLeafLink::begin() {
+    if (sock >= 0) return true;
+
+    sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) return false;
+
+    // A gateway with hundreds of leaves gets bursts; give it room like the ESP-NOW receive queue
+    int buffer = 1 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(port);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        fprintf(stderr, "udp leaf link: cannot bind port %u: %s\n", port, strerror(errno));
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    return true;
+}
+
+bool UdpLeafLink::send(const uint8_t* peer, const uint8_t* data, size_t length) {
+    if (sock < 0 || length > MAX_FRAME) {
+        sendFailures++;
+        return false;
+    }
+    // ESP-NOW reports a frame that got no MAC-level ACK; here the sender doesn't know
+    if (loss > 0 && drand48() < loss) return true;
+
+    sockaddr_in remote = {};
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    remote.sin_port = htons(static_cast<uint16_t>(peer[4] << 8 | peer[5]));
+    if (sendto(sock, data, length, 0, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) != (ssize_t)length) {
+        sendFailures++;
+        return false;
+    }
+    return true;
+}
+
+bool UdpLeafLink::receive(Frame& frame) {
+    if (sock < 0) return false;
+
+    sockaddr_in remote = {};
+    socklen_t remoteLength = sizeof(remote);
+    ssize_t length = recvfrom(sock, frame.data, sizeof(frame.data), 0, reinterpret_cast<sockaddr*>(&remote),
+                              &remoteLength);
+    if (length <= 0) return false;
+
+    addressOf(ntohs(remote.sin_port), frame.peer);
+    frame.length = static_cast<uint8_t>(length);
+    return true;
+}
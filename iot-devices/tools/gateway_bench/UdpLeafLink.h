@@ -0,0 +1,36 @@
+#ifndef UDP_LEAF_LINK_H
+#define UDP_LEAF_LINK_H
+
+#include <stdint.h>
+#include "network/LeafLink.h"
+
+// LeafLink over loopback UDP, standing in for ESP-NOW on Linux. Each link
+// binds 127.0.0.1:<port> and its address is 02:00:7f:00:<port>, so any
+// address seen in a frame can be sent back to. Like ESP-NOW, delivery is
+// best effort and frames are never split; setLoss() adds radio loss.
+class UdpLeafLink : public LeafLink {
+private:
+    uint16_t port;
+    int sock;
+    uint8_t ownAddress[ADDRESS_LENGTH];
+    uint32_t sendFailures;
+    double loss;                     // Probability that a sent frame is silently lost
+
+public:
+    explicit UdpLeafLink(uint16_t port);
+    ~UdpLeafLink();
+    UdpLeafLink(const UdpLeafLink&) = delete;
+    UdpLeafLink& operator=(const UdpLeafLink&) = delete;
+
+    bool begin() override;
+    bool send(const uint8_t* peer, const uint8_t* data, size_t length) override;
+    bool receive(Frame& frame) override;
+    const uint8_t* address() const override { return ownAddress; }
+    uint32_t getDropped() const override { return 0; }     // Lost in the kernel's socket buffer, not counted
+    uint32_t getSendFailures() const { return sendFailures; }
+    void setLoss(double probability) { loss = probability; }
+
+    static void addressOf(uint16_t port, uint8_t* address);
+};
+
+#endif
@@ -0,0 +1,413 @@
+// Gateway throughput: many simulated leaf nodes report over loopback UDP to
+// one gateway, which runs the firmware's IrrigationApp with a LeafGateway and
+// uplinks their reports in batches to the broker. The harness decodes those
+// batches to measure delivery and uplink latency, and sends leaf commands
+// through sf/<gateway>/leaves/command to measure the way back.
+//
+//   gateway_bench --leaves 300 --interval 10 --duration 120 --speed 10
+//
+// The gateway device is ticked from one event loop like tools/fleet_sim. See README.md.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <WiFiClient.h>
+#include "VirtualDevice.h"
+#include "UdpLeafLink.h"
+#include "network/LeafNode.h"
+#include "network/LeafProtocol.h"
+#include "network/MQTTTransport.h"
+
+namespace {
+    const uint8_t FIELD_COUNT = 5;
+    const char* const FIELD_NAMES[FIELD_COUNT] = {
+        "airTemperature", "airHumidity", "soilMoisture", "soilTemperature", "waterLevel"
+    };
+
+    struct Options {
+        BrokerConfig broker;
+        int leaves;
+        double intervalSeconds;      // Between reports of one leaf
+        double durationSeconds;
+        double warmupSeconds;
+        double commandRate;          // Leaf commands per second over all leaves
+        double loss;                 // Frame loss on the leaf link, both directions
+        double speed;
+        double tickMs;               // Gateway loop period
+        int basePort;
+        bool verbose;
+        uint32_t seed;
+    };
+
+    struct Leaf {
+        std::unique_ptr<UdpLeafLink> link;
+        std::unique_ptr<LeafNode> node;
+        uint64_t nextReport;
+        uint16_t relayMask;
+        float fields[FIELD_COUNT];
+        std::map<uint16_t, uint64_t> reportsInFlight;    // Sequence -> real µs sent, until uplinked
+        uint32_t commandId;          // Command in flight to this leaf, 0 = none
+        uint64_t commandSentAt;
+    };
+
+    struct Totals {
+        uint64_t reports;
+        uint64_t uplinked;
+        uint64_t uplinkedTwice;
+        uint64_t batches;
+        uint64_t batchBytes;
+        uint64_t commandsSent;
+        uint64_t commandsApplied;
+        std::vector<uint64_t> uplinkLatency;     // µs from the leaf's report to the batch at the harness
+        std::vector<uint64_t> commandLatency;    // µs from the publish to the leaf applying it
+    };
+
+    volatile sig_atomic_t stopRequested = 0;
+
+    Options options;
+    std::vector<Leaf> leaves;
+    Totals totals = {};
+    std::string gatewayId;
+
+    void onSignal(int) {
+        stopRequested = 1;
+    }
+
+    uint64_t percentile(std::vector<uint64_t>& values, double p) {
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    // Leaves are numbered by port: leaf i listens on basePort + 1 + i
+    int leafIndexOf(const uint8_t* address) {
+        int index = (address[4] << 8 | address[5]) - options.basePort - 1;
+        return index >= 0 && index < static_cast<int>(leaves.size()) ? index : -1;
+    }
+
+    void onLeafBatch(const uint8_t* data, size_t length) {
+        using namespace LeafProtocol;
+        if (length < sizeof(BatchHeader)) return;
+        BatchHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != BATCH_MAGIC || header.version != BATCH_VERSION) return;
+
+        totals.batches++;
+        totals.batchBytes += length;
+        uint64_t now = HostClock::realMicros();
+        size_t offset = sizeof(header);
+        for (uint16_t i = 0; i < header.recordCount && offset + sizeof(RecordHeader) <= length; i++) {
+            RecordHeader record;
+            memcpy(&record, data + offset, sizeof(record));
+            offset += sizeof(record);
+            if (offset + record.length > length || record.length < sizeof(Header)) break;
+
+            Header frame;
+            memcpy(&frame, data + offset, sizeof(frame));
+            offset += record.length;
+
+            int index = leafIndexOf(record.address);
+            if (index < 0) continue;
+            auto it = leaves[index].reportsInFlight.find(frame.sequence);
+            if (it == leaves[index].reportsInFlight.end()) {
+                totals.uplinkedTwice++;
+                continue;
+            }
+            totals.uplinked++;
+            totals.uplinkLatency.push_back(now - it->second);
+            leaves[index].reportsInFlight.erase(it);
+        }
+    }
+
+    void onBenchMessage(char* topic, uint8_t* payload, unsigned int length) {
+        if (std::string(topic) == "sf/" + gatewayId + "/leaves") onLeafBatch(payload, length);
+    }
+
+    void tickLeaf(Leaf& leaf, uint64_t now) {
+        unsigned long nowMillis = static_cast<unsigned long>(now / 1000);
+        if (now >= leaf.nextReport) {
+            for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+                leaf.fields[i] += (random(201) - 100) / 1000.0f;
+            }
+            static const uint16_t layout = LeafProtocol::layoutOf(FIELD_NAMES, FIELD_COUNT);
+            leaf.node->report(leaf.fields, FIELD_COUNT, layout, leaf.relayMask, nowMillis);
+            leaf.reportsInFlight[leaf.node->getSequence()] = now;
+            totals.reports++;
+            leaf.nextReport += static_cast<uint64_t>(options.intervalSeconds * 1e6);
+        }
+
+        RelayCommand command;
+        if (leaf.node->poll(nowMillis, command)) {
+            if (command.status) leaf.relayMask |= 1u << command.zone;
+            else leaf.relayMask &= ~(1u << command.zone);
+            leaf.node->commandApplied(command.id);
+
+            if (command.id == leaf.commandId) {
+                totals.commandsApplied++;
+                totals.commandLatency.push_back(now - leaf.commandSentAt);
+                leaf.commandId = 0;
+            }
+        }
+    }
+
+    void printLatency(const char* name, std::vector<uint64_t> values) {
+        if (values.empty()) {
+            printf("  %-24s %10s\n", name, "-");
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        printf("  %-24s %10.1f %10.1f %10.1f\n", name, percentile(values, 0.5) / 1000.0,
+               percentile(values, 0.99) / 1000.0, values.back() / 1000.0);
+    }
+
+    void printSummary(double elapsedSeconds) {
+        uint64_t sent = 0, acked = 0, retries = 0, lost = 0, pending = 0;
+        for (const Leaf& leaf : leaves) {
+            sent += leaf.node->getReportsSent();
+            acked += leaf.node->getReportsAcked();
+            retries += leaf.node->getRetries();
+            lost += leaf.node->getReportsLost();
+            pending += leaf.reportsInFlight.size();
+        }
+
+        printf("\n== %d leaves, %.0f s ==\n", options.leaves, elapsedSeconds);
+        printf("  reports     %llu sent, %llu acknowledged, %llu retries, %llu unacknowledged\n",
+               (unsigned long long)sent, (unsigned long long)acked, (unsigned long long)retries,
+               (unsigned long long)lost);
+        printf("  uplink      %llu reports in %llu batches (%.1f reports/batch, %.1f bytes/report), "
+               "%llu not uplinked yet, %llu uplinked twice\n",
+               (unsigned long long)totals.uplinked, (unsigned long long)totals.batches,
+               totals.batches ? (double)totals.uplinked / totals.batches : 0.0,
+               totals.uplinked ? (double)totals.batchBytes / totals.uplinked : 0.0,
+               (unsigned long long)pending, (unsigned long long)totals.uplinkedTwice);
+        printf("  mqtt        %.2f publishes/min for %.1f reports/min\n",
+               totals.batches * 60.0 / elapsedSeconds, totals.reports * 60.0 / elapsedSeconds);
+        printf("  commands    %llu sent, %llu applied\n", (unsigned long long)totals.commandsSent,
+               (unsigned long long)totals.commandsApplied);
+        printf("  %-24s %10s %10s %10s\n", "latency (ms)", "p50", "p99", "max");
+        printLatency("report -> broker", totals.uplinkLatency);
+        printLatency("command -> leaf", totals.commandLatency);
+        fflush(stdout);
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gateway_bench [options]\n"
+                "  --leaves N             simulated leaf nodes (default 100)\n"
+                "  --interval S           real seconds between reports of one leaf (default 10)\n"
+                "  --duration S           real seconds of measurement (default 60)\n"
+                "  --warmup S             real seconds before the leaves start (default 5)\n"
+                "  --command-rate R       leaf commands per second over all leaves (default 0.2)\n"
+                "  --loss P               frame loss probability on the leaf link (default 0)\n"
+                "  --speed X              gateway firmware clock speed-up (default 1)\n"
+                "  --tick-ms MS           real ms between gateway loop() passes (default 10)\n"
+                "  --base-port P          gateway UDP port; leaves use the ports above (default 40000)\n"
+                "  --broker HOST --port P --user U --password P\n"
+                "  --verbose              print the gateway's Serial output\n"
+                "  --seed N               random seed (default 1)\n");
+    }
+
+    bool parseOptions(int argc, char** argv) {
+        options.broker = {"127.0.0.1", 1883, "", ""};
+        options.leaves = 100;
+        options.intervalSeconds = 10;
+        options.durationSeconds = 60;
+        options.warmupSeconds = 5;
+        options.commandRate = 0.2;
+        options.loss = 0;
+        options.speed = 1;
+        options.tickMs = 10;
+        options.basePort = 40000;
+        options.verbose = false;
+        options.seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--verbose") {
+                options.verbose = true;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+            const char* value = argv[++i];
+
+            if (arg == "--leaves") options.leaves = atoi(value);
+            else if (arg == "--interval") options.intervalSeconds = atof(value);
+            else if (arg == "--duration") options.durationSeconds = atof(value);
+            else if (arg == "--warmup") options.warmupSeconds = atof(value);
+            else if (arg == "--command-rate") options.commandRate = atof(value);
+            else if (arg == "--loss") options.loss = atof(value);
+            else if (arg == "--speed") options.speed = atof(value);
+            else if (arg == "--tick-ms") options.tickMs = atof(value);
+            else if (arg == "--base-port") options.basePort = atoi(value);
+            else if (arg == "--broker") options.broker.host = value;
+            else if (arg == "--port") options.broker.port = atoi(value);
+            else if (arg == "--user") options.broker.user = value;
+            else if (arg == "--password") options.broker.password = value;
+            else if (arg == "--seed") options.seed = strtoul(value, nullptr, 10);
+            else return false;
+        }
+
+        return options.leaves > 0 && options.leaves <= 65535 - options.basePort - 1 && options.intervalSeconds > 0 &&
+               options.durationSeconds > 0 && options.speed > 0 && options.tickMs > 0 && options.loss >= 0 &&
+               options.loss < 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        usage();
+        return 2;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    HostClock::setSpeed(options.speed);
+    randomSeed(options.seed);
+    srand48(options.seed);
+
+    // Harness client: decodes the uplinked batches and publishes leaf commands
+    HostBoard benchBoard;
+    benchBoard.name = "bench";
+    benchBoard.wifiConnected = true;
+    HostBoard::select(&benchBoard);
+    WiFiClient benchNet;
+    OutboundQueue benchQueue;
+    MQTTTransport bench(benchNet, benchQueue);
+    gatewayId = "gateway-0000";
+    std::string batchTopic = "sf/" + gatewayId + "/leaves";
+    std::string commandTopic = "sf/" + gatewayId + "/leaves/command";
+    bench.setServer(options.broker.host.c_str(), options.broker.port);
+    bench.setCredentials("gateway-bench", options.broker.user.empty() ? nullptr : options.broker.user.c_str(),
+                         options.broker.password.c_str());
+    bench.setInflightWindow(32);
+    bench.setMessageCallback(onBenchMessage);
+    bench.subscribe(batchTopic.c_str(), 1);
+    if (bench.connect()) {
+        uint64_t deadline = HostClock::realMicros() + 5000000;
+        while (bench.connecting() && HostClock::realMicros() < deadline) {
+            bench.loop();
+            usleep(1000);
+        }
+    }
+    if (!bench.connected()) {
+        fprintf(stderr, "cannot connect to %s:%d (state %d)\n", options.broker.host.c_str(), options.broker.port,
+                bench.getState());
+        return 1;
+    }
+    HostBoard::select(nullptr);
+
+    // The gateway: firmware as on the board, with the UDP link in place of ESP-NOW
+    const FaultConfig noFaults = {0, 0, 0};
+    UdpLeafLink gatewayLink(options.basePort);
+    gatewayLink.setLoss(options.loss);
+    VirtualDevice gateway(gatewayId, options.broker, options.seed, options.verbose);
+    gateway.getApp().setLeafLink(&gatewayLink, static_cast<uint16_t>(options.leaves));
+    gateway.setup(noFaults);
+
+    uint64_t now = HostClock::realMicros();
+    uint64_t start = now + static_cast<uint64_t>(options.warmupSeconds * 1e6);
+    uint64_t interval = static_cast<uint64_t>(options.intervalSeconds * 1e6);
+    leaves.resize(options.leaves);
+    for (int i = 0; i < options.leaves; i++) {
+        Leaf& leaf = leaves[i];
+        leaf.link.reset(new UdpLeafLink(options.basePort + 1 + i));
+        leaf.link->setLoss(options.loss);
+        leaf.node.reset(new LeafNode(*leaf.link, gatewayLink.address()));
+        if (!leaf.node->begin()) return 1;
+        leaf.nextReport = start + interval * i / options.leaves;
+        leaf.relayMask = 0;
+        leaf.fields[0] = 22.0f + random(50) / 10.0f;
+        leaf.fields[1] = 60.0f + random(200) / 10.0f;
+        leaf.fields[2] = 40.0f + random(300) / 10.0f;
+        leaf.fields[3] = 18.0f + random(40) / 10.0f;
+        leaf.fields[4] = 50.0f + random(400) / 10.0f;
+        leaf.commandId = 0;
+        leaf.commandSentAt = 0;
+    }
+
+    printf("gateway_bench: %d leaves every %.1f s -> %s via %s:%d, %.0f s\n", options.leaves, options.intervalSeconds,
+           gatewayId.c_str(), options.broker.host.c_str(), options.broker.port, options.durationSeconds);
+    fflush(stdout);
+
+    uint64_t end = start + static_cast<uint64_t>(options.durationSeconds * 1e6);
+    uint64_t tickPeriod = static_cast<uint64_t>(options.tickMs * 1000.0);
+    uint64_t nextTick = now;
+    uint64_t nextCommand = options.commandRate > 0 ? start : UINT64_MAX;
+    uint64_t nextSummary = start + 30000000;
+    uint32_t commandId = 1;
+    size_t cursor = 0;
+
+    while (!stopRequested && now < end) {
+        now = HostClock::realMicros();
+
+        if (now >= start) {
+            for (Leaf& leaf : leaves) tickLeaf(leaf, now);
+        }
+
+        // Commands go to leaves with none in flight; ids are the harness's so they can be matched
+        while (now >= nextCommand) {
+            for (int n = 0; n < options.leaves; n++) {
+                Leaf& leaf = leaves[(cursor + n) % options.leaves];
+                if (leaf.commandId != 0) continue;
+                cursor = (cursor + n + 1) % options.leaves;
+
+                const uint8_t* address = leaf.link->address();
+                char payload[128];
+                bool status = !(leaf.relayMask & 1);
+                snprintf(payload, sizeof(payload),
+                         "{\"leaf\":\"%02x%02x%02x%02x%02x%02x\",\"relayStatus\":%s,\"zone\":1,\"commandId\":%u}",
+                         address[0], address[1], address[2], address[3], address[4], address[5],
+                         status ? "true" : "false", commandId);
+                leaf.commandId = commandId++;
+                leaf.commandSentAt = HostClock::realMicros();
+                HostBoard::select(&benchBoard);
+                bench.publish(commandTopic.c_str(), reinterpret_cast<const uint8_t*>(payload), strlen(payload), 1, false);
+                HostBoard::select(nullptr);
+                totals.commandsSent++;
+                break;
+            }
+            nextCommand += static_cast<uint64_t>(std::max(1e6 / options.commandRate, 1.0));
+        }
+
+        if (now >= nextTick) {
+            gateway.tick(noFaults);
+            nextTick = std::max(nextTick + tickPeriod, now);
+        }
+
+        HostBoard::select(&benchBoard);
+        bench.loop();
+        HostBoard::select(nullptr);
+
+        if (now >= nextSummary) {
+            printSummary((now - start) / 1e6);
+            nextSummary += 30000000;
+        }
+
+        uint64_t wake = std::min(nextTick, nextCommand);
+        if (wake > now) usleep(static_cast<useconds_t>(std::min<uint64_t>(wake - now, 1000)));
+    }
+
+    if (now > start) printSummary((std::min(now, end) - start) / 1e6);
+
+    HostBoard::select(&gateway.getBoard());
+    gateway.getApp().getMqttClient().disconnect();
+    HostBoard::select(&benchBoard);
+    bench.disconnect();
+    HostBoard::select(nullptr);
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef ADAFRUIT_GFX_H
+#define ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Text drawing is discarded on the host
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t width, int16_t height) { (void)width; (void)height; }
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    using Print::write;
+    void setCursor(int16_t x, int16_t y) { (void)x; (void)y; }
+    void setTextColor(uint16_t color) { (void)color; }
+    void setTextColor(uint16_t color, uint16_t background) { (void)color; (void)background; }
+    void setTextSize(uint8_t size) { (void)size; }
+    void setRotation(uint8_t rotation) { (void)rotation; }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) { (void)x0; (void)y0; (void)x1; (void)y1; (void)color; }
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { (void)x; (void)y; (void)w; (void)h; (void)color; }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { (void)x; (void)y; (void)w; (void)h; (void)color; }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef ADAFRUIT_SSD1306_H
+#define ADAFRUIT_SSD1306_H
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t width, uint8_t height, TwoWire* wire = &Wire, int8_t resetPin = -1)
+        : Adafruit_GFX(width, height) {
+        (void)wire;
+        (void)resetPin;
+    }
+    bool begin(uint8_t vcs = SSD1306_SWITCHCAPVCC, uint8_t address = 0, bool reset = true, bool periphBegin = true) {
+        (void)vcs; (void)address; (void)reset; (void)periphBegin;
+        return true;
+    }
+    void clearDisplay() {}
+    void display() {}
+    void dim(bool dim) { (void)dim; }
+};
+
+#endif
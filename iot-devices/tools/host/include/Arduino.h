@@ -0,0 +1,80 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Host (Linux) build of the Arduino core subset the firmware uses. Pins,
+// sensors, flash and network are backed by the selected HostBoard.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <cmath>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "HardwareSerial.h"
+#include "Esp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define PI 3.1415926535897932384626433832795
+#define PROGMEM
+#define F(string_literal) (string_literal)
+#define PGM_P const char*
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+// Handlers run synchronously when the simulator drives the pin (HostBoard::setInput)
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// The wall clock stays the host's; SNTP started by the firmware is a no-op
+void configTime(long gmtOffset, int daylightOffset, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef DHT_H
+#define DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+// Returns the selected HostBoard's air temperature and humidity
+class DHT {
+public:
+    DHT(uint8_t pin, uint8_t type, uint8_t count = 6) { (void)pin; (void)type; (void)count; }
+    void begin(uint8_t usec = 55) { (void)usec; }
+    float readTemperature(bool fahrenheit = false, bool force = false);
+    float readHumidity(bool force = false);
+};
+
+#endif
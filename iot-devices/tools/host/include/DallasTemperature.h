@@ -0,0 +1,21 @@
+#ifndef DALLAS_TEMPERATURE_H
+#define DALLAS_TEMPERATURE_H
+
+#include <Arduino.h>
+#include "OneWire.h"
+
+#define DEVICE_DISCONNECTED_C -127
+
+// DS18B20 bus of the selected HostBoard
+class DallasTemperature {
+public:
+    explicit DallasTemperature(OneWire* wire) { (void)wire; }
+    void begin() {}
+    uint8_t getDeviceCount();
+    void setResolution(uint8_t bits) { (void)bits; }
+    void setWaitForConversion(bool wait) { (void)wait; }
+    void requestTemperatures() {}
+    float getTempCByIndex(uint8_t index);
+};
+
+#endif
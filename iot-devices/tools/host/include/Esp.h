@@ -0,0 +1,24 @@
+#ifndef ESP_H
+#define ESP_H
+
+#include <stdint.h>
+
+// Heap figures of the host process (malloc statistics), shared by every board.
+// Free heap is counted down from a nominal size so allocations show up one to one.
+class EspClass {
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+
+    // No PSRAM on the host
+    uint32_t getPsramSize() { return 0; }
+    uint32_t getFreePsram() { return 0; }
+    uint32_t getMinFreePsram() { return 0; }
+    uint32_t getMaxAllocPsram() { return 0; }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+class HostBoard;
+
+namespace fs {
+    struct FileImpl;
+
+    // Handle to a file (or the root directory) in the selected HostBoard's flash
+    class File : public Stream {
+    private:
+        std::shared_ptr<FileImpl> impl;
+
+    public:
+        File() {}
+        explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t read(uint8_t* buffer, size_t size);
+        bool seek(uint32_t position);
+        size_t position() const;
+        size_t size() const;
+        void close();
+        operator bool() const;
+        const char* name() const;
+        const char* path() const;
+        bool isDirectory() const;
+        File openNextFile(const char* mode = "r");
+        void rewindDirectory();
+    };
+
+    class FS {
+    public:
+        File open(const char* path, const char* mode = "r", bool create = false);
+        File open(const String& path, const char* mode = "r", bool create = false) {
+            return open(path.c_str(), mode, create);
+        }
+        bool exists(const char* path);
+        bool exists(const String& path) { return exists(path.c_str()); }
+        bool remove(const char* path);
+        bool remove(const String& path) { return remove(path.c_str()); }
+        bool rename(const char* from, const char* to);
+        bool mkdir(const char* path) { (void)path; return true; }
+        bool rmdir(const char* path) { (void)path; return true; }
+    };
+}
+
+using fs::File;
+using fs::FS;
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+#endif
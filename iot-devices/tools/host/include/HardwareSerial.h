@@ -0,0 +1,23 @@
+#ifndef HARDWARE_SERIAL_H
+#define HARDWARE_SERIAL_H
+
+#include "Stream.h"
+
+// Serial of the selected HostBoard: lines go to stdout, prefixed with the
+// board name, when the board has serial output enabled
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Simulated hardware of one virtual device. The host Arduino layer reads pins,
+// sensors, NVS, flash and network state from the board that is currently
+// selected, so many firmware instances can share one process as long as each
+// one runs with its own board selected. delay() returns immediately on the
+// host: pacing is left to whoever drives the firmware loop.
+class HostBoard {
+public:
+    static const int PIN_COUNT = 40;
+
+    int pinModes[PIN_COUNT];
+    int digitalLevels[PIN_COUNT];
+    int analogValues[PIN_COUNT];
+
+    float airTemperature;        // NAN simulates a DHT read failure
+    float airHumidity;
+    float soilTemperature;       // -127 (DEVICE_DISCONNECTED_C) simulates a missing probe
+    uint8_t oneWireDevices;
+
+    bool wifiAvailable;          // Access point in range; false simulates an outage
+    bool wifiConnected;          // Station joined (WiFi.begin() called)
+    std::string wifiSsid;
+    uint32_t networkEpoch;       // Bumped by dropNetwork(); open sockets of an older epoch are closed
+
+    bool serialEnabled;          // Serial output of this board goes to stdout
+    bool serialAtLineStart;
+    std::string name;            // Prefix for Serial lines
+
+    std::map<std::string, std::vector<uint8_t>> nvs;     // "<namespace>/<key>" -> value
+    std::map<std::string, std::vector<uint8_t>> files;   // SPIFFS path -> content
+
+    std::vector<uint8_t> appSlots[2];                    // ota_0/ota_1 flash, grown as written
+    uint32_t appLengths[2];                              // Bytes written, what the SHA-256 covers
+    int runningSlot;
+    int bootSlot;
+
+    std::function<void(int pin, int level)> onDigitalWrite;
+
+    // attachInterruptArg() handlers, fired by setInput()
+    void (*interruptHandlers[PIN_COUNT])(void*);
+    void* interruptArgs[PIN_COUNT];
+    int interruptModes[PIN_COUNT];
+
+    HostBoard();
+    void dropNetwork();
+    void setInput(int pin, int level);      // Drives a digital input, firing its interrupt on an edge
+
+    static HostBoard& current();
+    static void select(HostBoard* board);
+};
+
+// Virtual clock behind millis()/micros(); speed > 1 runs firmware time faster than real time
+namespace HostClock {
+    void setSpeed(double speed);
+    double getSpeed();
+    uint64_t micros64();
+    uint64_t realMicros();
+}
+
+// Process-wide socket counters, for load reports
+struct HostNetStats {
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t mqttPublishes;      // MQTT PUBLISH packets written
+    uint64_t connects;
+    uint64_t connectFailures;
+    uint64_t disconnects;
+};
+
+namespace HostNet {
+    HostNetStats& stats();
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef IP_ADDRESS_H
+#define IP_ADDRESS_H
+
+#include <stdint.h>
+#include "Printable.h"
+#include "WString.h"
+
+class IPAddress : public Printable {
+private:
+    uint8_t bytes[4];
+
+public:
+    IPAddress() : bytes{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+    IPAddress(uint32_t address);
+
+    operator uint32_t() const;
+    uint8_t operator[](int index) const { return bytes[index]; }
+    uint8_t& operator[](int index) { return bytes[index]; }
+    bool operator==(const IPAddress& other) const;
+
+    bool fromString(const char* address);
+    String toString() const;
+    size_t printTo(Print& p) const override;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef ONE_WIRE_H
+#define ONE_WIRE_H
+
+#include <Arduino.h>
+
+class OneWire {
+private:
+    uint8_t pin;
+
+public:
+    explicit OneWire(uint8_t pin) : pin(pin) {}
+    uint8_t getPin() const { return pin; }
+};
+
+#endif
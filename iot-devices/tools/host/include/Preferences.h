@@ -0,0 +1,63 @@
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS namespace backed by the selected HostBoard's key/value map
+class Preferences {
+private:
+    String ns;
+    bool opened;
+    bool readOnly;
+
+    bool putRaw(const char* key, const void* value, size_t length);
+    bool getRaw(const char* key, void* value, size_t length) const;
+
+    template <typename T>
+    size_t putValue(const char* key, T value) {
+        return putRaw(key, &value, sizeof(value)) ? sizeof(value) : 0;
+    }
+
+    template <typename T>
+    T getValue(const char* key, T defaultValue) const {
+        T value;
+        return getRaw(key, &value, sizeof(value)) ? value : defaultValue;
+    }
+
+public:
+    Preferences() : opened(false), readOnly(false) {}
+
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key) const;
+    size_t freeEntries() const { return 256; }
+
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength) const;
+    size_t getBytesLength(const char* key) const;
+    size_t putString(const char* key, const String& value);
+    String getString(const char* key, const String& defaultValue = String()) const;
+
+    size_t putBool(const char* key, bool value) { return putValue<uint8_t>(key, value ? 1 : 0); }
+    bool getBool(const char* key, bool defaultValue = false) const { return getValue<uint8_t>(key, defaultValue ? 1 : 0) != 0; }
+    size_t putUChar(const char* key, uint8_t value) { return putValue(key, value); }
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putShort(const char* key, int16_t value) { return putValue(key, value); }
+    int16_t getShort(const char* key, int16_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putUShort(const char* key, uint16_t value) { return putValue(key, value); }
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putInt(const char* key, int32_t value) { return putValue(key, value); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putUInt(const char* key, uint32_t value) { return putValue(key, value); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putULong(const char* key, uint32_t value) { return putValue(key, value); }
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putULong64(const char* key, uint64_t value) { return putValue(key, value); }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    size_t putFloat(const char* key, float value) { return putValue(key, value); }
+    float getFloat(const char* key, float defaultValue = NAN) const { return getValue(key, defaultValue); }
+};
+
+#endif
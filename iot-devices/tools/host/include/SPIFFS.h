@@ -0,0 +1,18 @@
+#ifndef SPIFFS_H
+#define SPIFFS_H
+
+#include "FS.h"
+
+class SPIFFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = nullptr);
+    void end() {}
+    bool format();
+    size_t totalBytes() { return 1441792; }
+    size_t usedBytes();
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
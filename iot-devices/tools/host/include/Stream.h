@@ -0,0 +1,26 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+protected:
+    unsigned long timeout;
+    int timedRead();
+
+public:
+    Stream() : timeout(1000) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeout = ms; }
+    unsigned long getTimeout() const { return timeout; }
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+    String readString();
+    String readStringUntil(char terminator);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <stddef.h>
+#include <string>
+
+class StringSumHelper;
+
+// Arduino String on top of std::string
+class String {
+protected:
+    std::string buffer;
+
+public:
+    String(const char* cstr = "");
+    String(const String& str) = default;
+    String(String&& str) = default;
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& rhs) = default;
+    String& operator=(String&& rhs) = default;
+    String& operator=(const char* cstr);
+
+    bool reserve(unsigned int size);
+    unsigned int length() const { return buffer.size(); }
+    bool isEmpty() const { return buffer.empty(); }
+    const char* c_str() const { return buffer.c_str(); }
+
+    bool concat(const String& str);
+    bool concat(const char* cstr);
+    bool concat(const char* cstr, unsigned int length);
+    bool concat(char c);
+    bool concat(unsigned char value);
+    bool concat(int value);
+    bool concat(unsigned int value);
+    bool concat(long value);
+    bool concat(unsigned long value);
+    bool concat(float value);
+    bool concat(double value);
+
+    template <typename T>
+    String& operator+=(const T& rhs) {
+        concat(rhs);
+        return *this;
+    }
+
+    int compareTo(const String& s) const;
+    bool equals(const String& s) const { return buffer == s.buffer; }
+    bool equals(const char* cstr) const { return buffer == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& rhs) const { return buffer < rhs.buffer; }
+    bool startsWith(const String& prefix) const;
+    bool startsWith(const String& prefix, unsigned int offset) const;
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const;
+    void setCharAt(unsigned int index, char c);
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return buffer[index]; }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(const String& str) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* p) : String(p) {}
+};
+
+template <typename T>
+inline StringSumHelper operator+(const String& lhs, const T& rhs) {
+    StringSumHelper result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+inline StringSumHelper operator+(const char* lhs, const String& rhs) {
+    StringSumHelper result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) {
+    return rhs.equals(lhs);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+// Station interface of the selected HostBoard
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode) { (void)mode; return true; }
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+                IPAddress dns2 = IPAddress());
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool reconnect();
+    bool setSleep(bool enabled) { (void)enabled; return true; }
+    bool setAutoReconnect(bool enabled) { (void)enabled; return true; }
+
+    String SSID();
+    String macAddress();
+    uint8_t* macAddress(uint8_t* mac);
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    int8_t RSSI();
+    uint8_t* BSSID();
+    int32_t channel() { return 6; }
+};
+
+extern WiFiClass WiFi;
+
+#endif
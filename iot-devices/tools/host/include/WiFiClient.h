@@ -0,0 +1,40 @@
+#ifndef WIFI_CLIENT_H
+#define WIFI_CLIENT_H
+
+#include "Client.h"
+
+class HostBoard;
+
+// Plain TCP socket client. Reads are non-blocking; the connection is closed
+// when its board drops the network (HostBoard::dropNetwork()).
+class WiFiClient : public Client {
+private:
+    int fd;
+    HostBoard* board;
+    uint32_t epoch;
+
+    bool checkBoard();
+
+public:
+    WiFiClient();
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+    ~WiFiClient() override;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    using Print::write;
+};
+
+#endif
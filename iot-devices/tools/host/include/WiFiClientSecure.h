@@ -0,0 +1,13 @@
+#ifndef WIFI_CLIENT_SECURE_H
+#define WIFI_CLIENT_SECURE_H
+
+#include "WiFiClient.h"
+
+// TLS is not simulated: certificates are accepted and the connection is plain TCP
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setCACert(const char* rootCA) { (void)rootCA; }
+    void setInsecure() {}
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+// Only the SSD1306 address acknowledges; there is nothing behind it
+class TwoWire {
+private:
+    static const uint8_t DISPLAY_ADDRESS = 0x3C;
+    uint8_t address;
+
+public:
+    TwoWire() : address(0) {}
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { (void)sda; (void)scl; (void)frequency; return true; }
+    void setClock(uint32_t frequency) { (void)frequency; }
+    void beginTransmission(uint8_t address) { this->address = address; }
+    uint8_t endTransmission(bool sendStop = true) { (void)sendStop; return address == DISPLAY_ADDRESS ? 0 : 2; }
+    size_t write(uint8_t data) { (void)data; return 1; }
+};
+
+extern TwoWire Wire;
+
+#endif
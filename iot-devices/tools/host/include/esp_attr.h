@@ -0,0 +1,9 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+// Section attributes are meaningless on the host; RTC memory is ordinary
+// static storage that lives as long as the simulator process
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+#endif
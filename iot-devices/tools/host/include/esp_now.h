@@ -0,0 +1,36 @@
+#ifndef ESP_NOW_H
+#define ESP_NOW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_timer.h"
+
+// ESP-NOW is not simulated: esp_now_init() fails. tools/gateway_bench runs
+// the gateway's leaves over UDP instead, behind the same LeafLink interface.
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP = 1
+} wifi_interface_t;
+
+typedef struct {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[16];
+    uint8_t channel;
+    wifi_interface_t ifidx;
+    bool encrypt;
+    void* priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int length);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_del_peer(const uint8_t* peer);
+bool esp_now_is_peer_exist(const uint8_t* peer);
+esp_err_t esp_now_send(const uint8_t* peer, const uint8_t* data, size_t length);
+
+#endif
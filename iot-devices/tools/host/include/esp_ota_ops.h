@@ -0,0 +1,11 @@
+#ifndef ESP_OTA_OPS_H
+#define ESP_OTA_OPS_H
+
+#include "esp_partition.h"
+
+// The boot slot takes effect on the board's next (simulated) restart
+const esp_partition_t* esp_ota_get_running_partition();
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+
+#endif
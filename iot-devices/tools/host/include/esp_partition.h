@@ -0,0 +1,23 @@
+#ifndef ESP_PARTITION_H
+#define ESP_PARTITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// The two app slots of default.csv, backed by the selected HostBoard's
+// appSlots. Erased flash reads 0xFF; the SHA-256 covers the image written
+// front to back since the last erase, as the device hashes the image it finds.
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    int slot;                    // Host only: index into HostBoard::appSlots
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+esp_err_t esp_partition_get_sha256(const esp_partition_t* partition, uint8_t* sha256);
+
+#endif
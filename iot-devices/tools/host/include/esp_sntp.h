@@ -0,0 +1,19 @@
+#ifndef ESP_SNTP_H
+#define ESP_SNTP_H
+
+#include <stdint.h>
+#include <sys/time.h>
+
+// configTime() reports a sync with the host wall clock straight away
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+typedef enum {
+    SNTP_SYNC_MODE_IMMED,
+    SNTP_SYNC_MODE_SMOOTH
+} sntp_sync_mode_t;
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+void sntp_set_sync_interval(uint32_t intervalMs);
+void sntp_set_sync_mode(sntp_sync_mode_t mode);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ESP_TASK_WDT_H
+#define ESP_TASK_WDT_H
+
+#include <stdint.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// The task watchdog is not simulated: subscribing succeeds and it never fires
+esp_err_t esp_task_wdt_init(uint32_t timeoutSeconds, bool panic);
+esp_err_t esp_task_wdt_add(TaskHandle_t task);
+esp_err_t esp_task_wdt_reset();
+
+#endif
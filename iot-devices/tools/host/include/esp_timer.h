@@ -0,0 +1,30 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Monotonic time follows the accelerated host clock. Timers are created but
+// never fire: the simulators drive loop() themselves instead of sleeping.
+typedef struct HostTimer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+    ESP_TIMER_TASK
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+int64_t esp_timer_get_time();
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutMicros);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodMicros);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+
+#endif
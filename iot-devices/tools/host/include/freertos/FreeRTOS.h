@@ -0,0 +1,23 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+// The host runs every board's loop on one thread; each HostBoard stands in for its loop task
+typedef void* TaskHandle_t;
+typedef unsigned int UBaseType_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef int portMUX_TYPE;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portYIELD_FROM_ISR() ((void)0)
+
+#endif
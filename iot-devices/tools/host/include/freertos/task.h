@@ -0,0 +1,18 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TaskHandle_t xTaskGetHandle(const char* name);     // No system tasks on the host: always nullptr
+char* pcTaskGetName(TaskHandle_t task);
+
+// Stack use isn't measured on the host; reports the ESP32 loop task stack as untouched
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+// Nothing else runs on the host: a notification is never pending and waiting returns at once
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+
+#endif
@@ -0,0 +1,450 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdarg.h>
+#include <malloc.h>
+#include <random>
+#include <esp_timer.h>
+#include <esp_sntp.h>
+#include <esp_now.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include "HostBoard.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+EspClass ESP;
+
+namespace {
+    std::mt19937 randomEngine(1);
+    sntp_sync_time_cb_t sntpCallback = nullptr;
+
+    bool validPin(uint8_t pin) {
+        return pin < HostBoard::PIN_COUNT;
+    }
+}
+
+// ------------------------------------------------------------------ GPIO
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (validPin(pin)) HostBoard::current().pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (!validPin(pin)) return;
+    HostBoard& board = HostBoard::current();
+    board.digitalLevels[pin] = level ? HIGH : LOW;
+    if (board.onDigitalWrite) board.onDigitalWrite(pin, level ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+    return validPin(pin) ? HostBoard::current().digitalLevels[pin] : LOW;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+    if (!validPin(pin)) return;
+    HostBoard& board = HostBoard::current();
+    board.interruptHandlers[pin] = handler;
+    board.interruptArgs[pin] = arg;
+    board.interruptModes[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (validPin(pin)) HostBoard::current().interruptHandlers[pin] = nullptr;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return validPin(pin) ? static_cast<uint16_t>(constrain(HostBoard::current().analogValues[pin], 0, 4095)) : 0;
+}
+
+void analogReadResolution(uint8_t bits) {
+    (void)bits;
+}
+
+// ------------------------------------------------------------------ Time
+
+unsigned long millis() {
+    return static_cast<unsigned long>(HostClock::micros64() / 1000);
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(HostClock::micros64());
+}
+
+void delay(uint32_t ms) {
+    (void)ms;
+}
+
+void delayMicroseconds(uint32_t us) {
+    (void)us;
+}
+
+void yield() {
+}
+
+void configTime(long gmtOffset, int daylightOffset, const char* server1, const char* server2,
+                const char* server3) {
+    (void)gmtOffset;
+    (void)daylightOffset;
+    (void)server1;
+    (void)server2;
+    (void)server3;
+
+    if (sntpCallback) {
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        sntpCallback(&now);
+    }
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sntpCallback = callback;
+}
+
+void sntp_set_sync_interval(uint32_t intervalMs) {
+    (void)intervalMs;
+}
+
+void sntp_set_sync_mode(sntp_sync_mode_t mode) {
+    (void)mode;
+}
+
+// ------------------------------------------------------------------ System
+
+namespace {
+    const uint32_t HOST_HEAP_SIZE = 512UL * 1024 * 1024;
+    const UBaseType_t LOOP_TASK_STACK = 8192;
+
+    uint32_t minFreeHeap = HOST_HEAP_SIZE;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+    uint32_t freeHeap = used < HOST_HEAP_SIZE ? static_cast<uint32_t>(HOST_HEAP_SIZE - used) : 0;
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+    return freeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return minFreeHeap;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap();
+}
+
+esp_reset_reason_t esp_reset_reason() {
+    return ESP_RST_POWERON;
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                      return "ESP_OK";
+        case ESP_FAIL:                    return "ESP_FAIL";
+        case ESP_ERR_INVALID_ARG:         return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_SIZE:        return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:           return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_OTA_VALIDATE_FAILED: return "ESP_ERR_OTA_VALIDATE_FAILED";
+        default:                          return "UNKNOWN ERROR";
+    }
+}
+
+void esp_restart() {
+    fprintf(stderr, "[%s] esp_restart()\n", HostBoard::current().name.c_str());
+    exit(1);
+}
+
+esp_err_t esp_task_wdt_init(uint32_t timeoutSeconds, bool panic) {
+    (void)timeoutSeconds;
+    (void)panic;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(TaskHandle_t task) {
+    (void)task;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset() {
+    return ESP_OK;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return &HostBoard::current();
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+    (void)name;
+    return nullptr;
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+    (void)task;
+    static char loopTask[] = "loopTask";
+    return loopTask;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return LOOP_TASK_STACK;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+    return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    (void)task;
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    (void)clearOnExit;
+    (void)ticksToWait;
+    return 0;
+}
+
+int64_t esp_timer_get_time() {
+    return static_cast<int64_t>(HostClock::micros64());
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    (void)args;
+    *handle = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutMicros) {
+    (void)timer;
+    (void)timeoutMicros;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodMicros) {
+    (void)timer;
+    (void)periodMicros;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    (void)timer;
+    return ESP_OK;
+}
+
+// ------------------------------------------------------------------ ESP-NOW
+
+esp_err_t esp_now_init() {
+    return ESP_FAIL;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback) {
+    (void)callback;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+    (void)peer;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* peer) {
+    (void)peer;
+    return ESP_FAIL;
+}
+
+bool esp_now_is_peer_exist(const uint8_t* peer) {
+    (void)peer;
+    return false;
+}
+
+esp_err_t esp_now_send(const uint8_t* peer, const uint8_t* data, size_t length) {
+    (void)peer;
+    (void)data;
+    (void)length;
+    return ESP_FAIL;
+}
+
+// ------------------------------------------------------------------ Math
+
+long random(long max) {
+    return max > 0 ? random(0, max) : 0;
+}
+
+long random(long min, long max) {
+    if (min >= max) return min;
+    std::uniform_int_distribution<long> distribution(min, max - 1);
+    return distribution(randomEngine);
+}
+
+void randomSeed(unsigned long seed) {
+    randomEngine.seed(seed);
+}
+
+uint32_t esp_random() {
+    return static_cast<uint32_t>(randomEngine());
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ------------------------------------------------------------------ Print / Stream
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+
+    if (static_cast<size_t>(length) < sizeof(small)) {
+        return write(reinterpret_cast<const uint8_t*>(small), length);
+    }
+
+    std::string large(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(large.data()), length);
+}
+
+size_t Print::print(long value, int base) {
+    if (base == DEC) {
+        char buffer[24];
+        int length = snprintf(buffer, sizeof(buffer), "%ld", value);
+        return write(buffer, length);
+    }
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(long long value, int base) {
+    if (base == DEC) {
+        char buffer[24];
+        int length = snprintf(buffer, sizeof(buffer), "%lld", value);
+        return write(buffer, length);
+    }
+    return print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(double value, int digits) {
+    return print(String(value, static_cast<unsigned int>(digits)));
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+// ------------------------------------------------------------------ Serial
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    HostBoard& board = HostBoard::current();
+    if (!board.serialEnabled) return size;
+
+    for (size_t i = 0; i < size; i++) {
+        if (board.serialAtLineStart && !board.name.empty()) {
+            fprintf(stdout, "[%s] ", board.name.c_str());
+        }
+        if (buffer[i] != '\r') fputc(buffer[i], stdout);
+        board.serialAtLineStart = buffer[i] == '\n';
+    }
+    return size;
+}
+
+// ------------------------------------------------------------------ IPAddress
+
+IPAddress::IPAddress(uint32_t address) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (address >> (8 * i)) & 0xFF;
+    }
+}
+
+IPAddress::operator uint32_t() const {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+bool IPAddress::operator==(const IPAddress& other) const {
+    return memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+bool IPAddress::fromString(const char* address) {
+    unsigned int a, b, c, d;
+    if (sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    bytes[0] = a;
+    bytes[1] = b;
+    bytes[2] = c;
+    bytes[3] = d;
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return String(buffer);
+}
+
+size_t IPAddress::printTo(Print& p) const {
+    return p.print(toString());
+}
@@ -0,0 +1,23 @@
+#include <DHT.h>
+#include <DallasTemperature.h>
+#include "HostBoard.h"
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+    (void)force;
+    float celsius = HostBoard::current().airTemperature;
+    return fahrenheit ? celsius * 1.8f + 32.0f : celsius;
+}
+
+float DHT::readHumidity(bool force) {
+    (void)force;
+    return HostBoard::current().airHumidity;
+}
+
+uint8_t DallasTemperature::getDeviceCount() {
+    return HostBoard::current().oneWireDevices;
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+    HostBoard& board = HostBoard::current();
+    return index < board.oneWireDevices ? board.soilTemperature : DEVICE_DISCONNECTED_C;
+}
@@ -0,0 +1,200 @@
+#include <SPIFFS.h>
+#include "HostBoard.h"
+
+SPIFFSFS SPIFFS;
+
+namespace fs {
+    struct FileImpl {
+        HostBoard* board;
+        std::string path;
+        std::string baseName;
+        size_t pos;
+        bool directory;
+        bool writable;
+        bool open;
+        std::vector<std::string> entries;   // Directory listing taken at open time
+        size_t nextEntry;
+
+        std::vector<uint8_t>& data() { return board->files[path]; }
+    };
+
+    namespace {
+        std::shared_ptr<FileImpl> makeImpl(HostBoard& board, const std::string& path) {
+            std::shared_ptr<FileImpl> impl = std::make_shared<FileImpl>();
+            impl->board = &board;
+            impl->path = path;
+            size_t slash = path.rfind('/');
+            impl->baseName = slash == std::string::npos ? path : path.substr(slash + 1);
+            impl->pos = 0;
+            impl->directory = false;
+            impl->writable = false;
+            impl->open = true;
+            impl->nextEntry = 0;
+            return impl;
+        }
+
+        File openOnBoard(HostBoard& board, const char* path, const char* mode) {
+            std::string name = path ? path : "";
+            if (name.empty()) return File();
+
+            if (name == "/" || name.back() == '/') {
+                std::shared_ptr<FileImpl> impl = makeImpl(board, name);
+                impl->directory = true;
+                for (const auto& entry : board.files) {
+                    if (entry.first.compare(0, name.size(), name) == 0) impl->entries.push_back(entry.first);
+                }
+                return File(impl);
+            }
+
+            bool exists = board.files.count(name) > 0;
+            std::shared_ptr<FileImpl> impl = makeImpl(board, name);
+            switch (mode ? mode[0] : 'r') {
+                case 'w':
+                    board.files[name].clear();
+                    impl->writable = true;
+                    break;
+                case 'a':
+                    impl->pos = board.files[name].size();
+                    impl->writable = true;
+                    break;
+                default:
+                    if (!exists) return File();
+                    impl->writable = mode && mode[1] == '+';
+                    break;
+            }
+            return File(impl);
+        }
+    }
+
+    size_t File::write(uint8_t c) {
+        return write(&c, 1);
+    }
+
+    size_t File::write(const uint8_t* buffer, size_t size) {
+        if (!impl || !impl->open || !impl->writable) return 0;
+        std::vector<uint8_t>& data = impl->data();
+        if (impl->pos + size > data.size()) data.resize(impl->pos + size);
+        memcpy(data.data() + impl->pos, buffer, size);
+        impl->pos += size;
+        return size;
+    }
+
+    int File::available() {
+        if (!impl || !impl->open || impl->directory) return 0;
+        size_t length = impl->data().size();
+        return impl->pos < length ? static_cast<int>(length - impl->pos) : 0;
+    }
+
+    int File::read() {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int File::peek() {
+        if (available() <= 0) return -1;
+        return impl->data()[impl->pos];
+    }
+
+    size_t File::read(uint8_t* buffer, size_t size) {
+        size_t count = std::min(size, static_cast<size_t>(available()));
+        if (count == 0) return 0;
+        memcpy(buffer, impl->data().data() + impl->pos, count);
+        impl->pos += count;
+        return count;
+    }
+
+    bool File::seek(uint32_t position) {
+        if (!impl || !impl->open || position > impl->data().size()) return false;
+        impl->pos = position;
+        return true;
+    }
+
+    size_t File::position() const {
+        return impl ? impl->pos : 0;
+    }
+
+    size_t File::size() const {
+        if (!impl || impl->directory) return 0;
+        std::map<std::string, std::vector<uint8_t>>::const_iterator it = impl->board->files.find(impl->path);
+        return it == impl->board->files.end() ? 0 : it->second.size();
+    }
+
+    void File::close() {
+        if (impl) impl->open = false;
+    }
+
+    File::operator bool() const {
+        return impl && impl->open;
+    }
+
+    const char* File::name() const {
+        return impl ? impl->baseName.c_str() : "";
+    }
+
+    const char* File::path() const {
+        return impl ? impl->path.c_str() : "";
+    }
+
+    bool File::isDirectory() const {
+        return impl && impl->directory;
+    }
+
+    File File::openNextFile(const char* mode) {
+        if (!impl || !impl->directory) return File();
+        while (impl->nextEntry < impl->entries.size()) {
+            const std::string& path = impl->entries[impl->nextEntry++];
+            if (impl->board->files.count(path)) {
+                return openOnBoard(*impl->board, path.c_str(), mode);
+            }
+        }
+        return File();
+    }
+
+    void File::rewindDirectory() {
+        if (impl) impl->nextEntry = 0;
+    }
+
+    File FS::open(const char* path, const char* mode, bool create) {
+        (void)create;
+        return openOnBoard(HostBoard::current(), path, mode);
+    }
+
+    bool FS::exists(const char* path) {
+        return path && HostBoard::current().files.count(path) > 0;
+    }
+
+    bool FS::remove(const char* path) {
+        return path && HostBoard::current().files.erase(path) > 0;
+    }
+
+    bool FS::rename(const char* from, const char* to) {
+        std::map<std::string, std::vector<uint8_t>>& files = HostBoard::current().files;
+        std::map<std::string, std::vector<uint8_t>>::iterator it = files.find(from ? from : "");
+        if (it == files.end() || !to) return false;
+        std::vector<uint8_t> data = std::move(it->second);
+        files.erase(it);
+        files[to] = std::move(data);
+        return true;
+    }
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return true;
+}
+
+bool SPIFFSFS::format() {
+    HostBoard::current().files.clear();
+    return true;
+}
+
+size_t SPIFFSFS::usedBytes() {
+    size_t used = 0;
+    for (const auto& entry : HostBoard::current().files) {
+        used += entry.second.size();
+    }
+    return used;
+}
@@ -0,0 +1,84 @@
+#include "HostBoard.h"
+#include "Arduino.h"
+#include <math.h>
+#include <chrono>
+
+namespace {
+    HostBoard* selectedBoard = nullptr;
+    double clockSpeed = 1.0;
+    HostNetStats netStats = {};
+
+    const std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+}
+
+HostBoard::HostBoard() {
+    for (int i = 0; i < PIN_COUNT; i++) {
+        pinModes[i] = 0;
+        digitalLevels[i] = 1;    // Inputs idle high (pull-ups)
+        analogValues[i] = 0;
+        interruptHandlers[i] = nullptr;
+        interruptArgs[i] = nullptr;
+        interruptModes[i] = 0;
+    }
+    airTemperature = 25.0f;
+    airHumidity = 60.0f;
+    soilTemperature = 24.0f;
+    oneWireDevices = 1;
+    wifiAvailable = true;
+    wifiConnected = false;
+    networkEpoch = 0;
+    serialEnabled = false;
+    serialAtLineStart = true;
+    appLengths[0] = 0;
+    appLengths[1] = 0;
+    runningSlot = 0;
+    bootSlot = 0;
+}
+
+void HostBoard::dropNetwork() {
+    networkEpoch++;
+}
+
+void HostBoard::setInput(int pin, int level) {
+    if (pin < 0 || pin >= PIN_COUNT) return;
+    int previous = digitalLevels[pin];
+    digitalLevels[pin] = level;
+    if (!interruptHandlers[pin] || level == previous) return;
+
+    int edge = level ? RISING : FALLING;
+    if (interruptModes[pin] & edge) interruptHandlers[pin](interruptArgs[pin]);
+}
+
+HostBoard& HostBoard::current() {
+    static HostBoard fallback;
+    return selectedBoard ? *selectedBoard : fallback;
+}
+
+void HostBoard::select(HostBoard* board) {
+    selectedBoard = board;
+}
+
+namespace HostClock {
+    void setSpeed(double speed) {
+        clockSpeed = speed > 0 ? speed : 1.0;
+    }
+
+    double getSpeed() {
+        return clockSpeed;
+    }
+
+    uint64_t realMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - clockStart).count();
+    }
+
+    uint64_t micros64() {
+        return static_cast<uint64_t>(llround(realMicros() * clockSpeed));
+    }
+}
+
+namespace HostNet {
+    HostNetStats& stats() {
+        return netStats;
+    }
+}
@@ -0,0 +1,80 @@
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include <string.h>
+#include "HostBoard.h"
+#include "HostSha256.h"
+
+namespace {
+    const uint32_t SECTOR_SIZE = 4096;
+
+    // ota_0 and ota_1 of the Arduino default.csv
+    const esp_partition_t APP_PARTITIONS[2] = {
+        {0x10000, 0x140000, "app0", 0},
+        {0x150000, 0x140000, "app1", 1}
+    };
+
+    bool inRange(const esp_partition_t* partition, size_t offset, size_t size) {
+        return partition && offset <= partition->size && size <= partition->size - offset;
+    }
+
+    std::vector<uint8_t>& slotFlash(const esp_partition_t* partition, size_t end) {
+        std::vector<uint8_t>& flash = HostBoard::current().appSlots[partition->slot];
+        if (flash.size() < end) flash.resize(end, 0xFF);
+        return flash;
+    }
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+    if (!inRange(partition, srcOffset, size)) return ESP_ERR_INVALID_SIZE;
+    std::vector<uint8_t>& flash = slotFlash(partition, srcOffset + size);
+    memcpy(dst, flash.data() + srcOffset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size) {
+    if (!inRange(partition, dstOffset, size)) return ESP_ERR_INVALID_SIZE;
+    std::vector<uint8_t>& flash = slotFlash(partition, dstOffset + size);
+    // Like NOR flash, a write can only clear bits
+    const uint8_t* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; i++) flash[dstOffset + i] &= bytes[i];
+
+    uint32_t& length = HostBoard::current().appLengths[partition->slot];
+    if (dstOffset + size > length) length = static_cast<uint32_t>(dstOffset + size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (!inRange(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+    if (offset % SECTOR_SIZE || size % SECTOR_SIZE) return ESP_ERR_INVALID_ARG;
+    std::vector<uint8_t>& flash = slotFlash(partition, offset + size);
+    memset(flash.data() + offset, 0xFF, size);
+
+    // Images are written front to back, so an erase ends the one in the slot
+    uint32_t& length = HostBoard::current().appLengths[partition->slot];
+    if (length > offset) length = static_cast<uint32_t>(offset);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t* partition, uint8_t* sha256) {
+    if (!partition) return ESP_ERR_INVALID_ARG;
+    HostBoard& board = HostBoard::current();
+    uint32_t length = board.appLengths[partition->slot];
+    HostSha256::appImage(slotFlash(partition, length).data(), length, sha256);
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &APP_PARTITIONS[HostBoard::current().runningSlot];
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom) {
+    const esp_partition_t* from = startFrom ? startFrom : esp_ota_get_running_partition();
+    return &APP_PARTITIONS[1 - from->slot];
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    if (!partition) return ESP_ERR_INVALID_ARG;
+    if (HostBoard::current().appLengths[partition->slot] == 0) return ESP_ERR_OTA_VALIDATE_FAILED;
+    HostBoard::current().bootSlot = partition->slot;
+    return ESP_OK;
+}
@@ -0,0 +1,81 @@
+#include <Preferences.h>
+#include "HostBoard.h"
+
+namespace {
+    std::string entryKey(const String& ns, const char* key) {
+        return std::string(ns.c_str()) + "/" + key;
+    }
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (!name || strlen(name) > 15) return false;   // NVS namespace names are limited to 15 chars
+    ns = name;
+    this->readOnly = readOnly;
+    opened = true;
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    if (!opened || readOnly) return false;
+    std::map<std::string, std::vector<uint8_t>>& nvs = HostBoard::current().nvs;
+    std::string prefix = std::string(ns.c_str()) + "/";
+    for (auto it = nvs.begin(); it != nvs.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? nvs.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!opened || readOnly || !key) return false;
+    return HostBoard::current().nvs.erase(entryKey(ns, key)) > 0;
+}
+
+bool Preferences::isKey(const char* key) const {
+    return opened && key && HostBoard::current().nvs.count(entryKey(ns, key)) > 0;
+}
+
+bool Preferences::putRaw(const char* key, const void* value, size_t length) {
+    if (!opened || readOnly || !key || strlen(key) > 15) return false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    HostBoard::current().nvs[entryKey(ns, key)] = std::vector<uint8_t>(bytes, bytes + length);
+    return true;
+}
+
+bool Preferences::getRaw(const char* key, void* value, size_t length) const {
+    if (!isKey(key)) return false;
+    const std::vector<uint8_t>& stored = HostBoard::current().nvs.at(entryKey(ns, key));
+    if (stored.size() != length) return false;
+    memcpy(value, stored.data(), length);
+    return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    return putRaw(key, value, length) ? length : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) const {
+    if (!isKey(key)) return 0;
+    const std::vector<uint8_t>& stored = HostBoard::current().nvs.at(entryKey(ns, key));
+    if (stored.size() > maxLength) return 0;
+    memcpy(buffer, stored.data(), stored.size());
+    return stored.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) const {
+    return isKey(key) ? HostBoard::current().nvs.at(entryKey(ns, key)).size() : 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putRaw(key, value.c_str(), value.length() + 1) ? value.length() : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) const {
+    if (!isKey(key)) return defaultValue;
+    const std::vector<uint8_t>& stored = HostBoard::current().nvs.at(entryKey(ns, key));
+    return String(reinterpret_cast<const char*>(stored.data()));
+}
@@ -0,0 +1,184 @@
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+    std::string formatUnsigned(unsigned long long value, unsigned char base) {
+        if (base < 2 || base > 36) base = 10;
+        if (value == 0) return "0";
+
+        std::string digits;
+        while (value > 0) {
+            unsigned digit = value % base;
+            digits.push_back(static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10));
+            value /= base;
+        }
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    std::string formatSigned(long long value, unsigned char base) {
+        if (base == 10 && value < 0) {
+            return "-" + formatUnsigned(static_cast<unsigned long long>(-(value + 1)) + 1, base);
+        }
+        return formatUnsigned(static_cast<unsigned long long>(value), base);
+    }
+
+    std::string formatFloat(double value, unsigned int decimalPlaces) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+        return buffer;
+    }
+}
+
+String::String(const char* cstr) : buffer(cstr ? cstr : "") {}
+String::String(char c) : buffer(1, c) {}
+String::String(unsigned char value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : buffer(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : buffer(formatFloat(value, decimalPlaces)) {}
+
+String& String::operator=(const char* cstr) {
+    buffer = cstr ? cstr : "";
+    return *this;
+}
+
+bool String::reserve(unsigned int size) {
+    buffer.reserve(size);
+    return true;
+}
+
+bool String::concat(const String& str) { buffer += str.buffer; return true; }
+bool String::concat(const char* cstr) { if (!cstr) return false; buffer += cstr; return true; }
+bool String::concat(const char* cstr, unsigned int length) { if (!cstr) return false; buffer.append(cstr, length); return true; }
+bool String::concat(char c) { buffer += c; return true; }
+bool String::concat(unsigned char value) { return concat(String(value)); }
+bool String::concat(int value) { return concat(String(value)); }
+bool String::concat(unsigned int value) { return concat(String(value)); }
+bool String::concat(long value) { return concat(String(value)); }
+bool String::concat(unsigned long value) { return concat(String(value)); }
+bool String::concat(float value) { return concat(String(value)); }
+bool String::concat(double value) { return concat(String(value)); }
+
+int String::compareTo(const String& s) const {
+    return buffer.compare(s.buffer);
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (buffer.size() != s.buffer.size()) return false;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        if (tolower(static_cast<unsigned char>(buffer[i])) != tolower(static_cast<unsigned char>(s.buffer[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+    return offset <= buffer.size() && buffer.compare(offset, prefix.buffer.size(), prefix.buffer) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return buffer.size() >= suffix.buffer.size() &&
+           buffer.compare(buffer.size() - suffix.buffer.size(), suffix.buffer.size(), suffix.buffer) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+    return index < buffer.size() ? buffer[index] : '\0';
+}
+
+void String::setCharAt(unsigned int index, char c) {
+    if (index < buffer.size()) buffer[index] = c;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = buffer.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = buffer.find(str.buffer, fromIndex);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t pos = buffer.rfind(ch);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = buffer.rfind(str.buffer);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, buffer.size());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) std::swap(beginIndex, endIndex);
+    if (beginIndex >= buffer.size()) return String();
+    endIndex = std::min<unsigned int>(endIndex, buffer.size());
+    return String(buffer.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::replace(char find, char replace) {
+    std::replace(buffer.begin(), buffer.end(), find, replace);
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find.buffer.empty()) return;
+    size_t pos = 0;
+    while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+        buffer.replace(pos, find.buffer.size(), replace.buffer);
+        pos += replace.buffer.size();
+    }
+}
+
+void String::remove(unsigned int index) {
+    if (index < buffer.size()) buffer.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < buffer.size()) buffer.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (char& c : buffer) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+void String::toUpperCase() {
+    for (char& c : buffer) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+}
+
+void String::trim() {
+    size_t begin = 0;
+    while (begin < buffer.size() && isspace(static_cast<unsigned char>(buffer[begin]))) begin++;
+    size_t end = buffer.size();
+    while (end > begin && isspace(static_cast<unsigned char>(buffer[end - 1]))) end--;
+    buffer = buffer.substr(begin, end - begin);
+}
+
+long String::toInt() const {
+    return strtol(buffer.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return strtof(buffer.c_str(), nullptr);
+}
+
+double String::toDouble() const {
+    return strtod(buffer.c_str(), nullptr);
+}
@@ -0,0 +1,259 @@
+#include <WiFi.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "HostBoard.h"
+
+WiFiClass WiFi;
+
+namespace {
+    const int CONNECT_TIMEOUT_MS = 3000;
+    const uint8_t MQTT_PUBLISH = 0x30;
+}
+
+// ------------------------------------------------------------------ WiFiClass
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    (void)passphrase;
+    (void)channel;
+    (void)bssid;
+    HostBoard& board = HostBoard::current();
+    board.wifiSsid = ssid ? ssid : "";
+    board.wifiConnected = connect;
+    return status();
+}
+
+wl_status_t WiFiClass::status() {
+    // The station reconnects on its own once the access point is back, like the ESP32 does
+    HostBoard& board = HostBoard::current();
+    return board.wifiConnected && board.wifiAvailable ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1,
+                       IPAddress dns2) {
+    // Every board shares the host's address; a static configuration changes nothing
+    (void)localIP;
+    (void)gateway;
+    (void)subnet;
+    (void)dns1;
+    (void)dns2;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    (void)wifiOff;
+    (void)eraseAp;
+    HostBoard& board = HostBoard::current();
+    board.wifiConnected = false;
+    board.dropNetwork();
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    HostBoard& board = HostBoard::current();
+    board.wifiConnected = board.wifiAvailable;
+    return board.wifiConnected;
+}
+
+String WiFiClass::SSID() {
+    return String(HostBoard::current().wifiSsid.c_str());
+}
+
+String WiFiClass::macAddress() {
+    return String("02:00:00:00:00:01");
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) {
+    static const uint8_t ADDRESS[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(mac, ADDRESS, sizeof(ADDRESS));
+    return mac;
+}
+
+IPAddress WiFiClass::localIP() {
+    return IPAddress(127, 0, 0, 1);
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return IPAddress(127, 0, 0, 1);
+}
+
+IPAddress WiFiClass::subnetMask() {
+    return IPAddress(255, 0, 0, 0);
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index) {
+    (void)index;
+    return IPAddress(127, 0, 0, 53);
+}
+
+int8_t WiFiClass::RSSI() {
+    return -55;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    static uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x0A};
+    return bssid;
+}
+
+// ------------------------------------------------------------------ WiFiClient
+
+WiFiClient::WiFiClient() : fd(-1), board(nullptr), epoch(0) {
+}
+
+WiFiClient::~WiFiClient() {
+    stop();
+}
+
+bool WiFiClient::checkBoard() {
+    if (fd < 0) return false;
+    if (board && (board->networkEpoch != epoch || !board->wifiConnected || !board->wifiAvailable)) {
+        stop();     // Network dropped under the connection
+        return false;
+    }
+    return true;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    HostNetStats& stats = HostNet::stats();
+    board = &HostBoard::current();
+    epoch = board->networkEpoch;
+
+    if (!board->wifiConnected || !board->wifiAvailable) {
+        stats.connectFailures++;
+        return 0;
+    }
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host, service, &hints, &result) != 0) {
+        stats.connectFailures++;
+        return 0;
+    }
+
+    for (struct addrinfo* addr = result; addr && fd < 0; addr = addr->ai_next) {
+        int sock = socket(addr->ai_family, addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, addr->ai_protocol);
+        if (sock < 0) continue;
+
+        int rc = ::connect(sock, addr->ai_addr, addr->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = {sock, POLLOUT, 0};
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (poll(&pfd, 1, CONNECT_TIMEOUT_MS) == 1 &&
+                getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                rc = 0;
+            }
+        }
+        if (rc == 0) {
+            int one = 1;
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            fd = sock;
+        } else {
+            close(sock);
+        }
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0) {
+        stats.connectFailures++;
+        return 0;
+    }
+    stats.connects++;
+    return 1;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!checkBoard()) return 0;
+
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, CONNECT_TIMEOUT_MS) <= 0) break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            stop();
+            break;
+        }
+    }
+
+    HostNetStats& stats = HostNet::stats();
+    stats.bytesSent += sent;
+    if (sent > 0 && (buffer[0] & 0xF0) == MQTT_PUBLISH) stats.mqttPublishes++;
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (!checkBoard()) return 0;
+
+    int count = 0;
+    if (ioctl(fd, FIONREAD, &count) < 0) return 0;
+    if (count == 0) {
+        // Distinguish "nothing yet" from a closed peer
+        uint8_t probe;
+        ssize_t n = recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) stop();
+    }
+    return count;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (!checkBoard()) return -1;
+
+    ssize_t n = recv(fd, buffer, size, MSG_DONTWAIT);
+    if (n > 0) {
+        HostNet::stats().bytesReceived += n;
+        return static_cast<int>(n);
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) stop();
+    return -1;
+}
+
+int WiFiClient::peek() {
+    if (!checkBoard()) return -1;
+
+    uint8_t c;
+    return recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+void WiFiClient::stop() {
+    if (fd < 0) return;
+    close(fd);
+    fd = -1;
+    HostNet::stats().disconnects++;
+}
+
+uint8_t WiFiClient::connected() {
+    if (!checkBoard()) return 0;
+    available();    // Notices a closed peer
+    return fd >= 0;
+}
@@ -0,0 +1,475 @@
+// End-to-end latency of remote relay commands: publish {"relayStatus":...} on
+// sf/<id>/relay/command and timestamp every stage until the relay GPIO flips
+// and the relay log comes back from the broker.
+//
+//   latency_bench --devices 20 --rates 1,10,50 --phase 60
+//
+// Devices run the firmware's IrrigationApp (built with -DLATENCY_TRACE) on
+// host boards, ticked from one event loop like tools/fleet_sim. See README.md.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <WiFiClient.h>
+#include "VirtualDevice.h"
+#include "network/MQTTTransport.h"
+#include "utils/LatencyTrace.h"
+
+namespace {
+    // Stages of one command, in path order; all stamps are real time (us)
+    enum Stage : uint8_t {
+        BROKER_RECEIPT = 0,          // Our own subscription saw the command: broker accepted and fanned it out
+        MESSAGE_RECEIVED,            // handleMessage()
+        COMMAND_TAKEN,               // controlPump()
+        RELAY_SET,                   // setRelayState()
+        GPIO_CHANGED,                // digitalWrite() on the relay pin
+        RELAY_LOG_PUBLISHED,         // publishRelayLog() returned (message queued)
+        RELAY_LOG_RECEIVED,          // Relay log delivered back to us by the broker, as to the backend
+        STAGE_COUNT
+    };
+
+    const char* STAGE_NAMES[STAGE_COUNT] = {
+        "broker receipt", "handleMessage()", "controlPump()", "setRelayState()",
+        "relay GPIO", "relay log queued", "relay log delivered"
+    };
+
+    struct Options {
+        BrokerConfig broker;
+        int devices;
+        std::vector<double> rates;  // Commands per second over the whole fleet, one phase each
+        double phaseSeconds;
+        double warmupSeconds;
+        double timeoutSeconds;
+        double speed;
+        double tickMs;
+        bool poisson;               // Random arrivals; fixed gaps alias with the device tick
+        bool alwaysOn;              // Disable radio duty cycling on the devices
+        uint32_t seed;
+        std::string csvPath;
+    };
+
+    struct Command {
+        bool inFlight;
+        bool status;
+        uint64_t sentAt;
+        uint64_t stamps[STAGE_COUNT];
+    };
+
+    struct Sample {
+        uint64_t stamps[STAGE_COUNT];   // Relative to the publish; 0 = not reached
+    };
+
+    struct PhaseResult {
+        double rate;
+        uint64_t sent;
+        uint64_t completed;
+        uint64_t timeouts;
+        uint64_t skipped;           // No idle device when a command was due
+        std::vector<Sample> samples;
+    };
+
+    volatile sig_atomic_t stopRequested = 0;
+
+    std::vector<std::unique_ptr<VirtualDevice>> devices;
+    std::vector<Command> commands;
+    std::unordered_map<const HostBoard*, size_t> boardIndex;
+    std::unordered_map<std::string, size_t> idIndex;
+    PhaseResult* currentPhase = nullptr;
+    FILE* csv = nullptr;
+
+    void onSignal(int) {
+        stopRequested = 1;
+    }
+
+    void stamp(size_t device, Stage stage) {
+        Command& command = commands[device];
+        if (command.inFlight && command.stamps[stage] == 0) {
+            command.stamps[stage] = HostClock::realMicros();
+        }
+    }
+
+    // Called from inside the firmware, with the device's board selected
+    void onTracePoint(LatencyTrace::Stage stage) {
+        auto it = boardIndex.find(&HostBoard::current());
+        if (it == boardIndex.end()) return;
+
+        switch (stage) {
+            case LatencyTrace::STAGE_MESSAGE_RECEIVED: stamp(it->second, MESSAGE_RECEIVED); break;
+            case LatencyTrace::STAGE_COMMAND_TAKEN: stamp(it->second, COMMAND_TAKEN); break;
+            case LatencyTrace::STAGE_RELAY_SET: stamp(it->second, RELAY_SET); break;
+            case LatencyTrace::STAGE_RELAY_LOG_PUBLISHED:
+                // Automatic relay changes publish logs too; only count the one following our command
+                if (commands[it->second].stamps[RELAY_SET]) stamp(it->second, RELAY_LOG_PUBLISHED);
+                break;
+            default: break;
+        }
+    }
+
+    void finish(size_t device) {
+        Command& command = commands[device];
+        command.inFlight = false;
+        if (!currentPhase) return;
+
+        Sample sample = {};
+        for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) {
+            if (command.stamps[stage]) sample.stamps[stage] = command.stamps[stage] - command.sentAt;
+        }
+        currentPhase->samples.push_back(sample);
+        if (sample.stamps[RELAY_LOG_RECEIVED]) currentPhase->completed++;
+
+        if (csv) {
+            fprintf(csv, "%.1f,%s,%d", currentPhase->rate, devices[device]->getId().c_str(), command.status ? 1 : 0);
+            for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) {
+                fprintf(csv, ",%llu", (unsigned long long)sample.stamps[stage]);
+            }
+            fprintf(csv, "\n");
+        }
+    }
+
+    // Topics are sf/<id>/relay/command (our own command echoed) and sf/<id>/relay (relay log)
+    void onBenchMessage(char* topic, uint8_t* payload, unsigned int length) {
+        std::string path = topic;
+        if (path.compare(0, 3, "sf/") != 0) return;
+        size_t slash = path.find('/', 3);
+        if (slash == std::string::npos) return;
+
+        auto it = idIndex.find(path.substr(3, slash - 3));
+        if (it == idIndex.end()) return;
+        size_t device = it->second;
+        std::string suffix = path.substr(slash);
+
+        if (suffix == "/relay/command") {
+            stamp(device, BROKER_RECEIPT);
+        } else if (suffix == "/relay" && commands[device].stamps[RELAY_LOG_PUBLISHED]) {
+            std::string message(reinterpret_cast<char*>(payload), length);
+            if (message.find("Remote MQTT command") == std::string::npos) return;
+            stamp(device, RELAY_LOG_RECEIVED);
+            finish(device);
+        }
+    }
+
+    uint64_t percentile(std::vector<uint64_t>& values, double p) {
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    void printPhase(const PhaseResult& phase) {
+        printf("\n== %.1f commands/s: %llu sent, %llu completed, %llu timed out, %llu skipped ==\n",
+               phase.rate, (unsigned long long)phase.sent, (unsigned long long)phase.completed,
+               (unsigned long long)phase.timeouts, (unsigned long long)phase.skipped);
+        printf("  %-22s %10s %10s %10s %10s   %s\n", "since publish (ms)", "p50", "p99", "p999", "max",
+               "p50 of step");
+
+        for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) {
+            std::vector<uint64_t> total;
+            std::vector<uint64_t> step;
+            for (const Sample& sample : phase.samples) {
+                if (!sample.stamps[stage]) continue;
+                total.push_back(sample.stamps[stage]);
+
+                // Step from the closest earlier stage that was reached
+                uint64_t previous = 0;
+                for (int before = stage - 1; before >= 0; before--) {
+                    if (sample.stamps[before] && sample.stamps[before] <= sample.stamps[stage]) {
+                        previous = sample.stamps[before];
+                        break;
+                    }
+                }
+                step.push_back(sample.stamps[stage] - previous);
+            }
+            if (total.empty()) {
+                printf("  %-22s %10s\n", STAGE_NAMES[stage], "-");
+                continue;
+            }
+
+            std::sort(total.begin(), total.end());
+            std::sort(step.begin(), step.end());
+            printf("  %-22s %10.2f %10.2f %10.2f %10.2f   %.2f\n", STAGE_NAMES[stage],
+                   percentile(total, 0.5) / 1000.0, percentile(total, 0.99) / 1000.0,
+                   percentile(total, 0.999) / 1000.0, total.back() / 1000.0, percentile(step, 0.5) / 1000.0);
+        }
+        if (phase.samples.size() < 1000) {
+            printf("  (%zu samples: p999 is the maximum below 1000 samples)\n", phase.samples.size());
+        }
+        fflush(stdout);
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: latency_bench [options]\n"
+                "  --devices N            virtual devices receiving commands (default 10)\n"
+                "  --rates R1,R2,...      command rates over the whole fleet, commands/s (default 1)\n"
+                "  --phase S              real seconds per rate (default 60)\n"
+                "  --warmup S             real seconds before the first phase (default 10)\n"
+                "  --timeout S            give up on a command after S seconds (default 180)\n"
+                "  --fixed                evenly spaced commands instead of random (Poisson) arrivals\n"
+                "  --always-on            keep the devices' modem and WiFi on (no radio duty cycling)\n"
+                "  --broker HOST --port P --user U --password P\n"
+                "  --speed X              firmware clock speed-up for background load (default 1)\n"
+                "  --tick-ms MS           real ms between loop() passes per device (default 100, as on the board)\n"
+                "  --csv FILE             write every command's stage times (us since publish)\n"
+                "  --seed N               random seed (default 1)\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        options.broker = {"127.0.0.1", 1883, "", ""};
+        options.devices = 10;
+        options.rates = {1.0};
+        options.phaseSeconds = 60;
+        options.warmupSeconds = 10;
+        options.timeoutSeconds = 180;
+        options.speed = 1;
+        options.tickMs = 100;
+        options.poisson = true;
+        options.alwaysOn = false;
+        options.seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--fixed") {
+                options.poisson = false;
+                continue;
+            }
+            if (arg == "--always-on") {
+                options.alwaysOn = true;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+            const char* value = argv[++i];
+
+            if (arg == "--devices") options.devices = atoi(value);
+            else if (arg == "--rates") {
+                options.rates.clear();
+                for (char* cursor = const_cast<char*>(value); *cursor; ) {
+                    options.rates.push_back(strtod(cursor, &cursor));
+                    if (*cursor == ',') cursor++;
+                    else if (*cursor) return false;
+                }
+            }
+            else if (arg == "--phase") options.phaseSeconds = atof(value);
+            else if (arg == "--warmup") options.warmupSeconds = atof(value);
+            else if (arg == "--timeout") options.timeoutSeconds = atof(value);
+            else if (arg == "--broker") options.broker.host = value;
+            else if (arg == "--port") options.broker.port = atoi(value);
+            else if (arg == "--user") options.broker.user = value;
+            else if (arg == "--password") options.broker.password = value;
+            else if (arg == "--speed") options.speed = atof(value);
+            else if (arg == "--tick-ms") options.tickMs = atof(value);
+            else if (arg == "--csv") options.csvPath = value;
+            else if (arg == "--seed") options.seed = strtoul(value, nullptr, 10);
+            else return false;
+        }
+
+        for (double rate : options.rates) {
+            if (rate <= 0) return false;
+        }
+        return options.devices > 0 && !options.rates.empty() && options.speed > 0 && options.tickMs > 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    HostClock::setSpeed(options.speed);
+    randomSeed(options.seed);
+    LatencyTrace::hook = onTracePoint;
+
+    if (!options.csvPath.empty()) {
+        csv = fopen(options.csvPath.c_str(), "w");
+        if (!csv) {
+            fprintf(stderr, "cannot write %s\n", options.csvPath.c_str());
+            return 1;
+        }
+        fprintf(csv, "rate,device,status");
+        for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) fprintf(csv, ",%s", STAGE_NAMES[stage]);
+        fprintf(csv, "\n");
+    }
+
+    // Command injector: a plain MQTT client on its own board
+    HostBoard benchBoard;
+    benchBoard.name = "bench";
+    benchBoard.wifiConnected = true;
+    HostBoard::select(&benchBoard);
+    WiFiClient benchNet;
+    OutboundQueue benchQueue;
+    MQTTTransport bench(benchNet, benchQueue);
+    bench.setServer(options.broker.host.c_str(), options.broker.port);
+    bench.setCredentials("latency-bench", options.broker.user.empty() ? nullptr : options.broker.user.c_str(),
+                         options.broker.password.c_str());
+    bench.setInflightWindow(32);
+    bench.setMessageCallback(onBenchMessage);
+    bench.subscribe("sf/+/relay/command", 1);
+    bench.subscribe("sf/+/relay", 1);
+    if (bench.connect()) {
+        uint64_t deadline = HostClock::realMicros() + 5000000;
+        while (bench.connecting() && HostClock::realMicros() < deadline) {
+            bench.loop();
+            usleep(1000);
+        }
+    }
+    if (!bench.connected()) {
+        fprintf(stderr, "cannot connect to %s:%d (state %d)\n", options.broker.host.c_str(), options.broker.port,
+                bench.getState());
+        return 1;
+    }
+    HostBoard::select(nullptr);
+
+    const FaultConfig noFaults = {0, 0, 0};
+    uint64_t tickPeriod = static_cast<uint64_t>(options.tickMs * 1000.0);
+    std::vector<uint64_t> nextTick;
+    for (int i = 0; i < options.devices; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "bench-%04d", i);
+        devices.emplace_back(new VirtualDevice(id, options.broker, options.seed * 7919u + i, false));
+        commands.push_back(Command());
+        commands.back().inFlight = false;
+        boardIndex[&devices.back()->getBoard()] = i;
+        idIndex[id] = i;
+
+        devices.back()->getBoard().onDigitalWrite = [i](int pin, int) {
+            if (pin == Pins::RELAY_PIN && commands[i].stamps[RELAY_SET]) stamp(i, GPIO_CHANGED);
+        };
+        devices.back()->getApp().getRadio().setDutyCycling(!options.alwaysOn);
+        devices.back()->setup(noFaults);
+        nextTick.push_back(HostClock::realMicros() + tickPeriod * i / options.devices);
+    }
+
+    printf("latency_bench: %d devices -> %s:%d, tick %.0f ms, %zu phase(s) of %.0f s\n", options.devices,
+           options.broker.host.c_str(), options.broker.port, options.tickMs, options.rates.size(),
+           options.phaseSeconds);
+    fflush(stdout);
+
+    std::vector<PhaseResult> results;
+    results.reserve(options.rates.size());
+    uint64_t timeout = static_cast<uint64_t>(options.timeoutSeconds * 1e6);
+    uint64_t now = HostClock::realMicros();
+    uint64_t phaseEnd = now + static_cast<uint64_t>(options.warmupSeconds * 1e6);
+    uint64_t nextCommand = UINT64_MAX;
+    size_t phaseIndex = 0;
+    size_t cursor = 0;
+    bool warmingUp = true;
+
+    while (!stopRequested) {
+        now = HostClock::realMicros();
+
+        // A phase stops injecting at phaseEnd and is reported once its last command finished
+        if (now >= phaseEnd) nextCommand = UINT64_MAX;
+        bool idle = std::none_of(commands.begin(), commands.end(), [](const Command& c) { return c.inFlight; });
+        if (now >= phaseEnd && idle) {
+            if (!warmingUp) {
+                printPhase(*currentPhase);
+                phaseIndex++;
+            }
+            warmingUp = false;
+            if (phaseIndex >= options.rates.size()) break;
+
+            results.push_back(PhaseResult());
+            currentPhase = &results.back();
+            currentPhase->rate = options.rates[phaseIndex];
+            currentPhase->sent = currentPhase->completed = currentPhase->timeouts = currentPhase->skipped = 0;
+            phaseEnd = now + static_cast<uint64_t>(options.phaseSeconds * 1e6);
+            nextCommand = now;
+        }
+
+        // Inject due commands, one in flight per device
+        while (now >= nextCommand) {
+            size_t device = options.devices;
+            for (int n = 0; n < options.devices; n++) {
+                size_t candidate = (cursor + n) % options.devices;
+                if (!commands[candidate].inFlight) {
+                    device = candidate;
+                    break;
+                }
+            }
+
+            if (device == static_cast<size_t>(options.devices)) {
+                currentPhase->skipped++;
+            } else {
+                cursor = device + 1;
+                Command& command = commands[device];
+                command.status = !devices[device]->getApp().getZones().zone(0).relay.isRelayActive();
+
+                std::string payload = command.status ? "{\"relayStatus\":true}" : "{\"relayStatus\":false}";
+                HostBoard::select(&benchBoard);
+                command.inFlight = true;
+                memset(command.stamps, 0, sizeof(command.stamps));
+                command.sentAt = HostClock::realMicros();
+                // QoS 1 like the dashboard, so the device's persistent session matters
+                bench.publish(devices[device]->getRelayCommandTopic().c_str(),
+                              reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), 1, false);
+                bench.loop();
+                HostBoard::select(nullptr);
+                currentPhase->sent++;
+            }
+
+            double gap = 1e6 / currentPhase->rate;
+            if (options.poisson) gap *= -log(1.0 - random(1000000) / 1000000.0);
+            nextCommand += static_cast<uint64_t>(std::max(gap, 1.0));
+        }
+
+        for (size_t i = 0; i < devices.size(); i++) {
+            now = HostClock::realMicros();
+            if (now >= nextTick[i]) {
+                devices[i]->tick(noFaults);
+                nextTick[i] = std::max(nextTick[i] + tickPeriod, now);
+
+                // Pick up broker echoes and relay logs as soon as the device has published
+                HostBoard::select(&benchBoard);
+                bench.loop();
+                HostBoard::select(nullptr);
+            }
+        }
+        HostBoard::select(&benchBoard);
+        bench.loop();
+        HostBoard::select(nullptr);
+
+        now = HostClock::realMicros();
+        for (size_t i = 0; i < commands.size(); i++) {
+            if (commands[i].inFlight && now - commands[i].sentAt > timeout) {
+                if (currentPhase) currentPhase->timeouts++;
+                finish(i);
+            }
+        }
+
+        uint64_t wake = std::min(nextCommand, *std::min_element(nextTick.begin(), nextTick.end()));
+        if (phaseEnd > now) wake = std::min(wake, phaseEnd);
+        if (wake > now) usleep(static_cast<useconds_t>(std::min<uint64_t>(wake - now, 1000)));
+    }
+
+    if (stopRequested && !warmingUp && phaseIndex < options.rates.size()) {
+        printPhase(*currentPhase);
+    }
+    if (csv) fclose(csv);
+
+    for (std::unique_ptr<VirtualDevice>& device : devices) {
+        HostBoard::select(&device->getBoard());
+        device->getApp().getMqttClient().disconnect();
+        HostBoard::select(nullptr);
+    }
+    HostBoard::select(&benchBoard);
+    bench.disconnect();
+    HostBoard::select(nullptr);
+    return 0;
+}
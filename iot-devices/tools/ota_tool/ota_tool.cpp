@@ -0,0 +1,239 @@
+// Host-side companion of the device's OTA updater: builds SFD1 deltas
+// between two firmware images, checks them by decoding them with the
+// firmware's own DeltaPatch, and prints the offer the backend publishes on
+// sf/<deviceId>/ota. See README.md.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HostSha256.h"
+#include "ota/DeltaPatch.h"
+
+namespace {
+    const size_t BLOCK = 16;                     // Bytes hashed to find copy candidates
+    const size_t MIN_COPY = 24;                  // Shorter matches cost more as a copy than inserted
+
+    bool readFile(const char* path, std::vector<uint8_t>& data) {
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+        uint8_t buffer[65536];
+        size_t count;
+        data.clear();
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + count);
+        fclose(file);
+        return true;
+    }
+
+    bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+        FILE* file = fopen(path, "wb");
+        if (!file || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+            fprintf(stderr, "cannot write %s\n", path);
+            if (file) fclose(file);
+            return false;
+        }
+        fclose(file);
+        return true;
+    }
+
+    // Identifies an image the way the device does (see HostSha256::appImage)
+    std::string sha256(const std::vector<uint8_t>& data) {
+        uint8_t digest[32];
+        HostSha256::appImage(data.data(), data.size(), digest);
+        return HostSha256::hex(digest);
+    }
+
+    // ------------------------------------------------------------------ delta
+
+    void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint64_t blockHash(const uint8_t* data) {
+        uint64_t hash = 1469598103934665603ull;
+        for (size_t i = 0; i < BLOCK; i++) hash = (hash ^ data[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    void emitInsert(std::vector<uint8_t>& patch, const std::vector<uint8_t>& image, size_t from, size_t to) {
+        if (to <= from) return;
+        patch.push_back(DeltaPatch::OP_INSERT);
+        putVarint(patch, static_cast<uint32_t>(to - from));
+        patch.insert(patch.end(), image.begin() + from, image.begin() + to);
+    }
+
+    // Greedy: at each position, try the copy that continues the previous one (code after a
+    // small change keeps its layout), then any earlier block with the same hash
+    std::vector<uint8_t> makeDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image,
+                                   size_t& copies, size_t& copied) {
+        std::unordered_map<uint64_t, uint32_t> index;
+        index.reserve(base.size());
+        for (size_t i = 0; i + BLOCK <= base.size(); i++) index.emplace(blockHash(&base[i]), static_cast<uint32_t>(i));
+
+        std::vector<uint8_t> patch;
+        uint32_t magic = DeltaPatch::MAGIC;
+        for (int i = 0; i < 4; i++) patch.push_back(static_cast<uint8_t>(magic >> (8 * i)));
+        putVarint(patch, static_cast<uint32_t>(image.size()));
+
+        size_t pos = 0;
+        size_t pending = 0;                      // Start of bytes not yet emitted
+        long drift = 0;                          // Source minus target offset of the last copy
+        copies = copied = 0;
+        auto matchLength = [&](size_t source, size_t target) {
+            size_t length = 0;
+            while (source + length < base.size() && target + length < image.size() &&
+                   base[source + length] == image[target + length]) {
+                length++;
+            }
+            return length;
+        };
+
+        while (pos + BLOCK <= image.size()) {
+            size_t source = 0;
+            size_t length = 0;
+            long continued = static_cast<long>(pos) + drift;
+            if (continued >= 0 && static_cast<size_t>(continued) < base.size()) {
+                source = static_cast<size_t>(continued);
+                length = matchLength(source, pos);
+            }
+            if (length < MIN_COPY) {
+                auto found = index.find(blockHash(&image[pos]));
+                if (found != index.end()) {
+                    size_t candidate = matchLength(found->second, pos);
+                    if (candidate > length) {
+                        source = found->second;
+                        length = candidate;
+                    }
+                }
+            }
+            if (length < MIN_COPY) {
+                pos++;
+                continue;
+            }
+
+            // Grow the match backwards over bytes that would otherwise be inserted
+            while (pos > pending && source > 0 && base[source - 1] == image[pos - 1]) {
+                pos--;
+                source--;
+                length++;
+            }
+            emitInsert(patch, image, pending, pos);
+            patch.push_back(DeltaPatch::OP_COPY);
+            putVarint(patch, static_cast<uint32_t>(source));
+            putVarint(patch, static_cast<uint32_t>(length));
+            copies++;
+            copied += length;
+            drift = static_cast<long>(source) - static_cast<long>(pos);
+            pos += length;
+            pending = pos;
+        }
+        emitInsert(patch, image, pending, image.size());
+        patch.push_back(DeltaPatch::OP_END);
+        return patch;
+    }
+
+    // Decodes like the device: 4 KB sector buffer, source reads from the base image
+    class BufferSink : public DeltaPatch::Sink {
+    public:
+        const std::vector<uint8_t>& base;
+        std::vector<uint8_t> output;
+        size_t sectorFill = 0;
+
+        explicit BufferSink(const std::vector<uint8_t>& base) : base(base) {}
+
+        size_t room() override { return 4096 - sectorFill; }
+        bool write(const uint8_t* data, size_t length) override {
+            output.insert(output.end(), data, data + length);
+            sectorFill = (sectorFill + length) % 4096;
+            return true;
+        }
+        bool readSource(uint32_t offset, uint8_t* buffer, size_t length) override {
+            if (offset + length > base.size()) return false;
+            memcpy(buffer, &base[offset], length);
+            return true;
+        }
+    };
+
+    bool apply(const std::vector<uint8_t>& base, const std::vector<uint8_t>& patch, std::vector<uint8_t>& image) {
+        BufferSink sink(base);
+        DeltaPatch decoder;
+        decoder.begin(sink, false, 0, static_cast<uint32_t>(base.size()));
+
+        // In MQTT-sized chunks, as the device receives it
+        DeltaPatch::Result result = DeltaPatch::OK;
+        for (size_t offset = 0; offset < patch.size() && result == DeltaPatch::OK; offset += 1024) {
+            size_t length = patch.size() - offset < 1024 ? patch.size() - offset : 1024;
+            result = decoder.feed(&patch[offset], length);
+        }
+        if (result != DeltaPatch::DONE) {
+            fprintf(stderr, "patch rejected: %s\n", DeltaPatch::resultName(result));
+            return false;
+        }
+        image.swap(sink.output);
+        return true;
+    }
+
+    int usage() {
+        fprintf(stderr,
+                "usage: ota_tool delta <running.bin> <new.bin> <patch.sfd>\n"
+                "       ota_tool apply <running.bin> <patch.sfd> <out.bin>\n"
+                "       ota_tool offer <new.bin> <version> [<running.bin> <patch.sfd>]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    std::string command = argv[1];
+
+    if (command == "delta" && argc == 5) {
+        std::vector<uint8_t> base, image;
+        if (!readFile(argv[2], base) || !readFile(argv[3], image)) return 1;
+        size_t copies, copied;
+        std::vector<uint8_t> patch = makeDelta(base, image, copies, copied);
+
+        std::vector<uint8_t> check;
+        if (!apply(base, patch, check) || check != image) {
+            fprintf(stderr, "internal error: the patch does not rebuild the image\n");
+            return 1;
+        }
+        if (!writeFile(argv[4], patch)) return 1;
+        printf("image %zu bytes, patch %zu bytes (%.1f%%), %zu copies covering %zu bytes\n", image.size(),
+               patch.size(), 100.0 * patch.size() / (image.size() ? image.size() : 1), copies, copied);
+        return 0;
+    }
+
+    if (command == "apply" && argc == 5) {
+        std::vector<uint8_t> base, patch, image;
+        if (!readFile(argv[2], base) || !readFile(argv[3], patch)) return 1;
+        if (!apply(base, patch, image) || !writeFile(argv[4], image)) return 1;
+        printf("%zu bytes, sha256 %s\n", image.size(), sha256(image).c_str());
+        return 0;
+    }
+
+    if (command == "offer" && (argc == 4 || argc == 6)) {
+        std::vector<uint8_t> image;
+        if (!readFile(argv[2], image)) return 1;
+        if (argc == 4) {
+            printf("{\"version\":\"%s\",\"type\":\"full\",\"size\":%zu,\"image\":%zu,\"sha256\":\"%s\"}\n", argv[3],
+                   image.size(), image.size(), sha256(image).c_str());
+            return 0;
+        }
+        std::vector<uint8_t> base, patch;
+        if (!readFile(argv[4], base) || !readFile(argv[5], patch)) return 1;
+        printf("{\"version\":\"%s\",\"type\":\"delta\",\"size\":%zu,\"image\":%zu,\"sha256\":\"%s\",\"base\":\"%s\"}\n",
+               argv[3], patch.size(), image.size(), sha256(image).c_str(), sha256(base).c_str());
+        return 0;
+    }
+
+    return usage();
+}